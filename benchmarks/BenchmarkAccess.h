@@ -0,0 +1,101 @@
+#pragma once
+
+#include "vulkan/GraphicsEngine.h"
+#include <bit>
+
+namespace Vulkan {
+	// forwards to the engine's private hot paths so they can be timed without widening the public interface
+	struct BenchmarkAccess {
+		static GraphicsContext& getGraphicsContext(GraphicsEngine& engine) {
+			return engine.graphicsContext;
+		}
+
+		static VulkanContext& getVulkanContext(GraphicsEngine& engine) {
+			return engine.graphicsContext.context;
+		}
+
+		static vk::raii::Device const& getDevice(GraphicsEngine& engine) {
+			return engine.graphicsContext.context.device;
+		}
+
+		static vk::raii::PhysicalDevice const& getPhysicalDevice(GraphicsEngine& engine) {
+			return engine.graphicsContext.context.physicalDevice;
+		}
+
+		static uint32_t getQueueFamilyIndex(GraphicsEngine& engine) {
+			return engine.graphicsContext.context.acquiredQueueFamilyIndices[0];
+		}
+
+		static void updateUniformBuffer(GraphicsEngine& engine, uint32_t const& index) {
+			engine.updateUniformBuffer(index);
+		}
+
+		static vk::Pipeline getDrawPipeline(GraphicsEngine& engine) {
+			return engine.getDrawPipeline();
+		}
+
+		static bool isDrawPipelinePending(GraphicsEngine& engine) {
+			return engine.graphicsContext.pipelineRegistry->getState(engine.requestedPipeline) == PipelineState::ePending;
+		}
+
+		static vk::Image getSwapchainImage(GraphicsEngine& engine) {
+			return engine.graphicsContext.scImages[0];
+		}
+
+		static vk::ImageView getSwapchainImageView(GraphicsEngine& engine) {
+			return engine.graphicsContext.scImageViews[0];
+		}
+
+		static vk::Extent2D getSurfaceExtent(GraphicsEngine& engine) {
+			return engine.graphicsContext.getSurfaceExtent();
+		}
+
+		// one batch of the scene mesh, what the scene pass records for it
+		static void recordSceneDraw(GraphicsEngine& engine, CommandRecorder& recorder, vk::Pipeline const& pipeline) {
+			DrawBatch batch = { .key = SortKey::make(DrawPass::eScene, engine.graphicsContext.graphicsPipeline, 0, engine.sceneMesh, 0.0f), .firstInstance = 0, .instanceCount = 1, .packetCount = 1 };
+			engine.recordBatch(recorder, pipeline, engine.rasterState, batch, engine.graphicsContext.scExtent);
+		}
+
+		template <class T>
+		static bool featureBundleSupported(GraphicsEngine& engine, T const& requested, T const& available) {
+			return engine.graphicsContext.context.featureBundleSupported(requested, available);
+		}
+
+		template <class... Ts>
+		static bool hasPhysicalDeviceFeatures(GraphicsEngine& engine, vk::StructureChain<Ts...> const& features) {
+			return engine.graphicsContext.context.hasPhysicalDeviceFeatures(engine.graphicsContext.context.physicalDevice, features);
+		}
+
+		static void createBufferAndMemory(GraphicsEngine& engine, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory, vk::MemoryPropertyFlags const& properties, uint32_t const& size, vk::BufferUsageFlags const& usage) {
+			engine.graphicsContext.createBufferAndMemory(buffer, memory, properties, size, usage, vk::SharingMode::eExclusive);
+		}
+
+		static void createImageAndMemory(GraphicsEngine& engine, vk::raii::Image& image, vk::raii::DeviceMemory& memory, vk::ImageCreateInfo const& imageInfo) {
+			image = vk::raii::Image(engine.graphicsContext.context.device, imageInfo);
+			vk::MemoryRequirements requirements = image.getMemoryRequirements();
+			memory = vk::raii::DeviceMemory(engine.graphicsContext.context.device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = engine.graphicsContext.getSuitableMemoryTypeIndex(requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal) });
+			image.bindMemory(memory, 0);
+		}
+
+		// fills the tiles the last workgroup reads with a value far below zero, ahead of the next recording on the same command buffer
+		// a tile read that the dispatch did not write first then drags every level built from it out of range instead of reusing the last run
+		static void poisonTileBuffer(MipGenerator& generator, vk::raii::CommandBuffer const& cmdBuffer) {
+			vk::MemoryBarrier2 beforeFill = {
+				.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.srcAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+				.dstAccessMask = vk::AccessFlagBits2::eTransferWrite
+			};
+			cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &beforeFill });
+			cmdBuffer.fillBuffer(generator.tileBuffer, 0, vk::WholeSize, std::bit_cast<uint32_t>(-65536.0f));
+		}
+
+		// the queue the frames submit on
+		static vk::raii::Queue const& getQueue(GraphicsEngine& engine) {
+			return engine.graphicsContext.context.queues[0][0];
+		}
+	};
+
+	// headless, built once on first use with the same setup as main and kept for the whole run
+	GraphicsEngine& getBenchmarkEngine();
+}
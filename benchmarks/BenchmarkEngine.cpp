@@ -0,0 +1,176 @@
+#include "BenchmarkAccess.h"
+#include "general/Vertex.h"
+#include "general/VertexTransformations.h"
+#include <memory>
+
+namespace Vulkan {
+	// the same setup main uses for a headless run, minus validation and the startup overlap
+	static std::unique_ptr<GraphicsEngine> createBenchmarkEngine() {
+		VulkanContextInitInfo<vk::PhysicalDeviceFeatures2,
+		vk::PhysicalDeviceVulkan11Features,
+		vk::PhysicalDeviceVulkan12Features,
+		vk::PhysicalDeviceVulkan13Features,
+		vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> contextInfo = {
+			.windowWidth = 800,
+			.windowHeight = 600,
+			.appName = "GunAndHeart",
+			.headless = true,
+			.apiVersion = vk::ApiVersion13,
+			.validationLayers = {},
+			.deviceExtensions = {
+				vk::KHRSwapchainExtensionName,
+				vk::KHRSpirv14ExtensionName,
+				vk::KHRSynchronization2ExtensionName,
+				vk::KHRCreateRenderpass2ExtensionName
+			},
+			.optionalDeviceExtensions = {
+				vk::EXTExtendedDynamicState3ExtensionName,
+				vk::EXTMemoryBudgetExtensionName
+			},
+			.optionalDeviceFeatures = {
+				.textureCompressionBC = true,
+				.pipelineStatisticsQuery = true,
+				.shaderStorageImageWriteWithoutFormat = true,
+				.shaderStorageImageArrayDynamicIndexing = true
+			},
+			.deviceFeatures = 
+				vk::StructureChain<vk::PhysicalDeviceFeatures2,
+				vk::PhysicalDeviceVulkan11Features,
+				vk::PhysicalDeviceVulkan12Features,
+				vk::PhysicalDeviceVulkan13Features,
+				vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> {
+					{},
+					{.shaderDrawParameters = true },
+					{.timelineSemaphore = true },
+					{.synchronization2 = true, .dynamicRendering = true },
+					{.extendedDynamicState = true }
+				},
+			.queueFamiliesInfo = {
+				{vk::QueueFlagBits::eGraphics, 1, {0.5f}}
+			}
+		};
+		VulkanContext context(contextInfo);
+
+		GraphicsContextInitInfo graphicsContextInfo = {
+			.scFormat = vk::SurfaceFormatKHR(vk::Format::eB8G8R8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear),
+			.scImageCount = 3,
+			.scPresentMode = vk::PresentModeKHR::eFifo,
+			.scImageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+			.scImageViewAspect = vk::ImageAspectFlagBits::eColor,
+			.scImageSharingMode = vk::SharingMode::eExclusive,
+			.scQueueFamilyAccessorCount = 1,
+			.scQueueFamilyAccessorIndiceList = context.getQueueFamilyIndices().data(),
+			.scPreTransform = vk::SurfaceTransformFlagBitsKHR::eIdentity,
+			
+			.descriptorSetLayoutBindings = { General::VertexTransformations::getDescriptorSetLayoutBinding(0, 1), Vulkan::TextureStreamer::getDescriptorSetLayoutBinding(Vulkan::GraphicsEngine::TEXTURE_BINDING) },
+			.uniformBufferInfo = { 2, sizeof(General::VertexTransformations), vk::SharingMode::eExclusive },
+			
+			.gpShaderStageInfos = {
+				{vk::ShaderStageFlagBits::eVertex, "shaders/shader.spv", "vertexShader", {}},
+				{vk::ShaderStageFlagBits::eFragment, "shaders/shader.spv", "fragmentShader", {}}
+			},
+			.gpShaderVariant = ShaderVariantKey{}.with(ShaderFeature::eVertexColour, true),
+			.gpPreloadedShaders = {},
+			.gpVertexInputInfo = {
+				General::Vertex::getVertexInputBindingDescription(),
+				General::Vertex::getVertexInputAttributeDescription()
+			},
+			.gpInputAssemblyInfo = {
+				vk::PrimitiveTopology::eTriangleList,
+				false
+			},
+			.gpViewportStateInfo = {
+				{0.0f, 0.0f, 800.0f, 800.0f, 0.0f, 1.0f},
+				{0, 0, 800, 800}
+			},
+			.gpRasterizationInfo = {
+				false,
+				false,
+				vk::PolygonMode::eFill,
+				vk::CullModeFlagBits::eNone,
+				vk::FrontFace::eClockwise,
+				false,
+				1.0f,
+				0.0f,
+				1.0f,
+				1.0f
+			},
+			.gpSampleCount = vk::SampleCountFlagBits::e1,
+			.gpColourBlendingInfo = {
+				{
+					std::make_tuple(
+						false,
+						vk::BlendFactor::eOne,
+						vk::BlendFactor::eOne,
+						vk::BlendOp::eAdd,
+						vk::BlendFactor::eOne,
+						vk::BlendFactor::eOne,
+						vk::BlendOp::eAdd,
+						vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+					)
+				},
+				std::make_tuple(
+					false,
+					vk::LogicOp::eClear,
+					std::array<float, 4>{ 1.0f, 1.0f, 1.0f, 1.0f }
+				)
+			},
+			.dynamicStates = {
+				vk::DynamicState::eViewport,
+				vk::DynamicState::eScissor,
+				vk::DynamicState::eLineWidth,
+				vk::DynamicState::eDepthBias,
+				vk::DynamicState::eCullMode,
+				vk::DynamicState::eFrontFace,
+				vk::DynamicState::ePrimitiveTopology,
+				vk::DynamicState::eDepthTestEnable,
+				vk::DynamicState::eDepthWriteEnable,
+				vk::DynamicState::eDepthCompareOp,
+				vk::DynamicState::eDepthBoundsTestEnable,
+				vk::DynamicState::eStencilTestEnable,
+				vk::DynamicState::eRasterizerDiscardEnable,
+				vk::DynamicState::eDepthBiasEnable,
+				vk::DynamicState::ePrimitiveRestartEnable,
+				vk::DynamicState::ePolygonModeEXT,
+				vk::DynamicState::eDepthClampEnableEXT,
+				vk::DynamicState::eLogicOpEnableEXT,
+				vk::DynamicState::eColorBlendEnableEXT,
+				vk::DynamicState::eColorBlendEquationEXT,
+				vk::DynamicState::eColorWriteMaskEXT
+			},
+			.gpCompileWorkerCount = 2,
+			.verticiesBufferInfo = {
+				vk::SharingMode::eExclusive,
+				std::vector<General::Vertex>{
+					General::Vertex{ .colour = glm::vec3(1.0f, 0.0f, 0.0f), .position = glm::vec2(-0.5f, -0.5f), .texCoord = glm::vec2(0.0f, 0.0f) },
+					General::Vertex{ .colour = glm::vec3(0.0f, 1.0f, 0.0f), .position = glm::vec2(0.5f, -0.5f), .texCoord = glm::vec2(1.0f, 0.0f) },
+					General::Vertex{ .colour = glm::vec3(0.0f, 0.0f, 1.0f), .position = glm::vec2(0.5f, 0.5f), .texCoord = glm::vec2(1.0f, 1.0f) },
+					General::Vertex{ .colour = glm::vec3(1.0f, 1.0f, 0.0f), .position = glm::vec2(-0.5f, 0.5f), .texCoord = glm::vec2(0.0f, 1.0f) }
+				}
+			},
+			.indexBufferData = {
+				0, 1, 2,
+				0, 2, 3
+			}
+		};
+		GraphicsContext graphicsContext(std::move(context), graphicsContextInfo);
+
+		GraphicsEngineInitInfo graphicsEngineInfo = {
+			.commandPoolsInfos = {
+				{vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient, graphicsContext.getContext().getQueueFamilyIndices()[0]}
+			},
+			.commandBuffersInfos = {
+				0, vk::CommandBufferLevel::ePrimary, 2
+			},
+			.framesInFlightCount = 2
+		};
+
+
+		return std::make_unique<GraphicsEngine>(std::move(graphicsContext), graphicsEngineInfo);
+	}
+
+	GraphicsEngine& getBenchmarkEngine() {
+		static std::unique_ptr<GraphicsEngine> engine = createBenchmarkEngine();
+		return *engine;
+	}
+}
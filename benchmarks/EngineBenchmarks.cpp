@@ -0,0 +1,403 @@
+#include "BenchmarkAccess.h"
+#include "general/Vertex.h"
+#include "general/VertexTransformations.h"
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cstring>
+#include <random>
+#include <array>
+#include <cstdlib>
+
+// the default pipeline compiles in the background, the recording benchmarks need it finished
+static vk::Pipeline waitForDrawPipeline(Vulkan::GraphicsEngine& engine) {
+	while (Vulkan::BenchmarkAccess::isDrawPipelinePending(engine)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return Vulkan::BenchmarkAccess::getDrawPipeline(engine);
+}
+
+static void BM_VertexTransformationsCompute(benchmark::State& state) {
+	General::CameraState camera = { .position = glm::vec3(0.0f, 2.0f, 2.0f), .target = glm::vec3(0.0f, 0.0f, 0.0f), .up = glm::vec3(0.0f, 1.0f, 0.0f), .fovY = glm::radians(45.0f) };
+	float time = 0.0f;
+
+	for (auto _ : state) {
+		General::VertexTransformations transformation = General::VertexTransformations::compute(time, camera, 800.0f / 600.0f);
+		benchmark::DoNotOptimize(transformation);
+		time += 1.0f / 60.0f;
+	}
+}
+BENCHMARK(BM_VertexTransformationsCompute);
+
+// the whole of updateUniformBuffer, the matrices and the write into mapped memory
+static void BM_UpdateUniformBuffer(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+
+	for (auto _ : state) {
+		Vulkan::BenchmarkAccess::updateUniformBuffer(engine, 0);
+	}
+}
+BENCHMARK(BM_UpdateUniformBuffer);
+
+static void BM_SurfaceExtentQuery(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Vulkan::BenchmarkAccess::getSurfaceExtent(engine));
+	}
+}
+BENCHMARK(BM_SurfaceExtentQuery);
+
+// submit, sort and merge range(0) packets spread over a few pipelines, materials and meshes, each mesh's instances submitted in order
+static void BM_DrawListBuild(benchmark::State& state) {
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+	std::vector<Vulkan::DrawPacket> packets(state.range(0));
+	std::vector<uint32_t> meshInstances(16, 0);
+	for (Vulkan::DrawPacket& packet : packets) {
+		uint32_t mesh = random() % 16;
+		packet = Vulkan::DrawPacket{ .key = Vulkan::SortKey::make(Vulkan::DrawPass::eScene, random() % 4, random() % 8, mesh, depth(random)), .firstInstance = mesh * static_cast<uint32_t>(packets.size()) + meshInstances[mesh]++, .instanceCount = 1 };
+	}
+
+	Vulkan::DrawList drawList{};
+	for (uint32_t i = 0; i < 16; i++) {
+		drawList.addMesh(Vulkan::MeshRange{ .indexCount = 36, .firstIndex = 0, .vertexOffset = 0, .boundsMin = glm::vec3(-0.5f), .boundsMax = glm::vec3(0.5f) });
+	}
+
+	for (auto _ : state) {
+		drawList.clear();
+		for (Vulkan::DrawPacket const& packet : packets) {
+			drawList.submit(packet);
+		}
+		benchmark::DoNotOptimize(drawList.build());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.counters["batches"] = drawList.getStatistics().batches;
+}
+BENCHMARK(BM_DrawListBuild)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+// one rendering scope with range(0) scene draws through the recorder the way the scene pass records them
+// range(1) switches redundant state filtering, with it on everything after the first draw is elided
+static void BM_RecordSceneDraws(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+	vk::Pipeline pipeline = waitForDrawPipeline(engine);
+	if (!pipeline) {
+		state.SkipWithError("the draw pipeline failed to compile");
+		return;
+	}
+
+	vk::raii::Device const& device = Vulkan::BenchmarkAccess::getDevice(engine);
+	vk::raii::CommandPool pool(device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eTransient, .queueFamilyIndex = Vulkan::BenchmarkAccess::getQueueFamilyIndex(engine) });
+	vk::raii::CommandBuffer cmdBuffer = std::move(vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo{ .commandPool = pool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = 1 }).front());
+
+	vk::RenderingAttachmentInfo attachmentInfo = {
+		.imageView = Vulkan::BenchmarkAccess::getSwapchainImageView(engine),
+		.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+		.loadOp = vk::AttachmentLoadOp::eClear,
+		.storeOp = vk::AttachmentStoreOp::eStore,
+		.clearValue = vk::ClearColorValue(0.3f, 0.3f, 0.3f, 1.0f)
+	};
+	vk::RenderingInfo renderingInfo = {
+		.renderArea = vk::Rect2D{ .offset = {0, 0}, .extent = Vulkan::BenchmarkAccess::getSurfaceExtent(engine) },
+		.layerCount = 1,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &attachmentInfo
+	};
+	vk::ImageMemoryBarrier2 toAttachment = {
+		.srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
+		.dstStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+		.oldLayout = vk::ImageLayout::eUndefined,
+		.newLayout = vk::ImageLayout::eColorAttachmentOptimal,
+		.image = Vulkan::BenchmarkAccess::getSwapchainImage(engine),
+		.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+	};
+
+	int64_t drawCount = state.range(0);
+	Vulkan::CommandRecorder recorder{};
+	recorder.setFiltering(state.range(1) != 0);
+	for (auto _ : state) {
+		pool.reset();
+		cmdBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		recorder.begin(cmdBuffer);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toAttachment });
+		cmdBuffer.beginRendering(renderingInfo);
+		for (int64_t i = 0; i < drawCount; i++) {
+			Vulkan::BenchmarkAccess::recordSceneDraw(engine, recorder, pipeline);
+		}
+		cmdBuffer.endRendering();
+		cmdBuffer.end();
+	}
+
+	state.SetItemsProcessed(state.iterations() * drawCount);
+	state.counters["issued"] = recorder.getStatistics().issued;
+	state.counters["elided"] = recorder.getStatistics().elided;
+}
+BENCHMARK(BM_RecordSceneDraws)->ArgNames({ "draws", "filtering" })->ArgsProduct({ benchmark::CreateRange(1, 4096, 8), { 0, 1 } });
+
+static void BM_VertexInputDescriptions(benchmark::State& state) {
+	for (auto _ : state) {
+		vk::VertexInputBindingDescription binding = General::Vertex::getVertexInputBindingDescription();
+		std::vector<vk::VertexInputAttributeDescription> attributes = General::Vertex::getVertexInputAttributeDescription();
+		benchmark::DoNotOptimize(binding);
+		benchmark::DoNotOptimize(attributes.data());
+	}
+}
+BENCHMARK(BM_VertexInputDescriptions);
+
+// featureBundleSupported logs every supported feature, the log goes to a string stream so the terminal is not the bottleneck
+class SilencedOutput {
+private:
+	std::ostringstream sink;
+	std::streambuf* original;
+public:
+	SilencedOutput() : sink{}, original{ std::cout.rdbuf(sink.rdbuf()) } {
+
+	}
+
+	~SilencedOutput() {
+		std::cout.rdbuf(original);
+	}
+
+	void clear() {
+		sink.str(std::string{});
+	}
+};
+
+static void BM_FeatureBundleSupported(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+	vk::PhysicalDeviceVulkan13Features requested = { .synchronization2 = true, .dynamicRendering = true };
+	vk::PhysicalDeviceVulkan13Features available = Vulkan::BenchmarkAccess::getPhysicalDevice(engine).getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features>().get<vk::PhysicalDeviceVulkan13Features>();
+	SilencedOutput silenced{};
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Vulkan::BenchmarkAccess::featureBundleSupported(engine, requested, available));
+		state.PauseTiming();
+		silenced.clear();
+		state.ResumeTiming();
+	}
+}
+BENCHMARK(BM_FeatureBundleSupported);
+
+// the full device check run once per physical device at startup, including the driver's getFeatures2
+static void BM_HasPhysicalDeviceFeatures(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+	vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> requested = {
+		{},
+		{.shaderDrawParameters = true },
+		{.timelineSemaphore = true },
+		{.synchronization2 = true, .dynamicRendering = true },
+		{.extendedDynamicState = true }
+	};
+	SilencedOutput silenced{};
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Vulkan::BenchmarkAccess::hasPhysicalDeviceFeatures(engine, requested));
+		state.PauseTiming();
+		silenced.clear();
+		state.ResumeTiming();
+	}
+}
+BENCHMARK(BM_HasPhysicalDeviceFeatures);
+
+// what an upload costs before any command is recorded: the staging and destination buffers, their memory, and the copy into the mapping
+static void BM_BufferUploadSetup(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+	uint32_t size = static_cast<uint32_t>(state.range(0));
+	std::vector<uint8_t> data(size, 0xAB);
+
+	for (auto _ : state) {
+		vk::raii::Buffer staging = nullptr;
+		vk::raii::DeviceMemory stagingMemory = nullptr;
+		vk::raii::Buffer destination = nullptr;
+		vk::raii::DeviceMemory destinationMemory = nullptr;
+
+		Vulkan::BenchmarkAccess::createBufferAndMemory(engine, staging, stagingMemory, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, size, vk::BufferUsageFlagBits::eTransferSrc);
+		void* address = stagingMemory.mapMemory(0, size);
+		memcpy(address, data.data(), size);
+		stagingMemory.unmapMemory();
+		Vulkan::BenchmarkAccess::createBufferAndMemory(engine, destination, destinationMemory, vk::MemoryPropertyFlagBits::eDeviceLocal, size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer);
+	}
+
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_BufferUploadSetup)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+
+static vk::ImageMemoryBarrier2 mipLevelsBarrier(vk::Image const& image, uint32_t const& baseLevel, uint32_t const& levelCount, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout) {
+	return vk::ImageMemoryBarrier2{
+		.srcStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+		.srcAccessMask = vk::AccessFlagBits2::eMemoryWrite,
+		.dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+		.dstAccessMask = vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite,
+		.oldLayout = oldLayout,
+		.newLayout = newLayout,
+		.image = image,
+		.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = baseLevel, .levelCount = levelCount, .baseArrayLayer = 0, .layerCount = 1 }
+	};
+}
+
+// levels 1 and up of a range(0) x range(1) sRGB image generated from the same level 0 every iteration, timed by the generator's own timestamps
+// with range(2) on they come from the compute path and are read back afterwards against a blit chain of the same image
+// level 0 is a gradient stretched over the image, so no two sizes share their texels, with an alpha of one that every level keeps whichever way it is filtered
+// the tile buffer is poisoned before every run, so a level built from a tile the run did not write loses its alpha
+static void BM_MipGeneration(benchmark::State& state) {
+	Vulkan::GraphicsEngine& engine = Vulkan::getBenchmarkEngine();
+	Vulkan::GraphicsContext& context = Vulkan::BenchmarkAccess::getGraphicsContext(engine);
+	vk::raii::Device const& device = Vulkan::BenchmarkAccess::getDevice(engine);
+	vk::raii::Queue const& queue = Vulkan::BenchmarkAccess::getQueue(engine);
+	vk::Format format = vk::Format::eR8G8B8A8Srgb;
+	vk::Extent2D extent = { static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)) };
+	Vulkan::MipPath path = state.range(2) != 0 ? Vulkan::MipPath::eCompute : Vulkan::MipPath::eBlit;
+
+	Vulkan::MipGenerator generator(context);
+	if (!generator.canGenerate(context, format)) {
+		state.SkipWithError("levels of R8G8B8A8_SRGB can not be generated on this device");
+		return;
+	}
+	uint32_t levelCount = Vulkan::MipGenerator::getFullLevelCount(extent);
+
+	vk::ImageCreateInfo imageInfo = {
+		.flags = generator.getImageFlags(context, format),
+		.imageType = vk::ImageType::e2D,
+		.format = format,
+		.extent = vk::Extent3D{ extent.width, extent.height, 1 },
+		.mipLevels = levelCount,
+		.arrayLayers = 1,
+		.samples = vk::SampleCountFlagBits::e1,
+		.tiling = vk::ImageTiling::eOptimal,
+		.usage = generator.getImageUsage(context, format) | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+		.sharingMode = vk::SharingMode::eExclusive,
+		.initialLayout = vk::ImageLayout::eUndefined
+	};
+	vk::raii::Image image = nullptr;
+	vk::raii::DeviceMemory imageMemory = nullptr;
+	Vulkan::BenchmarkAccess::createImageAndMemory(engine, image, imageMemory, imageInfo);
+	vk::raii::Image reference = nullptr;
+	vk::raii::DeviceMemory referenceMemory = nullptr;
+	Vulkan::BenchmarkAccess::createImageAndMemory(engine, reference, referenceMemory, imageInfo);
+
+	// the staging buffer first holds level 0, then the levels below it of both images back to back
+	uint32_t baseSize = extent.width * extent.height * 4;
+	uint32_t levelsSize = 0;
+	std::vector<vk::BufferImageCopy> levelRegions;
+	for (uint32_t level = 1; level < levelCount; level++) {
+		vk::Extent3D levelExtent = { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), 1 };
+		levelRegions.push_back(vk::BufferImageCopy{ .bufferOffset = levelsSize, .imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = level, .baseArrayLayer = 0, .layerCount = 1 }, .imageExtent = levelExtent });
+		levelsSize += levelExtent.width * levelExtent.height * 4;
+	}
+	vk::raii::Buffer staging = nullptr;
+	vk::raii::DeviceMemory stagingMemory = nullptr;
+	Vulkan::BenchmarkAccess::createBufferAndMemory(engine, staging, stagingMemory, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, std::max(baseSize, levelsSize * 2), vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst);
+	uint8_t* mapped = static_cast<uint8_t*>(stagingMemory.mapMemory(0, vk::WholeSize));
+	for (uint32_t y = 0; y < extent.height; y++) {
+		for (uint32_t x = 0; x < extent.width; x++) {
+			std::array<uint8_t, 4> texel = {
+				static_cast<uint8_t>(x * 255 / std::max(extent.width - 1, 1u)),
+				static_cast<uint8_t>(y * 255 / std::max(extent.height - 1, 1u)),
+				static_cast<uint8_t>((x + y) * 255 / std::max(extent.width + extent.height - 2, 1u)),
+				255
+			};
+			memcpy(mapped + (y * extent.width + x) * 4, texel.data(), texel.size());
+		}
+	}
+
+	vk::raii::CommandPool pool(device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eTransient, .queueFamilyIndex = Vulkan::BenchmarkAccess::getQueueFamilyIndex(engine) });
+	vk::raii::CommandBuffer cmdBuffer = std::move(vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo{ .commandPool = pool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = 1 }).front());
+	auto submitAndWait = [&]() {
+		cmdBuffer.end();
+		queue.submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*cmdBuffer }, nullptr);
+		queue.waitIdle();
+		pool.reset();
+	};
+
+	// level 0 of both, and the reference chain through the blit path
+	cmdBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+	for (vk::Image target : { *image, *reference }) {
+		vk::ImageMemoryBarrier2 toTransfer = mipLevelsBarrier(target, 0, 1, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+		cmdBuffer.copyBufferToImage(staging, target, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy{ .bufferOffset = 0, .imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 }, .imageExtent = imageInfo.extent });
+		vk::ImageMemoryBarrier2 toShader = mipLevelsBarrier(target, 0, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShader });
+	}
+	generator.setPreferredPath(Vulkan::MipPath::eBlit);
+	generator.record(context, cmdBuffer, reference, format, extent, levelCount);
+	submitAndWait();
+	generator.collect();
+
+	generator.setPreferredPath(path);
+	for (auto _ : state) {
+		Vulkan::MipGenerationStatistics before = generator.getStatistics();
+		cmdBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		if (path == Vulkan::MipPath::eCompute) {
+			Vulkan::BenchmarkAccess::poisonTileBuffer(generator, cmdBuffer);
+		}
+		Vulkan::MipPath taken = generator.record(context, cmdBuffer, image, format, extent, levelCount);
+		submitAndWait();
+		generator.collect();
+
+		Vulkan::MipGenerationStatistics const& after = generator.getStatistics();
+		double milliseconds = path == Vulkan::MipPath::eCompute ? after.computeMilliseconds - before.computeMilliseconds : after.blitMilliseconds - before.blitMilliseconds;
+		if (taken != path) {
+			state.SkipWithError("the compute path is not available for this device or size");
+			break;
+		}
+		if (milliseconds <= 0.0) {
+			state.SkipWithError("the queue has no timestamps");
+			break;
+		}
+		state.SetIterationTime(milliseconds / 1000.0);
+	}
+	if (state.error_occurred() || path != Vulkan::MipPath::eCompute) {
+		return;
+	}
+
+	cmdBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+	uint32_t readbackOffset = 0;
+	for (vk::Image source : { *image, *reference }) {
+		vk::ImageMemoryBarrier2 toTransfer = mipLevelsBarrier(source, 1, levelCount - 1, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+		std::vector<vk::BufferImageCopy> regions = levelRegions;
+		for (vk::BufferImageCopy& region : regions) {
+			region.bufferOffset += readbackOffset;
+		}
+		cmdBuffer.copyImageToBuffer(source, vk::ImageLayout::eTransferSrcOptimal, staging, regions);
+		readbackOffset += levelsSize;
+	}
+	vk::MemoryBarrier2 toHost = { .srcStageMask = vk::PipelineStageFlagBits2::eCopy, .srcAccessMask = vk::AccessFlagBits2::eTransferWrite, .dstStageMask = vk::PipelineStageFlagBits2::eHost, .dstAccessMask = vk::AccessFlagBits2::eHostRead };
+	cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &toHost });
+	submitAndWait();
+
+	// while every level above has even sides both paths average the same 2x2 texels and may only round differently
+	// below an odd side they place their taps differently, so only the alpha is checked there
+	uint32_t exactSize = 0;
+	for (uint32_t level = 1; level < levelCount; level++) {
+		uint32_t aboveWidth = std::max(extent.width >> (level - 1), 1u);
+		uint32_t aboveHeight = std::max(extent.height >> (level - 1), 1u);
+		if ((aboveWidth != 1 && aboveWidth % 2 != 0) || (aboveHeight != 1 && aboveHeight % 2 != 0)) {
+			break;
+		}
+		exactSize += std::max(extent.width >> level, 1u) * std::max(extent.height >> level, 1u) * 4;
+	}
+	int maxDifference = 0;
+	for (uint32_t offset = 0; offset < exactSize; offset++) {
+		maxDifference = std::max(maxDifference, std::abs(static_cast<int>(mapped[offset]) - static_cast<int>(mapped[levelsSize + offset])));
+	}
+	uint32_t lostAlpha = 0;
+	for (uint32_t offset = 3; offset < levelsSize; offset += 4) {
+		lostAlpha += mapped[offset] != 255 ? 1 : 0;
+	}
+	state.counters["maxDifference"] = maxDifference;
+	state.counters["lostAlpha"] = lostAlpha;
+	if (lostAlpha != 0) {
+		state.SkipWithError("the compute levels were built from tiles outside the dispatch");
+	} else if (maxDifference > 1) {
+		state.SkipWithError("the compute levels differ from the blit chain");
+	}
+}
+// square, odd sized, and thin both ways so the compute path runs with a single row or column of tiles
+BENCHMARK(BM_MipGeneration)->ArgNames({ "width", "height", "compute" })->Args({ 1024, 1024, 0 })->Args({ 1024, 1024, 1 })->Args({ 1000, 600, 0 })->Args({ 1000, 600, 1 })->Args({ 4096, 64, 0 })->Args({ 4096, 64, 1 })->Args({ 64, 4096, 0 })->Args({ 64, 4096, 1 })->UseManualTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+#pragma once
+
+// define GH_TRACK_ALLOCATIONS to replace the global operator new and delete with counting versions
+// without it every macro below expands to nothing and the allocator is left alone
+#ifdef GH_TRACK_ALLOCATIONS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define GH_ALLOCATION_CONCAT_INNER(a, b) a##b
+#define GH_ALLOCATION_CONCAT(a, b) GH_ALLOCATION_CONCAT_INNER(a, b)
+#define GH_ALLOCATION_FRAME() General::AllocationFrame GH_ALLOCATION_CONCAT(allocationFrame, __LINE__){}
+#define GH_ALLOCATION_SAMPLE_EVERY(interval) General::AllocationTracker::get().setSampleInterval(interval)
+#define GH_ALLOCATION_RESET() General::AllocationTracker::get().resetStatistics()
+#define GH_ALLOCATION_PRINT_SUMMARY() General::AllocationTracker::get().printSummary()
+#define GH_ALLOCATION_PRINT_REPORT(topCount) General::AllocationTracker::get().printReport(topCount)
+
+namespace General {
+	struct FrameAllocations {
+		uint64_t count;
+		uint64_t bytes;
+	};
+
+	// only allocations made by the frame's own thread between beginFrame and endFrame are counted against the frame
+	// every sampleInterval-th of those also records its call stack into a fixed table, nothing in the hook allocates
+	class AllocationTracker {
+	private:
+		static constexpr uint32_t MAX_CALLSITES = 256;
+		static constexpr uint32_t MAX_DEPTH = 16;
+
+		struct Callsite {
+			std::array<void*, MAX_DEPTH> frames;
+			uint32_t depth;
+			uint64_t hash;
+			uint64_t count;
+			uint64_t bytes;
+		};
+
+		std::array<Callsite, MAX_CALLSITES> callsites;
+		uint32_t callsiteCount;
+		uint64_t droppedSamples;
+		std::mutex callsitesMutex;
+		std::atomic<uint32_t> sampleInterval;
+
+		// the frame thread is the only writer, the totals are read from it as well
+		FrameAllocations lastFrame;
+		FrameAllocations frameTotals;
+		FrameAllocations worstFrame;
+		uint64_t trackedFrames;
+		uint64_t allocatingFrames;
+		std::atomic<uint64_t> processCount;
+		std::atomic<uint64_t> processBytes;
+
+		void sampleCallsite(size_t const& size);
+
+		AllocationTracker();
+	public:
+		static AllocationTracker& get();
+
+		// called by the replaced operator new, from any thread
+		void onAllocation(size_t const& size);
+
+		void beginFrame();
+		void endFrame();
+		// 0 turns sampling off, which is the default
+		void setSampleInterval(uint32_t const& interval);
+		// frame counters and sampled callsites, the process wide counters keep running
+		void resetStatistics();
+
+		FrameAllocations const& getLastFrame() const;
+		uint64_t getTrackedFrames() const;
+		uint64_t getAllocatingFrames() const;
+
+		// one line for the once a second statistics
+		void printSummary();
+		// the totals and the topCount most frequent sampled stacks
+		void printReport(uint32_t const& topCount);
+	};
+
+	class AllocationFrame {
+	public:
+		AllocationFrame();
+		~AllocationFrame();
+
+		AllocationFrame(AllocationFrame const& copyFrom) = delete;
+		AllocationFrame& operator=(AllocationFrame const& assignFrom) = delete;
+	};
+}
+
+#else
+
+#define GH_ALLOCATION_FRAME() ((void)0)
+#define GH_ALLOCATION_SAMPLE_EVERY(interval) ((void)0)
+#define GH_ALLOCATION_RESET() ((void)0)
+#define GH_ALLOCATION_PRINT_SUMMARY() ((void)0)
+#define GH_ALLOCATION_PRINT_REPORT(topCount) ((void)0)
+
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace General {
+	struct CameraState {
+		glm::vec3 position;
+		glm::vec3 target;
+		glm::vec3 up;
+		// radians
+		float fovY;
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace General {
+	constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+	inline uint64_t fnv1a(void const* data, size_t const& size, uint64_t seed = FNV_OFFSET_BASIS) {
+		unsigned char const* bytes = static_cast<unsigned char const*>(data);
+
+		for (size_t i = 0; i < size; i++) {
+			seed ^= bytes[i];
+			seed *= FNV_PRIME;
+		}
+
+		return seed;
+	}
+
+	// only for types without padding, otherwise indeterminate padding bytes end up in the hash
+	template <class T>
+	uint64_t hashValue(T const& value, uint64_t seed = FNV_OFFSET_BASIS) {
+		static_assert(std::is_trivially_copyable_v<T>, "hashValue needs a trivially copyable type");
+		return fnv1a(&value, sizeof(T), seed);
+	}
+
+	inline uint64_t hashValue(std::string const& value, uint64_t seed = FNV_OFFSET_BASIS) {
+		seed = hashValue(value.size(), seed);
+		return fnv1a(value.data(), value.size(), seed);
+	}
+
+	template <class T>
+	uint64_t hashValue(std::vector<T> const& values, uint64_t seed = FNV_OFFSET_BASIS) {
+		seed = hashValue(values.size(), seed);
+		for (T const& value : values) {
+			seed = hashValue(value, seed);
+		}
+
+		return seed;
+	}
+}
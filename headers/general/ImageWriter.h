@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace General {
+	// rgba8, tightly packed rows, top row first
+	// the deflate stream uses stored blocks only, so the files are bigger than a real encoder's but there is no dependency and any viewer opens them
+	bool writePng(std::string const& path, uint32_t const& width, uint32_t const& height, uint8_t const* rgba);
+	bool writeRaw(std::string const& path, void const* data, size_t const& size);
+}
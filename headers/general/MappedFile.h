@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace General {
+	// read only view of a whole file, the pages are only read in when touched
+	class MappedFile {
+	private:
+		void const* data;
+		size_t size;
+#ifdef _WIN32
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int fileDescriptor;
+#endif
+
+		void unmap();
+	public:
+		MappedFile(std::string const& path);
+		MappedFile(MappedFile&& moveFrom);
+		~MappedFile();
+
+		MappedFile(MappedFile const& copyFrom) = delete;
+		MappedFile& operator=(MappedFile const& assignFrom) = delete;
+
+		void const* getData() const;
+		size_t getSize() const;
+	};
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// define GH_PROFILING to build the profiler in, without it every macro below expands to nothing and no profiler code is compiled
+#ifdef GH_PROFILING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define GH_PROFILE_CONCAT_INNER(a, b) a##b
+#define GH_PROFILE_CONCAT(a, b) GH_PROFILE_CONCAT_INNER(a, b)
+#define GH_PROFILE_ZONE(name) General::ProfileZone GH_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define GH_PROFILE_FUNCTION() GH_PROFILE_ZONE(__func__)
+#define GH_PROFILE_THREAD(name) General::Profiler::get().setThreadName(name)
+#define GH_PROFILE_EXPORT(path) General::Profiler::get().writeChromeTrace(path)
+
+namespace General {
+	struct ProfileSpan {
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+		uint32_t depth;
+	};
+
+	// one per thread, only the owning thread writes so pushing is relaxed stores fenced by the slot's sequence and a release of the head
+	// once full the oldest spans are overwritten
+	class ProfileRing {
+	private:
+		static constexpr uint64_t CAPACITY = 1 << 16;
+
+		// a span's fields are atomics so the exporter can read a slot the owner is overwriting without a data race
+		// the sequence is odd while the slot is being written and 2 * (index + 1) once span index is in it
+		struct Slot {
+			std::atomic<uint64_t> sequence;
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> startNs;
+			std::atomic<uint64_t> endNs;
+			std::atomic<uint32_t> depth;
+		};
+
+		std::array<Slot, CAPACITY> slots;
+		std::atomic<uint64_t> head;
+	public:
+		uint32_t threadIndex;
+		// written and read under the profiler's rings mutex
+		std::string threadName;
+		uint32_t depth;
+
+		ProfileRing(uint32_t const& threadIndex);
+
+		void push(ProfileSpan const& span);
+		// copies the spans below the published head that are still intact, spans the owner overwrote while copying are dropped
+		std::vector<ProfileSpan> snapshot() const;
+	};
+
+	class Profiler {
+	private:
+		std::chrono::steady_clock::time_point epoch;
+		std::vector<std::shared_ptr<ProfileRing>> rings;
+		std::mutex ringsMutex;
+
+		Profiler();
+	public:
+		static Profiler& get();
+
+		// the lock is only taken the first time a thread records, rings outlive their threads so nothing is lost on join
+		ProfileRing& getThreadRing();
+		uint64_t now() const;
+
+		void setThreadName(std::string const& name);
+		// chrome://tracing and ui.perfetto.dev both open this
+		void writeChromeTrace(std::string const& path);
+	};
+
+	class ProfileZone {
+	private:
+		ProfileRing& ring;
+		const char* name;
+		uint64_t startNs;
+	public:
+		ProfileZone(const char* name);
+		~ProfileZone();
+
+		ProfileZone(ProfileZone const& copyFrom) = delete;
+		ProfileZone& operator=(ProfileZone const& assignFrom) = delete;
+	};
+}
+
+#else
+
+#define GH_PROFILE_ZONE(name) ((void)0)
+#define GH_PROFILE_FUNCTION() ((void)0)
+#define GH_PROFILE_THREAD(name) ((void)0)
+#define GH_PROFILE_EXPORT(path) ((void)0)
+
+#endif
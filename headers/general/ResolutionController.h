@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace General {
+	struct ResolutionControllerSettings {
+		// fractions of the output size per axis, the scale is clamped to these
+		float minScale;
+		float maxScale;
+		double targetMilliseconds;
+		// gains on the relative error, (target - measured) / target
+		double proportionalGain;
+		double integralGain;
+		// the scale only moves in steps this big, every change resizes the targets it is applied to
+		float step;
+		// frames to ignore after a change, the measurements still come from the old size until the frames in flight drain
+		uint32_t settleFrames;
+	};
+
+	// a PI controller on frame time with the scale as output, above the target the scale drops and with headroom it climbs back
+	// the integral only accumulates while the output is not clamped, so a long stretch at a limit does not wind it up
+	class ResolutionController {
+	private:
+		ResolutionControllerSettings settings;
+		double integral;
+		float scale;
+		uint32_t framesSinceChange;
+	public:
+		ResolutionController(ResolutionControllerSettings const& settings);
+
+		// starts again from the maximum scale with nothing integrated
+		void reset(ResolutionControllerSettings const& newSettings);
+		// one measurement per frame, returns true when the scale changed
+		bool update(double const& frameMilliseconds);
+		float getScale() const;
+		ResolutionControllerSettings const& getSettings() const;
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace General {
+	// keeps the last windowSize samples, percentiles are taken over that window only
+	class RollingPercentiles {
+	private:
+		std::vector<double> samples;
+		// reused by percentile so reading the window does not allocate
+		mutable std::vector<double> sorted;
+		uint32_t windowSize;
+		uint32_t next;
+	public:
+		RollingPercentiles(uint32_t const& windowSize);
+
+		void add(double const& sample);
+		// fraction in [0, 1], 0 when there are no samples yet
+		double percentile(double const& fraction) const;
+		// the sample added last, 0 when there are none
+		double getLatest() const;
+		uint32_t getSampleCount() const;
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "general/Camera.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace General {
+	enum class InputEventType : uint8_t {
+		eKey,
+		eMouseButton,
+		eCursor,
+		eScroll
+	};
+
+	// code, action and mods are glfw's values, x and y are only used by cursor and scroll events
+	struct InputEvent {
+		InputEventType type;
+		uint8_t action;
+		uint16_t mods;
+		int32_t code;
+		float x;
+		float y;
+	};
+
+	// whatever the caller spawned that frame, the engine only stores and hands these back, kind is up to the caller
+	struct SpawnedObject {
+		uint32_t id;
+		uint32_t kind;
+		glm::vec3 position;
+		glm::vec3 rotation;
+		glm::vec3 scale;
+	};
+
+	// everything from outside the engine that decides what a frame looks like
+	struct FrameRecord {
+		// seconds the scene advanced this frame
+		double deltaTime;
+		CameraState camera;
+		std::vector<InputEvent> events;
+		std::vector<SpawnedObject> spawns;
+	};
+
+	// binary, little endian, a header with the extent the session ran at followed by one record per frame
+	// frames are appended as they happen, the frame count in the header is filled in on close
+	class SessionRecorder {
+	private:
+		std::ofstream file;
+		std::string path;
+		uint32_t frameCount;
+	public:
+		static constexpr char MAGIC[4] = { 'G', 'H', 'S', 'L' };
+		static constexpr uint32_t VERSION = 1;
+
+		SessionRecorder(std::string const& path, uint32_t const& width, uint32_t const& height);
+		~SessionRecorder();
+
+		SessionRecorder(SessionRecorder const& copyFrom) = delete;
+		SessionRecorder& operator=(SessionRecorder const& assignFrom) = delete;
+
+		void writeFrame(FrameRecord const& frame);
+		void close();
+		uint32_t getFrameCount() const;
+	};
+
+	// the whole log is decoded up front so replaying a frame never touches the disk
+	class SessionReplay {
+	private:
+		std::vector<FrameRecord> frames;
+		uint32_t width;
+		uint32_t height;
+	public:
+		SessionReplay(std::string const& path);
+
+		std::vector<FrameRecord> const& getFrames() const;
+		uint32_t getWidth() const;
+		uint32_t getHeight() const;
+	};
+}
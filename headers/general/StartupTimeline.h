@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace General {
+	// collects how long every startup step took and on which thread, until the first frame is presented
+	class StartupTimeline {
+	private:
+		struct Step {
+			std::string name;
+			std::thread::id thread;
+			std::chrono::steady_clock::time_point start;
+			std::chrono::steady_clock::time_point end;
+		};
+
+		std::chrono::steady_clock::time_point processStart;
+		std::vector<Step> steps;
+		std::mutex stepsMutex;
+		std::atomic<bool> finished;
+
+		StartupTimeline();
+		void printReport(std::chrono::steady_clock::time_point const& firstFrame);
+	public:
+		// the clock starts on the first call, so call it at the top of main
+		static StartupTimeline& get();
+
+		void record(std::string const& name, std::chrono::steady_clock::time_point const& start, std::chrono::steady_clock::time_point const& end);
+		// prints the report the first time, does nothing afterwards
+		void markFirstFrame();
+		bool isFinished() const;
+	};
+
+	class StartupStep {
+	private:
+		const char* name;
+		std::chrono::steady_clock::time_point start;
+	public:
+		StartupStep(const char* name);
+		~StartupStep();
+
+		StartupStep(StartupStep const& copyFrom) = delete;
+		StartupStep& operator=(StartupStep const& assignFrom) = delete;
+	};
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace General {
+	class ThreadPool {
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> tasks;
+		std::mutex tasksMutex;
+		std::condition_variable tasksAvailable;
+		std::condition_variable tasksDrained;
+		uint32_t busyWorkers;
+		bool stopping;
+
+		void workerLoop();
+	public:
+		ThreadPool(uint32_t const& threadCount);
+		~ThreadPool();
+
+		ThreadPool(ThreadPool const& copyFrom) = delete;
+		ThreadPool& operator=(ThreadPool const& assignFrom) = delete;
+
+		void submit(std::function<void()> task);
+		template <class F>
+		std::future<std::invoke_result_t<F>> enqueue(F&& task);
+		void waitIdle();
+
+		uint32_t getThreadCount() const;
+	};
+
+	template <class F>
+	std::future<std::invoke_result_t<F>> ThreadPool::enqueue(F&& task) {
+		std::shared_ptr<std::packaged_task<std::invoke_result_t<F>()>> packagedTask = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+		std::future<std::invoke_result_t<F>> result = packagedTask->get_future();
+
+		submit([packagedTask]() { (*packagedTask)(); });
+
+		return result;
+	}
+}
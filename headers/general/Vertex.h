@@ -9,6 +9,7 @@ namespace General {
 	struct Vertex {
 		glm::vec3 colour;
 		glm::vec2 position;
+		glm::vec2 texCoord;
 
 		static vk::VertexInputBindingDescription getVertexInputBindingDescription();
 		static std::vector<vk::VertexInputAttributeDescription> getVertexInputAttributeDescription();
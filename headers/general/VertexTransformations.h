@@ -3,6 +3,7 @@
 #define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
 #include "vulkan/vulkan_raii.hpp"
 #include <glm/glm.hpp>
+#include "general/Camera.h"
 
 namespace General {
 	struct VertexTransformations {
@@ -10,6 +11,11 @@ namespace General {
 		glm::mat4 view;
 		glm::mat4 projection;
 
+		static constexpr float NEAR_PLANE = 0.1f;
+		static constexpr float FAR_PLANE = 10.0f;
+
 		static vk::DescriptorSetLayoutBinding getDescriptorSetLayoutBinding(uint32_t const& bindingNum, uint32_t const& descCount);
+		// the model spins half a turn a second around y, the projection maps depth to vulkan's 0 to 1 and is flipped for its y down clip space
+		static VertexTransformations compute(float const& time, CameraState const& camera, float const& aspectRatio);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "general/RollingPercentiles.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace Vulkan {
+	struct BenchmarkSettings {
+		uint32_t frameCount;
+		// run first and left out of every number, covers pipeline compiles and the first uploads
+		uint32_t warmupFrameCount;
+		// seconds the scene advances each frame regardless of how long the frame took, 0 uses real time
+		double fixedTimestep;
+		std::string reportPath;
+	};
+
+	struct MemoryHeapReport {
+		uint64_t size;
+		bool deviceLocal;
+		// only filled when VK_EXT_memory_budget is enabled
+		uint64_t budget;
+		uint64_t usage;
+	};
+
+	// everything a benchmark run measured, written out as one JSON object so CI can diff runs
+	struct BenchmarkReport {
+		std::string deviceName;
+		uint32_t driverVersion;
+		uint32_t apiVersion;
+		bool headless;
+		BenchmarkSettings settings;
+		vk::Extent2D extent;
+		double wallTimeMs;
+		std::vector<std::pair<std::string, General::RollingPercentiles>> timings;
+		bool hasMemoryBudget;
+		std::vector<MemoryHeapReport> heaps;
+
+		void writeJson(std::string const& path) const;
+	};
+}
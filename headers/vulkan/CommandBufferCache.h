@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <vector>
+
+namespace Vulkan {
+	// one command buffer per swapchain image and frame slot, recorded once and then resubmitted as long as nothing it recorded changes
+	// a change anywhere bumps the version, entries recorded under an older version are recorded again the next time they come up
+	// an entry is only touched after its slot's fence has been waited on, so it is never reset while the GPU may still run it
+	class CommandBufferCache {
+	private:
+		struct Entry {
+			vk::raii::CommandBuffer buffer;
+			// 0 until the entry is first recorded, the cache itself starts at 1
+			uint64_t version;
+		};
+
+		vk::raii::CommandPool pool;
+		// indexed by slot then swapchain image, grows when a new swapchain has more images and never shrinks
+		std::vector<std::vector<Entry>> slotEntries;
+		uint64_t version;
+		uint64_t reusedCount;
+		uint64_t recordedCount;
+		bool enabled;
+	public:
+		CommandBufferCache(vk::raii::Device const& device, uint32_t const& queueFamilyIndex, uint32_t const& frameSlotCount);
+
+		CommandBufferCache(CommandBufferCache const& copyFrom) = delete;
+		CommandBufferCache& operator=(CommandBufferCache const& assignFrom) = delete;
+
+		// allocates for images not seen before and invalidates, a new swapchain means new images in every recording
+		void resize(vk::raii::Device const& device, uint32_t const& imageCount);
+		void invalidate();
+
+		vk::raii::CommandBuffer const& get(uint32_t const& image, uint32_t const& slot) const;
+		// true when the entry was recorded under the current version and can be submitted as is, counts the reuse
+		bool reuse(uint32_t const& image, uint32_t const& slot);
+		void markRecorded(uint32_t const& image, uint32_t const& slot);
+
+		// switching it off leaves the entries alone, they are invalidated so nothing stale comes back when it is switched on again
+		void setEnabled(bool const& enable);
+		bool isEnabled() const;
+		uint64_t getVersion() const;
+		uint64_t getReusedCount() const;
+		uint64_t getRecordedCount() const;
+	};
+}
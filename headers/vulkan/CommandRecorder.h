@@ -0,0 +1,156 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <array>
+
+namespace Vulkan {
+	struct RecorderStatistics {
+		// binds, dynamic state sets and push constants, draws are counted on their own
+		uint32_t issued;
+		uint32_t elided;
+		uint32_t draws;
+	};
+
+	// sits between the recording code and the command buffer, remembers what is bound and set and drops calls that would not change it
+	// state carries over pipeline binds, so every pipeline recorded through one recorder must make the same states dynamic and use compatible layouts
+	// the engine's pipelines all do, anything else has to call invalidate after binding
+	class CommandRecorder {
+	private:
+		static constexpr uint32_t MAX_VERTEX_BINDINGS = 8;
+		static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+		// the smallest maxPushConstantsSize the spec allows, pushes past it are always issued
+		static constexpr uint32_t PUSH_CONSTANT_BYTES = 128;
+
+		template<typename T>
+		struct Tracked {
+			T value{};
+			bool valid = false;
+		};
+
+		struct VertexBinding {
+			vk::Buffer buffer;
+			vk::DeviceSize offset;
+			bool operator==(VertexBinding const& other) const = default;
+		};
+
+		struct IndexBinding {
+			vk::Buffer buffer;
+			vk::DeviceSize offset;
+			vk::IndexType type;
+			bool operator==(IndexBinding const& other) const = default;
+		};
+
+		struct SetBinding {
+			vk::PipelineLayout layout;
+			vk::DescriptorSet set;
+			bool operator==(SetBinding const& other) const = default;
+		};
+
+		struct DepthBias {
+			float constantFactor;
+			float clamp;
+			float slopeFactor;
+			bool operator==(DepthBias const& other) const = default;
+		};
+
+		vk::raii::CommandBuffer const* cmdBuffer;
+		RecorderStatistics statistics;
+		bool filtering;
+
+		// graphics then compute
+		std::array<Tracked<vk::Pipeline>, 2> pipelines;
+		std::array<std::array<Tracked<SetBinding>, MAX_DESCRIPTOR_SETS>, 2> descriptorSets;
+		std::array<Tracked<VertexBinding>, MAX_VERTEX_BINDINGS> vertexBuffers;
+		Tracked<IndexBinding> indexBuffer;
+
+		vk::PipelineLayout pushLayout;
+		vk::ShaderStageFlags pushStages;
+		std::array<uint8_t, PUSH_CONSTANT_BYTES> pushValues;
+		std::array<bool, PUSH_CONSTANT_BYTES> pushValid;
+
+		Tracked<vk::Viewport> viewport;
+		Tracked<vk::Rect2D> scissor;
+		Tracked<vk::PrimitiveTopology> topology;
+		Tracked<bool> primitiveRestart;
+		Tracked<bool> rasterizerDiscard;
+		Tracked<vk::CullModeFlags> cullMode;
+		Tracked<vk::FrontFace> frontFace;
+		Tracked<bool> depthBiasEnable;
+		Tracked<DepthBias> depthBias;
+		Tracked<float> lineWidth;
+		Tracked<bool> depthTest;
+		Tracked<bool> depthWrite;
+		Tracked<vk::CompareOp> depthCompareOp;
+		Tracked<bool> depthBoundsTest;
+		Tracked<bool> stencilTest;
+		Tracked<vk::PolygonMode> polygonMode;
+		Tracked<bool> depthClamp;
+		Tracked<bool> logicOpEnable;
+		Tracked<bool> blendEnable;
+		Tracked<vk::ColorBlendEquationEXT> blendEquation;
+		Tracked<vk::ColorComponentFlags> colourWriteMask;
+
+		// true when the call has to go to the command buffer, the value is remembered either way
+		template<typename T>
+		bool update(Tracked<T>& tracked, T const& value) {
+			if (filtering && tracked.valid && tracked.value == value) {
+				++statistics.elided;
+				return false;
+			}
+
+			tracked.value = value;
+			tracked.valid = true;
+			++statistics.issued;
+			return true;
+		}
+
+		static uint32_t getBindPointIndex(vk::PipelineBindPoint const& bindPoint);
+	public:
+		CommandRecorder();
+
+		CommandRecorder(CommandRecorder const& copyFrom) = delete;
+		CommandRecorder& operator=(CommandRecorder const& assignFrom) = delete;
+
+		// a freshly begun command buffer has nothing bound, so this forgets everything and zeroes the statistics
+		void begin(vk::raii::CommandBuffer const& cmdBuffer);
+		// after anything recorded around the recorder that may have changed state
+		void invalidate();
+		// off still counts every call as issued, for comparing against the filtered numbers
+		void setFiltering(bool const& enable);
+
+		void bindPipeline(vk::PipelineBindPoint const& bindPoint, vk::Pipeline const& pipeline);
+		// calls with dynamic offsets are always issued
+		void bindDescriptorSets(vk::PipelineBindPoint const& bindPoint, vk::PipelineLayout const& layout, uint32_t const& firstSet, vk::ArrayProxy<const vk::DescriptorSet> const& sets, vk::ArrayProxy<const uint32_t> const& dynamicOffsets);
+		void bindVertexBuffers(uint32_t const& firstBinding, vk::ArrayProxy<const vk::Buffer> const& buffers, vk::ArrayProxy<const vk::DeviceSize> const& offsets);
+		void bindIndexBuffer(vk::Buffer const& buffer, vk::DeviceSize const& offset, vk::IndexType const& type);
+		void pushConstants(vk::PipelineLayout const& layout, vk::ShaderStageFlags const& stages, uint32_t const& offset, uint32_t const& size, void const* values);
+
+		// first viewport and scissor and first colour attachment only, which is all the engine uses
+		void setViewport(vk::Viewport const& value);
+		void setScissor(vk::Rect2D const& value);
+		void setPrimitiveTopology(vk::PrimitiveTopology const& value);
+		void setPrimitiveRestartEnable(bool const& value);
+		void setRasterizerDiscardEnable(bool const& value);
+		void setCullMode(vk::CullModeFlags const& value);
+		void setFrontFace(vk::FrontFace const& value);
+		void setDepthBiasEnable(bool const& value);
+		void setDepthBias(float const& constantFactor, float const& clamp, float const& slopeFactor);
+		void setLineWidth(float const& value);
+		void setDepthTestEnable(bool const& value);
+		void setDepthWriteEnable(bool const& value);
+		void setDepthCompareOp(vk::CompareOp const& value);
+		void setDepthBoundsTestEnable(bool const& value);
+		void setStencilTestEnable(bool const& value);
+		void setPolygonMode(vk::PolygonMode const& value);
+		void setDepthClampEnable(bool const& value);
+		void setLogicOpEnable(bool const& value);
+		void setColourBlendEnable(bool const& value);
+		void setColourBlendEquation(vk::ColorBlendEquationEXT const& value);
+		void setColourWriteMask(vk::ColorComponentFlags const& value);
+
+		void drawIndexed(uint32_t const& indexCount, uint32_t const& instanceCount, uint32_t const& firstIndex, int32_t const& vertexOffset, uint32_t const& firstInstance);
+
+		vk::raii::CommandBuffer const& getCommandBuffer() const;
+		RecorderStatistics const& getStatistics() const;
+	};
+}
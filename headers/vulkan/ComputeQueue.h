@@ -0,0 +1,48 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <vector>
+
+namespace Vulkan {
+	// compute work on a queue of its own family, ordered against the graphics queue with one timeline semaphore per queue
+	// graphics signals its timeline once per frame and a compute batch waits on that value, the next graphics frame waits on the compute timeline in turn
+	// images crossing between the two families are handed over with a release on one queue and a matching acquire on the other
+	class ComputeQueue {
+	private:
+		vk::raii::CommandPool pool;
+		std::vector<vk::raii::CommandBuffer> slotBuffers;
+		vk::raii::Semaphore graphicsTimeline;
+		vk::raii::Semaphore computeTimeline;
+		uint64_t graphicsValue;
+		uint64_t computeValue;
+		// the compute value each slot's last batch signals, 0 before its first one
+		std::vector<uint64_t> slotValues;
+		uint32_t graphicsFamily;
+		uint32_t computeFamily;
+		uint64_t submittedCount;
+	public:
+		ComputeQueue(vk::raii::Device const& device, uint32_t const& graphicsFamily, uint32_t const& computeFamily, uint32_t const& frameSlotCount);
+
+		ComputeQueue(ComputeQueue const& copyFrom) = delete;
+		ComputeQueue& operator=(ComputeQueue const& assignFrom) = delete;
+
+		// the slot's last batch is done on the GPU, after this its command buffer and whatever it wrote to host memory are free to touch
+		void frameCompleted(vk::raii::Device const& device, uint32_t const& slot);
+		// for the graphics submit, the compute batch before it has finished by the time these stages run
+		vk::SemaphoreSubmitInfo getGraphicsWait(vk::PipelineStageFlags2 const& stages) const;
+		// for the graphics submit, the next compute batch waits on this value
+		vk::SemaphoreSubmitInfo signalGraphics();
+
+		vk::raii::CommandBuffer const& begin(uint32_t const& slot);
+		// waits on the last graphics value at the given stages, so submit it after the graphics frame it follows
+		void submit(vk::raii::Queue const& queue, uint32_t const& slot, vk::PipelineStageFlags2 const& waitStages);
+
+		// the layout stays as it is, the release's destination and the acquire's source scopes are ignored by the other queue
+		vk::ImageMemoryBarrier2 releaseToCompute(vk::Image const& image, vk::ImageSubresourceRange const& range, vk::ImageLayout const& layout, vk::PipelineStageFlags2 const& srcStages, vk::AccessFlags2 const& srcAccess) const;
+		vk::ImageMemoryBarrier2 acquireFromGraphics(vk::Image const& image, vk::ImageSubresourceRange const& range, vk::ImageLayout const& layout, vk::PipelineStageFlags2 const& dstStages, vk::AccessFlags2 const& dstAccess) const;
+
+		uint32_t getGraphicsFamily() const;
+		uint32_t getComputeFamily() const;
+		uint64_t getSubmittedCount() const;
+	};
+}
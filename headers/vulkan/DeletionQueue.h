@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <vector>
+#include <variant>
+
+namespace Vulkan {
+	// objects the CPU is done with but frames already submitted may still use, the swapchain replaced on a resize for one
+	// each is kept until every frame submitted before it was retired has had its fence waited on, plus one more round of frames in flight
+	// the presentation engine never says when it has let go of a retired swapchain's images, the extra round covers that
+	class DeletionQueue {
+	public:
+		using RetiredObject = std::variant<std::monostate, vk::raii::SwapchainKHR, vk::raii::ImageView, vk::raii::Image, vk::raii::DeviceMemory, vk::raii::Buffer, vk::raii::Semaphore, vk::raii::DescriptorSet, vk::raii::DescriptorPool>;
+	private:
+		struct Entry {
+			uint64_t releaseSerial;
+			RetiredObject object;
+		};
+
+		// in the order they were retired, which is also the order they are destroyed in
+		std::vector<Entry> entries;
+		// serial of the last frame submitted from each slot and whether its fence has not been waited on since
+		std::vector<uint64_t> slotSerials;
+		std::vector<bool> slotPending;
+		uint64_t nextSerial;
+		uint64_t releasedCount;
+
+		void release(uint64_t const& completedSerial);
+	public:
+		DeletionQueue(uint32_t const& frameSlotCount);
+
+		DeletionQueue(DeletionQueue const& copyFrom) = delete;
+		DeletionQueue& operator=(DeletionQueue const& assignFrom) = delete;
+
+		void retire(RetiredObject&& object);
+		// moves every element in and leaves the vector empty, views should go before the images and memory they use and sets before their pool
+		template<typename T>
+		void retireAll(std::vector<T>& objects) {
+			for (T& object : objects) {
+				retire(std::move(object));
+			}
+			objects.clear();
+		}
+
+		void frameSubmitted(uint32_t const& slot);
+		// called once the slot's fence has been waited on, destroys whatever no frame can still be using
+		void frameCompleted(uint32_t const& slot);
+		// the GPU must be idle, destroys everything
+		void flush();
+
+		size_t getPendingCount() const;
+		uint64_t getReleasedCount() const;
+	};
+}
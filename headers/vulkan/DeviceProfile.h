@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Vulkan {
+	// the device a full selection picked and what it offered, saved so the next launch on the same device and driver can skip rating them all
+	// binary, little endian, anything unreadable or from another version is treated as no profile and the devices are rated again
+	struct DeviceProfile {
+		static constexpr char MAGIC[4] = { 'G', 'H', 'D', 'P' };
+		static constexpr uint32_t VERSION = 1;
+
+		uint32_t vendorId;
+		uint32_t deviceId;
+		// a driver update can change what the device supports, so it invalidates the profile
+		uint32_t driverVersion;
+		// of the api version, extensions, features and queue families asked for, a different request rates the devices again
+		uint64_t requirementsHash;
+		// vk::PhysicalDeviceType
+		uint32_t deviceType;
+		uint64_t deviceLocalBytes;
+		uint32_t score;
+		// the optional extensions the device has, device creation takes them from here instead of enumerating them again
+		std::vector<std::string> optionalExtensions;
+
+		// false when there is no usable profile at the path
+		static bool load(std::string const& path, DeviceProfile& profile);
+		// a failed write only costs the next launch a full selection, so it is reported and otherwise ignored
+		void save(std::string const& path) const;
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace Vulkan {
+	// the top field of every key, so the sorted list is grouped by pass and each pass finds its draws in one range
+	enum class DrawPass : uint8_t {
+		eDepthPrepass = 0,
+		eScene = 1,
+		eOverdraw = 2
+	};
+
+	// most significant first: pass 4 bits, pipeline 16, material 12, mesh 16, depth 16
+	// sorting by it groups draws by the state that is most expensive to switch, depth only orders draws that share everything else
+	struct SortKey {
+		static constexpr uint32_t DEPTH_BITS = 16;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t MATERIAL_BITS = 12;
+		static constexpr uint32_t PIPELINE_BITS = 16;
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint64_t DEPTH_MASK = (uint64_t(1) << DEPTH_BITS) - 1;
+
+		// depth in [0, 1] with 0 nearest, clamped, front to back for opaque passes, a pass drawn back to front hands in 1 - depth
+		// ids wider than their field are truncated, the caller keeps them in range
+		static uint64_t make(DrawPass const& pass, uint32_t const& pipeline, uint32_t const& material, uint32_t const& mesh, float const& depth);
+		static DrawPass getPass(uint64_t const& key);
+		static uint32_t getPipeline(uint64_t const& key);
+		static uint32_t getMaterial(uint64_t const& key);
+		static uint32_t getMesh(uint64_t const& key);
+	};
+
+	// where a mesh sits in the shared vertex and index buffers, with its object space bounds for culling
+	struct MeshRange {
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// the instance range picks the per instance data, draws of the same mesh with neighbouring ranges become one instanced draw
+	struct DrawPacket {
+		uint64_t key;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	struct DrawBatch {
+		uint64_t key;
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+		uint32_t packetCount;
+	};
+
+	struct DrawListStatistics {
+		uint32_t packets;
+		uint32_t batches;
+		// byte passes the radix sort actually ran, bytes that are the same in every key are skipped
+		uint32_t sortPasses;
+	};
+
+	// systems submit packets during the frame, build sorts them and merges the ones that can share a draw call
+	// the vectors keep their capacity between frames, a steady scene builds without allocating
+	class DrawList {
+	private:
+		std::vector<MeshRange> meshes;
+		std::vector<DrawPacket> packets;
+		std::vector<DrawPacket> scratch;
+		std::vector<DrawBatch> batches;
+		// the previous build's batches, to tell whether anything that ends up in a recording changed
+		std::vector<DrawBatch> previousBatches;
+		DrawListStatistics statistics;
+
+		// least significant digit first and stable, packets with equal keys keep the order they were submitted in
+		void sort();
+		void merge();
+	public:
+		DrawList();
+
+		uint32_t addMesh(MeshRange const& mesh);
+		MeshRange const& getMesh(uint32_t const& id) const;
+
+		void submit(DrawPacket const& packet);
+		// true when the batches differ from the previous build in anything but depth, a depth change alone records the same calls
+		bool build();
+		// forgets the packets but keeps the batches of the last build until the next one
+		void clear();
+
+		std::span<const DrawBatch> getBatches(DrawPass const& pass) const;
+		DrawListStatistics const& getStatistics() const;
+	};
+}
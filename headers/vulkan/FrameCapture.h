@@ -0,0 +1,92 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/DeletionQueue.h"
+#include "general/ThreadPool.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <string>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	enum class CaptureMode {
+		eOff,
+		eOneShot,
+		eEveryNth,
+		eContinuous
+	};
+
+	enum class CaptureFormat {
+		ePng,
+		eRaw
+	};
+
+	struct CaptureSettings {
+		CaptureMode mode;
+		// for eEveryNth, a frame is captured when its number is a multiple of this
+		uint32_t interval;
+		CaptureFormat format;
+		std::string directory;
+	};
+
+	// copies the presented image into a ring of host buffers inside the frame's own command buffer
+	// a copy is picked up once the engine has waited on that frame's fence and handed to encoder threads, nothing ever waits for it
+	// if every buffer is still in flight or being encoded the frame is dropped from the capture instead of stalling
+	class FrameCapture {
+	private:
+		enum class SlotState : uint32_t {
+			eFree,
+			eCopying,
+			eEncoding
+		};
+
+		struct Slot {
+			vk::raii::Buffer buffer = nullptr;
+			vk::raii::DeviceMemory memory = nullptr;
+			void* address = nullptr;
+			std::atomic<SlotState> state = SlotState::eFree;
+			uint32_t frameIndex = 0;
+			uint64_t frameNumber = 0;
+		};
+
+		std::vector<std::unique_ptr<Slot>> slots;
+		CaptureSettings settings;
+		vk::Extent2D extent;
+		vk::Format format;
+		bool coherent;
+		vk::Device device;
+		DeviceDispatcher const* dispatcher;
+
+		uint32_t ringSize;
+		uint64_t frameNumber;
+		std::atomic<uint64_t> capturedCount;
+		std::atomic<uint64_t> droppedCount;
+		std::unique_ptr<General::ThreadPool> encoders;
+
+		bool isCaptureFrame() const;
+		void encode(Slot& slot);
+	public:
+		FrameCapture(uint32_t const& ringSize, uint32_t const& encoderCount);
+		~FrameCapture();
+
+		FrameCapture(FrameCapture const& copyFrom) = delete;
+		FrameCapture& operator=(FrameCapture const& assignFrom) = delete;
+
+		// recreates the ring for the new image size, finishes pending encodes first, copies still in flight are dropped and their buffers go into the deletion queue
+		void resize(GraphicsContext& context, vk::Extent2D const& newExtent, vk::Format const& newFormat, DeletionQueue& deletionQueue);
+		// hands the copies recorded the last time this frame slot was used to the encoders
+		void beginFrame(uint32_t const& frameIndex);
+		// image is already in transfer source layout, the render graph puts it there whenever capturing is on, call once per frame
+		// counts the frame and records the copy if the trigger fires and a buffer is free
+		bool recordCopy(vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, uint32_t const& frameIndex);
+
+		void setSettings(CaptureSettings const& newSettings);
+		CaptureSettings const& getSettings() const;
+		bool isActive() const;
+		bool isSized() const;
+		uint64_t getCapturedCount() const;
+		uint64_t getDroppedCount() const;
+	};
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "general/RollingPercentiles.h"
+#include <vector>
+#include <utility>
+
+namespace Vulkan {
+	struct GpuFrameSample {
+		uint64_t frameNumber;
+		const char* zone;
+		double milliseconds;
+	};
+
+	// timestamp queries with one pool per frame in flight, a slot is read back when the engine comes round to record it again
+	// by then its fence has been waited on, so with two frames in flight the results are frame N-2's and reading never stalls
+	class GpuProfiler {
+	private:
+		struct Zone {
+			const char* name;
+			uint32_t beginQuery;
+			uint32_t endQuery;
+		};
+
+		std::vector<vk::raii::QueryPool> pools;
+		std::vector<std::vector<Zone>> frameZones;
+		std::vector<uint32_t> usedQueries;
+		std::vector<bool> awaitingResults;
+		std::vector<uint64_t> results;
+		std::vector<std::pair<const char*, General::RollingPercentiles>> zoneTimes;
+		std::vector<uint64_t> slotFrameNumbers;
+		std::vector<GpuFrameSample>* frameHistory;
+
+		uint32_t queriesPerFrame;
+		uint32_t windowSize;
+		uint32_t currentFrame;
+		uint64_t frameNumber;
+		double timestampPeriod;
+		uint64_t timestampMask;
+		bool supported;
+
+		void collect(uint32_t const& frameIndex);
+		General::RollingPercentiles& getZoneTimes(const char* name);
+	public:
+		static constexpr uint32_t WINDOW_SIZE = 240;
+
+		GpuProfiler(vk::raii::Device const& device, vk::raii::PhysicalDevice const& physicalDevice, uint32_t const& queueFamilyIndex, uint32_t const& framesInFlightCount, uint32_t const& maxZonesPerFrame);
+
+		GpuProfiler(GpuProfiler const& copyFrom) = delete;
+		GpuProfiler& operator=(GpuProfiler const& assignFrom) = delete;
+
+		// reads what the slot measured last time, then resets its pool, call before the first zone of the command buffer
+		void beginFrame(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex);
+		// instead of beginFrame when the slot resubmits a command buffer recorded earlier, the zones it recorded then are expected again
+		void replayFrame(uint32_t const& frameIndex);
+		uint32_t beginZone(vk::raii::CommandBuffer const& cmdBuffer, const char* name);
+		void endZone(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& zone);
+
+		// milliseconds, nullptr until the zone has been read back at least once
+		General::RollingPercentiles const* getZoneStats(const char* name) const;
+		// drops every sample so far, zones then keep up to windowSize samples each
+		void resetStatistics(uint32_t const& newWindowSize);
+		// every zone read back from now on is also appended to history with the number of the frame it came from, nullptr stops it
+		void setFrameHistory(std::vector<GpuFrameSample>* history);
+		// reads every slot still waiting, only once the device is idle
+		void flush();
+		// the number the next beginFrame hands out, counting from 0
+		uint64_t getFrameNumber() const;
+		bool isSupported() const;
+	};
+
+	class GpuZone {
+	private:
+		GpuProfiler& profiler;
+		vk::raii::CommandBuffer const& cmdBuffer;
+		uint32_t zone;
+	public:
+		GpuZone(GpuProfiler& profiler, vk::raii::CommandBuffer const& cmdBuffer, const char* name);
+		~GpuZone();
+
+		GpuZone(GpuZone const& copyFrom) = delete;
+		GpuZone& operator=(GpuZone const& assignFrom) = delete;
+	};
+}
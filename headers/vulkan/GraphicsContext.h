@@ -1,13 +1,19 @@
 #pragma once
 
 #include "vulkan/VulkanContext.h"
+#include "vulkan/PipelineRegistry.h"
+#include "vulkan/DeletionQueue.h"
 #include "general/Vertex.h"
 #include "general/VertexTransformations.h"
 #include <tuple>
 #include <string>
+#include <memory>
 
 namespace Vulkan {
 	class GraphicsEngine;
+	class OverdrawMeter;
+	class FrameCapture;
+	class RenderGraph;
 
 	struct GraphicsContextInitInfo {
 		vk::SurfaceFormatKHR scFormat;
@@ -23,27 +29,60 @@ namespace Vulkan {
 		std::vector<vk::DescriptorSetLayoutBinding> descriptorSetLayoutBindings;
 		std::tuple<uint32_t, uint32_t, vk::SharingMode> uniformBufferInfo;
 
-		std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*>> const& gpShaderStageInfos;
+		std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*, SpecializationConstants>> const& gpShaderStageInfos;
+		ShaderVariantKey gpShaderVariant;
+		std::vector<std::shared_ptr<SprivBinary const>> gpPreloadedShaders;
 		std::tuple<vk::VertexInputBindingDescription, std::vector<vk::VertexInputAttributeDescription>> gpVertexInputInfo;
 		std::tuple<vk::PrimitiveTopology, bool> gpInputAssemblyInfo;
 		std::tuple<std::array<float, 6>, std::array<uint32_t, 4>> gpViewportStateInfo;
 		std::tuple<bool, bool, vk::PolygonMode, vk::CullModeFlagBits, vk::FrontFace, bool, float, float, float, float> gpRasterizationInfo;
-		// MULTISAMPLING INFO MISSING NANA
+		// lowered to the most both the colour and depth attachments support, e1 renders straight into the swapchain
+		vk::SampleCountFlagBits gpSampleCount;
 		std::tuple<
 			std::vector<std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags>>,
 			std::tuple<bool, vk::LogicOp, std::array<float, 4>>> gpColourBlendingInfo;
 		std::vector<vk::DynamicState> dynamicStates;
+		uint32_t gpCompileWorkerCount;
 
 		std::tuple<vk::SharingMode, std::vector<General::Vertex>> verticiesBufferInfo;
 		std::vector<uint32_t> indexBufferData;
 	};
 
+	// values for the state the pipeline leaves dynamic, the engine sets them at record time so one pipeline serves every variant
+	struct DynamicRasterState {
+		vk::PrimitiveTopology topology;
+		bool primitiveRestart;
+		bool rasterizerDiscard;
+		bool depthClamp;
+		vk::PolygonMode polygonMode;
+		vk::CullModeFlags cullMode;
+		vk::FrontFace frontFace;
+		bool depthBias;
+		float depthBiasConstantFactor;
+		float depthBiasClamp;
+		float depthBiasSlopeFactor;
+		float lineWidth;
+		bool depthTest;
+		bool depthWrite;
+		vk::CompareOp depthCompareOp;
+		bool depthBoundsTest;
+		bool stencilTest;
+		bool logicOpEnable;
+		bool blendEnable;
+		vk::ColorBlendEquationEXT blendEquation;
+		vk::ColorComponentFlags colourWriteMask;
+	};
+
 	class GraphicsContext {
 	private:
 		VulkanContext context;
 		vk::raii::SwapchainKHR swapchain;
+		// fetched once per swapchain, frames index these instead of asking the swapchain or the surface again
+		std::vector<vk::Image> scImages;
 		std::vector<vk::raii::ImageView> scImageViews;
-		vk::raii::Pipeline graphicsPipeline;
+		vk::Extent2D scExtent;
+		// picked once before any pipeline is built, so every swapchain and every pipeline rendering into it agree on it
+		vk::SurfaceFormatKHR scFormat;
 
 		vk::raii::Buffer verticiesBuffer;
 		vk::raii::DeviceMemory verticiesBufferMemory;
@@ -51,6 +90,9 @@ namespace Vulkan {
 		vk::raii::DeviceMemory indicesBufferMemory;
 		uint32_t verticiesCount;
 		uint32_t indicesCount;
+		// object space, the vertices are flat so z is 0 on both
+		glm::vec3 verticiesBoundsMin;
+		glm::vec3 verticiesBoundsMax;
 
 		vk::raii::DescriptorSetLayout descriptorSetLayout;
 		// KIND OF HARD CODED NANA
@@ -60,16 +102,37 @@ namespace Vulkan {
 		vk::raii::DescriptorPool descriptorSetPool;
 		std::vector<vk::raii::DescriptorSet> descriptorSets;
 		vk::raii::PipelineLayout pipelineLayout;
+		std::unique_ptr<ShaderModuleCache> shaderModuleCache;
+		std::unique_ptr<PipelineRegistry> pipelineRegistry;
+		PipelineRegistry::PipelineId graphicsPipeline;
+		std::vector<vk::DynamicState> dynamicStates;
+		// the scene's depth attachment, sampled as well by the hi-z build
+		vk::Format depthFormat;
+		// the scene's attachments are multisampled and resolved at the end of its pass when this is above e1
+		vk::SampleCountFlagBits sampleCount;
+		// how the multisampled depth is resolved for the hi-z build, max keeps it conservative where supported
+		vk::ResolveModeFlagBits depthResolveMode;
+		DynamicRasterState defaultRasterState;
+		PipelineDescription pipelineDescription;
 
 		std::tuple<vk::SurfaceFormatKHR, uint32_t, vk::PresentModeKHR, vk::ImageUsageFlags, vk::ImageAspectFlags, vk::SharingMode, uint32_t, uint32_t*, vk::SurfaceTransformFlagBitsKHR> savedScConfigInfo;
-		void recreateSwapchain();
+		// nothing is waited on, whatever the old swapchain's frames still use goes into the deletion queue
+		void recreateSwapchain(DeletionQueue& deletionQueue);
 
-		void initSwapchainAndImageViews(vk::SurfaceFormatKHR const& desiredFormat, uint32_t const& desiredImageCount, vk::PresentModeKHR const& desiredPresentMode, vk::ImageUsageFlags const& imageUsage, vk::ImageAspectFlags const& imageViewAspect, vk::SharingMode const& sharingMode, uint32_t const& queueFamilyAccessorCount, uint32_t* queueFamilyAccessorIndiceList, vk::SurfaceTransformFlagBitsKHR const& preTransform);
+		void initSwapchainAndImageViews(uint32_t const& desiredImageCount, vk::PresentModeKHR const& desiredPresentMode, vk::ImageUsageFlags const& imageUsage, vk::ImageAspectFlags const& imageViewAspect, vk::SharingMode const& sharingMode, uint32_t const& queueFamilyAccessorCount, uint32_t* queueFamilyAccessorIndiceList, vk::SurfaceTransformFlagBitsKHR const& preTransform, vk::SwapchainKHR const& oldSwapchain);
 		void initDescriptorSetLayout(std::vector<vk::DescriptorSetLayoutBinding> const& bindings);
 		void initUniformBuffers(std::tuple<uint32_t, uint32_t, vk::SharingMode> const& uboInfo);
-		void createDescriptorPool();
+		// room for the two sets with every binding of the layout
+		void createDescriptorPool(std::vector<vk::DescriptorSetLayoutBinding> const& bindings);
 		void createDescriptorSets();
-		void initGraphicsPipeline(std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*>> const& shaderStageInfos, std::tuple<vk::VertexInputBindingDescription, std::vector<vk::VertexInputAttributeDescription>> const& vInfo, std::tuple<vk::PrimitiveTopology, bool> const& inAssemInfo, std::tuple<std::array<float, 6>, std::array<uint32_t, 4>> const& viewInfo, std::tuple<bool, bool, vk::PolygonMode, vk::CullModeFlagBits, vk::FrontFace, bool, float, float, float, float> const& rasInfo, std::tuple<std::vector<std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags>>, std::tuple<bool, vk::LogicOp, std::array<float, 4>>> const& cBlendInfo, std::vector<vk::DynamicState> const& dyInfo);
+		void initPipelineLayout();
+		void initGraphicsPipeline(ShaderVariantKey const& variant, uint32_t const& compileWorkerCount, std::vector<std::shared_ptr<SprivBinary const>> const& preloadedShaders);
+		vk::Format getDepthFormat();
+		vk::SampleCountFlagBits getSampleCount(vk::SampleCountFlagBits const& requested);
+		vk::ResolveModeFlagBits getDepthResolveMode();
+		std::vector<vk::DynamicState> getSupportedDynamicStates(std::vector<vk::DynamicState> const& requested);
+		DynamicRasterState getRasterState(PipelineDescription const& description);
+		PipelineDescription getPipelineDescription(std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*, SpecializationConstants>> const& shaderStageInfos, std::tuple<vk::VertexInputBindingDescription, std::vector<vk::VertexInputAttributeDescription>> const& vInfo, std::tuple<vk::PrimitiveTopology, bool> const& inAssemInfo, std::tuple<std::array<float, 6>, std::array<uint32_t, 4>> const& viewInfo, std::tuple<bool, bool, vk::PolygonMode, vk::CullModeFlagBits, vk::FrontFace, bool, float, float, float, float> const& rasInfo, std::tuple<std::vector<std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags>>, std::tuple<bool, vk::LogicOp, std::array<float, 4>>> const& cBlendInfo, std::vector<vk::DynamicState> const& dyInfo);
 		void initVertexBuffer(std::tuple<vk::SharingMode, std::vector<General::Vertex>> const& vbInfo);
 		void initIndexBuffer(std::vector<uint32_t> const& indexBufferData);
 
@@ -78,15 +141,19 @@ namespace Vulkan {
 		uint32_t getScImageCount(uint32_t const& desiredImageCount);
 		vk::PresentModeKHR getScPresentMode(vk::PresentModeKHR const& desiredPresentMode);
 
-		std::vector<vk::PipelineShaderStageCreateInfo> getConfigurableShaderStageInfos(std::vector<std::tuple<vk::ShaderStageFlagBits, vk::raii::ShaderModule, const char*>> const& infos);
-		vk::raii::ShaderModule getShaderModule(std::string const& sprivPath);
-		std::vector<char> fileBytes(std::string const& path);
 
 		void createBufferAndMemory(vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory, vk::MemoryPropertyFlags const& properties, uint32_t const& size, vk::BufferUsageFlags const& usage, vk::SharingMode const& sharingMode);
 		void copyBuffer(vk::raii::Buffer& src, vk::raii::Buffer& dst, uint32_t const& qfIndex, uint32_t const& srcOff, uint32_t const& dstOff, uint32_t const& size);
 		uint32_t getSuitableMemoryTypeIndex(uint32_t filter, vk::MemoryPropertyFlags const& requiredProperties);
 	public:
 		friend class GraphicsEngine;
+		friend class OverdrawMeter;
+		friend class FrameCapture;
+		friend class RenderGraph;
+		friend class OcclusionCuller;
+		friend class TextureStreamer;
+		friend class MipGenerator;
+		friend struct BenchmarkAccess;
 
 		GraphicsContext(VulkanContext&& context, GraphicsContextInitInfo const& initInfo);
 		GraphicsContext(GraphicsContext&& moveFrom);
@@ -95,5 +162,13 @@ namespace Vulkan {
 		GraphicsContext& operator=(GraphicsContext const& assignFrom) = delete;
 		
 		VulkanContext& getContext();
+		// same description as the default pipeline specialized for the variant, identical variants share one pipeline
+		PipelineRegistry::PipelineId requestPipelineVariant(ShaderVariantKey const& variant);
+		// the default pipeline with additive blending into a counter target, the fragment shader outputs one per fragment
+		PipelineRegistry::PipelineId requestOverdrawPipeline(vk::Format const& counterFormat);
+		// the default pipeline without its fragment stage or colour attachment, for filling the depth buffer ahead of the scene
+		PipelineRegistry::PipelineId requestDepthOnlyPipeline();
+		// compute pipelines are not part of the registry, the caller owns the result, the module comes from the shared cache
+		vk::raii::Pipeline createComputePipeline(std::string const& sprivPath, const char* entryPoint, vk::PipelineLayout const& layout);
 	};
 }
\ No newline at end of file
@@ -3,9 +3,25 @@
 #pragma once
 
 #include "vulkan/GraphicsContext.h"
+#include "vulkan/GpuProfiler.h"
+#include "vulkan/PipelineStatistics.h"
+#include "vulkan/OverdrawMeter.h"
+#include "vulkan/FrameCapture.h"
+#include "vulkan/OcclusionCuller.h"
+#include "vulkan/ComputeQueue.h"
+#include "vulkan/TextureStreamer.h"
+#include "vulkan/RenderGraph.h"
+#include "vulkan/CommandBufferCache.h"
+#include "vulkan/CommandRecorder.h"
+#include "vulkan/DrawList.h"
+#include "vulkan/BenchmarkReport.h"
+#include "general/RollingPercentiles.h"
+#include "general/ResolutionController.h"
+#include "general/SessionLog.h"
 #include <tuple>
 #include <string>
 #include <utility>
+#include <functional>
 
 namespace Vulkan {
 	struct GraphicsEngineInitInfo {
@@ -14,6 +30,13 @@ namespace Vulkan {
 		uint32_t framesInFlightCount;
 	};
 
+	// milliseconds spent on the CPU by the last frame that was submitted
+	struct FrameTiming {
+		double cpuWork;
+		double cpuRecord;
+		double cpuSubmit;
+	};
+
 	class GraphicsEngine {
 	private:
 		GraphicsContext graphicsContext;
@@ -22,12 +45,81 @@ namespace Vulkan {
 		std::vector<vk::raii::Semaphore> readyToRender;
 		std::vector<vk::raii::Semaphore> renderingFinished;
 		std::vector<vk::raii::Fence> commandBufferFinished;
+		// what a resize or a rebuild replaces is destroyed from here once the frames using it are done, nothing waits for the GPU to go idle
+		std::unique_ptr<DeletionQueue> deletionQueue;
 
 		uint32_t frameInFlight;
 		const uint32_t FRAMES_IN_FLIGHT_COUNT;
 
+		DynamicRasterState rasterState;
+		PipelineRegistry::PipelineId requestedPipeline;
+
+		std::unique_ptr<GpuProfiler> gpuProfiler;
+		// frame is the time between presents, work leaves out the fence, acquire and present waits
+		General::RollingPercentiles cpuFrameTimes;
+		General::RollingPercentiles cpuWorkTimes;
+		General::RollingPercentiles cpuRecordTimes;
+		General::RollingPercentiles cpuSubmitTimes;
+		std::unique_ptr<PipelineStatistics> pipelineStatistics;
+		std::unique_ptr<OverdrawMeter> overdrawMeter;
+		PipelineRegistry::PipelineId overdrawPipeline;
+		std::unique_ptr<FrameCapture> frameCapture;
+		// tests the draws against a depth pyramid read back from earlier frames, the pyramid is built from every frame's depth while it is on
+		std::unique_ptr<OcclusionCuller> occlusionCuller;
+		// only with a dedicated compute family, the hi-z build and readback then run there instead of in the graphics recording
+		std::unique_ptr<ComputeQueue> computeQueue;
+		// its uploads go into the same submit as the frame, ahead of it
+		std::unique_ptr<TextureStreamer> textureStreamer;
+		PipelineRegistry::PipelineId depthOnlyPipeline;
+		bool depthPrepass;
+		// scales the extent everything up to the upscale renders at from the GPU frame time, the swapchain extent while it is off
+		General::ResolutionController resolutionController;
+		bool dynamicResolution;
+		vk::Extent2D renderExtent;
+
+		// rebuilt when the swapchain is recreated or a pass is switched on or off, the passes capture this engine
+		RenderGraph renderGraph;
+		uint32_t swapchainResource;
+		bool graphHasOverdraw;
+		bool graphHasCapture;
+		bool graphHasPrepass;
+		bool graphHasOcclusion;
+		// the single sampled depth the hi-z build reads, handed to the compute queue at the end of the graph
+		uint32_t hiZDepthResource;
+		vk::Extent2D graphRenderExtent;
+		bool renderGraphDump;
+		// static frames resubmit what was recorded for their swapchain image and slot
+		std::unique_ptr<CommandBufferCache> commandBufferCache;
+		// every pass of a recording draws through it, its statistics are the last recording's
+		CommandRecorder recorder;
+		// collected and sorted every frame even when the recording is reused, a change in its batches invalidates the cache
+		DrawList drawList;
+		uint32_t sceneMesh;
+		// what collectDraws culled with, the occlusion culler pairs it with the slot's readback once the frame is submitted
+		glm::mat4 frameViewProjection;
+		TextureStreamer::TextureId sceneTexture;
+		// the streamer's view version each slot's descriptor set was last written with
+		std::vector<uint64_t> slotTextureVersions;
+
+		// the scene is animated from simulationTime, which the loops advance by real, fixed or replayed deltas
+		double simulationTime;
+		General::CameraState camera;
+		FrameTiming lastFrameTiming;
+		uint64_t submittedFrameCount;
+
+		std::unique_ptr<General::SessionRecorder> sessionRecorder;
+		std::vector<General::InputEvent> pendingEvents;
+		std::vector<General::SpawnedObject> pendingSpawns;
+		std::function<void(General::SpawnedObject const&)> spawnHandler;
+
 		bool windowResized;
 		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+		static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+		static void cursorPositionCallback(GLFWwindow* window, double x, double y);
+		static void scrollCallback(GLFWwindow* window, double x, double y);
+		void queueInputEvent(General::InputEvent const& event);
+		void recordSessionFrame(double const& deltaTime);
 		void windowResizedAlert();
 		void recreateSemaphores();
 
@@ -35,14 +127,95 @@ namespace Vulkan {
 		void initCommandBuffers(std::tuple<uint32_t, vk::CommandBufferLevel, uint32_t> const& bufInfos);
 		void initSemaphores(uint32_t const& count);
 		void initFences(uint32_t const& count);
+		void initGpuProfiler();
+		void initFrameStatistics();
+		void initTextures();
+		void printFrameTimings(uint32_t const& fps);
+		void printFrameStatistics();
+		void resetFrameStatistics(uint32_t const& windowSize);
+		BenchmarkReport getBenchmarkReport(BenchmarkSettings const& settings, double const& wallTimeMs);
 
 		void renderAndPresentImage();
 		void updateUniformBuffer(uint32_t const& index);
+		void recordAsyncHiZ(vk::raii::CommandBuffer const& cmdBuffer);
+		vk::raii::CommandBuffer const& prepareCommandBuffer(uint32_t const& imageIndex);
 		void recordCommandBuffer(vk::raii::CommandBuffer const& buffer, vk::Image const& image, vk::ImageView const& imageView);
-		void transitionImageLayout(vk::raii::CommandBuffer const& buffer, vk::Image const& image, vk::ImageLayout const& old, vk::ImageLayout const& newX, vk::PipelineStageFlags2 const& srcStage, vk::AccessFlags2 const& srcAccess, uint32_t const& srcQfIndex, vk::PipelineStageFlags2 const& dstStage, vk::AccessFlags2 const& dstAccess, uint32_t const& dstQfIndex, vk::ImageSubresourceRange const& range);
+		bool collectDraws();
+		// pixels the world space box covers at the render extent, all of them when a corner is behind the camera
+		float getScreenCoverage(glm::vec3 const& worldMin, glm::vec3 const& worldMax) const;
+		void writeTextureDescriptor(uint32_t const& slot);
+		void recordDrawBatches(CommandRecorder& recorder, DrawPass const& pass, DynamicRasterState const& state, vk::Extent2D const& extent);
+		void recordBatch(CommandRecorder& recorder, vk::Pipeline const& pipeline, DynamicRasterState const& state, DrawBatch const& batch, vk::Extent2D const& extent);
+		vk::Extent2D getRenderExtent() const;
+		void applyDynamicState(CommandRecorder& recorder, DynamicRasterState const& state);
+		DynamicRasterState getOverdrawRasterState() const;
+		DynamicRasterState getDepthPrepassRasterState() const;
+		DynamicRasterState getSceneRasterState() const;
+		vk::Pipeline getDrawPipeline();
+		void buildRenderGraph(bool const& prepass, bool const& occlusion, bool const& overdraw, bool const& capture);
 	
 	public:
+		friend struct BenchmarkAccess;
+
+		// windowed only, runs until the window is closed
 		void runLoop();
+		// renders exactly settings.frameCount measured frames, works with or without a window, writes the report if a path is given
+		BenchmarkReport runBenchmark(BenchmarkSettings const& settings);
+		// drives the scene from the log instead of the clock and live input, writes the timings of every frame as CSV if a path is given
+		void runReplay(General::SessionReplay const& replay, std::string const& timingsPath);
+
+		// records every frame runLoop presents until stopRecording is called or the loop ends
+		void startRecording(std::string const& path);
+		void stopRecording();
+		void setCamera(General::CameraState const& state);
+		General::CameraState const& getCamera() const;
+		// hands the object to the spawn handler and records it, a replay calls the handler with the recorded spawns instead
+		void spawnObject(General::SpawnedObject const& object);
+		void setSpawnHandler(std::function<void(General::SpawnedObject const&)> handler);
+
+		// takes effect from the next recorded frame, only the states the device could make dynamic are applied
+		void setRasterState(DynamicRasterState const& state);
+		DynamicRasterState const& getRasterState() const;
+		// the current variant keeps being drawn until the new one has finished compiling
+		void setShaderVariant(ShaderVariantKey const& variant);
+
+		// both take effect from the next recorded frame and are reported with the timings once a second
+		void setPipelineStatisticsEnabled(bool const& enable);
+		std::vector<std::pair<const char*, PassStatistics>> const& getPipelineStatistics() const;
+		// creates the counter target when turned on, a previous one goes into the deletion queue
+		void setOverdrawEnabled(bool const& enable);
+		OverdrawResult const& getOverdraw() const;
+		// the prepass goes into the graph once its depth only pipeline has compiled, the scene then only tests against the depth it wrote
+		void setDepthPrepassEnabled(bool const& enable);
+		// creates the pyramid the first time it is turned on, stays off if the hi-z shader could not be loaded
+		void setOcclusionCullingEnabled(bool const& enable);
+		OcclusionStatistics const& getOcclusionStatistics() const;
+		// the scene's descriptor sets sample the texture at this binding
+		static constexpr uint32_t TEXTURE_BINDING = 1;
+		// 4 MiB a frame, levels up to 64 texels resident from the start
+		static constexpr TextureStreamingSettings DEFAULT_TEXTURE_STREAMING_SETTINGS = { .frameBudgetBytes = 4 * 1024 * 1024, .residentTailSize = 64 };
+		// the scene draws with the fallback until this is called, only between frames as the resident levels are uploaded right away
+		void loadSceneTexture(std::string const& path);
+		TextureStatistics const& getTextureStatistics() const;
+		// which path fills in the levels of textures loaded from here on, each path's GPU time is reported with the frame statistics
+		void setMipGenerationPath(MipPath const& path);
+		// 60 fps between half and full resolution, in steps of 5%
+		static constexpr General::ResolutionControllerSettings DEFAULT_RESOLUTION_SETTINGS = { .minScale = 0.5f, .maxScale = 1.0f, .targetMilliseconds = 1000.0 / 60.0, .proportionalGain = 0.5, .integralGain = 0.05, .step = 0.05f, .settleFrames = 4 };
+		// below the maximum scale the scene renders offscreen and is upscaled to the swapchain with a bilinear blit
+		void setDynamicResolution(General::ResolutionControllerSettings const& settings);
+		void setDynamicResolutionEnabled(bool const& enable);
+		float getResolutionScale() const;
+		// creates the readback buffers the first time capturing is turned on
+		void setCapture(CaptureSettings const& settings);
+		// one shot with the current directory and format
+		void captureNextFrame();
+		FrameCapture const& getFrameCapture() const;
+		// prints the compiled render graph with its barriers every time it is rebuilt
+		void setRenderGraphDumpEnabled(bool const& enable);
+		// on by default, off records every frame from scratch for comparison
+		void setCommandBufferCacheEnabled(bool const& enable);
+		// on by default, off issues every bind and state set even when it changes nothing, the counts are still kept
+		void setRedundantStateFiltering(bool const& enable);
 
 		GraphicsEngine(GraphicsContext&& context, GraphicsEngineInitInfo const& initInfo);
 		GraphicsEngine(GraphicsEngine&& moveFrom);
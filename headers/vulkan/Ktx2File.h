@@ -0,0 +1,51 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "general/MappedFile.h"
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Vulkan {
+	// size of a format's smallest addressable unit, a 4x4 block for the BC formats and a single texel for the rest
+	struct TexelBlock {
+		uint32_t width;
+		uint32_t height;
+		uint32_t bytes;
+	};
+
+	// a mapped KTX2 container holding one 2D image, the level data is only read in when it is asked for
+	// supercompressed files, arrays, cube maps and 3D images are rejected, and so is any format without a TexelBlock
+	class Ktx2File {
+	private:
+		struct Level {
+			uint64_t offset;
+			uint64_t length;
+		};
+
+		General::MappedFile file;
+		vk::Format format;
+		vk::Extent2D extent;
+		// level 0 is the full size image, every one after it half the one before
+		std::vector<Level> levels;
+	public:
+		static constexpr uint8_t IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		// BC1, BC3, BC4, BC5 and BC7, and 8 bit unorm with one, two or four channels, false for anything else
+		static bool getTexelBlock(vk::Format const& format, TexelBlock& block);
+		static bool isBlockCompressed(vk::Format const& format);
+		static uint64_t getLevelSize(vk::Format const& format, vk::Extent2D const& levelExtent);
+
+		// throws when the file is not a KTX2 container this can read, or its image is larger than maxDimension on either side
+		Ktx2File(std::string const& path, uint32_t const& maxDimension);
+
+		Ktx2File(Ktx2File const& copyFrom) = delete;
+		Ktx2File& operator=(Ktx2File const& assignFrom) = delete;
+
+		vk::Format getFormat() const;
+		vk::Extent2D getExtent() const;
+		vk::Extent2D getLevelExtent(uint32_t const& level) const;
+		uint32_t getLevelCount() const;
+		std::span<const uint8_t> getLevelData(uint32_t const& level) const;
+	};
+}
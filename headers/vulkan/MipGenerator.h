@@ -0,0 +1,105 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <vector>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	enum class MipPath : uint8_t {
+		// compute where the image and the device allow it, the blit chain otherwise
+		eAuto = 0,
+		eBlit = 1,
+		eCompute = 2
+	};
+
+	// images each path generated and the GPU time they took between them, from the timestamps around every recording
+	struct MipGenerationStatistics {
+		uint32_t blitImages;
+		uint32_t computeImages;
+		double blitMilliseconds;
+		double computeMilliseconds;
+	};
+
+	// fills levels 1 and up of an image from its level 0 on the GPU
+	// the blit chain halves one level at a time with a barrier between each, sRGB is filtered in linear space by the blit itself
+	// the compute path is a single dispatch: each workgroup reduces a 64x64 tile to one texel of level 6, reducing 2x2 texels across
+	// subgroup quads, and the last workgroup to bump a global counter carries on from level 6 down to level 12
+	// it reads an sRGB level 0 through an sRGB view and writes the levels through unorm views, encoding in the shader
+	class MipGenerator {
+	private:
+		friend struct BenchmarkAccess;
+
+		struct DownsampleConstants {
+			uint32_t sourceWidth;
+			uint32_t sourceHeight;
+			uint32_t tilesX;
+			uint32_t tilesY;
+			uint32_t levelCount;
+			uint32_t srgb;
+		};
+
+		// a recording whose views and set are kept until collect, with where its timestamps went
+		struct Pending {
+			MipPath path;
+			uint32_t firstQuery;
+		};
+
+		vk::raii::Sampler sampler;
+		vk::raii::DescriptorSetLayout setLayout;
+		vk::raii::PipelineLayout pipelineLayout;
+		vk::raii::Pipeline pipeline;
+		// the global counter the workgroups bump, and the level 6 texel of every tile for the last workgroup to read
+		vk::raii::Buffer counterBuffer;
+		vk::raii::DeviceMemory counterMemory;
+		vk::raii::Buffer tileBuffer;
+		vk::raii::DeviceMemory tileMemory;
+
+		vk::raii::QueryPool queryPool;
+		std::vector<Pending> pending;
+		std::vector<vk::raii::ImageView> pendingViews;
+		// ahead of the sets so they are destroyed after them
+		std::vector<vk::raii::DescriptorPool> pendingPools;
+		std::vector<vk::raii::DescriptorSet> pendingSets;
+		std::vector<uint64_t> queryResults;
+
+		MipGenerationStatistics statistics;
+		MipPath preferredPath;
+		double timestampPeriod;
+		uint64_t timestampMask;
+		bool computeAvailable;
+
+		bool canCompute(GraphicsContext& context, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount) const;
+		bool canBlit(GraphicsContext& context, vk::Format const& format) const;
+		void recordBlitChain(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount);
+		void recordDownsample(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount);
+	public:
+		// levels the single dispatch writes, so level 0 can be at most 4096 texels on a side
+		static constexpr uint32_t MAX_COMPUTE_LEVELS = 12;
+		// recordings between two collects
+		static constexpr uint32_t MAX_PENDING = 16;
+
+		MipGenerator(GraphicsContext& context);
+
+		MipGenerator(MipGenerator const& copyFrom) = delete;
+		MipGenerator& operator=(MipGenerator const& assignFrom) = delete;
+
+		static uint32_t getFullLevelCount(vk::Extent2D const& extent);
+		// the unorm format an sRGB one is written through, the format itself for anything else
+		static vk::Format getStorageFormat(vk::Format const& format);
+		// what an image needs to be created with so either path can generate its levels
+		vk::ImageUsageFlags getImageUsage(GraphicsContext& context, vk::Format const& format) const;
+		vk::ImageCreateFlags getImageFlags(GraphicsContext& context, vk::Format const& format) const;
+
+		// false for formats neither path can write, block compressed ones among them
+		bool canGenerate(GraphicsContext& context, vk::Format const& format) const;
+		// at least two levels, level 0 in shader read only layout and the rest undefined, every level is left in shader read only layout for fragment shaders
+		// returns the path it took, the timestamps are read by collect
+		MipPath record(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount);
+		// once every recording since the last collect has completed, adds their times to the statistics and frees what they used
+		void collect();
+
+		void setPreferredPath(MipPath const& path);
+		MipGenerationStatistics const& getStatistics() const;
+	};
+}
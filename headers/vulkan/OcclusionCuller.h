@@ -0,0 +1,95 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/DeletionQueue.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	// objects tested and culled by the last collection of draws
+	struct OcclusionStatistics {
+		uint32_t tested;
+		uint32_t culled;
+	};
+
+	// a max depth pyramid is built by compute from each frame's depth buffer, and one small level of it is copied to a host buffer per frame in flight
+	// the CPU tests bounds against the newest level it has read back, projected with the matrices that frame was drawn with
+	// that is a few frames behind, so something that just came out from behind an occluder can pop in late
+	class OcclusionCuller {
+	private:
+		struct ReduceConstants {
+			uint32_t sourceWidth;
+			uint32_t sourceHeight;
+			uint32_t destinationWidth;
+			uint32_t destinationHeight;
+		};
+
+		vk::raii::Sampler sampler;
+		vk::raii::DescriptorSetLayout setLayout;
+		vk::raii::PipelineLayout pipelineLayout;
+		vk::raii::Pipeline pipeline;
+
+		vk::raii::Image pyramidImage;
+		vk::raii::DeviceMemory pyramidMemory;
+		std::vector<vk::raii::ImageView> levelViews;
+		// one set per level, bound to the depth buffer of the current render graph
+		vk::raii::DescriptorPool descriptorPool;
+		std::vector<vk::raii::DescriptorSet> levelSets;
+		std::vector<vk::Extent2D> levelExtents;
+		vk::Extent2D depthExtent;
+		uint32_t readbackLevel;
+
+		std::vector<vk::raii::Buffer> readbackBuffers;
+		std::vector<vk::raii::DeviceMemory> readbackMemory;
+		std::vector<void*> readbackAddresses;
+		std::vector<bool> awaitingResults;
+		std::vector<glm::mat4> slotViewProjections;
+
+		// the newest level that came back and what it was drawn with
+		std::vector<float> readbackDepths;
+		glm::mat4 readbackViewProjection;
+		bool hasReadback;
+
+		OcclusionStatistics statistics;
+		uint32_t framesInFlightCount;
+		bool available;
+		bool enabled;
+	public:
+		static constexpr vk::Format PYRAMID_FORMAT = vk::Format::eR32Sfloat;
+		// the level read back is the first one no larger than this on either side
+		static constexpr uint32_t READBACK_SIZE = 64;
+
+		// without shaders/hiz.spv the culler stays unavailable and can not be enabled
+		OcclusionCuller(GraphicsContext& context, uint32_t const& framesInFlightCount);
+
+		OcclusionCuller(OcclusionCuller const& copyFrom) = delete;
+		OcclusionCuller& operator=(OcclusionCuller const& assignFrom) = delete;
+
+		// recreates the pyramid and the readback buffers for a depth buffer of this size, the old ones go into the deletion queue
+		void resize(GraphicsContext& context, vk::Extent2D const& newDepthExtent, DeletionQueue& deletionQueue);
+		// after every render graph compile, the depth buffer is a transient and moves whenever the graph is rebuilt
+		void bindDepth(GraphicsContext& context, vk::ImageView const& depthView, DeletionQueue& deletionQueue);
+		// once the slot's fence has been waited on, takes the level its last frame read back
+		void beginFrame(uint32_t const& frameIndex);
+		// depth buffer sampled and the whole pyramid in general layout, levels are ordered against each other in here
+		void recordBuild(vk::raii::CommandBuffer const& cmdBuffer);
+		// pyramid in transfer source layout
+		void recordReadback(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex);
+		// the frame's recording, cached or not, holds the build and readback, the matrices are the ones its uniform buffer got
+		void frameSubmitted(uint32_t const& frameIndex, glm::mat4 const& viewProjection);
+
+		void beginCulling();
+		// world space bounds, false whenever there is nothing to test against or the bounds reach behind the camera
+		bool isOccluded(glm::vec3 const& boundsMin, glm::vec3 const& boundsMax);
+
+		void setEnabled(bool const& enable);
+		bool isEnabled() const;
+		bool isAvailable() const;
+		bool isSized() const;
+		vk::Image getPyramidImage() const;
+		vk::Extent2D getPyramidExtent() const;
+		OcclusionStatistics const& getStatistics() const;
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/DeletionQueue.h"
+#include <vector>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	struct OverdrawResult {
+		// fragments per pixel over the whole target and over only the pixels something was drawn to
+		double average;
+		double coveredAverage;
+		uint32_t max;
+		double coverage;
+	};
+
+	// the scene is drawn a second time with additive blending into a one channel counter target, each fragment adds one
+	// the target is copied to a host buffer per frame in flight and reduced on the CPU once that frame's fence has been waited on
+	class OverdrawMeter {
+	private:
+		vk::raii::Image counterImage;
+		vk::raii::DeviceMemory counterMemory;
+		vk::raii::ImageView counterView;
+		std::vector<vk::raii::Buffer> readbackBuffers;
+		std::vector<vk::raii::DeviceMemory> readbackMemory;
+		std::vector<void*> readbackAddresses;
+		std::vector<bool> awaitingResults;
+
+		vk::Extent2D extent;
+		OverdrawResult lastResult;
+		uint32_t framesInFlightCount;
+		bool enabled;
+
+		void reduce(uint32_t const& frameIndex);
+		static float halfToFloat(uint16_t const& half);
+	public:
+		// blending into R16_SFLOAT is required by the spec, and a half counts exactly up to 2048
+		static constexpr vk::Format COUNTER_FORMAT = vk::Format::eR16Sfloat;
+
+		OverdrawMeter(uint32_t const& framesInFlightCount);
+
+		OverdrawMeter(OverdrawMeter const& copyFrom) = delete;
+		OverdrawMeter& operator=(OverdrawMeter const& assignFrom) = delete;
+
+		// recreates the target and the readback buffers, the old ones go into the deletion queue and the results still in them are dropped
+		void resize(GraphicsContext& context, vk::Extent2D const& newExtent, DeletionQueue& deletionQueue);
+		void beginFrame(uint32_t const& frameIndex);
+		// the caller records the scene with the overdraw pipeline between the two, inside the counter target's rendering scope
+		// the render graph moves the counter target between colour attachment and transfer source layout around these
+		void beginPass(vk::raii::CommandBuffer const& cmdBuffer);
+		void endPass(vk::raii::CommandBuffer const& cmdBuffer);
+		// counter target in transfer source layout, copies it into this frame's readback buffer
+		void recordReadback(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex);
+
+		void setEnabled(bool const& enable);
+		bool isEnabled() const;
+		vk::Image getCounterImage() const;
+		vk::Extent2D getExtent() const;
+		OverdrawResult const& getLastResult() const;
+	};
+}
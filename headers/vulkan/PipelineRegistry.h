@@ -0,0 +1,119 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/SpecializationConstants.h"
+#include "vulkan/ShaderModuleCache.h"
+#include "general/ThreadPool.h"
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <array>
+
+namespace Vulkan {
+	struct PipelineShaderStage {
+		vk::ShaderStageFlagBits stage;
+		std::string sprivPath;
+		std::string entryPoint;
+		SpecializationConstants specialization;
+
+		bool operator==(PipelineShaderStage const& other) const = default;
+	};
+
+	// everything that goes into a graphics pipeline, by value, so two requests for the same pipeline compare and hash equal
+	struct PipelineDescription {
+		std::vector<PipelineShaderStage> shaderStages;
+		vk::VertexInputBindingDescription vertexBinding;
+		std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+		vk::PrimitiveTopology topology;
+		bool primitiveRestart;
+		vk::Viewport viewport;
+		vk::Rect2D scissor;
+		bool depthClamp;
+		bool rasterizerDiscard;
+		vk::PolygonMode polygonMode;
+		vk::CullModeFlags cullMode;
+		vk::FrontFace frontFace;
+		bool depthBias;
+		float depthBiasConstantFactor;
+		float depthBiasClamp;
+		float depthBiasSlopeFactor;
+		float lineWidth;
+		bool depthTest;
+		bool depthWrite;
+		vk::CompareOp depthCompareOp;
+		bool depthBoundsTest;
+		bool stencilTest;
+		std::vector<vk::PipelineColorBlendAttachmentState> blendAttachments;
+		bool logicOpEnable;
+		vk::LogicOp logicOp;
+		std::array<float, 4> blendConstants;
+		std::vector<vk::DynamicState> dynamicStates;
+		vk::Format colourFormat;
+		vk::Format depthFormat;
+		vk::SampleCountFlagBits samples;
+		vk::PipelineLayout layout;
+
+		// zeroes out state that cannot affect the compiled pipeline (dynamic or disabled) and sorts the dynamic states,
+		// so variants that only differ in dynamic state end up as the same pipeline
+		void canonicalize();
+		bool isDynamic(vk::DynamicState const& state) const;
+		// writes the variant's feature constants into every stage, constants a stage sets itself are kept
+		void applyVariant(ShaderVariantKey const& variant);
+		bool operator==(PipelineDescription const& other) const = default;
+	};
+
+	struct PipelineDescriptionHash {
+		size_t operator()(PipelineDescription const& description) const;
+	};
+
+	enum class PipelineState {
+		ePending,
+		eReady,
+		eFailed
+	};
+
+	class PipelineRegistry {
+	public:
+		using PipelineId = uint32_t;
+	private:
+		struct Entry {
+			PipelineDescription description{};
+			std::atomic<PipelineState> state{ PipelineState::ePending };
+			vk::Pipeline pipeline{};
+		};
+
+		vk::Device device;
+		DeviceDispatcher const* dispatcher;
+		vk::PipelineCache pipelineCache;
+		ShaderModuleCache& shaderModules;
+
+		std::unordered_map<PipelineDescription, PipelineId, PipelineDescriptionHash> lookup;
+		std::vector<std::unique_ptr<Entry>> entries;
+		mutable std::mutex entriesMutex;
+		std::condition_variable entryFinished;
+		uint32_t deduplicatedRequests;
+		std::unique_ptr<General::ThreadPool> compileWorkers;
+
+		void compile(Entry& entry);
+	public:
+		PipelineRegistry(vk::raii::Device const& device, ShaderModuleCache& shaderModules, uint32_t const& workerCount);
+		~PipelineRegistry();
+
+		PipelineRegistry(PipelineRegistry const& copyFrom) = delete;
+		PipelineRegistry& operator=(PipelineRegistry const& assignFrom) = delete;
+
+		// returns the id of an identical earlier request if there is one, otherwise queues a compile
+		PipelineId request(PipelineDescription description);
+		// never waits, returns a null handle while the pipeline is still compiling or if it failed
+		vk::Pipeline tryGet(PipelineId const& id) const;
+		// waits for the compile to finish, throws if it failed
+		vk::Pipeline get(PipelineId const& id);
+		PipelineState getState(PipelineId const& id) const;
+
+		uint32_t getPipelineCount() const;
+		uint32_t getDeduplicatedRequestCount() const;
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include <vector>
+#include <utility>
+
+namespace Vulkan {
+	struct PassStatistics {
+		uint64_t inputVertices;
+		uint64_t inputPrimitives;
+		uint64_t vertexInvocations;
+		uint64_t clippingPrimitives;
+		uint64_t fragmentInvocations;
+	};
+
+	// pipeline statistics queries per pass, read back the same way as GpuProfiler so it never waits on the GPU
+	// needs the pipelineStatisticsQuery feature, without it enabling does nothing
+	class PipelineStatistics {
+	private:
+		struct Pass {
+			const char* name;
+			uint32_t query;
+		};
+
+		std::vector<vk::raii::QueryPool> pools;
+		std::vector<std::vector<Pass>> framePasses;
+		std::vector<bool> awaitingResults;
+		std::vector<std::pair<const char*, PassStatistics>> lastStatistics;
+		std::vector<uint64_t> results;
+
+		uint32_t maxPassesPerFrame;
+		uint32_t currentFrame;
+		bool supported;
+		bool enabled;
+
+		void collect(uint32_t const& frameIndex);
+	public:
+		// the results come back in flag bit order, PassStatistics follows it
+		static constexpr vk::QueryPipelineStatisticFlags FLAGS = vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices | vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives | vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations | vk::QueryPipelineStatisticFlagBits::eClippingPrimitives | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+		static constexpr uint32_t VALUE_COUNT = 5;
+
+		PipelineStatistics(vk::raii::Device const& device, bool const& supported, uint32_t const& framesInFlightCount, uint32_t const& maxPassesPerFrame);
+
+		PipelineStatistics(PipelineStatistics const& copyFrom) = delete;
+		PipelineStatistics& operator=(PipelineStatistics const& assignFrom) = delete;
+
+		void beginFrame(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex);
+		// instead of beginFrame when the slot resubmits a command buffer recorded earlier, enabling or disabling must invalidate those recordings
+		void replayFrame(uint32_t const& frameIndex);
+		uint32_t beginPass(vk::raii::CommandBuffer const& cmdBuffer, const char* name);
+		void endPass(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& pass);
+
+		void setEnabled(bool const& enable);
+		bool isEnabled() const;
+		bool isSupported() const;
+		// the most recent complete frame, one entry per pass
+		std::vector<std::pair<const char*, PassStatistics>> const& getLastStatistics() const;
+	};
+
+	class PipelineStatisticsScope {
+	private:
+		PipelineStatistics& statistics;
+		vk::raii::CommandBuffer const& cmdBuffer;
+		uint32_t pass;
+	public:
+		PipelineStatisticsScope(PipelineStatistics& statistics, vk::raii::CommandBuffer const& cmdBuffer, const char* name);
+		~PipelineStatisticsScope();
+
+		PipelineStatisticsScope(PipelineStatisticsScope const& copyFrom) = delete;
+		PipelineStatisticsScope& operator=(PipelineStatisticsScope const& assignFrom) = delete;
+	};
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/DeletionQueue.h"
+#include <vector>
+#include <functional>
+#include <ostream>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	// how a pass touches an image, each one decides the layout and the stages and accesses its barriers are built from
+	enum class ImageAccess {
+		eNone,
+		eColorAttachmentWrite,
+		eDepthAttachmentWrite,
+		eDepthAttachmentRead,
+		// the single sampled target of a depth resolve, resolves run in the colour output stage whatever the aspect
+		eDepthResolveWrite,
+		eFragmentSampled,
+		eComputeSampled,
+		eComputeStorageRead,
+		eComputeStorageWrite,
+		eTransferSrc,
+		eTransferDst,
+		ePresent
+	};
+
+	// barriers cover every mip level, a pass that works through the levels one after another orders them itself
+	struct ImportedImageInfo {
+		vk::Format format;
+		vk::Extent2D extent;
+		vk::ImageAspectFlags aspect;
+		// what touched the image before the graph, the first barrier waits on it
+		ImageAccess initialAccess;
+		// false lets the first pass discard the contents by transitioning from undefined
+		bool preserveContents;
+		// where the graph leaves the image, eNone leaves it wherever the last pass put it and lets its writers be culled
+		ImageAccess finalAccess;
+	};
+
+	// owned by the graph, passes whose lifetimes do not overlap share memory
+	// images only ever used as attachments are created transient and put in lazily allocated memory where the device has it
+	struct TransientImageInfo {
+		vk::Format format;
+		vk::Extent2D extent;
+		vk::ImageAspectFlags aspect;
+		vk::SampleCountFlagBits samples;
+	};
+
+	class RenderGraph;
+
+	class PassBuilder {
+	private:
+		RenderGraph& graph;
+		uint32_t pass;
+	public:
+		PassBuilder(RenderGraph& graph, uint32_t const& pass);
+
+		PassBuilder& read(uint32_t const& resource, ImageAccess const& access);
+		PassBuilder& write(uint32_t const& resource, ImageAccess const& access);
+		// writes something the graph does not track, like a readback buffer, so the pass is never culled
+		PassBuilder& sideEffects();
+	};
+
+	// passes run in the order they are added, each declares the images it reads and writes
+	// compiling culls passes nothing needs, places transient images in shared memory and works out every barrier once
+	// executing only patches in the imported images for the frame, so steady state frames do not allocate
+	class RenderGraph {
+	private:
+		static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+		struct Access {
+			uint32_t resource;
+			ImageAccess access;
+		};
+
+		struct Pass {
+			const char* name;
+			std::function<void(vk::raii::CommandBuffer const&)> execute;
+			std::vector<Access> accesses;
+			bool sideEffects;
+			bool live;
+		};
+
+		struct Resource {
+			const char* name;
+			bool imported;
+			vk::Format format;
+			vk::Extent2D extent;
+			vk::ImageAspectFlags aspect;
+			vk::SampleCountFlagBits samples;
+			ImageAccess initialAccess;
+			bool preserveContents;
+			ImageAccess finalAccess;
+			vk::Image image;
+			vk::ImageView view;
+
+			// filled in by compile, positions are in the order the live passes run
+			uint32_t firstPosition;
+			uint32_t lastPosition;
+			vk::PipelineStageFlags2 usedStages;
+			vk::AccessFlags2 writtenAccess;
+			vk::ImageUsageFlags usage;
+			uint32_t memoryBlock;
+			vk::DeviceSize memorySize;
+			// the transient that used the memory before this one, the first user of a block waits on the block's last one from the previous frame
+			uint32_t previousOccupant;
+		};
+
+		struct BarrierBatch {
+			std::vector<vk::ImageMemoryBarrier2> barriers;
+			std::vector<uint32_t> resources;
+		};
+
+		std::vector<Pass> passes;
+		std::vector<Resource> resources;
+		std::vector<uint32_t> order;
+		// batch i is recorded before the i-th live pass, the last one after every pass
+		std::vector<BarrierBatch> batches;
+
+		std::vector<vk::raii::DeviceMemory> memoryBlocks;
+		std::vector<vk::raii::Image> transientImages;
+		std::vector<vk::raii::ImageView> transientViews;
+		vk::DeviceSize transientBytes;
+		vk::DeviceSize allocatedBytes;
+		// part of allocatedBytes, tilers may never back it with memory at all
+		vk::DeviceSize lazilyAllocatedBytes;
+		uint32_t barrierCount;
+		bool compiled;
+
+		void cull();
+		void computeLifetimes();
+		void allocateTransients(GraphicsContext& context);
+		void buildBarriers();
+		void addAccess(uint32_t const& pass, uint32_t const& resource, ImageAccess const& access, bool const& write);
+	public:
+		friend class PassBuilder;
+
+		RenderGraph();
+
+		RenderGraph(RenderGraph const& copyFrom) = delete;
+		RenderGraph& operator=(RenderGraph const& assignFrom) = delete;
+
+		// drops every pass and resource, the transient images go into the deletion queue since frames in flight may still use them
+		void reset(DeletionQueue& deletionQueue);
+		uint32_t importImage(const char* name, ImportedImageInfo const& info);
+		uint32_t createImage(const char* name, TransientImageInfo const& info);
+		PassBuilder addPass(const char* name, std::function<void(vk::raii::CommandBuffer const&)> execute);
+
+		void compile(GraphicsContext& context);
+		// imported images can change every frame, the swapchain image for one
+		void setImportedImage(uint32_t const& resource, vk::Image const& image, vk::ImageView const& view);
+		void execute(vk::raii::CommandBuffer const& cmdBuffer);
+
+		vk::Image getImage(uint32_t const& resource) const;
+		vk::ImageView getImageView(uint32_t const& resource) const;
+		bool isCompiled() const;
+		bool isLive(uint32_t const& pass) const;
+		// every pass with its barriers, culled passes, resource lifetimes and the memory aliasing saved
+		void dump(std::ostream& out) const;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "general/MappedFile.h"
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Vulkan {
+	// a mapped and validated SPIR-V file, loading one needs no device so it can happen before the device exists
+	struct SprivBinary {
+		std::string path;
+		General::MappedFile file;
+		uint64_t contentHash;
+		// the SpecId of every specialization constant the module declares, ascending
+		std::vector<uint32_t> specializationIds;
+
+		uint32_t const* getWords() const;
+	};
+
+	// one vk::ShaderModule per distinct SPIR-V binary, shared by every stage and pipeline that uses it
+	// mapping files and creating modules happen outside the lock, so the compile workers only queue up on the lookups
+	class ShaderModuleCache {
+	private:
+		// the binary stays mapped so a hash hit can be confirmed byte for byte
+		struct CachedModule {
+			std::shared_ptr<SprivBinary const> binary;
+			vk::ShaderModule module;
+		};
+
+		vk::Device device;
+		DeviceDispatcher const* dispatcher;
+
+		std::unordered_map<std::string, CachedModule> pathModules;
+		std::unordered_map<std::string, std::shared_ptr<SprivBinary const>> preloadedBinaries;
+		// binaries whose hashes collide share a bucket
+		std::unordered_map<uint64_t, std::vector<CachedModule>> modules;
+		std::mutex cacheMutex;
+		uint32_t fileLoads;
+		uint32_t cacheHits;
+		uint32_t moduleCount;
+
+		vk::ShaderModule loadShaderModule(std::string const& sprivPath);
+		// the module made from the same bytes, a null handle if there is none, only with cacheMutex held
+		vk::ShaderModule findModule(SprivBinary const& binary) const;
+	public:
+		static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+		static constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+		static constexpr uint32_t SPIRV_OP_FUNCTION = 54;
+		static constexpr uint32_t SPIRV_OP_DECORATE = 71;
+		static constexpr uint32_t SPIRV_DECORATION_SPEC_ID = 1;
+
+		static std::shared_ptr<SprivBinary const> loadSprivBinary(std::string const& sprivPath);
+
+		ShaderModuleCache(vk::raii::Device const& device);
+		~ShaderModuleCache();
+
+		ShaderModuleCache(ShaderModuleCache const& copyFrom) = delete;
+		ShaderModuleCache& operator=(ShaderModuleCache const& assignFrom) = delete;
+
+		// safe to call from the pipeline compile workers, the module stays owned by the cache
+		vk::ShaderModule getShaderModule(std::string const& sprivPath);
+		// the constant ids of a binary getShaderModule has already loaded
+		std::vector<uint32_t> const& getSpecializationIds(std::string const& sprivPath);
+		// a later getShaderModule for the binary's path uses it instead of mapping the file again
+		void addPreloaded(std::shared_ptr<SprivBinary const> const& binary);
+		uint32_t getModuleCount();
+	};
+}
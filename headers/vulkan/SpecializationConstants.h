@@ -0,0 +1,54 @@
+#pragma once
+
+#define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
+#include "vulkan/vulkan_raii.hpp"
+#include <map>
+#include <variant>
+#include <vector>
+
+namespace Vulkan {
+	using SpecializationValue = std::variant<bool, int32_t, uint32_t, float>;
+
+	// every constant is packed as 4 bytes, bools as VkBool32 which is what SPIR-V OpSpecConstantTrue/False expects
+	struct PackedSpecialization {
+		std::vector<vk::SpecializationMapEntry> entries;
+		std::vector<uint32_t> data;
+
+		vk::SpecializationInfo getInfo() const;
+	};
+
+	class SpecializationConstants {
+	private:
+		std::map<uint32_t, SpecializationValue> constants;
+	public:
+		void set(uint32_t const& constantId, SpecializationValue const& value);
+		void merge(SpecializationConstants const& other);
+		bool empty() const;
+		std::map<uint32_t, SpecializationValue> const& getConstants() const;
+		// true when the set constants are exactly these ids, which have to be ascending
+		bool setsExactly(std::vector<uint32_t> const& constantIds) const;
+		PackedSpecialization pack() const;
+
+		bool operator==(SpecializationConstants const& other) const = default;
+	};
+
+	// the bit index of a feature is also the constant_id the shaders declare it under
+	enum class ShaderFeature : uint32_t {
+		eVertexColour = 0,
+		eOverdraw = 1
+	};
+
+	struct ShaderVariantKey {
+		// one past the highest ShaderFeature bit, a new feature has to raise it or its constant is never emitted
+		static constexpr uint32_t FEATURE_COUNT = 2;
+
+		uint32_t features;
+
+		ShaderVariantKey with(ShaderFeature const& feature, bool const& enabled) const;
+		bool has(ShaderFeature const& feature) const;
+		// every feature bit becomes a bool constant under its bit index, set or not
+		SpecializationConstants getConstants() const;
+
+		bool operator==(ShaderVariantKey const& other) const = default;
+	};
+}
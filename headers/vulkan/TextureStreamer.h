@@ -0,0 +1,125 @@
+#pragma once
+
+#include "vulkan/VulkanContext.h"
+#include "vulkan/DeletionQueue.h"
+#include "vulkan/Ktx2File.h"
+#include "vulkan/MipGenerator.h"
+#include "general/ThreadPool.h"
+#include <memory>
+#include <vector>
+#include <future>
+#include <string>
+
+namespace Vulkan {
+	class GraphicsContext;
+
+	struct TextureStreamingSettings {
+		// copied into textures per frame at most, a level bigger than this arrives over several frames a row of blocks at a time
+		uint64_t frameBudgetBytes;
+		// levels no larger than this on either side are uploaded when a texture is loaded, so it can be drawn right away
+		uint32_t residentTailSize;
+	};
+
+	struct TextureStatistics {
+		uint32_t textures;
+		// levels the coverage asks for that are not in a view yet, across all textures
+		uint32_t pendingLevels;
+		uint64_t residentBytes;
+		uint64_t lastFrameBytes;
+		uint64_t streamedBytes;
+	};
+
+	// textures from KTX2 files, the smallest levels are uploaded on load and the rest streamed in finest last as screen coverage asks for them
+	// a file with only level 0 in a format the GPU can write gets its full chain generated on load instead, and is never streamed
+	// uploads are recorded into a command buffer per frame slot that goes into the frame's submit ahead of the frame itself
+	// a level only joins its texture's view once the frame that finished uploading it has completed, until then the view starts below it
+	// nothing is streamed out again, a texture keeps every level it once needed
+	class TextureStreamer {
+	public:
+		using TextureId = uint32_t;
+		// 1x1 opaque white, whatever failed to load is drawn with it
+		static constexpr TextureId FALLBACK_TEXTURE = 0;
+	private:
+		struct Texture {
+			std::string name;
+			// null for the fallback and generated chains, which have nothing left to stream
+			std::unique_ptr<Ktx2File> source;
+			vk::raii::Image image;
+			vk::raii::DeviceMemory memory;
+			vk::raii::ImageView view;
+			vk::Format format;
+			vk::Extent2D extent;
+			uint32_t levelCount;
+			// the finest level in the view
+			uint32_t residentLevel;
+			// the finest level whose upload is recorded, it runs ahead of residentLevel until that frame completes
+			uint32_t recordedLevel;
+			// block rows of the level after recordedLevel copied so far, and its data once the reader has it
+			uint32_t uploadedRows;
+			std::future<std::vector<uint8_t>> pendingRead;
+			std::vector<uint8_t> levelData;
+			// the finest level the coverage asked for, and the largest coverage in pixels any draw asked for this frame
+			uint32_t wantedLevel;
+			float coverage;
+		};
+
+		struct Landing {
+			TextureId texture;
+			uint32_t level;
+		};
+
+		TextureStreamingSettings settings;
+		vk::raii::Sampler sampler;
+		std::vector<Texture> textures;
+		bool blockCompressionEnabled;
+
+		vk::raii::CommandPool pool;
+		std::vector<vk::raii::CommandBuffer> uploadBuffers;
+		std::vector<vk::raii::Buffer> stagingBuffers;
+		std::vector<vk::raii::DeviceMemory> stagingMemory;
+		std::vector<void*> stagingAddresses;
+		// levels whose last rows went into the slot's upload, they land when its fence has been waited on
+		std::vector<std::vector<Landing>> slotLandings;
+		uint64_t viewVersion;
+		TextureStatistics statistics;
+		MipGenerator mipGenerator;
+		// last so it is destroyed first, its reads point into the textures' files
+		General::ThreadPool reader;
+
+		TextureId createTexture(GraphicsContext& context, std::string const& name, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount, vk::ImageUsageFlags const& usage, vk::ImageCreateFlags const& flags);
+		// uploads the levels from first on and waits for them, only while no frame is in flight
+		// with generateLevels the one level given is level 0 and every level after it is generated from it in the same submit
+		void uploadNow(GraphicsContext& context, TextureId const& id, uint32_t const& firstLevel, std::vector<std::span<const uint8_t>> const& levels, bool const& generateLevels);
+		void createView(GraphicsContext& context, Texture& texture);
+		bool isFormatUsable(GraphicsContext& context, vk::Format const& format) const;
+		void updateWantedLevel(Texture& texture);
+		// true when anything was recorded, the buffer is begun on the first copy
+		bool recordLevelRows(vk::raii::CommandBuffer const& cmdBuffer, TextureId const& id, uint32_t const& slot, uint64_t& stagingOffset, bool& begun);
+	public:
+		TextureStreamer(GraphicsContext& context, uint32_t const& framesInFlightCount, TextureStreamingSettings const& settings);
+
+		TextureStreamer(TextureStreamer const& copyFrom) = delete;
+		TextureStreamer& operator=(TextureStreamer const& assignFrom) = delete;
+
+		static vk::DescriptorSetLayoutBinding getDescriptorSetLayoutBinding(uint32_t const& bindingNum);
+
+		// before the first frame, anything that can not be read or sampled on this device gives the fallback
+		TextureId load(GraphicsContext& context, std::string const& path);
+		// once the slot's fence has been waited on, the levels its upload finished join their views
+		void frameCompleted(GraphicsContext& context, uint32_t const& slot, DeletionQueue& deletionQueue);
+		void beginFrame();
+		// pixels a draw with the texture covers on screen, the largest of a frame picks the level it wants
+		void requestCoverage(TextureId const& id, float const& pixels);
+		// the slot's upload buffer is only worth submitting when this returns true
+		bool recordUploads(uint32_t const& slot);
+		vk::raii::CommandBuffer const& getUploadBuffer(uint32_t const& slot) const;
+
+		vk::DescriptorImageInfo getDescriptorInfo(TextureId const& id) const;
+		// bumped whenever a view is replaced, descriptors written under an older one point at a retired view
+		uint64_t getViewVersion() const;
+		TextureStatistics const& getStatistics() const;
+		// for the chains generated from here on, the auto path takes compute wherever it can
+		void setMipPath(MipPath const& path);
+		MipGenerationStatistics const& getMipStatistics() const;
+	};
+}
@@ -4,26 +4,45 @@
 #include "vulkan/vulkan_raii.hpp"
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
+#include "general/StartupTimeline.h"
+#include "general/Hash.h"
+#include "vulkan/DeviceProfile.h"
 #include <stdexcept>
 #include <iostream>
 #include <utility>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <future>
+#include <limits>
 
 namespace Vulkan {
 	class GraphicsContext;
 	class GraphicsEngine;
 
+	// owned on the heap by vk::raii::Device so the pointer stays valid when the device is moved, which lets worker threads hold on to it
+	using DeviceDispatcher = std::remove_pointer_t<decltype(std::declval<vk::raii::Device const&>().getDispatcher())>;
+
 	template <class... Ts>
 	struct VulkanContextInitInfo {
 		int windowWidth = 0;
 		int windowHeight = 0;
 		const char* appName = nullptr;
+		// no glfw and no window, the surface comes from VK_EXT_headless_surface and is windowWidth x windowHeight
+		bool headless = false;
 		uint32_t apiVersion = 0;
 		std::vector<const char*> validationLayers{};
 		std::vector<const char*> deviceExtensions{};
+		// enabled when the physical device has them, the selection never rejects a device for missing one
+		std::vector<const char*> optionalDeviceExtensions{};
+		// same for core features, each one set here is turned on only if the device has it
+		vk::PhysicalDeviceFeatures optionalDeviceFeatures{};
 		vk::StructureChain<Ts...> deviceFeatures{};
 		std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> queueFamiliesInfo{};
+		// one more queue from a compute family without graphics, when the device has such a family, for work that overlaps the graphics queue
+		bool asyncCompute = false;
+		// where the chosen device's profile is kept between launches, empty rates every device on every launch
+		std::string deviceProfilePath{};
 	};
 
 	class VulkanContext {
@@ -35,25 +54,39 @@ namespace Vulkan {
 		vk::raii::PhysicalDevice physicalDevice;
 		vk::raii::Device device;
 		std::vector<std::vector<vk::raii::Queue>> queues;
+		// null unless async compute was asked for and the device has a dedicated compute family
+		vk::raii::Queue computeQueue;
+		uint32_t computeQueueFamily;
 
 		std::vector<uint32_t> acquiredQueueFamilyIndices;
-
+		std::vector<std::string> enabledDeviceExtensions;
+		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features;
+		vk::PhysicalDeviceFeatures enabledOptionalFeatures;
+		DeviceProfile deviceProfile;
+		// true when the device came from a saved profile instead of rating all of them
+		bool deviceProfileCached;
+		bool headless;
+		vk::Extent2D headlessExtent;
+
+		void initGlfw();
 		void initWindow(int const& WIDTH, int const& HEIGHT, const char* name);
 		void initInstance(uint32_t const& apiVersion, const std::vector<const char*>& validLays);
+		void initHeadlessWindow(int const& WIDTH, int const& HEIGHT);
 		void initSurface();
 		template <class... Ts>
-		void initPhysicalDevice(uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo);
+		void initPhysicalDevice(uint32_t const& apiVersion, std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, std::string const& profilePath);
 		template <class... Ts>
-		void initDeviceAndQueues(std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo);
+		void initDeviceAndQueues(std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::PhysicalDeviceFeatures const& optionalDevFeats, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, bool const& asyncCompute);
 
 		// for initInstance
 		std::pair<uint32_t, const char**> enumerateGlfwExtensions();
+		std::pair<uint32_t, const char**> enumerateHeadlessExtensions();
 		bool verifyHaveValidationLayers(std::vector<const char*> const& needs);
 		bool verifyHaveGlfwExtensions(uint32_t const& needCount, const char**& needs);
 
 		// for initPhysicalDevice
 		template <class... Ts>
-		std::vector<std::array<std::pair<std::string, uint32_t>, 4>> ratePhysicalDevices(uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo);
+		std::vector<std::array<std::pair<std::string, uint32_t>, 4>> ratePhysicalDevices(std::vector<vk::raii::PhysicalDevice> const& physicalDevices, uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo);
 		uint32_t judgePhysicalDevice(std::array<std::pair<std::string, uint32_t>, 4> rating);
 		bool hasMinimumApiVersion(vk::raii::PhysicalDevice const& phyDev, uint32_t const& apiVersion);
 		bool hasQueueFamilyQueues(vk::raii::PhysicalDevice const& phyDev, vk::QueueFlagBits const& familyBits, uint32_t const& queueCount);
@@ -62,14 +95,33 @@ namespace Vulkan {
 		template <class T>
 		bool featureBundleSupported(T const& requested, T const& supported);
 		bool hasPhysicalDeviceExtensions(vk::raii::PhysicalDevice const& phyDev, std::vector<const char*> const& extensions);
+		template <class... Ts>
+		uint64_t hashRequirements(uint32_t const& apiVersion, std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo);
+		template <class T>
+		uint64_t hashFeatureBundle(T const& features, uint64_t seed);
+		bool loadCachedPhysicalDevice(std::vector<vk::raii::PhysicalDevice> const& physicalDevices, std::string const& profilePath, uint64_t const& requirementsHash);
+		DeviceProfile profilePhysicalDevice(vk::raii::PhysicalDevice const& phyDev, std::vector<const char*> const& optionalDevExts, uint64_t const& requirementsHash);
+		uint32_t scorePhysicalDevice(vk::raii::PhysicalDevice const& phyDev, DeviceProfile const& profile);
 
 		// for initDeviceAndQueues
 		uint32_t queueFamilyIndex(vk::raii::PhysicalDevice const& phyDev, vk::raii::SurfaceKHR const& surf, vk::QueueFlagBits const& familyBits);
+		// the first family with compute and without graphics that is not already acquired, or the max value when there is none
+		uint32_t dedicatedComputeFamilyIndex(vk::raii::PhysicalDevice const& phyDev, std::vector<uint32_t> const& acquired);
 		std::vector<vk::DeviceQueueCreateInfo> createDeviceQueueCreateInfos(std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, std::vector<uint32_t> const& familyIndices);
+		std::vector<const char*> getSupportedOptionalExtensions(std::vector<const char*> const& optionalDevExts);
+		vk::PhysicalDeviceFeatures getSupportedOptionalFeatures(vk::PhysicalDeviceFeatures const& optionalDevFeats);
 
 	public:
 		friend class GraphicsContext;
 		friend class GraphicsEngine;
+		friend class OverdrawMeter;
+		friend class FrameCapture;
+		friend class RenderGraph;
+		friend class OcclusionCuller;
+		friend class TextureStreamer;
+		friend class MipGenerator;
+		// the microbenchmarks in benchmarks/ time private hot paths directly
+		friend struct BenchmarkAccess;
 
 		template <class... Ts>
 		VulkanContext(VulkanContextInitInfo<Ts...> const& initInfo);
@@ -80,29 +132,70 @@ namespace Vulkan {
 		VulkanContext& operator=(VulkanContext const& assignFrom) = delete;
 
 		std::vector<uint32_t> getQueueFamilyIndices() const;
+		bool hasEnabledDeviceExtension(const char* extension) const;
+		vk::PhysicalDeviceFeatures const& getEnabledOptionalFeatures() const;
+		DeviceProfile const& getDeviceProfile() const;
+		bool isDeviceProfileCached() const;
+		bool isHeadless() const;
+		bool hasAsyncCompute() const;
+		uint32_t getComputeQueueFamilyIndex() const;
 	};
 
 	template <class... Ts>
-	VulkanContext::VulkanContext(VulkanContextInitInfo<Ts...> const& initInfo) : window{ nullptr }, context{}, instance{ nullptr }, surface{ nullptr }, physicalDevice{ nullptr }, device{ nullptr }, queues{} {
-		initWindow(initInfo.windowWidth, initInfo.windowHeight, initInfo.appName);
-		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initInstance(initInfo.apiVersion, initInfo.validationLayers);
-		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initSurface();
+	VulkanContext::VulkanContext(VulkanContextInitInfo<Ts...> const& initInfo) : window{ nullptr }, context{}, instance{ nullptr }, surface{ nullptr }, physicalDevice{ nullptr }, device{ nullptr }, queues{}, computeQueue{ nullptr }, computeQueueFamily{ std::numeric_limits<uint32_t>::max() }, acquiredQueueFamilyIndices{}, enabledDeviceExtensions{}, extendedDynamicState3Features{}, enabledOptionalFeatures{}, deviceProfile{}, deviceProfileCached{ false }, headless{ initInfo.headless }, headlessExtent{} {
+		if (!headless) {
+			initGlfw();
+		}
+
+		// the instance only needs glfw's required extension list, not the window, so the two are created side by side
+		std::future<void> instanceReady = std::async(std::launch::async, [this, &initInfo]() {
+			General::StartupStep step("instance");
+			initInstance(initInfo.apiVersion, initInfo.validationLayers);
+		});
+		{
+			General::StartupStep step("window");
+			if (headless) {
+				initHeadlessWindow(initInfo.windowWidth, initInfo.windowHeight);
+			} else {
+				initWindow(initInfo.windowWidth, initInfo.windowHeight, initInfo.appName);
+			}
+		}
+		instanceReady.get();
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initPhysicalDevice(initInfo.apiVersion, initInfo.deviceExtensions, initInfo.deviceFeatures, initInfo.queueFamiliesInfo);
+
+		// rating devices does not touch the surface, it is first needed to pick the present capable family in initDeviceAndQueues
+		std::future<void> physicalDeviceReady = std::async(std::launch::async, [this, &initInfo]() {
+			General::StartupStep step("physical device selection");
+			initPhysicalDevice(initInfo.apiVersion, initInfo.deviceExtensions, initInfo.optionalDeviceExtensions, initInfo.deviceFeatures, initInfo.queueFamiliesInfo, initInfo.deviceProfilePath);
+		});
+		{
+			General::StartupStep step("surface");
+			initSurface();
+		}
+		physicalDeviceReady.get();
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initDeviceAndQueues(initInfo.deviceExtensions, initInfo.deviceFeatures, initInfo.queueFamiliesInfo);
+
+		{
+			General::StartupStep step("device and queues");
+			initDeviceAndQueues(initInfo.deviceExtensions, initInfo.optionalDeviceExtensions, initInfo.optionalDeviceFeatures, initInfo.deviceFeatures, initInfo.queueFamiliesInfo, initInfo.asyncCompute);
+		}
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
 	}
 
+	// every device that meets the requirements is scored and the best one wins, the first one enumerated on a tie
 	template <class... Ts>
-	void VulkanContext::initPhysicalDevice(uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo) {
-		std::vector<std::array<std::pair<std::string, uint32_t>, 4>> physicalDeviceRatings = ratePhysicalDevices(apiVersion, devExts, devFeats, queuesInfo);
+	void VulkanContext::initPhysicalDevice(uint32_t const& apiVersion, std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, std::string const& profilePath) {
+		std::vector<vk::raii::PhysicalDevice> physicalDevices = instance.enumeratePhysicalDevices();
+		uint64_t requirementsHash = hashRequirements(apiVersion, devExts, optionalDevExts, devFeats, queuesInfo);
+		if (!profilePath.empty() && loadCachedPhysicalDevice(physicalDevices, profilePath, requirementsHash)) {
+			return;
+		}
+
+		std::vector<std::array<std::pair<std::string, uint32_t>, 4>> physicalDeviceRatings = ratePhysicalDevices(physicalDevices, apiVersion, devExts, devFeats, queuesInfo);
 
 		bool foundSuitablePhysicalDevice = false;
 		for (uint32_t i = 0; i < physicalDeviceRatings.size(); i++) {
-			vk::raii::PhysicalDevice phyDev = instance.enumeratePhysicalDevices()[i];
+			vk::raii::PhysicalDevice const& phyDev = physicalDevices[i];
 			std::cout << "Rating of " << phyDev.getProperties().deviceName << ": \n" << 
 				physicalDeviceRatings[i][0].first << " is " << physicalDeviceRatings[i][0].second << '\n' << 
 				physicalDeviceRatings[i][1].first << " is " << physicalDeviceRatings[i][1].second << '\n' << 
@@ -110,9 +203,14 @@ namespace Vulkan {
 				physicalDeviceRatings[i][3].first << " is " << physicalDeviceRatings[i][3].second << '\n';
 
 			if (judgePhysicalDevice(physicalDeviceRatings[i]) == 4) {
-				foundSuitablePhysicalDevice = true;
-				physicalDevice = phyDev;
-				break;
+				DeviceProfile profile = profilePhysicalDevice(phyDev, optionalDevExts, requirementsHash);
+				std::cout << "Performance score is " << profile.score << " with " << profile.deviceLocalBytes / (1024 * 1024) << " MiB device local\n";
+
+				if (!foundSuitablePhysicalDevice || profile.score > deviceProfile.score) {
+					foundSuitablePhysicalDevice = true;
+					physicalDevice = phyDev;
+					deviceProfile = profile;
+				}
 			}
 		}
 
@@ -122,10 +220,14 @@ namespace Vulkan {
 		else {
 			std::cout << "Physical device selection successful: " << physicalDevice.getProperties().deviceName << '\n';
 		}
+
+		if (!profilePath.empty()) {
+			deviceProfile.save(profilePath);
+		}
 	}
 
 	template <class... Ts>
-	void VulkanContext::initDeviceAndQueues(std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo) {
+	void VulkanContext::initDeviceAndQueues(std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::PhysicalDeviceFeatures const& optionalDevFeats, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, bool const& asyncCompute) {
 		std::vector<uint32_t> queueFamilyIndices{};
 		for (std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>> const& queueFamily : queuesInfo) {
 			queueFamilyIndices.push_back(queueFamilyIndex(physicalDevice, surface, std::get<0>(queueFamily)));
@@ -133,16 +235,47 @@ namespace Vulkan {
 		acquiredQueueFamilyIndices = queueFamilyIndices;
 
 		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos = createDeviceQueueCreateInfos(queuesInfo, queueFamilyIndices);
+		float computePriority = 1.0f;
+		if (asyncCompute) {
+			computeQueueFamily = dedicatedComputeFamilyIndex(physicalDevice, queueFamilyIndices);
+			if (computeQueueFamily != std::numeric_limits<uint32_t>::max()) {
+				queueCreateInfos.push_back(vk::DeviceQueueCreateInfo{ .queueFamilyIndex = computeQueueFamily, .queueCount = 1, .pQueuePriorities = &computePriority });
+			}
+		}
+
+		std::vector<const char*> extensions = devExts;
+		for (const char* optionalExtension : getSupportedOptionalExtensions(optionalDevExts)) {
+			extensions.push_back(optionalExtension);
+		}
+		enabledDeviceExtensions = std::vector<std::string>(extensions.begin(), extensions.end());
+
+		// the required core features get the supported optional ones added on a copy, the rest of the chain is shared
+		enabledOptionalFeatures = getSupportedOptionalFeatures(optionalDevFeats);
+		vk::PhysicalDeviceFeatures2 coreFeatures = devFeats.get<vk::PhysicalDeviceFeatures2>();
+		VkBool32* coreFeatureBools = reinterpret_cast<VkBool32*>(&coreFeatures.features);
+		VkBool32 const* optionalFeatureBools = reinterpret_cast<VkBool32 const*>(&enabledOptionalFeatures);
+		for (size_t i = 0; i < sizeof(vk::PhysicalDeviceFeatures) / sizeof(VkBool32); i++) {
+			coreFeatureBools[i] = coreFeatureBools[i] | optionalFeatureBools[i];
+		}
+
+		// the optional extension's feature struct goes in front of the required chain with everything the device supports turned on
+		void const* featuresChain = &coreFeatures;
+		if (hasEnabledDeviceExtension(vk::EXTExtendedDynamicState3ExtensionName)) {
+			extendedDynamicState3Features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>().get<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>();
+			extendedDynamicState3Features.pNext = const_cast<void*>(featuresChain);
+			featuresChain = &extendedDynamicState3Features;
+		}
 
 		vk::DeviceCreateInfo deviceInfo = {
-			.pNext = &devFeats.get<vk::PhysicalDeviceFeatures2>(),
+			.pNext = featuresChain,
 			.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
 			.pQueueCreateInfos = queueCreateInfos.data(),
-			.enabledExtensionCount = static_cast<uint32_t>(devExts.size()),
-			.ppEnabledExtensionNames = devExts.data()
+			.enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
+			.ppEnabledExtensionNames = extensions.data()
 		};
 
 		device = vk::raii::Device(physicalDevice, deviceInfo);
+		extendedDynamicState3Features.pNext = nullptr;
 
 		queues.resize(queuesInfo.size());
 		for (uint32_t i = 0; i < queuesInfo.size(); i++) {
@@ -150,6 +283,9 @@ namespace Vulkan {
 				queues[i].push_back(vk::raii::Queue(device, queueFamilyIndices[i], j));
 			}
 		}
+		if (hasAsyncCompute()) {
+			computeQueue = vk::raii::Queue(device, computeQueueFamily, 0);
+		}
 
 		std::cout << "Device creation successful with queue families:\n";
 		for (uint32_t i = 0; i < queues.size(); i++) {
@@ -159,12 +295,17 @@ namespace Vulkan {
 			}
 			std::cout << "}\n";
 		}
+		if (hasAsyncCompute()) {
+			std::cout << "\tQueue family " << computeQueueFamily << " on this GPU with 1 async compute queue\n";
+		} else if (asyncCompute) {
+			std::cout << "\tNo dedicated compute queue family, compute work stays on the graphics queue\n";
+		}
+		std::cout << "Enabled " << enabledDeviceExtensions.size() << " device extensions, " << enabledDeviceExtensions.size() - devExts.size() << " of them optional\n";
 	}
 
 	template <class... Ts>
-	std::vector<std::array<std::pair<std::string, uint32_t>, 4>> VulkanContext::ratePhysicalDevices(uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo) {
+	std::vector<std::array<std::pair<std::string, uint32_t>, 4>> VulkanContext::ratePhysicalDevices(std::vector<vk::raii::PhysicalDevice> const& physicalDevices, uint32_t const& apiVersion, std::vector<const char*> const& devExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo) {
 		std::vector<std::array<std::pair<std::string, uint32_t>, 4>> physicalDeviceRatings{};
-		std::vector<vk::raii::PhysicalDevice> physicalDevices = instance.enumeratePhysicalDevices();
 
 		for (vk::raii::PhysicalDevice const& phyDev : physicalDevices) {
 			std::array<std::pair<std::string, uint32_t>, 4> propertyChecklist = { {
@@ -203,6 +344,35 @@ namespace Vulkan {
 		return physicalDeviceRatings;
 	}
 
+	// only what decides the selection, the queue priorities and which optional features get enabled do not
+	template <class... Ts>
+	uint64_t VulkanContext::hashRequirements(uint32_t const& apiVersion, std::vector<const char*> const& devExts, std::vector<const char*> const& optionalDevExts, vk::StructureChain<Ts...> const& devFeats, std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo) {
+		uint64_t seed = General::hashValue(apiVersion);
+		for (const char* extension : devExts) {
+			seed = General::hashValue(std::string(extension), seed);
+		}
+		seed = General::hashValue(devExts.size(), seed);
+		for (const char* extension : optionalDevExts) {
+			seed = General::hashValue(std::string(extension), seed);
+		}
+		seed = General::hashValue(optionalDevExts.size(), seed);
+		((seed = hashFeatureBundle(devFeats.get<Ts>(), seed)), ...);
+		for (std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>> const& queueFamily : queuesInfo) {
+			seed = General::hashValue(static_cast<uint32_t>(std::get<0>(queueFamily)), seed);
+			seed = General::hashValue(std::get<1>(queueFamily), seed);
+		}
+
+		return seed;
+	}
+
+	// the bools after pNext, the pointer itself differs between launches
+	template <class T>
+	uint64_t VulkanContext::hashFeatureBundle(T const& features, uint64_t seed) {
+		size_t boolOffset = offsetof(T, pNext) + sizeof(void*);
+
+		return General::fnv1a(reinterpret_cast<char const*>(&features) + boolOffset, sizeof(T) - boolOffset, seed);
+	}
+
 	template <class... Ts>
 	bool VulkanContext::hasPhysicalDeviceFeatures(vk::raii::PhysicalDevice const& phyDev, vk::StructureChain<Ts...> const& features) {
 		vk::StructureChain<Ts...> availableFeatures = phyDev.getFeatures2<Ts...>();
@@ -1 +1,3 @@
-C:/VulkanSDK/1.4.321.1/Bin/slangc.exe shader.slang -target spirv -profile spirv_1_4 -fvk-use-entrypoint-name -entry vertexShader -stage vertex -entry fragmentShader -stage fragment -o shader.spv
\ No newline at end of file
+C:/VulkanSDK/1.4.321.1/Bin/slangc.exe shader.slang -target spirv -profile spirv_1_4 -fvk-use-entrypoint-name -entry vertexShader -stage vertex -entry fragmentShader -stage fragment -o shader.spv
+C:/VulkanSDK/1.4.321.1/Bin/slangc.exe hiz.slang -target spirv -profile spirv_1_4 -fvk-use-entrypoint-name -entry reduceDepth -stage compute -o hiz.spv
+C:/VulkanSDK/1.4.321.1/Bin/slangc.exe downsample.slang -target spirv -profile spirv_1_4 -fvk-use-entrypoint-name -entry downsample -stage compute -default-image-format-unknown -o downsample.spv
\ No newline at end of file
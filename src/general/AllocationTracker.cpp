@@ -0,0 +1,324 @@
+#include "general/AllocationTracker.h"
+
+#ifdef GH_TRACK_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "general/Hash.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <execinfo.h>
+#endif
+
+namespace General {
+	// trivial so it is constant initialized, the hook can touch it on a thread before anything else has run there
+	struct ThreadAllocationState {
+		bool inFrame;
+		// set while the hook itself is running, the stack capture may allocate the first time it is used
+		bool inHook;
+		uint32_t sinceSample;
+		uint64_t count;
+		uint64_t bytes;
+	};
+
+	thread_local ThreadAllocationState threadState{};
+
+	// the tracker's own frames, operator new itself is left at the top of every stack
+	static constexpr uint32_t OWN_FRAMES = 2;
+
+	AllocationTracker::AllocationTracker() : callsites{}, callsiteCount{ 0 }, droppedSamples{ 0 }, callsitesMutex{}, sampleInterval{ 0 }, lastFrame{}, frameTotals{}, worstFrame{}, trackedFrames{ 0 }, allocatingFrames{ 0 }, processCount{ 0 }, processBytes{ 0 } {
+
+	}
+
+	// never destroyed, other statics' destructors can still allocate at exit
+	AllocationTracker& AllocationTracker::get() {
+		alignas(AllocationTracker) static unsigned char storage[sizeof(AllocationTracker)];
+		static AllocationTracker* tracker = new (storage) AllocationTracker();
+		return *tracker;
+	}
+
+	void AllocationTracker::onAllocation(size_t const& size) {
+		processCount.fetch_add(1, std::memory_order_relaxed);
+		processBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (!threadState.inFrame || threadState.inHook) {
+			return;
+		}
+
+		++threadState.count;
+		threadState.bytes += size;
+
+		uint32_t interval = sampleInterval.load(std::memory_order_relaxed);
+		if (interval != 0 && ++threadState.sinceSample >= interval) {
+			threadState.sinceSample = 0;
+			threadState.inHook = true;
+			sampleCallsite(size);
+			threadState.inHook = false;
+		}
+	}
+
+	void AllocationTracker::sampleCallsite(size_t const& size) {
+		std::array<void*, MAX_DEPTH> frames{};
+		uint32_t depth = 0;
+
+#ifdef _WIN32
+		depth = CaptureStackBackTrace(OWN_FRAMES, MAX_DEPTH, frames.data(), nullptr);
+#else
+		std::array<void*, MAX_DEPTH + OWN_FRAMES> captured{};
+		int capturedDepth = backtrace(captured.data(), static_cast<int>(captured.size()));
+		for (int i = OWN_FRAMES; i < capturedDepth; i++) {
+			frames[depth++] = captured[i];
+		}
+#endif
+
+		uint64_t hash = fnv1a(frames.data(), depth * sizeof(void*));
+
+		std::lock_guard<std::mutex> lock(callsitesMutex);
+		for (uint32_t i = 0; i < callsiteCount; i++) {
+			if (callsites[i].hash == hash && callsites[i].depth == depth) {
+				++callsites[i].count;
+				callsites[i].bytes += size;
+				return;
+			}
+		}
+
+		if (callsiteCount == MAX_CALLSITES) {
+			++droppedSamples;
+			return;
+		}
+
+		callsites[callsiteCount++] = Callsite{ .frames = frames, .depth = depth, .hash = hash, .count = 1, .bytes = size };
+	}
+
+	void AllocationTracker::beginFrame() {
+		threadState.count = 0;
+		threadState.bytes = 0;
+		threadState.inFrame = true;
+	}
+
+	void AllocationTracker::endFrame() {
+		threadState.inFrame = false;
+
+		lastFrame = FrameAllocations{ .count = threadState.count, .bytes = threadState.bytes };
+		frameTotals.count += lastFrame.count;
+		frameTotals.bytes += lastFrame.bytes;
+		if (lastFrame.count > worstFrame.count) {
+			worstFrame = lastFrame;
+		}
+		++trackedFrames;
+		if (lastFrame.count != 0) {
+			++allocatingFrames;
+		}
+	}
+
+	void AllocationTracker::setSampleInterval(uint32_t const& interval) {
+		sampleInterval.store(interval, std::memory_order_relaxed);
+	}
+
+	void AllocationTracker::resetStatistics() {
+		lastFrame = FrameAllocations{};
+		frameTotals = FrameAllocations{};
+		worstFrame = FrameAllocations{};
+		trackedFrames = 0;
+		allocatingFrames = 0;
+
+		std::lock_guard<std::mutex> lock(callsitesMutex);
+		callsiteCount = 0;
+		droppedSamples = 0;
+	}
+
+	FrameAllocations const& AllocationTracker::getLastFrame() const {
+		return lastFrame;
+	}
+
+	uint64_t AllocationTracker::getTrackedFrames() const {
+		return trackedFrames;
+	}
+
+	uint64_t AllocationTracker::getAllocatingFrames() const {
+		return allocatingFrames;
+	}
+
+	void AllocationTracker::printSummary() {
+		std::cout << "\tAllocations: last frame " << lastFrame.count << " (" << lastFrame.bytes << " bytes), worst " << worstFrame.count << " (" << worstFrame.bytes << " bytes), " << allocatingFrames << " of " << trackedFrames << " frames allocated\n";
+	}
+
+	void AllocationTracker::printReport(uint32_t const& topCount) {
+		double perFrame = trackedFrames == 0 ? 0.0 : static_cast<double>(frameTotals.count) / static_cast<double>(trackedFrames);
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "Allocations in " << trackedFrames << " frames: " << frameTotals.count << " (" << frameTotals.bytes << " bytes), " << perFrame << " per frame, " << allocatingFrames << " frames allocated\n";
+		std::cout << "Allocations over the whole process: " << processCount.load() << " (" << processBytes.load() << " bytes)\n";
+		std::cout << std::defaultfloat;
+
+		uint32_t interval = sampleInterval.load(std::memory_order_relaxed);
+		if (interval == 0) {
+			std::cout << "Callsite sampling is off\n";
+			return;
+		}
+
+		std::vector<Callsite> sorted{};
+		uint64_t dropped = 0;
+		{
+			std::lock_guard<std::mutex> lock(callsitesMutex);
+			sorted.assign(callsites.begin(), callsites.begin() + callsiteCount);
+			dropped = droppedSamples;
+		}
+		std::sort(sorted.begin(), sorted.end(), [](Callsite const& a, Callsite const& b) { return a.count > b.count; });
+
+		std::cout << "Sampled every " << interval << " frame allocations, " << sorted.size() << " distinct callsites, " << dropped << " samples dropped with the table full\n";
+		for (uint32_t i = 0; i < std::min<uint32_t>(topCount, static_cast<uint32_t>(sorted.size())); i++) {
+			Callsite const& callsite = sorted[i];
+			std::cout << "\t#" << i << ": " << callsite.count << " samples, " << callsite.bytes << " bytes\n";
+
+#ifdef _WIN32
+			// module and offset, the pdb turns these into lines
+			for (uint32_t frame = 0; frame < callsite.depth; frame++) {
+				HMODULE module = nullptr;
+				char modulePath[MAX_PATH] = "?";
+				if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, reinterpret_cast<LPCSTR>(callsite.frames[frame]), &module)) {
+					GetModuleFileNameA(module, modulePath, MAX_PATH);
+				}
+				char const* moduleName = strrchr(modulePath, '\\');
+				uintptr_t offset = reinterpret_cast<uintptr_t>(callsite.frames[frame]) - reinterpret_cast<uintptr_t>(module);
+				std::cout << "\t\t" << (moduleName != nullptr ? moduleName + 1 : modulePath) << "+0x" << std::hex << offset << std::dec << '\n';
+			}
+#else
+			char** symbols = backtrace_symbols(callsite.frames.data(), static_cast<int>(callsite.depth));
+			for (uint32_t frame = 0; frame < callsite.depth; frame++) {
+				std::cout << "\t\t" << (symbols != nullptr ? symbols[frame] : "?") << '\n';
+			}
+			free(symbols);
+#endif
+		}
+	}
+
+	AllocationFrame::AllocationFrame() {
+		AllocationTracker::get().beginFrame();
+	}
+
+	AllocationFrame::~AllocationFrame() {
+		AllocationTracker::get().endFrame();
+	}
+}
+
+#ifdef _WIN32
+static void* alignedAllocate(std::size_t const& size, std::size_t const& alignment) {
+	return _aligned_malloc(size == 0 ? 1 : size, alignment);
+}
+
+static void alignedFree(void* pointer) {
+	_aligned_free(pointer);
+}
+#else
+static void* alignedAllocate(std::size_t const& size, std::size_t const& alignment) {
+	void* pointer = nullptr;
+	return posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size == 0 ? 1 : size) == 0 ? pointer : nullptr;
+}
+
+static void alignedFree(void* pointer) {
+	free(pointer);
+}
+#endif
+
+void* operator new(std::size_t size) {
+	General::AllocationTracker::get().onAllocation(size);
+	void* pointer = malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+	General::AllocationTracker::get().onAllocation(size);
+	return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	General::AllocationTracker::get().onAllocation(size);
+	void* pointer = alignedAllocate(size, static_cast<std::size_t>(alignment));
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+	General::AllocationTracker::get().onAllocation(size);
+	return alignedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+	return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, std::nothrow_t const&) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, std::nothrow_t const&) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	alignedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	alignedFree(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, std::nothrow_t const&) noexcept {
+	alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, std::nothrow_t const&) noexcept {
+	alignedFree(pointer);
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "general/ImageWriter.h"
+#include <array>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+namespace General {
+	static std::array<uint32_t, 256> makeCrcTable() {
+		std::array<uint32_t, 256> table{};
+
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+			}
+			table[i] = crc;
+		}
+
+		return table;
+	}
+
+	static uint32_t crc32(uint8_t const* data, size_t const& size, uint32_t crc) {
+		static const std::array<uint32_t, 256> table = makeCrcTable();
+
+		for (size_t i = 0; i < size; i++) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+
+		return crc;
+	}
+
+	static void appendBigEndian(std::vector<uint8_t>& out, uint32_t const& value) {
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	// length, type, data, then the crc over type and data
+	static void appendChunk(std::vector<uint8_t>& out, const char* type, std::vector<uint8_t> const& data) {
+		appendBigEndian(out, static_cast<uint32_t>(data.size()));
+
+		size_t typeStart = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		appendBigEndian(out, crc32(out.data() + typeStart, out.size() - typeStart, 0xFFFFFFFFu) ^ 0xFFFFFFFFu);
+	}
+
+	bool writePng(std::string const& path, uint32_t const& width, uint32_t const& height, uint8_t const* rgba) {
+		size_t rowSize = static_cast<size_t>(width) * 4;
+
+		// every row gets filter type 0 in front of it
+		std::vector<uint8_t> filtered{};
+		filtered.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++) {
+			filtered.push_back(0);
+			filtered.insert(filtered.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+		}
+
+		std::vector<uint8_t> zlib{ 0x78, 0x01 };
+		zlib.reserve(filtered.size() + filtered.size() / 65535 * 5 + 16);
+		uint32_t adlerA = 1;
+		uint32_t adlerB = 0;
+		size_t offset = 0;
+		do {
+			size_t blockSize = std::min<size_t>(65535, filtered.size() - offset);
+			bool last = offset + blockSize == filtered.size();
+
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(blockSize));
+			zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+			zlib.push_back(static_cast<uint8_t>(~blockSize));
+			zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			zlib.insert(zlib.end(), filtered.begin() + offset, filtered.begin() + offset + blockSize);
+
+			for (size_t i = offset; i < offset + blockSize; i++) {
+				adlerA = (adlerA + filtered[i]) % 65521;
+				adlerB = (adlerB + adlerA) % 65521;
+			}
+			offset += blockSize;
+		} while (offset < filtered.size());
+		appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+		std::vector<uint8_t> header{};
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		// 8 bit depth, rgba, deflate, no filter method extensions, no interlace
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+		std::vector<uint8_t> png{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		appendChunk(png, "IHDR", header);
+		appendChunk(png, "IDAT", zlib);
+		appendChunk(png, "IEND", {});
+
+		return writeRaw(path, png.data(), png.size());
+	}
+
+	bool writeRaw(std::string const& path, void const* data, size_t const& size) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+		return static_cast<bool>(file);
+	}
+}
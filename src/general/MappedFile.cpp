@@ -0,0 +1,110 @@
+#include "general/MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace General {
+#ifdef _WIN32
+	MappedFile::MappedFile(std::string const& path) : data{ nullptr }, size{ 0 }, fileHandle{ INVALID_HANDLE_VALUE }, mappingHandle{ nullptr } {
+		fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Failure opening file at " + path);
+		}
+
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(fileHandle, &fileSize);
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		// empty files cannot be mapped, they are left as a null view of size 0
+		if (size != 0) {
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			data = mappingHandle == nullptr ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (data == nullptr) {
+				unmap();
+				throw std::runtime_error("Failure mapping file at " + path);
+			}
+		}
+	}
+
+	MappedFile::MappedFile(MappedFile&& moveFrom) : data{ moveFrom.data }, size{ moveFrom.size }, fileHandle{ moveFrom.fileHandle }, mappingHandle{ moveFrom.mappingHandle } {
+		moveFrom.data = nullptr;
+		moveFrom.size = 0;
+		moveFrom.fileHandle = INVALID_HANDLE_VALUE;
+		moveFrom.mappingHandle = nullptr;
+	}
+
+	void MappedFile::unmap() {
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle != INVALID_HANDLE_VALUE) {
+			CloseHandle(fileHandle);
+		}
+	}
+#else
+	MappedFile::MappedFile(std::string const& path) : data{ nullptr }, size{ 0 }, fileDescriptor{ -1 } {
+		fileDescriptor = open(path.c_str(), O_RDONLY);
+		if (fileDescriptor == -1) {
+			throw std::runtime_error("Failure opening file at " + path);
+		}
+
+		struct stat fileStatus{};
+		if (fstat(fileDescriptor, &fileStatus) != 0) {
+			unmap();
+			throw std::runtime_error("Failure reading size of file at " + path);
+		}
+		size = static_cast<size_t>(fileStatus.st_size);
+
+		// empty files cannot be mapped, they are left as a null view of size 0
+		if (size != 0) {
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+			if (mapped == MAP_FAILED) {
+				unmap();
+				throw std::runtime_error("Failure mapping file at " + path);
+			}
+
+			data = mapped;
+			madvise(mapped, size, MADV_SEQUENTIAL);
+		}
+	}
+
+	MappedFile::MappedFile(MappedFile&& moveFrom) : data{ moveFrom.data }, size{ moveFrom.size }, fileDescriptor{ moveFrom.fileDescriptor } {
+		moveFrom.data = nullptr;
+		moveFrom.size = 0;
+		moveFrom.fileDescriptor = -1;
+	}
+
+	void MappedFile::unmap() {
+		if (data != nullptr) {
+			munmap(const_cast<void*>(data), size);
+		}
+		if (fileDescriptor != -1) {
+			close(fileDescriptor);
+		}
+	}
+#endif
+
+	MappedFile::~MappedFile() {
+		unmap();
+	}
+
+	void const* MappedFile::getData() const {
+		return data;
+	}
+
+	size_t MappedFile::getSize() const {
+		return size;
+	}
+}
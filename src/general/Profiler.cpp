@@ -0,0 +1,131 @@
+#include "general/Profiler.h"
+
+#ifdef GH_PROFILING
+
+#include <fstream>
+#include <iostream>
+
+namespace General {
+	ProfileRing::ProfileRing(uint32_t const& threadIndex) : slots{}, head{ 0 }, threadIndex{ threadIndex }, threadName{}, depth{ 0 } {
+
+	}
+
+	void ProfileRing::push(ProfileSpan const& span) {
+		uint64_t index = head.load(std::memory_order_relaxed);
+		Slot& slot = slots[index % CAPACITY];
+		slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(span.name, std::memory_order_relaxed);
+		slot.startNs.store(span.startNs, std::memory_order_relaxed);
+		slot.endNs.store(span.endNs, std::memory_order_relaxed);
+		slot.depth.store(span.depth, std::memory_order_relaxed);
+		slot.sequence.store(2 * index + 2, std::memory_order_release);
+		head.store(index + 1, std::memory_order_release);
+	}
+
+	std::vector<ProfileSpan> ProfileRing::snapshot() const {
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+		std::vector<ProfileSpan> copied{};
+		copied.reserve(end - begin);
+		for (uint64_t i = begin; i < end; i++) {
+			Slot const& slot = slots[i % CAPACITY];
+			// a slot holding a later span, or one the owner is writing, was lapped during the copy
+			uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence != 2 * i + 2) {
+				continue;
+			}
+			ProfileSpan span = { slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed), slot.endNs.load(std::memory_order_relaxed), slot.depth.load(std::memory_order_relaxed) };
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+				continue;
+			}
+			copied.push_back(span);
+		}
+
+		return copied;
+	}
+
+	Profiler::Profiler() : epoch{ std::chrono::steady_clock::now() }, rings{} {
+
+	}
+
+	Profiler& Profiler::get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	ProfileRing& Profiler::getThreadRing() {
+		thread_local ProfileRing* ring = nullptr;
+
+		if (ring == nullptr) {
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			rings.push_back(std::make_shared<ProfileRing>(static_cast<uint32_t>(rings.size())));
+			ring = rings.back().get();
+		}
+
+		return *ring;
+	}
+
+	uint64_t Profiler::now() const {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+	}
+
+	void Profiler::setThreadName(std::string const& name) {
+		ProfileRing& ring = getThreadRing();
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		ring.threadName = name;
+	}
+
+	void Profiler::writeChromeTrace(std::string const& path) {
+		std::vector<std::shared_ptr<ProfileRing>> ringsCopy{};
+		std::vector<std::string> threadNames{};
+		{
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			ringsCopy = rings;
+			for (std::shared_ptr<ProfileRing> const& ring : rings) {
+				threadNames.push_back(ring->threadName.empty() ? "thread " + std::to_string(ring->threadIndex) : ring->threadName);
+			}
+		}
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file) {
+			std::cout << "Could not open " << path << " for the profile trace\n";
+			return;
+		}
+
+		// timestamps are in microseconds with the nanoseconds kept as decimals
+		auto toUs = [](uint64_t const& ns) {
+			return std::to_string(ns / 1000) + '.' + std::string(3 - std::to_string(ns % 1000).size(), '0') + std::to_string(ns % 1000);
+		};
+
+		file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+		size_t spanCount = 0;
+		for (size_t i = 0; i < ringsCopy.size(); i++) {
+			std::shared_ptr<ProfileRing> const& ring = ringsCopy[i];
+			file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadIndex << ",\"args\":{\"name\":\"" << threadNames[i] << "\"}}";
+			first = false;
+
+			for (ProfileSpan const& span : ring->snapshot()) {
+				file << ",\n{\"name\":\"" << span.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadIndex << ",\"ts\":" << toUs(span.startNs) << ",\"dur\":" << toUs(span.endNs - span.startNs) << ",\"args\":{\"depth\":" << span.depth << "}}";
+				++spanCount;
+			}
+		}
+		file << "\n]}\n";
+
+		std::cout << "Wrote " << spanCount << " profile spans from " << ringsCopy.size() << " threads to " << path << '\n';
+	}
+
+	ProfileZone::ProfileZone(const char* name) : ring{ Profiler::get().getThreadRing() }, name{ name }, startNs{ Profiler::get().now() } {
+		++ring.depth;
+	}
+
+	ProfileZone::~ProfileZone() {
+		--ring.depth;
+		ring.push(ProfileSpan{ name, startNs, Profiler::get().now(), ring.depth });
+	}
+}
+
+#endif
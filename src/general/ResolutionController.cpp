@@ -0,0 +1,54 @@
+#include "general/ResolutionController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace General {
+	ResolutionController::ResolutionController(ResolutionControllerSettings const& settings) : settings{}, integral{ 0.0 }, scale{ 1.0f }, framesSinceChange{ 0 } {
+		reset(settings);
+	}
+
+	void ResolutionController::reset(ResolutionControllerSettings const& newSettings) {
+		settings = newSettings;
+		settings.minScale = std::clamp(settings.minScale, 0.1f, 1.0f);
+		settings.maxScale = std::clamp(settings.maxScale, settings.minScale, 1.0f);
+		settings.step = std::max(settings.step, 0.01f);
+		integral = 0.0;
+		scale = settings.maxScale;
+		framesSinceChange = 0;
+	}
+
+	// the output is relative to the maximum scale, so with no error and nothing integrated the full size is rendered
+	bool ResolutionController::update(double const& frameMilliseconds) {
+		if (frameMilliseconds <= 0.0 || settings.targetMilliseconds <= 0.0 || ++framesSinceChange <= settings.settleFrames) {
+			return false;
+		}
+
+		double error = (settings.targetMilliseconds - frameMilliseconds) / settings.targetMilliseconds;
+		double output = settings.maxScale + settings.proportionalGain * error + settings.integralGain * (integral + error);
+		bool saturatedLow = output <= settings.minScale && error < 0.0;
+		bool saturatedHigh = output >= settings.maxScale && error > 0.0;
+		if (!saturatedLow && !saturatedHigh) {
+			integral += error;
+		}
+
+		float clamped = static_cast<float>(std::clamp(output, static_cast<double>(settings.minScale), static_cast<double>(settings.maxScale)));
+		// snapped down from the maximum so the maximum itself is always reachable
+		float snapped = settings.maxScale - std::round((settings.maxScale - clamped) / settings.step) * settings.step;
+		snapped = std::clamp(snapped, settings.minScale, settings.maxScale);
+		if (std::abs(snapped - scale) < settings.step * 0.5f) {
+			return false;
+		}
+
+		scale = snapped;
+		framesSinceChange = 0;
+		return true;
+	}
+
+	float ResolutionController::getScale() const {
+		return scale;
+	}
+
+	ResolutionControllerSettings const& ResolutionController::getSettings() const {
+		return settings;
+	}
+}
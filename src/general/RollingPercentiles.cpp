@@ -0,0 +1,45 @@
+#include "general/RollingPercentiles.h"
+#include <algorithm>
+#include <cmath>
+
+namespace General {
+	RollingPercentiles::RollingPercentiles(uint32_t const& windowSize) : samples{}, sorted{}, windowSize{ windowSize == 0 ? 1 : windowSize }, next{ 0 } {
+		samples.reserve(this->windowSize);
+		sorted.reserve(this->windowSize);
+	}
+
+	void RollingPercentiles::add(double const& sample) {
+		if (samples.size() < windowSize) {
+			samples.push_back(sample);
+		} else {
+			samples[next] = sample;
+		}
+
+		next = (next + 1) % windowSize;
+	}
+
+	double RollingPercentiles::percentile(double const& fraction) const {
+		if (samples.empty()) {
+			return 0.0;
+		}
+
+		sorted.assign(samples.begin(), samples.end());
+		size_t rank = static_cast<size_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * sorted.size()));
+		size_t index = rank == 0 ? 0 : rank - 1;
+		std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+
+		return sorted[index];
+	}
+
+	double RollingPercentiles::getLatest() const {
+		if (samples.empty()) {
+			return 0.0;
+		}
+
+		return samples[(next + windowSize - 1) % windowSize];
+	}
+
+	uint32_t RollingPercentiles::getSampleCount() const {
+		return static_cast<uint32_t>(samples.size());
+	}
+}
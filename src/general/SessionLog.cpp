@@ -0,0 +1,174 @@
+#include "general/SessionLog.h"
+#include "general/MappedFile.h"
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+
+namespace General {
+	template <class T>
+	static void writeValue(std::ofstream& file, T const& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	static void writeVec3(std::ofstream& file, glm::vec3 const& value) {
+		writeValue(file, value.x);
+		writeValue(file, value.y);
+		writeValue(file, value.z);
+	}
+
+	// reads are bounds checked, a truncated log throws instead of replaying garbage
+	class LogReader {
+	private:
+		uint8_t const* data;
+		size_t size;
+		size_t offset;
+	public:
+		LogReader(void const* data, size_t const& size) : data{ reinterpret_cast<uint8_t const*>(data) }, size{ size }, offset{ 0 } {
+
+		}
+
+		template <class T>
+		T read() {
+			if (offset + sizeof(T) > size) {
+				throw std::runtime_error("Session log is truncated");
+			}
+
+			T value{};
+			memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		glm::vec3 readVec3() {
+			float x = read<float>();
+			float y = read<float>();
+			float z = read<float>();
+			return glm::vec3(x, y, z);
+		}
+	};
+
+	SessionRecorder::SessionRecorder(std::string const& path, uint32_t const& width, uint32_t const& height) : file(path, std::ios::binary | std::ios::trunc), path{ path }, frameCount{ 0 } {
+		if (!file) {
+			throw std::runtime_error("Could not open " + path + " for recording");
+		}
+
+		file.write(MAGIC, sizeof(MAGIC));
+		writeValue(file, VERSION);
+		writeValue(file, width);
+		writeValue(file, height);
+		writeValue(file, frameCount);
+	}
+
+	SessionRecorder::~SessionRecorder() {
+		close();
+	}
+
+	void SessionRecorder::writeFrame(FrameRecord const& frame) {
+		writeValue(file, frame.deltaTime);
+		writeVec3(file, frame.camera.position);
+		writeVec3(file, frame.camera.target);
+		writeVec3(file, frame.camera.up);
+		writeValue(file, frame.camera.fovY);
+		writeValue(file, static_cast<uint16_t>(frame.events.size()));
+		writeValue(file, static_cast<uint16_t>(frame.spawns.size()));
+
+		for (InputEvent const& event : frame.events) {
+			writeValue(file, event.type);
+			writeValue(file, event.action);
+			writeValue(file, event.mods);
+			writeValue(file, event.code);
+			writeValue(file, event.x);
+			writeValue(file, event.y);
+		}
+
+		for (SpawnedObject const& spawn : frame.spawns) {
+			writeValue(file, spawn.id);
+			writeValue(file, spawn.kind);
+			writeVec3(file, spawn.position);
+			writeVec3(file, spawn.rotation);
+			writeVec3(file, spawn.scale);
+		}
+
+		++frameCount;
+	}
+
+	void SessionRecorder::close() {
+		if (!file.is_open()) {
+			return;
+		}
+
+		file.seekp(sizeof(MAGIC) + 3 * sizeof(uint32_t));
+		writeValue(file, frameCount);
+		file.close();
+
+		std::cout << "Recorded " << frameCount << " frames to " << path << '\n';
+	}
+
+	uint32_t SessionRecorder::getFrameCount() const {
+		return frameCount;
+	}
+
+	SessionReplay::SessionReplay(std::string const& path) : frames{}, width{ 0 }, height{ 0 } {
+		MappedFile log(path);
+		LogReader reader(log.getData(), log.getSize());
+
+		char magic[4]{};
+		for (char& c : magic) {
+			c = reader.read<char>();
+		}
+		if (memcmp(magic, SessionRecorder::MAGIC, sizeof(magic)) != 0) {
+			throw std::runtime_error(path + " is not a session log");
+		}
+		uint32_t version = reader.read<uint32_t>();
+		if (version != SessionRecorder::VERSION) {
+			throw std::runtime_error(path + " is session log version " + std::to_string(version) + ", expected " + std::to_string(SessionRecorder::VERSION));
+		}
+		width = reader.read<uint32_t>();
+		height = reader.read<uint32_t>();
+		uint32_t frameCount = reader.read<uint32_t>();
+
+		frames.resize(frameCount);
+		for (FrameRecord& frame : frames) {
+			frame.deltaTime = reader.read<double>();
+			frame.camera.position = reader.readVec3();
+			frame.camera.target = reader.readVec3();
+			frame.camera.up = reader.readVec3();
+			frame.camera.fovY = reader.read<float>();
+			uint16_t eventCount = reader.read<uint16_t>();
+			uint16_t spawnCount = reader.read<uint16_t>();
+
+			frame.events.resize(eventCount);
+			for (InputEvent& event : frame.events) {
+				event.type = reader.read<InputEventType>();
+				event.action = reader.read<uint8_t>();
+				event.mods = reader.read<uint16_t>();
+				event.code = reader.read<int32_t>();
+				event.x = reader.read<float>();
+				event.y = reader.read<float>();
+			}
+
+			frame.spawns.resize(spawnCount);
+			for (SpawnedObject& spawn : frame.spawns) {
+				spawn.id = reader.read<uint32_t>();
+				spawn.kind = reader.read<uint32_t>();
+				spawn.position = reader.readVec3();
+				spawn.rotation = reader.readVec3();
+				spawn.scale = reader.readVec3();
+			}
+		}
+
+		std::cout << "Loaded " << frames.size() << " frames recorded at " << width << "x" << height << " from " << path << '\n';
+	}
+
+	std::vector<FrameRecord> const& SessionReplay::getFrames() const {
+		return frames;
+	}
+
+	uint32_t SessionReplay::getWidth() const {
+		return width;
+	}
+
+	uint32_t SessionReplay::getHeight() const {
+		return height;
+	}
+}
@@ -0,0 +1,75 @@
+#include "general/StartupTimeline.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace General {
+	StartupTimeline::StartupTimeline() : processStart{ std::chrono::steady_clock::now() }, steps{}, finished{ false } {
+
+	}
+
+	StartupTimeline& StartupTimeline::get() {
+		static StartupTimeline timeline;
+		return timeline;
+	}
+
+	void StartupTimeline::record(std::string const& name, std::chrono::steady_clock::time_point const& start, std::chrono::steady_clock::time_point const& end) {
+		if (finished.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(stepsMutex);
+		steps.push_back(Step{ name, std::this_thread::get_id(), start, end });
+	}
+
+	void StartupTimeline::markFirstFrame() {
+		if (finished.exchange(true)) {
+			return;
+		}
+
+		printReport(std::chrono::steady_clock::now());
+	}
+
+	bool StartupTimeline::isFinished() const {
+		return finished.load(std::memory_order_relaxed);
+	}
+
+	void StartupTimeline::printReport(std::chrono::steady_clock::time_point const& firstFrame) {
+		std::lock_guard<std::mutex> lock(stepsMutex);
+
+		std::sort(steps.begin(), steps.end(), [](Step const& a, Step const& b) { return a.start < b.start; });
+
+		auto toMs = [](std::chrono::steady_clock::duration const& duration) {
+			return std::chrono::duration<double, std::milli>(duration).count();
+		};
+
+		std::vector<std::thread::id> threads{};
+		std::chrono::steady_clock::duration serialTime{};
+
+		std::cout << "-------------------------------------------------------------------------------------------------------\n";
+		std::cout << "Startup report (ms since process start)\n";
+		std::cout << std::fixed << std::setprecision(2);
+		for (Step const& step : steps) {
+			auto found = std::find(threads.begin(), threads.end(), step.thread);
+			size_t threadIndex = found - threads.begin();
+			if (found == threads.end()) {
+				threads.push_back(step.thread);
+			}
+
+			serialTime += step.end - step.start;
+			std::cout << "\t" << std::left << std::setw(28) << step.name << std::right << " thread " << threadIndex << "  start " << std::setw(9) << toMs(step.start - processStart) << "  took " << std::setw(9) << toMs(step.end - step.start) << '\n';
+		}
+		std::cout << "Sum of all steps: " << toMs(serialTime) << " ms on " << threads.size() << " threads\n";
+		std::cout << "Time to first frame: " << toMs(firstFrame - processStart) << " ms\n";
+		std::cout << std::defaultfloat;
+		std::cout << "-------------------------------------------------------------------------------------------------------\n";
+	}
+
+	StartupStep::StartupStep(const char* name) : name{ name }, start{ std::chrono::steady_clock::now() } {
+
+	}
+
+	StartupStep::~StartupStep() {
+		StartupTimeline::get().record(name, start, std::chrono::steady_clock::now());
+	}
+}
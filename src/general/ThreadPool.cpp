@@ -0,0 +1,73 @@
+#include "general/ThreadPool.h"
+#include "general/Profiler.h"
+
+namespace General {
+	ThreadPool::ThreadPool(uint32_t const& threadCount) : workers{}, tasks{}, busyWorkers{ 0 }, stopping{ false } {
+		uint32_t count = threadCount == 0 ? 1 : threadCount;
+
+		for (uint32_t i = 0; i < count; i++) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			stopping = true;
+		}
+		tasksAvailable.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::submit(std::function<void()> task) {
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			tasks.push_back(std::move(task));
+		}
+		tasksAvailable.notify_one();
+	}
+
+	void ThreadPool::waitIdle() {
+		std::unique_lock<std::mutex> lock(tasksMutex);
+		tasksDrained.wait(lock, [this]() { return tasks.empty() && busyWorkers == 0; });
+	}
+
+	uint32_t ThreadPool::getThreadCount() const {
+		return static_cast<uint32_t>(workers.size());
+	}
+
+	// remaining tasks are still drained when stopping so nothing that was submitted gets dropped
+	void ThreadPool::workerLoop() {
+		GH_PROFILE_THREAD("pool worker");
+
+		while (true) {
+			std::function<void()> task{};
+
+			{
+				std::unique_lock<std::mutex> lock(tasksMutex);
+				tasksAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+				if (tasks.empty()) {
+					return;
+				}
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+				++busyWorkers;
+			}
+
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock(tasksMutex);
+				--busyWorkers;
+				if (tasks.empty() && busyWorkers == 0) {
+					tasksDrained.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -24,6 +24,12 @@ namespace General {
 				.binding = 0,
 				.format = vk::Format::eR32G32Sfloat,
 				.offset = offsetof(Vertex, position)
+			},
+			vk::VertexInputAttributeDescription{
+				.location = 2,
+				.binding = 0,
+				.format = vk::Format::eR32G32Sfloat,
+				.offset = offsetof(Vertex, texCoord)
 			}
 		};
 
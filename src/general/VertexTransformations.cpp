@@ -1,4 +1,5 @@
 #include "general/VertexTransformations.h"
+#include "glm/gtc/matrix_transform.hpp"
 
 namespace General {
 	vk::DescriptorSetLayoutBinding VertexTransformations::getDescriptorSetLayoutBinding(uint32_t const& bindingNum, uint32_t const& descCount) {
@@ -12,4 +13,15 @@ namespace General {
 
 		return descSetBinding;
 	}
+
+	VertexTransformations VertexTransformations::compute(float const& time, CameraState const& camera, float const& aspectRatio) {
+		VertexTransformations transformation = {
+			.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+			.view = glm::lookAt(camera.position, camera.target, camera.up),
+			.projection = glm::perspectiveZO(camera.fovY, aspectRatio, NEAR_PLANE, FAR_PLANE)
+		};
+		transformation.projection[1][1] *= -1.0f;
+
+		return transformation;
+	}
 }
\ No newline at end of file
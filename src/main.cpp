@@ -4,65 +4,221 @@
 #include "vulkan/GraphicsEngine.h"
 #include "general/Vertex.h"
 #include "general/VertexTransformations.h"
+#include "general/ThreadPool.h"
+#include "general/StartupTimeline.h"
+#include "general/AllocationTracker.h"
+#include <string>
+#include <cstring>
+#include <filesystem>
+
+int main(int argc, char** argv) {
+	General::StartupTimeline::get();
 
-int main() {
 	try {
+		// --headless [--benchmark <frames>] [--warmup <frames>] [--timestep <ms>] [--report <path>], headless always benchmarks
+		// --capture <every nth frame> [--capture-dir <path>] [--capture-raw]
+		// --record <path> or --replay <path> [--replay-timings <path>], a replay runs at the recorded size and ignores --benchmark
+		// --allocation-samples <every nth frame allocation>, only does anything in builds with GH_TRACK_ALLOCATIONS
+		// --dump-render-graph prints the compiled render graph whenever it is rebuilt
+		// --no-command-buffer-cache records every frame instead of resubmitting the recording for the image and slot
+		// --no-state-filtering issues every bind and dynamic state set even when it repeats the last one
+		// --depth-prepass lays down depth first so the scene only shades the nearest surface
+		// --msaa <samples> renders the scene multisampled and resolves it into the swapchain, lowered to what the device supports
+		// --dynamic-resolution <target GPU ms> [--resolution-scale <min> <max>] scales the scene's resolution to hold the target, upscaling to the window
+		// --occlusion-culling skips draws hidden behind the depth of earlier frames, needs shaders/hiz.spv
+		// --async-compute builds the occlusion culling pyramid on a dedicated compute queue when the device has one
+		// --rescan-devices rates every GPU again instead of taking the one saved in device_profile.bin
+		// --texture <path.ktx2> draws the scene with a KTX2 texture whose finer levels stream in as the scene covers more of the screen
+		// --mip-path <blit|compute> generates the levels of a texture that only has level 0 with one path, by default compute where it can, needs shaders/downsample.spv
+		bool headless = false;
+		Vulkan::BenchmarkSettings benchmark = {
+			.frameCount = 0,
+			.warmupFrameCount = 60,
+			.fixedTimestep = 1.0 / 60.0,
+			.reportPath = "benchmark.json"
+		};
+		Vulkan::CaptureSettings capture = {
+			.mode = Vulkan::CaptureMode::eOff,
+			.interval = 1,
+			.format = Vulkan::CaptureFormat::ePng,
+			.directory = "captures"
+		};
+		std::string recordPath{};
+		std::string replayPath{};
+		std::string replayTimingsPath = "replay_timings.csv";
+		bool dumpRenderGraph = false;
+		bool commandBufferCache = true;
+		bool stateFiltering = true;
+		bool depthPrepass = false;
+		bool occlusionCulling = false;
+		bool asyncCompute = false;
+		bool rescanDevices = false;
+		std::string texturePath{};
+		Vulkan::MipPath mipPath = Vulkan::MipPath::eAuto;
+		uint32_t msaaSamples = 1;
+		bool dynamicResolution = false;
+		General::ResolutionControllerSettings resolutionSettings = Vulkan::GraphicsEngine::DEFAULT_RESOLUTION_SETTINGS;
+		for (int i = 1; i < argc; i++) {
+			bool hasValue = i + 1 < argc;
+			if (strcmp(argv[i], "--headless") == 0) {
+				headless = true;
+			} else if (strcmp(argv[i], "--benchmark") == 0 && hasValue) {
+				benchmark.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+			} else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+				benchmark.warmupFrameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+			} else if (strcmp(argv[i], "--timestep") == 0 && hasValue) {
+				benchmark.fixedTimestep = std::stod(argv[++i]) / 1000.0;
+			} else if (strcmp(argv[i], "--report") == 0 && hasValue) {
+				benchmark.reportPath = argv[++i];
+			} else if (strcmp(argv[i], "--capture") == 0 && hasValue) {
+				capture.interval = static_cast<uint32_t>(std::stoul(argv[++i]));
+				capture.mode = capture.interval <= 1 ? Vulkan::CaptureMode::eContinuous : Vulkan::CaptureMode::eEveryNth;
+			} else if (strcmp(argv[i], "--capture-dir") == 0 && hasValue) {
+				capture.directory = argv[++i];
+			} else if (strcmp(argv[i], "--capture-raw") == 0) {
+				capture.format = Vulkan::CaptureFormat::eRaw;
+			} else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+				recordPath = argv[++i];
+			} else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+				replayPath = argv[++i];
+			} else if (strcmp(argv[i], "--replay-timings") == 0 && hasValue) {
+				replayTimingsPath = argv[++i];
+			} else if (strcmp(argv[i], "--dump-render-graph") == 0) {
+				dumpRenderGraph = true;
+			} else if (strcmp(argv[i], "--no-command-buffer-cache") == 0) {
+				commandBufferCache = false;
+			} else if (strcmp(argv[i], "--no-state-filtering") == 0) {
+				stateFiltering = false;
+			} else if (strcmp(argv[i], "--depth-prepass") == 0) {
+				depthPrepass = true;
+			} else if (strcmp(argv[i], "--occlusion-culling") == 0) {
+				occlusionCulling = true;
+			} else if (strcmp(argv[i], "--async-compute") == 0) {
+				asyncCompute = true;
+			} else if (strcmp(argv[i], "--rescan-devices") == 0) {
+				rescanDevices = true;
+			} else if (strcmp(argv[i], "--texture") == 0 && hasValue) {
+				texturePath = argv[++i];
+			} else if (strcmp(argv[i], "--mip-path") == 0 && hasValue) {
+				++i;
+				if (strcmp(argv[i], "blit") == 0) {
+					mipPath = Vulkan::MipPath::eBlit;
+				} else if (strcmp(argv[i], "compute") == 0) {
+					mipPath = Vulkan::MipPath::eCompute;
+				} else {
+					throw std::runtime_error(std::string("Unknown mip path: ") + argv[i]);
+				}
+			} else if (strcmp(argv[i], "--msaa") == 0 && hasValue) {
+				msaaSamples = static_cast<uint32_t>(std::stoul(argv[++i]));
+			} else if (strcmp(argv[i], "--dynamic-resolution") == 0 && hasValue) {
+				dynamicResolution = true;
+				resolutionSettings.targetMilliseconds = std::stod(argv[++i]);
+			} else if (strcmp(argv[i], "--resolution-scale") == 0 && i + 2 < argc) {
+				resolutionSettings.minScale = std::stof(argv[++i]);
+				resolutionSettings.maxScale = std::stof(argv[++i]);
+			} else if (strcmp(argv[i], "--allocation-samples") == 0 && hasValue) {
+				uint32_t sampleInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+				GH_ALLOCATION_SAMPLE_EVERY(sampleInterval);
+			} else {
+				throw std::runtime_error(std::string("Unknown or incomplete argument: ") + argv[i]);
+			}
+		}
+		std::unique_ptr<General::SessionReplay> replay = replayPath.empty() ? nullptr : std::make_unique<General::SessionReplay>(replayPath);
+		if (headless && benchmark.frameCount == 0 && !replay) {
+			benchmark.frameCount = 600;
+		}
+		bool benchmarking = benchmark.frameCount > 0 || replay;
+
+		// file and mesh loading need no vulkan objects, so they run while the window, instance and device come up
+		General::ThreadPool startupWorkers(2);
+		std::future<std::shared_ptr<Vulkan::SprivBinary const>> shaderLoad = startupWorkers.enqueue([]() {
+			General::StartupStep step("shader file load");
+			return Vulkan::ShaderModuleCache::loadSprivBinary("shaders/shader.spv");
+		});
+		std::future<std::vector<General::Vertex>> meshDecode = startupWorkers.enqueue([]() {
+			General::StartupStep step("mesh decode");
+			return std::vector<General::Vertex>{
+				General::Vertex{ .colour = glm::vec3(1.0f, 0.0f, 0.0f), .position = glm::vec2(-0.5f, -0.5f), .texCoord = glm::vec2(0.0f, 0.0f) },
+				General::Vertex{ .colour = glm::vec3(0.0f, 1.0f, 0.0f), .position = glm::vec2(0.5f, -0.5f), .texCoord = glm::vec2(1.0f, 0.0f) },
+				General::Vertex{ .colour = glm::vec3(0.0f, 0.0f, 1.0f), .position = glm::vec2(0.5f, 0.5f), .texCoord = glm::vec2(1.0f, 1.0f) },
+				General::Vertex{ .colour = glm::vec3(1.0f, 1.0f, 0.0f), .position = glm::vec2(-0.5f, 0.5f), .texCoord = glm::vec2(0.0f, 1.0f) }
+			};
+		});
+
 		Vulkan::VulkanContextInitInfo<vk::PhysicalDeviceFeatures2,
 		vk::PhysicalDeviceVulkan11Features,
+		vk::PhysicalDeviceVulkan12Features,
 		vk::PhysicalDeviceVulkan13Features,
 		vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> contextInfo = {
-			.windowWidth = 800,
-			.windowHeight = 600,
+			.windowWidth = replay ? static_cast<int>(replay->getWidth()) : 800,
+			.windowHeight = replay ? static_cast<int>(replay->getHeight()) : 600,
 			.appName = "GunAndHeart",
+			.headless = headless,
 			.apiVersion = vk::ApiVersion13,
-			.validationLayers = {"VK_LAYER_KHRONOS_validation"},
+			// perf boxes and CI usually lack the layer, and it would skew the numbers anyway
+			.validationLayers = benchmarking ? std::vector<const char*>{} : std::vector<const char*>{"VK_LAYER_KHRONOS_validation"},
 			.deviceExtensions = {
 				vk::KHRSwapchainExtensionName,
 				vk::KHRSpirv14ExtensionName,
 				vk::KHRSynchronization2ExtensionName,
 				vk::KHRCreateRenderpass2ExtensionName
 			},
+			.optionalDeviceExtensions = {
+				vk::EXTExtendedDynamicState3ExtensionName,
+				vk::EXTMemoryBudgetExtensionName
+			},
+			.optionalDeviceFeatures = {
+				.textureCompressionBC = true,
+				.pipelineStatisticsQuery = true,
+				.shaderStorageImageWriteWithoutFormat = true,
+				.shaderStorageImageArrayDynamicIndexing = true
+			},
 			.deviceFeatures = 
 				vk::StructureChain<vk::PhysicalDeviceFeatures2,
 				vk::PhysicalDeviceVulkan11Features,
+				vk::PhysicalDeviceVulkan12Features,
 				vk::PhysicalDeviceVulkan13Features,
 				vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> {
 					{},
 					{.shaderDrawParameters = true },
+					{.timelineSemaphore = true },
 					{.synchronization2 = true, .dynamicRendering = true },
 					{.extendedDynamicState = true }
 				},
 			.queueFamiliesInfo = {
 				{vk::QueueFlagBits::eGraphics, 1, {0.5f}}
-			}
+			},
+			.asyncCompute = asyncCompute,
+			.deviceProfilePath = "device_profile.bin"
 		};
+		if (rescanDevices) {
+			std::filesystem::remove(contextInfo.deviceProfilePath);
+		}
 		Vulkan::VulkanContext context(contextInfo);
 
-		std::vector<General::Vertex> verticies = {
-			General::Vertex{.colour = glm::vec3(1.0f, 0.0f, 0.0f), .position = glm::vec2(-0.5f, -0.5f) },
-			General::Vertex{ .colour = glm::vec3(0.0f, 1.0f, 0.0f), .position = glm::vec2(0.5f, -0.5f) },
-			General::Vertex{ .colour = glm::vec3(0.0f, 0.0f, 1.0f), .position = glm::vec2(0.5f, 0.5f) },
-			General::Vertex{ .colour = glm::vec3(1.0f, 1.0f, 0.0f), .position = glm::vec2(-0.5f, 0.5f) }
-		};
+		std::vector<General::Vertex> verticies = meshDecode.get();
 
 		Vulkan::GraphicsContextInitInfo graphicsContextInfo = {
-			.scFormat = vk::SurfaceFormatKHR(vk::Format::eR8G8B8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear),
-			.scImageCount = 2,
-			.scPresentMode = vk::PresentModeKHR::eMailbox,
-			.scImageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+			// the headless surface only guarantees the bgra formats and fifo
+			.scFormat = vk::SurfaceFormatKHR(headless ? vk::Format::eB8G8R8A8Srgb : vk::Format::eR8G8B8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear),
+			.scImageCount = headless ? 3u : 2u,
+			.scPresentMode = headless ? vk::PresentModeKHR::eFifo : vk::PresentModeKHR::eMailbox,
+			.scImageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
 			.scImageViewAspect = vk::ImageAspectFlagBits::eColor,
 			.scImageSharingMode = vk::SharingMode::eExclusive,
 			.scQueueFamilyAccessorCount = 1,
 			.scQueueFamilyAccessorIndiceList = context.getQueueFamilyIndices().data(),
 			.scPreTransform = vk::SurfaceTransformFlagBitsKHR::eIdentity,
 			
-			.descriptorSetLayoutBindings = { General::VertexTransformations::getDescriptorSetLayoutBinding(0, 1) },
+			.descriptorSetLayoutBindings = { General::VertexTransformations::getDescriptorSetLayoutBinding(0, 1), Vulkan::TextureStreamer::getDescriptorSetLayoutBinding(Vulkan::GraphicsEngine::TEXTURE_BINDING) },
 			.uniformBufferInfo = { 2, sizeof(General::VertexTransformations), vk::SharingMode::eExclusive },
 			
 			.gpShaderStageInfos = {
-				{vk::ShaderStageFlagBits::eVertex, "shaders/shader.spv", "vertexShader"},
-				{vk::ShaderStageFlagBits::eFragment, "shaders/shader.spv", "fragmentShader"}
+				{vk::ShaderStageFlagBits::eVertex, "shaders/shader.spv", "vertexShader", {}},
+				{vk::ShaderStageFlagBits::eFragment, "shaders/shader.spv", "fragmentShader", {}}
 			},
+			.gpShaderVariant = Vulkan::ShaderVariantKey{}.with(Vulkan::ShaderFeature::eVertexColour, true),
+			.gpPreloadedShaders = { shaderLoad.get() },
 			.gpVertexInputInfo = {
 				General::Vertex::getVertexInputBindingDescription(),
 				General::Vertex::getVertexInputAttributeDescription()
@@ -87,6 +243,7 @@ int main() {
 				1.0f,
 				1.0f
 			},
+			.gpSampleCount = static_cast<vk::SampleCountFlagBits>(msaaSamples),
 			.gpColourBlendingInfo = {
 				{
 					std::make_tuple(
@@ -108,8 +265,28 @@ int main() {
 			},
 			.dynamicStates = {
 				vk::DynamicState::eViewport,
-				vk::DynamicState::eScissor
+				vk::DynamicState::eScissor,
+				vk::DynamicState::eLineWidth,
+				vk::DynamicState::eDepthBias,
+				vk::DynamicState::eCullMode,
+				vk::DynamicState::eFrontFace,
+				vk::DynamicState::ePrimitiveTopology,
+				vk::DynamicState::eDepthTestEnable,
+				vk::DynamicState::eDepthWriteEnable,
+				vk::DynamicState::eDepthCompareOp,
+				vk::DynamicState::eDepthBoundsTestEnable,
+				vk::DynamicState::eStencilTestEnable,
+				vk::DynamicState::eRasterizerDiscardEnable,
+				vk::DynamicState::eDepthBiasEnable,
+				vk::DynamicState::ePrimitiveRestartEnable,
+				vk::DynamicState::ePolygonModeEXT,
+				vk::DynamicState::eDepthClampEnableEXT,
+				vk::DynamicState::eLogicOpEnableEXT,
+				vk::DynamicState::eColorBlendEnableEXT,
+				vk::DynamicState::eColorBlendEquationEXT,
+				vk::DynamicState::eColorWriteMaskEXT
 			},
+			.gpCompileWorkerCount = 2,
 			.verticiesBufferInfo = {
 				vk::SharingMode::eExclusive,
 				verticies
@@ -132,7 +309,30 @@ int main() {
 		};
 
 		Vulkan::GraphicsEngine graphicsEngine(std::move(graphicsContext), graphicsEngineInfo);
-		graphicsEngine.runLoop();
+		graphicsEngine.setRenderGraphDumpEnabled(dumpRenderGraph);
+		graphicsEngine.setCommandBufferCacheEnabled(commandBufferCache);
+		graphicsEngine.setRedundantStateFiltering(stateFiltering);
+		graphicsEngine.setDepthPrepassEnabled(depthPrepass);
+		graphicsEngine.setOcclusionCullingEnabled(occlusionCulling);
+		graphicsEngine.setDynamicResolution(resolutionSettings);
+		graphicsEngine.setDynamicResolutionEnabled(dynamicResolution);
+		graphicsEngine.setMipGenerationPath(mipPath);
+		if (!texturePath.empty()) {
+			graphicsEngine.loadSceneTexture(texturePath);
+		}
+		if (capture.mode != Vulkan::CaptureMode::eOff) {
+			graphicsEngine.setCapture(capture);
+		}
+		if (replay) {
+			graphicsEngine.runReplay(*replay, replayTimingsPath);
+		} else if (benchmarking) {
+			graphicsEngine.runBenchmark(benchmark);
+		} else {
+			if (!recordPath.empty()) {
+				graphicsEngine.startRecording(recordPath);
+			}
+			graphicsEngine.runLoop();
+		}
 	} catch(std::exception const& e) {
 		std::cout << e.what() << '\n';
 	}
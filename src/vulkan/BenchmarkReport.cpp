@@ -0,0 +1,50 @@
+#include "vulkan/BenchmarkReport.h"
+#include <fstream>
+#include <iomanip>
+
+namespace Vulkan {
+	void BenchmarkReport::writeJson(std::string const& path) const {
+		std::ofstream file(path, std::ios::trunc);
+		if (!file) {
+			throw std::runtime_error("Could not open " + path + " for the benchmark report");
+		}
+
+		file << std::fixed << std::setprecision(4);
+		file << "{\n";
+		file << "\t\"device\": \"" << deviceName << "\",\n";
+		file << "\t\"driverVersion\": " << driverVersion << ",\n";
+		file << "\t\"apiVersion\": \"" << VK_API_VERSION_MAJOR(apiVersion) << '.' << VK_API_VERSION_MINOR(apiVersion) << '.' << VK_API_VERSION_PATCH(apiVersion) << "\",\n";
+		file << "\t\"headless\": " << (headless ? "true" : "false") << ",\n";
+		file << "\t\"extent\": [" << extent.width << ", " << extent.height << "],\n";
+		file << "\t\"frames\": " << settings.frameCount << ",\n";
+		file << "\t\"warmupFrames\": " << settings.warmupFrameCount << ",\n";
+		file << "\t\"fixedTimestepMs\": " << settings.fixedTimestep * 1000.0 << ",\n";
+		file << "\t\"wallTimeMs\": " << wallTimeMs << ",\n";
+		file << "\t\"averageFps\": " << (wallTimeMs > 0.0 ? settings.frameCount * 1000.0 / wallTimeMs : 0.0) << ",\n";
+
+		file << "\t\"timingsMs\": {";
+		for (size_t i = 0; i < timings.size(); i++) {
+			General::RollingPercentiles const& samples = timings[i].second;
+			file << (i == 0 ? "" : ",") << "\n\t\t\"" << timings[i].first << "\": { \"samples\": " << samples.getSampleCount()
+				<< ", \"min\": " << samples.percentile(0.0)
+				<< ", \"p50\": " << samples.percentile(0.50)
+				<< ", \"p95\": " << samples.percentile(0.95)
+				<< ", \"p99\": " << samples.percentile(0.99)
+				<< ", \"max\": " << samples.percentile(1.0) << " }";
+		}
+		file << "\n\t},\n";
+
+		file << "\t\"memory\": {\n\t\t\"budgetExtension\": " << (hasMemoryBudget ? "true" : "false") << ",\n\t\t\"heaps\": [";
+		for (size_t i = 0; i < heaps.size(); i++) {
+			file << (i == 0 ? "" : ",") << "\n\t\t\t{ \"index\": " << i << ", \"size\": " << heaps[i].size << ", \"deviceLocal\": " << (heaps[i].deviceLocal ? "true" : "false");
+			if (hasMemoryBudget) {
+				file << ", \"budget\": " << heaps[i].budget << ", \"usage\": " << heaps[i].usage;
+			}
+			file << " }";
+		}
+		file << "\n\t\t]\n\t}\n";
+		file << "}\n";
+
+		std::cout << "Wrote benchmark report to " << path << '\n';
+	}
+}
@@ -0,0 +1,76 @@
+#include "vulkan/CommandBufferCache.h"
+
+namespace Vulkan {
+	// not transient, the buffers live as long as the swapchain does
+	CommandBufferCache::CommandBufferCache(vk::raii::Device const& device, uint32_t const& queueFamilyIndex, uint32_t const& frameSlotCount) : pool{ device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, .queueFamilyIndex = queueFamilyIndex } }, slotEntries(frameSlotCount), version{ 1 }, reusedCount{ 0 }, recordedCount{ 0 }, enabled{ true } {
+
+	}
+
+	void CommandBufferCache::resize(vk::raii::Device const& device, uint32_t const& imageCount) {
+		invalidate();
+
+		uint32_t existingCount = static_cast<uint32_t>(slotEntries[0].size());
+		if (imageCount <= existingCount) {
+			return;
+		}
+
+		vk::CommandBufferAllocateInfo allocateInfo = {
+			.commandPool = pool,
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = imageCount - existingCount
+		};
+		for (std::vector<Entry>& entries : slotEntries) {
+			vk::raii::CommandBuffers buffers(device, allocateInfo);
+			for (vk::raii::CommandBuffer& buffer : buffers) {
+				entries.push_back(Entry{ .buffer = std::move(buffer), .version = 0 });
+			}
+		}
+
+		std::cout << "Created " << slotEntries.size() * (imageCount - existingCount) << " cached command buffers for " << imageCount << " swapchain images\n";
+	}
+
+	void CommandBufferCache::invalidate() {
+		++version;
+	}
+
+	vk::raii::CommandBuffer const& CommandBufferCache::get(uint32_t const& image, uint32_t const& slot) const {
+		return slotEntries[slot][image].buffer;
+	}
+
+	bool CommandBufferCache::reuse(uint32_t const& image, uint32_t const& slot) {
+		if (slotEntries[slot][image].version != version) {
+			return false;
+		}
+
+		++reusedCount;
+		return true;
+	}
+
+	void CommandBufferCache::markRecorded(uint32_t const& image, uint32_t const& slot) {
+		slotEntries[slot][image].version = version;
+		++recordedCount;
+	}
+
+	void CommandBufferCache::setEnabled(bool const& enable) {
+		if (enable != enabled) {
+			invalidate();
+		}
+		enabled = enable;
+	}
+
+	bool CommandBufferCache::isEnabled() const {
+		return enabled;
+	}
+
+	uint64_t CommandBufferCache::getVersion() const {
+		return version;
+	}
+
+	uint64_t CommandBufferCache::getReusedCount() const {
+		return reusedCount;
+	}
+
+	uint64_t CommandBufferCache::getRecordedCount() const {
+		return recordedCount;
+	}
+}
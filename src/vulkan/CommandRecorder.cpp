@@ -0,0 +1,273 @@
+#include "vulkan/CommandRecorder.h"
+#include <cstring>
+#include <algorithm>
+
+namespace Vulkan {
+	CommandRecorder::CommandRecorder() : cmdBuffer{ nullptr }, statistics{}, filtering{ true }, pipelines{}, descriptorSets{}, vertexBuffers{}, indexBuffer{}, pushLayout{}, pushStages{}, pushValues{}, pushValid{}, viewport{}, scissor{}, topology{}, primitiveRestart{}, rasterizerDiscard{}, cullMode{}, frontFace{}, depthBiasEnable{}, depthBias{}, lineWidth{}, depthTest{}, depthWrite{}, depthCompareOp{}, depthBoundsTest{}, stencilTest{}, polygonMode{}, depthClamp{}, logicOpEnable{}, blendEnable{}, blendEquation{}, colourWriteMask{} {
+
+	}
+
+	void CommandRecorder::begin(vk::raii::CommandBuffer const& buffer) {
+		cmdBuffer = &buffer;
+		statistics = RecorderStatistics{};
+		invalidate();
+	}
+
+	void CommandRecorder::invalidate() {
+		pipelines = {};
+		descriptorSets = {};
+		vertexBuffers = {};
+		indexBuffer = {};
+		pushLayout = vk::PipelineLayout{};
+		pushStages = vk::ShaderStageFlags{};
+		pushValid.fill(false);
+
+		viewport = {};
+		scissor = {};
+		topology = {};
+		primitiveRestart = {};
+		rasterizerDiscard = {};
+		cullMode = {};
+		frontFace = {};
+		depthBiasEnable = {};
+		depthBias = {};
+		lineWidth = {};
+		depthTest = {};
+		depthWrite = {};
+		depthCompareOp = {};
+		depthBoundsTest = {};
+		stencilTest = {};
+		polygonMode = {};
+		depthClamp = {};
+		logicOpEnable = {};
+		blendEnable = {};
+		blendEquation = {};
+		colourWriteMask = {};
+	}
+
+	void CommandRecorder::setFiltering(bool const& enable) {
+		filtering = enable;
+	}
+
+	uint32_t CommandRecorder::getBindPointIndex(vk::PipelineBindPoint const& bindPoint) {
+		return bindPoint == vk::PipelineBindPoint::eCompute ? 1 : 0;
+	}
+
+	void CommandRecorder::bindPipeline(vk::PipelineBindPoint const& bindPoint, vk::Pipeline const& pipeline) {
+		if (update(pipelines[getBindPointIndex(bindPoint)], pipeline)) {
+			cmdBuffer->bindPipeline(bindPoint, pipeline);
+		}
+	}
+
+	void CommandRecorder::bindDescriptorSets(vk::PipelineBindPoint const& bindPoint, vk::PipelineLayout const& layout, uint32_t const& firstSet, vk::ArrayProxy<const vk::DescriptorSet> const& sets, vk::ArrayProxy<const uint32_t> const& dynamicOffsets) {
+		std::array<Tracked<SetBinding>, MAX_DESCRIPTOR_SETS>& bound = descriptorSets[getBindPointIndex(bindPoint)];
+
+		bool redundant = filtering && dynamicOffsets.empty() && firstSet + sets.size() <= MAX_DESCRIPTOR_SETS;
+		for (uint32_t i = 0; redundant && i < sets.size(); i++) {
+			Tracked<SetBinding> const& tracked = bound[firstSet + i];
+			redundant = tracked.valid && tracked.value == SetBinding{ .layout = layout, .set = sets.data()[i] };
+		}
+		if (redundant) {
+			++statistics.elided;
+			return;
+		}
+
+		cmdBuffer->bindDescriptorSets(bindPoint, layout, firstSet, sets, dynamicOffsets);
+		++statistics.issued;
+
+		// sets bound with another layout may be disturbed, and dynamic offsets are not tracked so those sets are never matched
+		for (uint32_t i = 0; i < MAX_DESCRIPTOR_SETS; i++) {
+			bool written = i >= firstSet && i - firstSet < sets.size();
+			if (written) {
+				bound[i] = Tracked<SetBinding>{ .value = SetBinding{ .layout = layout, .set = sets.data()[i - firstSet] }, .valid = dynamicOffsets.empty() };
+			} else if (bound[i].value.layout != layout) {
+				bound[i].valid = false;
+			}
+		}
+	}
+
+	void CommandRecorder::bindVertexBuffers(uint32_t const& firstBinding, vk::ArrayProxy<const vk::Buffer> const& buffers, vk::ArrayProxy<const vk::DeviceSize> const& offsets) {
+		bool redundant = filtering && firstBinding + buffers.size() <= MAX_VERTEX_BINDINGS;
+		for (uint32_t i = 0; redundant && i < buffers.size(); i++) {
+			Tracked<VertexBinding> const& tracked = vertexBuffers[firstBinding + i];
+			redundant = tracked.valid && tracked.value == VertexBinding{ .buffer = buffers.data()[i], .offset = offsets.data()[i] };
+		}
+		if (redundant) {
+			++statistics.elided;
+			return;
+		}
+
+		cmdBuffer->bindVertexBuffers(firstBinding, buffers, offsets);
+		++statistics.issued;
+		for (uint32_t i = 0; i < buffers.size() && firstBinding + i < MAX_VERTEX_BINDINGS; i++) {
+			vertexBuffers[firstBinding + i] = Tracked<VertexBinding>{ .value = VertexBinding{ .buffer = buffers.data()[i], .offset = offsets.data()[i] }, .valid = true };
+		}
+	}
+
+	void CommandRecorder::bindIndexBuffer(vk::Buffer const& buffer, vk::DeviceSize const& offset, vk::IndexType const& type) {
+		if (update(indexBuffer, IndexBinding{ .buffer = buffer, .offset = offset, .type = type })) {
+			cmdBuffer->bindIndexBuffer(buffer, offset, type);
+		}
+	}
+
+	void CommandRecorder::pushConstants(vk::PipelineLayout const& layout, vk::ShaderStageFlags const& stages, uint32_t const& offset, uint32_t const& size, void const* values) {
+		bool shadowed = offset + size <= PUSH_CONSTANT_BYTES;
+		if (layout != pushLayout || stages != pushStages) {
+			pushLayout = layout;
+			pushStages = stages;
+			pushValid.fill(false);
+		}
+
+		if (filtering && shadowed && std::all_of(pushValid.begin() + offset, pushValid.begin() + offset + size, [](bool const& valid) { return valid; }) && memcmp(pushValues.data() + offset, values, size) == 0) {
+			++statistics.elided;
+			return;
+		}
+
+		cmdBuffer->pushConstants<uint8_t>(layout, stages, offset, vk::ArrayProxy<const uint8_t>(size, static_cast<uint8_t const*>(values)));
+		++statistics.issued;
+		if (shadowed) {
+			memcpy(pushValues.data() + offset, values, size);
+			std::fill(pushValid.begin() + offset, pushValid.begin() + offset + size, true);
+		}
+	}
+
+	void CommandRecorder::setViewport(vk::Viewport const& value) {
+		if (update(viewport, value)) {
+			cmdBuffer->setViewport(0, value);
+		}
+	}
+
+	void CommandRecorder::setScissor(vk::Rect2D const& value) {
+		if (update(scissor, value)) {
+			cmdBuffer->setScissor(0, value);
+		}
+	}
+
+	void CommandRecorder::setPrimitiveTopology(vk::PrimitiveTopology const& value) {
+		if (update(topology, value)) {
+			cmdBuffer->setPrimitiveTopology(value);
+		}
+	}
+
+	void CommandRecorder::setPrimitiveRestartEnable(bool const& value) {
+		if (update(primitiveRestart, value)) {
+			cmdBuffer->setPrimitiveRestartEnable(value);
+		}
+	}
+
+	void CommandRecorder::setRasterizerDiscardEnable(bool const& value) {
+		if (update(rasterizerDiscard, value)) {
+			cmdBuffer->setRasterizerDiscardEnable(value);
+		}
+	}
+
+	void CommandRecorder::setCullMode(vk::CullModeFlags const& value) {
+		if (update(cullMode, value)) {
+			cmdBuffer->setCullMode(value);
+		}
+	}
+
+	void CommandRecorder::setFrontFace(vk::FrontFace const& value) {
+		if (update(frontFace, value)) {
+			cmdBuffer->setFrontFace(value);
+		}
+	}
+
+	void CommandRecorder::setDepthBiasEnable(bool const& value) {
+		if (update(depthBiasEnable, value)) {
+			cmdBuffer->setDepthBiasEnable(value);
+		}
+	}
+
+	void CommandRecorder::setDepthBias(float const& constantFactor, float const& clamp, float const& slopeFactor) {
+		if (update(depthBias, DepthBias{ .constantFactor = constantFactor, .clamp = clamp, .slopeFactor = slopeFactor })) {
+			cmdBuffer->setDepthBias(constantFactor, clamp, slopeFactor);
+		}
+	}
+
+	void CommandRecorder::setLineWidth(float const& value) {
+		if (update(lineWidth, value)) {
+			cmdBuffer->setLineWidth(value);
+		}
+	}
+
+	void CommandRecorder::setDepthTestEnable(bool const& value) {
+		if (update(depthTest, value)) {
+			cmdBuffer->setDepthTestEnable(value);
+		}
+	}
+
+	void CommandRecorder::setDepthWriteEnable(bool const& value) {
+		if (update(depthWrite, value)) {
+			cmdBuffer->setDepthWriteEnable(value);
+		}
+	}
+
+	void CommandRecorder::setDepthCompareOp(vk::CompareOp const& value) {
+		if (update(depthCompareOp, value)) {
+			cmdBuffer->setDepthCompareOp(value);
+		}
+	}
+
+	void CommandRecorder::setDepthBoundsTestEnable(bool const& value) {
+		if (update(depthBoundsTest, value)) {
+			cmdBuffer->setDepthBoundsTestEnable(value);
+		}
+	}
+
+	void CommandRecorder::setStencilTestEnable(bool const& value) {
+		if (update(stencilTest, value)) {
+			cmdBuffer->setStencilTestEnable(value);
+		}
+	}
+
+	void CommandRecorder::setPolygonMode(vk::PolygonMode const& value) {
+		if (update(polygonMode, value)) {
+			cmdBuffer->setPolygonModeEXT(value);
+		}
+	}
+
+	void CommandRecorder::setDepthClampEnable(bool const& value) {
+		if (update(depthClamp, value)) {
+			cmdBuffer->setDepthClampEnableEXT(value);
+		}
+	}
+
+	void CommandRecorder::setLogicOpEnable(bool const& value) {
+		if (update(logicOpEnable, value)) {
+			cmdBuffer->setLogicOpEnableEXT(value);
+		}
+	}
+
+	void CommandRecorder::setColourBlendEnable(bool const& value) {
+		if (update(blendEnable, value)) {
+			vk::Bool32 enable = value;
+			cmdBuffer->setColorBlendEnableEXT(0, enable);
+		}
+	}
+
+	void CommandRecorder::setColourBlendEquation(vk::ColorBlendEquationEXT const& value) {
+		if (update(blendEquation, value)) {
+			cmdBuffer->setColorBlendEquationEXT(0, value);
+		}
+	}
+
+	void CommandRecorder::setColourWriteMask(vk::ColorComponentFlags const& value) {
+		if (update(colourWriteMask, value)) {
+			cmdBuffer->setColorWriteMaskEXT(0, value);
+		}
+	}
+
+	void CommandRecorder::drawIndexed(uint32_t const& indexCount, uint32_t const& instanceCount, uint32_t const& firstIndex, int32_t const& vertexOffset, uint32_t const& firstInstance) {
+		cmdBuffer->drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		++statistics.draws;
+	}
+
+	vk::raii::CommandBuffer const& CommandRecorder::getCommandBuffer() const {
+		return *cmdBuffer;
+	}
+
+	RecorderStatistics const& CommandRecorder::getStatistics() const {
+		return statistics;
+	}
+}
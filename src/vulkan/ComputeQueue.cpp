@@ -0,0 +1,100 @@
+#include "vulkan/ComputeQueue.h"
+
+namespace Vulkan {
+	ComputeQueue::ComputeQueue(vk::raii::Device const& device, uint32_t const& graphicsFamily, uint32_t const& computeFamily, uint32_t const& frameSlotCount) : pool{ device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, .queueFamilyIndex = computeFamily } }, slotBuffers{}, graphicsTimeline{ nullptr }, computeTimeline{ nullptr }, graphicsValue{ 0 }, computeValue{ 0 }, slotValues(frameSlotCount, 0), graphicsFamily{ graphicsFamily }, computeFamily{ computeFamily }, submittedCount{ 0 } {
+		slotBuffers = vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo{ .commandPool = pool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = frameSlotCount });
+
+		vk::SemaphoreTypeCreateInfo timelineInfo = { .semaphoreType = vk::SemaphoreType::eTimeline, .initialValue = 0 };
+		graphicsTimeline = vk::raii::Semaphore(device, vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
+		computeTimeline = vk::raii::Semaphore(device, vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
+
+		std::cout << "Created async compute command buffers and timelines on queue family " << computeFamily << '\n';
+	}
+
+	void ComputeQueue::frameCompleted(vk::raii::Device const& device, uint32_t const& slot) {
+		if (slotValues[slot] == 0) {
+			return;
+		}
+
+		vk::SemaphoreWaitInfo waitInfo = { .semaphoreCount = 1, .pSemaphores = &*computeTimeline, .pValues = &slotValues[slot] };
+		while (device.waitSemaphores(waitInfo, UINT64_MAX) == vk::Result::eTimeout);
+	}
+
+	// waiting on 0 before the first batch is already satisfied, so the graphics submit looks the same every frame
+	vk::SemaphoreSubmitInfo ComputeQueue::getGraphicsWait(vk::PipelineStageFlags2 const& stages) const {
+		return vk::SemaphoreSubmitInfo{ .semaphore = computeTimeline, .value = computeValue, .stageMask = stages };
+	}
+
+	vk::SemaphoreSubmitInfo ComputeQueue::signalGraphics() {
+		return vk::SemaphoreSubmitInfo{ .semaphore = graphicsTimeline, .value = ++graphicsValue, .stageMask = vk::PipelineStageFlagBits2::eAllCommands };
+	}
+
+	vk::raii::CommandBuffer const& ComputeQueue::begin(uint32_t const& slot) {
+		vk::raii::CommandBuffer const& buffer = slotBuffers[slot];
+		buffer.reset();
+		buffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+		return buffer;
+	}
+
+	void ComputeQueue::submit(vk::raii::Queue const& queue, uint32_t const& slot, vk::PipelineStageFlags2 const& waitStages) {
+		slotBuffers[slot].end();
+
+		vk::SemaphoreSubmitInfo wait = { .semaphore = graphicsTimeline, .value = graphicsValue, .stageMask = waitStages };
+		vk::SemaphoreSubmitInfo signal = { .semaphore = computeTimeline, .value = ++computeValue, .stageMask = vk::PipelineStageFlagBits2::eAllCommands };
+		vk::CommandBufferSubmitInfo commandBufferInfo = { .commandBuffer = slotBuffers[slot] };
+		queue.submit2(vk::SubmitInfo2{
+			.waitSemaphoreInfoCount = 1,
+			.pWaitSemaphoreInfos = &wait,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &commandBufferInfo,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signal
+		});
+
+		slotValues[slot] = computeValue;
+		++submittedCount;
+	}
+
+	vk::ImageMemoryBarrier2 ComputeQueue::releaseToCompute(vk::Image const& image, vk::ImageSubresourceRange const& range, vk::ImageLayout const& layout, vk::PipelineStageFlags2 const& srcStages, vk::AccessFlags2 const& srcAccess) const {
+		return vk::ImageMemoryBarrier2{
+			.srcStageMask = srcStages,
+			.srcAccessMask = srcAccess,
+			.dstStageMask = vk::PipelineStageFlagBits2::eNone,
+			.dstAccessMask = vk::AccessFlagBits2::eNone,
+			.oldLayout = layout,
+			.newLayout = layout,
+			.srcQueueFamilyIndex = graphicsFamily,
+			.dstQueueFamilyIndex = computeFamily,
+			.image = image,
+			.subresourceRange = range
+		};
+	}
+
+	vk::ImageMemoryBarrier2 ComputeQueue::acquireFromGraphics(vk::Image const& image, vk::ImageSubresourceRange const& range, vk::ImageLayout const& layout, vk::PipelineStageFlags2 const& dstStages, vk::AccessFlags2 const& dstAccess) const {
+		return vk::ImageMemoryBarrier2{
+			.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask = dstStages,
+			.dstAccessMask = dstAccess,
+			.oldLayout = layout,
+			.newLayout = layout,
+			.srcQueueFamilyIndex = graphicsFamily,
+			.dstQueueFamilyIndex = computeFamily,
+			.image = image,
+			.subresourceRange = range
+		};
+	}
+
+	uint32_t ComputeQueue::getGraphicsFamily() const {
+		return graphicsFamily;
+	}
+
+	uint32_t ComputeQueue::getComputeFamily() const {
+		return computeFamily;
+	}
+
+	uint64_t ComputeQueue::getSubmittedCount() const {
+		return submittedCount;
+	}
+}
@@ -0,0 +1,56 @@
+#include "vulkan/DeletionQueue.h"
+#include <algorithm>
+
+namespace Vulkan {
+	DeletionQueue::DeletionQueue(uint32_t const& frameSlotCount) : entries{}, slotSerials(frameSlotCount, 0), slotPending(frameSlotCount, false), nextSerial{ 0 }, releasedCount{ 0 } {
+
+	}
+
+	void DeletionQueue::retire(RetiredObject&& object) {
+		entries.push_back(Entry{ .releaseSerial = nextSerial + slotSerials.size(), .object = std::move(object) });
+	}
+
+	void DeletionQueue::frameSubmitted(uint32_t const& slot) {
+		slotSerials[slot] = nextSerial++;
+		slotPending[slot] = true;
+	}
+
+	void DeletionQueue::frameCompleted(uint32_t const& slot) {
+		slotPending[slot] = false;
+		if (entries.empty()) {
+			return;
+		}
+
+		// frames finish out of order as far as the fences can tell, only the ones before the oldest pending frame are known to be done
+		uint64_t completedSerial = nextSerial;
+		for (uint32_t i = 0; i < slotSerials.size(); i++) {
+			if (slotPending[i]) {
+				completedSerial = std::min(completedSerial, slotSerials[i]);
+			}
+		}
+		release(completedSerial);
+	}
+
+	void DeletionQueue::flush() {
+		release(UINT64_MAX);
+	}
+
+	void DeletionQueue::release(uint64_t const& completedSerial) {
+		size_t released = 0;
+		while (released < entries.size() && entries[released].releaseSerial <= completedSerial) {
+			entries[released].object = std::monostate{};
+			++released;
+		}
+
+		entries.erase(entries.begin(), entries.begin() + released);
+		releasedCount += released;
+	}
+
+	size_t DeletionQueue::getPendingCount() const {
+		return entries.size();
+	}
+
+	uint64_t DeletionQueue::getReleasedCount() const {
+		return releasedCount;
+	}
+}
@@ -0,0 +1,75 @@
+#include "vulkan/DeviceProfile.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace Vulkan {
+	template <class T>
+	static void writeValue(std::ofstream& file, T const& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <class T>
+	static bool readValue(std::ifstream& file, T& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	bool DeviceProfile::load(std::string const& path, DeviceProfile& profile) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		char magic[4]{};
+		uint32_t version = 0;
+		if (!file.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(magic)) != 0 || !readValue(file, version) || version != VERSION) {
+			return false;
+		}
+
+		uint32_t extensionCount = 0;
+		if (!readValue(file, profile.vendorId) || !readValue(file, profile.deviceId) || !readValue(file, profile.driverVersion) || !readValue(file, profile.requirementsHash) || !readValue(file, profile.deviceType) || !readValue(file, profile.deviceLocalBytes) || !readValue(file, profile.score) || !readValue(file, extensionCount)) {
+			return false;
+		}
+
+		profile.optionalExtensions.clear();
+		for (uint32_t i = 0; i < extensionCount; i++) {
+			uint32_t length = 0;
+			if (!readValue(file, length) || length > 256) {
+				return false;
+			}
+
+			std::string extension(length, '\0');
+			if (!file.read(extension.data(), length)) {
+				return false;
+			}
+			profile.optionalExtensions.push_back(std::move(extension));
+		}
+
+		return true;
+	}
+
+	void DeviceProfile::save(std::string const& path) const {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cout << "Could not open " << path << " to save the device profile\n";
+			return;
+		}
+
+		file.write(MAGIC, sizeof(MAGIC));
+		writeValue(file, VERSION);
+		writeValue(file, vendorId);
+		writeValue(file, deviceId);
+		writeValue(file, driverVersion);
+		writeValue(file, requirementsHash);
+		writeValue(file, deviceType);
+		writeValue(file, deviceLocalBytes);
+		writeValue(file, score);
+		writeValue(file, static_cast<uint32_t>(optionalExtensions.size()));
+		for (std::string const& extension : optionalExtensions) {
+			writeValue(file, static_cast<uint32_t>(extension.size()));
+			file.write(extension.data(), extension.size());
+		}
+
+		std::cout << "Saved the device profile to " << path << '\n';
+	}
+}
@@ -0,0 +1,131 @@
+#include "vulkan/DrawList.h"
+#include <algorithm>
+
+namespace Vulkan {
+	uint64_t SortKey::make(DrawPass const& pass, uint32_t const& pipeline, uint32_t const& material, uint32_t const& mesh, float const& depth) {
+		uint64_t quantisedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(DEPTH_MASK));
+
+		uint64_t key = static_cast<uint64_t>(pass) & ((uint64_t(1) << PASS_BITS) - 1);
+		key = (key << PIPELINE_BITS) | (pipeline & ((uint64_t(1) << PIPELINE_BITS) - 1));
+		key = (key << MATERIAL_BITS) | (material & ((uint64_t(1) << MATERIAL_BITS) - 1));
+		key = (key << MESH_BITS) | (mesh & ((uint64_t(1) << MESH_BITS) - 1));
+		key = (key << DEPTH_BITS) | quantisedDepth;
+		return key;
+	}
+
+	DrawPass SortKey::getPass(uint64_t const& key) {
+		return static_cast<DrawPass>(key >> (DEPTH_BITS + MESH_BITS + MATERIAL_BITS + PIPELINE_BITS));
+	}
+
+	uint32_t SortKey::getPipeline(uint64_t const& key) {
+		return static_cast<uint32_t>((key >> (DEPTH_BITS + MESH_BITS + MATERIAL_BITS)) & ((uint64_t(1) << PIPELINE_BITS) - 1));
+	}
+
+	uint32_t SortKey::getMaterial(uint64_t const& key) {
+		return static_cast<uint32_t>((key >> (DEPTH_BITS + MESH_BITS)) & ((uint64_t(1) << MATERIAL_BITS) - 1));
+	}
+
+	uint32_t SortKey::getMesh(uint64_t const& key) {
+		return static_cast<uint32_t>((key >> DEPTH_BITS) & ((uint64_t(1) << MESH_BITS) - 1));
+	}
+
+	DrawList::DrawList() : meshes{}, packets{}, scratch{}, batches{}, previousBatches{}, statistics{} {
+
+	}
+
+	uint32_t DrawList::addMesh(MeshRange const& mesh) {
+		meshes.push_back(mesh);
+		return static_cast<uint32_t>(meshes.size() - 1);
+	}
+
+	MeshRange const& DrawList::getMesh(uint32_t const& id) const {
+		return meshes[id];
+	}
+
+	void DrawList::submit(DrawPacket const& packet) {
+		packets.push_back(packet);
+	}
+
+	bool DrawList::build() {
+		std::swap(batches, previousBatches);
+		sort();
+		merge();
+
+		statistics.packets = static_cast<uint32_t>(packets.size());
+		statistics.batches = static_cast<uint32_t>(batches.size());
+
+		return !std::equal(batches.begin(), batches.end(), previousBatches.begin(), previousBatches.end(), [](DrawBatch const& a, DrawBatch const& b) {
+			return (a.key & ~SortKey::DEPTH_MASK) == (b.key & ~SortKey::DEPTH_MASK) && a.firstInstance == b.firstInstance && a.instanceCount == b.instanceCount;
+		});
+	}
+
+	void DrawList::clear() {
+		packets.clear();
+	}
+
+	void DrawList::sort() {
+		statistics.sortPasses = 0;
+		if (packets.size() < 2) {
+			return;
+		}
+
+		// every byte's histogram in one read of the keys
+		std::array<std::array<uint32_t, 256>, 8> histograms{};
+		for (DrawPacket const& packet : packets) {
+			for (uint32_t byte = 0; byte < 8; byte++) {
+				++histograms[byte][(packet.key >> (byte * 8)) & 0xFF];
+			}
+		}
+
+		scratch.resize(packets.size());
+		for (uint32_t byte = 0; byte < 8; byte++) {
+			std::array<uint32_t, 256>& histogram = histograms[byte];
+			if (histogram[(packets[0].key >> (byte * 8)) & 0xFF] == packets.size()) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t& count : histogram) {
+				uint32_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+			for (DrawPacket const& packet : packets) {
+				scratch[histogram[(packet.key >> (byte * 8)) & 0xFF]++] = packet;
+			}
+			std::swap(packets, scratch);
+			++statistics.sortPasses;
+		}
+	}
+
+	// same state and mesh with the instance ranges following on from each other, depth is ignored since the batch draws all of them anyway
+	void DrawList::merge() {
+		batches.clear();
+		for (DrawPacket const& packet : packets) {
+			if (!batches.empty()) {
+				DrawBatch& last = batches.back();
+				if ((last.key & ~SortKey::DEPTH_MASK) == (packet.key & ~SortKey::DEPTH_MASK) && last.firstInstance + last.instanceCount == packet.firstInstance) {
+					last.instanceCount += packet.instanceCount;
+					++last.packetCount;
+					continue;
+				}
+			}
+
+			batches.push_back(DrawBatch{ .key = packet.key, .firstInstance = packet.firstInstance, .instanceCount = packet.instanceCount, .packetCount = 1 });
+		}
+	}
+
+	std::span<const DrawBatch> DrawList::getBatches(DrawPass const& pass) const {
+		std::vector<DrawBatch>::const_iterator first = std::partition_point(batches.begin(), batches.end(), [&pass](DrawBatch const& batch) {
+			return SortKey::getPass(batch.key) < pass;
+		});
+		std::vector<DrawBatch>::const_iterator last = std::partition_point(first, batches.end(), [&pass](DrawBatch const& batch) {
+			return SortKey::getPass(batch.key) == pass;
+		});
+		return std::span<const DrawBatch>(first, last);
+	}
+
+	DrawListStatistics const& DrawList::getStatistics() const {
+		return statistics;
+	}
+}
@@ -0,0 +1,194 @@
+#include "vulkan/FrameCapture.h"
+#include "vulkan/GraphicsContext.h"
+#include "general/ImageWriter.h"
+#include "general/Profiler.h"
+#include <cstring>
+#include <filesystem>
+
+namespace Vulkan {
+	FrameCapture::FrameCapture(uint32_t const& ringSize, uint32_t const& encoderCount) : slots{}, settings{ .mode = CaptureMode::eOff, .interval = 1, .format = CaptureFormat::ePng, .directory = "captures" }, extent{}, format{}, coherent{ true }, device{}, dispatcher{ nullptr }, ringSize{ ringSize }, frameNumber{ 0 }, capturedCount{ 0 }, droppedCount{ 0 }, encoders{ std::make_unique<General::ThreadPool>(encoderCount) } {
+
+	}
+
+	// the encoders still hold pointers into the slots, so they have to be drained and joined before the buffers go
+	FrameCapture::~FrameCapture() {
+		encoders.reset();
+	}
+
+	void FrameCapture::resize(GraphicsContext& context, vk::Extent2D const& newExtent, vk::Format const& newFormat, DeletionQueue& deletionQueue) {
+		encoders->waitIdle();
+		for (std::unique_ptr<Slot>& slot : slots) {
+			deletionQueue.retire(std::move(slot->buffer));
+			deletionQueue.retire(std::move(slot->memory));
+		}
+		slots.clear();
+		extent = newExtent;
+		format = newFormat;
+		device = *context.context.device;
+		dispatcher = context.context.device.getDispatcher();
+
+		vk::DeviceSize bufferSize = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+		vk::PhysicalDeviceMemoryProperties memoryProperties = context.context.physicalDevice.getMemoryProperties();
+
+		for (uint32_t i = 0; i < ringSize; i++) {
+			std::unique_ptr<Slot> slot = std::make_unique<Slot>();
+			slot->buffer = vk::raii::Buffer(context.context.device, vk::BufferCreateInfo{ .size = bufferSize, .usage = vk::BufferUsageFlagBits::eTransferDst, .sharingMode = vk::SharingMode::eExclusive });
+
+			// cached memory makes the encoders' reads fast, uncached coherent memory is read at a few hundred MB/s at best
+			vk::MemoryRequirements requirements = slot->buffer.getMemoryRequirements();
+			uint32_t memoryTypeIndex = context.getSuitableMemoryTypeIndex(requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached);
+			if (memoryTypeIndex == 0xFFFFFFFF) {
+				memoryTypeIndex = context.getSuitableMemoryTypeIndex(requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+			}
+			if (memoryTypeIndex == 0xFFFFFFFF) {
+				throw std::runtime_error("No suitable memory type found for the capture readback buffers");
+			}
+			coherent = static_cast<bool>(memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+
+			slot->memory = vk::raii::DeviceMemory(context.context.device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = memoryTypeIndex });
+			slot->buffer.bindMemory(slot->memory, 0);
+			slot->address = slot->memory.mapMemory(0, vk::WholeSize);
+			slots.push_back(std::move(slot));
+		}
+
+		std::cout << "Created " << slots.size() << " capture readback buffers for " << extent.width << "x" << extent.height << " frames {HOST CACHED: " << (coherent ? "no" : "yes") << "} {ENCODERS: " << encoders->getThreadCount() << "}\n";
+	}
+
+	void FrameCapture::beginFrame(uint32_t const& frameIndex) {
+		for (std::unique_ptr<Slot>& slot : slots) {
+			if (slot->state.load(std::memory_order_acquire) != SlotState::eCopying || slot->frameIndex != frameIndex) {
+				continue;
+			}
+
+			if (!coherent) {
+				device.invalidateMappedMemoryRanges(vk::MappedMemoryRange{ .memory = *slot->memory, .offset = 0, .size = vk::WholeSize }, *dispatcher);
+			}
+
+			slot->state.store(SlotState::eEncoding, std::memory_order_release);
+			Slot* encodedSlot = slot.get();
+			encoders->submit([this, encodedSlot]() { encode(*encodedSlot); });
+		}
+	}
+
+	bool FrameCapture::recordCopy(vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, uint32_t const& frameIndex) {
+		bool capture = isCaptureFrame();
+		++frameNumber;
+		if (!capture) {
+			return false;
+		}
+
+		Slot* freeSlot = nullptr;
+		for (std::unique_ptr<Slot>& slot : slots) {
+			if (slot->state.load(std::memory_order_acquire) == SlotState::eFree) {
+				freeSlot = slot.get();
+				break;
+			}
+		}
+		if (freeSlot == nullptr) {
+			++droppedCount;
+			return false;
+		}
+
+		freeSlot->state.store(SlotState::eCopying, std::memory_order_relaxed);
+		freeSlot->frameIndex = frameIndex;
+		freeSlot->frameNumber = frameNumber - 1;
+
+		vk::BufferImageCopy region = {
+			.bufferOffset = 0,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 },
+			.imageOffset = vk::Offset3D{ 0, 0, 0 },
+			.imageExtent = vk::Extent3D{ extent.width, extent.height, 1 }
+		};
+		cmdBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, freeSlot->buffer, region);
+
+		vk::BufferMemoryBarrier2 toHost = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eHost,
+			.dstAccessMask = vk::AccessFlagBits2::eHostRead,
+			.buffer = freeSlot->buffer,
+			.offset = 0,
+			.size = vk::WholeSize
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .bufferMemoryBarrierCount = 1, .pBufferMemoryBarriers = &toHost });
+
+		if (settings.mode == CaptureMode::eOneShot) {
+			settings.mode = CaptureMode::eOff;
+		}
+		return true;
+	}
+
+	bool FrameCapture::isCaptureFrame() const {
+		switch (settings.mode) {
+		case CaptureMode::eOneShot:
+		case CaptureMode::eContinuous:
+			return true;
+		case CaptureMode::eEveryNth:
+			return settings.interval <= 1 || frameNumber % settings.interval == 0;
+		default:
+			return false;
+		}
+	}
+
+	// runs on an encoder thread, the slot is handed back as soon as its pixels are copied out so the ring refills while the file is written
+	void FrameCapture::encode(Slot& slot) {
+		GH_PROFILE_ZONE("frame capture encode");
+
+		size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+		std::vector<uint8_t> pixels(pixelCount * 4);
+		memcpy(pixels.data(), slot.address, pixels.size());
+		uint64_t capturedFrame = slot.frameNumber;
+		slot.state.store(SlotState::eFree, std::memory_order_release);
+
+		std::string path = settings.directory + "/frame_" + std::to_string(capturedFrame);
+		bool written = false;
+		if (settings.format == CaptureFormat::ePng) {
+			if (format == vk::Format::eB8G8R8A8Srgb || format == vk::Format::eB8G8R8A8Unorm) {
+				for (size_t i = 0; i < pixelCount; i++) {
+					std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+				}
+			}
+			written = General::writePng(path + ".png", extent.width, extent.height, pixels.data());
+		} else {
+			// the swapchain's own byte order, the size and format go in the name since there is no header
+			written = General::writeRaw(path + "_" + std::to_string(extent.width) + "x" + std::to_string(extent.height) + "_" + vk::to_string(format) + ".raw", pixels.data(), pixels.size());
+		}
+
+		if (written) {
+			++capturedCount;
+		} else {
+			std::cout << "Failed to write capture of frame " << capturedFrame << " to " << settings.directory << '\n';
+		}
+	}
+
+	void FrameCapture::setSettings(CaptureSettings const& newSettings) {
+		// the encoders read the directory and format, so they must not be halfway through a file when those change
+		encoders->waitIdle();
+		settings = newSettings;
+		if (settings.mode != CaptureMode::eOff) {
+			std::filesystem::create_directories(settings.directory);
+		}
+	}
+
+	CaptureSettings const& FrameCapture::getSettings() const {
+		return settings;
+	}
+
+	bool FrameCapture::isActive() const {
+		return settings.mode != CaptureMode::eOff && isSized();
+	}
+
+	bool FrameCapture::isSized() const {
+		return !slots.empty();
+	}
+
+	uint64_t FrameCapture::getCapturedCount() const {
+		return capturedCount.load();
+	}
+
+	uint64_t FrameCapture::getDroppedCount() const {
+		return droppedCount.load();
+	}
+}
@@ -0,0 +1,165 @@
+#include "vulkan/GpuProfiler.h"
+#include <cstring>
+#include <limits>
+
+namespace Vulkan {
+	GpuProfiler::GpuProfiler(vk::raii::Device const& device, vk::raii::PhysicalDevice const& physicalDevice, uint32_t const& queueFamilyIndex, uint32_t const& framesInFlightCount, uint32_t const& maxZonesPerFrame) : pools{}, frameZones(framesInFlightCount), usedQueries(framesInFlightCount, 0), awaitingResults(framesInFlightCount, false), results{}, zoneTimes{}, slotFrameNumbers(framesInFlightCount, 0), frameHistory{ nullptr }, queriesPerFrame{ maxZonesPerFrame * 2 }, windowSize{ WINDOW_SIZE }, currentFrame{ 0 }, frameNumber{ 0 }, timestampPeriod{ physicalDevice.getProperties().limits.timestampPeriod }, timestampMask{ 0 }, supported{ false } {
+		uint32_t validBits = physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].timestampValidBits;
+		if (validBits == 0) {
+			std::cout << "GPU timestamps not supported on queue family " << queueFamilyIndex << ", GPU timings disabled\n";
+			return;
+		}
+
+		timestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : ((uint64_t{ 1 } << validBits) - 1);
+		supported = true;
+
+		vk::QueryPoolCreateInfo poolInfo = {
+			.queryType = vk::QueryType::eTimestamp,
+			.queryCount = queriesPerFrame
+		};
+		for (uint32_t i = 0; i < framesInFlightCount; i++) {
+			pools.push_back(vk::raii::QueryPool(device, poolInfo));
+			frameZones[i].reserve(maxZonesPerFrame);
+		}
+		// a value and an availability word per query
+		results.resize(queriesPerFrame * 2);
+
+		std::cout << "Created " << pools.size() << " timestamp query pools with " << queriesPerFrame << " queries each {TIMESTAMP PERIOD: " << timestampPeriod << " ns} {VALID BITS: " << validBits << "}\n";
+	}
+
+	void GpuProfiler::beginFrame(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex) {
+		if (!supported) {
+			return;
+		}
+
+		collect(frameIndex);
+
+		currentFrame = frameIndex;
+		slotFrameNumbers[frameIndex] = frameNumber++;
+		frameZones[frameIndex].clear();
+		usedQueries[frameIndex] = 0;
+		cmdBuffer.resetQueryPool(pools[frameIndex], 0, queriesPerFrame);
+		awaitingResults[frameIndex] = true;
+	}
+
+	void GpuProfiler::replayFrame(uint32_t const& frameIndex) {
+		if (!supported) {
+			return;
+		}
+
+		collect(frameIndex);
+
+		currentFrame = frameIndex;
+		slotFrameNumbers[frameIndex] = frameNumber++;
+		awaitingResults[frameIndex] = true;
+	}
+
+	uint32_t GpuProfiler::beginZone(vk::raii::CommandBuffer const& cmdBuffer, const char* name) {
+		if (!supported || usedQueries[currentFrame] + 2 > queriesPerFrame) {
+			return std::numeric_limits<uint32_t>::max();
+		}
+
+		Zone zone = {
+			.name = name,
+			.beginQuery = usedQueries[currentFrame],
+			.endQuery = usedQueries[currentFrame] + 1
+		};
+		usedQueries[currentFrame] += 2;
+
+		cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, pools[currentFrame], zone.beginQuery);
+		frameZones[currentFrame].push_back(zone);
+
+		return static_cast<uint32_t>(frameZones[currentFrame].size() - 1);
+	}
+
+	void GpuProfiler::endZone(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& zone) {
+		if (zone == std::numeric_limits<uint32_t>::max()) {
+			return;
+		}
+
+		cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, pools[currentFrame], frameZones[currentFrame][zone].endQuery);
+	}
+
+	// no wait flag, a query that is somehow not written yet is skipped instead of stalling the frame
+	void GpuProfiler::collect(uint32_t const& frameIndex) {
+		if (!awaitingResults[frameIndex] || usedQueries[frameIndex] == 0) {
+			return;
+		}
+		awaitingResults[frameIndex] = false;
+
+		// straight into results, the raii overload would hand back a new vector every frame
+		uint32_t queryCount = usedQueries[frameIndex];
+		vk::raii::QueryPool const& pool = pools[frameIndex];
+		vk::Result queried = pool.getDevice().getQueryPoolResults(*pool, 0, queryCount, queryCount * 2 * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability, *pool.getDispatcher());
+		if (queried != vk::Result::eSuccess && queried != vk::Result::eNotReady) {
+			return;
+		}
+
+		for (Zone const& zone : frameZones[frameIndex]) {
+			uint64_t beginAvailable = results[zone.beginQuery * 2 + 1];
+			uint64_t endAvailable = results[zone.endQuery * 2 + 1];
+			if (beginAvailable == 0 || endAvailable == 0) {
+				continue;
+			}
+
+			uint64_t ticks = (results[zone.endQuery * 2] - results[zone.beginQuery * 2]) & timestampMask;
+			double milliseconds = static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+			getZoneTimes(zone.name).add(milliseconds);
+			if (frameHistory != nullptr) {
+				frameHistory->push_back(GpuFrameSample{ .frameNumber = slotFrameNumbers[frameIndex], .zone = zone.name, .milliseconds = milliseconds });
+			}
+		}
+	}
+
+	General::RollingPercentiles& GpuProfiler::getZoneTimes(const char* name) {
+		for (std::pair<const char*, General::RollingPercentiles>& times : zoneTimes) {
+			if (strcmp(times.first, name) == 0) {
+				return times.second;
+			}
+		}
+
+		zoneTimes.emplace_back(name, General::RollingPercentiles(windowSize));
+		return zoneTimes.back().second;
+	}
+
+	General::RollingPercentiles const* GpuProfiler::getZoneStats(const char* name) const {
+		for (std::pair<const char*, General::RollingPercentiles> const& times : zoneTimes) {
+			if (strcmp(times.first, name) == 0) {
+				return &times.second;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void GpuProfiler::resetStatistics(uint32_t const& newWindowSize) {
+		windowSize = newWindowSize;
+		zoneTimes.clear();
+	}
+
+	void GpuProfiler::setFrameHistory(std::vector<GpuFrameSample>* history) {
+		frameHistory = history;
+	}
+
+	void GpuProfiler::flush() {
+		for (uint32_t i = 0; i < static_cast<uint32_t>(pools.size()); i++) {
+			collect(i);
+		}
+	}
+
+	uint64_t GpuProfiler::getFrameNumber() const {
+		return frameNumber;
+	}
+
+	bool GpuProfiler::isSupported() const {
+		return supported;
+	}
+
+	GpuZone::GpuZone(GpuProfiler& profiler, vk::raii::CommandBuffer const& cmdBuffer, const char* name) : profiler{ profiler }, cmdBuffer{ cmdBuffer }, zone{ profiler.beginZone(cmdBuffer, name) } {
+
+	}
+
+	GpuZone::~GpuZone() {
+		profiler.endZone(cmdBuffer, zone);
+	}
+}
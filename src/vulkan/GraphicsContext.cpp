@@ -1,27 +1,55 @@
 #include "vulkan/GraphicsContext.h"
-#include <fstream>
+#include <limits>
+#include <bit>
+#include <algorithm>
 
 namespace Vulkan {
-	GraphicsContext::GraphicsContext(VulkanContext&& context, GraphicsContextInitInfo const& initInfo) : context(std::move(context)), swapchain{ nullptr }, scImageViews{}, graphicsPipeline{ nullptr }, verticiesBuffer{ nullptr }, verticiesBufferMemory{ nullptr }, indicesBuffer{ nullptr }, indicesBufferMemory{ nullptr }, verticiesCount{}, indicesCount{}, descriptorSetLayout{ nullptr }, uniformBuffers{}, uniformBuffersMemory{}, uniformBuffersAddresses{}, descriptorSetPool{ nullptr }, descriptorSets{}, pipelineLayout{ nullptr }, savedScConfigInfo { initInfo.scFormat, initInfo.scImageCount, initInfo.scPresentMode, initInfo.scImageUsage, initInfo.scImageViewAspect, initInfo.scImageSharingMode, initInfo.scQueueFamilyAccessorCount, initInfo.scQueueFamilyAccessorIndiceList, initInfo.scPreTransform } {
-		initSwapchainAndImageViews(initInfo.scFormat, initInfo.scImageCount, initInfo.scPresentMode, initInfo.scImageUsage, initInfo.scImageViewAspect, initInfo.scImageSharingMode, initInfo.scQueueFamilyAccessorCount, initInfo.scQueueFamilyAccessorIndiceList, initInfo.scPreTransform);
-		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initDescriptorSetLayout(initInfo.descriptorSetLayoutBindings);
-		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initUniformBuffers(initInfo.uniformBufferInfo);
-		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		createDescriptorPool();
+	GraphicsContext::GraphicsContext(VulkanContext&& context, GraphicsContextInitInfo const& initInfo) : context(std::move(context)), swapchain{ nullptr }, scImages{}, scImageViews{}, scExtent{}, scFormat{}, verticiesBuffer{ nullptr }, verticiesBufferMemory{ nullptr }, indicesBuffer{ nullptr }, indicesBufferMemory{ nullptr }, verticiesCount{}, indicesCount{}, verticiesBoundsMin{}, verticiesBoundsMax{}, descriptorSetLayout{ nullptr }, uniformBuffers{}, uniformBuffersMemory{}, uniformBuffersAddresses{}, descriptorSetPool{ nullptr }, descriptorSets{}, pipelineLayout{ nullptr }, shaderModuleCache{ nullptr }, pipelineRegistry{ nullptr }, graphicsPipeline{ 0 }, dynamicStates{}, depthFormat{}, sampleCount{ vk::SampleCountFlagBits::e1 }, depthResolveMode{ vk::ResolveModeFlagBits::eSampleZero }, defaultRasterState{}, pipelineDescription{}, savedScConfigInfo { initInfo.scFormat, initInfo.scImageCount, initInfo.scPresentMode, initInfo.scImageUsage, initInfo.scImageViewAspect, initInfo.scImageSharingMode, initInfo.scQueueFamilyAccessorCount, initInfo.scQueueFamilyAccessorIndiceList, initInfo.scPreTransform } {
+		// pipeline compiles and the buffer uploads go to other threads first, the swapchain and descriptors are built while they run
+		{
+			General::StartupStep step("descriptor and pipeline layout");
+			initDescriptorSetLayout(initInfo.descriptorSetLayoutBindings);
+			initPipelineLayout();
+		}
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		createDescriptorSets();
+		dynamicStates = getSupportedDynamicStates(initInfo.dynamicStates);
+		depthFormat = getDepthFormat();
+		sampleCount = getSampleCount(initInfo.gpSampleCount);
+		depthResolveMode = getDepthResolveMode();
+		scFormat = getScFormat(initInfo.scFormat);
+		if (scFormat == vk::SurfaceFormatKHR{}) {
+			throw std::runtime_error("Surface reports no swapchain formats");
+		}
+		pipelineDescription = getPipelineDescription(initInfo.gpShaderStageInfos, initInfo.gpVertexInputInfo, initInfo.gpInputAssemblyInfo, initInfo.gpViewportStateInfo, initInfo.gpRasterizationInfo, initInfo.gpColourBlendingInfo, dynamicStates);
+		defaultRasterState = getRasterState(pipelineDescription);
+		initGraphicsPipeline(initInfo.gpShaderVariant, initInfo.gpCompileWorkerCount, initInfo.gpPreloadedShaders);
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initGraphicsPipeline(initInfo.gpShaderStageInfos, initInfo.gpVertexInputInfo, initInfo.gpInputAssemblyInfo, initInfo.gpViewportStateInfo, initInfo.gpRasterizationInfo, initInfo.gpColourBlendingInfo, initInfo.dynamicStates);
+
+		// the uploads are the only queue users during construction, so they get the queue to themselves
+		std::future<void> buffersUploaded = std::async(std::launch::async, [this, &initInfo]() {
+			General::StartupStep step("vertex and index upload");
+			initVertexBuffer(initInfo.verticiesBufferInfo);
+			initIndexBuffer(initInfo.indexBufferData);
+		});
+
+		{
+			General::StartupStep step("swapchain");
+			initSwapchainAndImageViews(initInfo.scImageCount, initInfo.scPresentMode, initInfo.scImageUsage, initInfo.scImageViewAspect, initInfo.scImageSharingMode, initInfo.scQueueFamilyAccessorCount, initInfo.scQueueFamilyAccessorIndiceList, initInfo.scPreTransform, nullptr);
+		}
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initVertexBuffer(initInfo.verticiesBufferInfo);
+		{
+			General::StartupStep step("uniform buffers and descriptors");
+			initUniformBuffers(initInfo.uniformBufferInfo);
+			createDescriptorPool(initInfo.descriptorSetLayoutBindings);
+			createDescriptorSets();
+		}
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
-		initIndexBuffer(initInfo.indexBufferData);
+
+		buffersUploaded.get();
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
 	}
 
-	GraphicsContext::GraphicsContext(GraphicsContext&& moveFrom) : context(std::move(moveFrom.context)), swapchain(std::move(moveFrom.swapchain)), scImageViews(std::move(moveFrom.scImageViews)), graphicsPipeline(std::move(moveFrom.graphicsPipeline)), verticiesBuffer(std::move(moveFrom.verticiesBuffer)), verticiesBufferMemory(std::move(moveFrom.verticiesBufferMemory)), indicesBuffer(std::move(moveFrom.indicesBuffer)), indicesBufferMemory(std::move(moveFrom.indicesBufferMemory)), verticiesCount(std::move(moveFrom.verticiesCount)), indicesCount(std::move(moveFrom.indicesCount)), descriptorSetLayout(std::move(moveFrom.descriptorSetLayout)), uniformBuffers(std::move(moveFrom.uniformBuffers)), uniformBuffersMemory(std::move(moveFrom.uniformBuffersMemory)), uniformBuffersAddresses(std::move(moveFrom.uniformBuffersAddresses)), descriptorSetPool(std::move(moveFrom.descriptorSetPool)), descriptorSets(std::move(moveFrom.descriptorSets)), pipelineLayout(std::move(moveFrom.pipelineLayout)), savedScConfigInfo(std::move(moveFrom.savedScConfigInfo)) {
+	GraphicsContext::GraphicsContext(GraphicsContext&& moveFrom) : context(std::move(moveFrom.context)), swapchain(std::move(moveFrom.swapchain)), scImages(std::move(moveFrom.scImages)), scImageViews(std::move(moveFrom.scImageViews)), scExtent(moveFrom.scExtent), scFormat(moveFrom.scFormat), verticiesBuffer(std::move(moveFrom.verticiesBuffer)), verticiesBufferMemory(std::move(moveFrom.verticiesBufferMemory)), indicesBuffer(std::move(moveFrom.indicesBuffer)), indicesBufferMemory(std::move(moveFrom.indicesBufferMemory)), verticiesCount(std::move(moveFrom.verticiesCount)), indicesCount(std::move(moveFrom.indicesCount)), verticiesBoundsMin(moveFrom.verticiesBoundsMin), verticiesBoundsMax(moveFrom.verticiesBoundsMax), descriptorSetLayout(std::move(moveFrom.descriptorSetLayout)), uniformBuffers(std::move(moveFrom.uniformBuffers)), uniformBuffersMemory(std::move(moveFrom.uniformBuffersMemory)), uniformBuffersAddresses(std::move(moveFrom.uniformBuffersAddresses)), descriptorSetPool(std::move(moveFrom.descriptorSetPool)), descriptorSets(std::move(moveFrom.descriptorSets)), pipelineLayout(std::move(moveFrom.pipelineLayout)), shaderModuleCache(std::move(moveFrom.shaderModuleCache)), pipelineRegistry(std::move(moveFrom.pipelineRegistry)), graphicsPipeline(moveFrom.graphicsPipeline), dynamicStates(std::move(moveFrom.dynamicStates)), depthFormat(moveFrom.depthFormat), sampleCount(moveFrom.sampleCount), depthResolveMode(moveFrom.depthResolveMode), defaultRasterState(moveFrom.defaultRasterState), pipelineDescription(std::move(moveFrom.pipelineDescription)), savedScConfigInfo(std::move(moveFrom.savedScConfigInfo)) {
 		
 	}
 
@@ -29,22 +57,82 @@ namespace Vulkan {
 		return context;
 	}
 
-	void GraphicsContext::recreateSwapchain() {
-		swapchain = nullptr;
-		scImageViews.clear();
+	PipelineRegistry::PipelineId GraphicsContext::requestPipelineVariant(ShaderVariantKey const& variant) {
+		PipelineDescription variantDescription = pipelineDescription;
+		variantDescription.applyVariant(variant);
+
+		return pipelineRegistry->request(variantDescription);
+	}
+
+	PipelineRegistry::PipelineId GraphicsContext::requestOverdrawPipeline(vk::Format const& counterFormat) {
+		PipelineDescription overdrawDescription = pipelineDescription;
+		overdrawDescription.colourFormat = counterFormat;
+		overdrawDescription.depthFormat = vk::Format::eUndefined;
+		overdrawDescription.samples = vk::SampleCountFlagBits::e1;
+		overdrawDescription.logicOpEnable = false;
+		for (vk::PipelineColorBlendAttachmentState& attachment : overdrawDescription.blendAttachments) {
+			attachment = vk::PipelineColorBlendAttachmentState{
+				.blendEnable = true,
+				.srcColorBlendFactor = vk::BlendFactor::eOne,
+				.dstColorBlendFactor = vk::BlendFactor::eOne,
+				.colorBlendOp = vk::BlendOp::eAdd,
+				.srcAlphaBlendFactor = vk::BlendFactor::eOne,
+				.dstAlphaBlendFactor = vk::BlendFactor::eOne,
+				.alphaBlendOp = vk::BlendOp::eAdd,
+				.colorWriteMask = vk::ColorComponentFlagBits::eR
+			};
+		}
+		overdrawDescription.applyVariant(ShaderVariantKey{}.with(ShaderFeature::eOverdraw, true));
+
+		// a stage's own constants win over the variant's, without OVERDRAW the pass would count shaded colour instead of fragments
+		uint32_t overdrawId = static_cast<uint32_t>(ShaderFeature::eOverdraw);
+		for (PipelineShaderStage const& stage : overdrawDescription.shaderStages) {
+			std::map<uint32_t, SpecializationValue> const& constants = stage.specialization.getConstants();
+			auto overdraw = constants.find(overdrawId);
+			if (stage.stage == vk::ShaderStageFlagBits::eFragment && (overdraw == constants.end() || overdraw->second != SpecializationValue{ true })) {
+				throw std::runtime_error("Overdraw pipeline does not specialize OVERDRAW to true");
+			}
+		}
+
+		return pipelineRegistry->request(overdrawDescription);
+	}
+
+	// an undefined colour format leaves the attachment slot unused, the prepass renders with a null view in it
+	PipelineRegistry::PipelineId GraphicsContext::requestDepthOnlyPipeline() {
+		PipelineDescription depthDescription = pipelineDescription;
+		std::erase_if(depthDescription.shaderStages, [](PipelineShaderStage const& stage) { return stage.stage == vk::ShaderStageFlagBits::eFragment; });
+		depthDescription.colourFormat = vk::Format::eUndefined;
+		// no feature changes the depth, but every constant the shader declares has to be set
+		depthDescription.applyVariant(ShaderVariantKey{});
+
+		return pipelineRegistry->request(depthDescription);
+	}
+
+	vk::raii::Pipeline GraphicsContext::createComputePipeline(std::string const& sprivPath, const char* entryPoint, vk::PipelineLayout const& layout) {
+		vk::ComputePipelineCreateInfo pipelineInfo = {
+			.stage = vk::PipelineShaderStageCreateInfo{ .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModuleCache->getShaderModule(sprivPath), .pName = entryPoint },
+			.layout = layout
+		};
+
+		return vk::raii::Pipeline(context.device, nullptr, pipelineInfo);
+	}
+
+	// the old swapchain is handed to the new one so presentation carries on, it and its views wait in the queue until no frame uses them
+	void GraphicsContext::recreateSwapchain(DeletionQueue& deletionQueue) {
+		vk::raii::SwapchainKHR oldSwapchain = std::move(swapchain);
+		deletionQueue.retireAll(scImageViews);
+		scImages.clear();
 
-		initSwapchainAndImageViews(std::get<0>(savedScConfigInfo), std::get<1>(savedScConfigInfo), std::get<2>(savedScConfigInfo), std::get<3>(savedScConfigInfo), std::get<4>(savedScConfigInfo), std::get<5>(savedScConfigInfo), std::get<6>(savedScConfigInfo), std::get<7>(savedScConfigInfo), std::get<8>(savedScConfigInfo));
+		initSwapchainAndImageViews(std::get<1>(savedScConfigInfo), std::get<2>(savedScConfigInfo), std::get<3>(savedScConfigInfo), std::get<4>(savedScConfigInfo), std::get<5>(savedScConfigInfo), std::get<6>(savedScConfigInfo), std::get<7>(savedScConfigInfo), std::get<8>(savedScConfigInfo), *oldSwapchain);
+		deletionQueue.retire(std::move(oldSwapchain));
 	}
 
-	void GraphicsContext::initSwapchainAndImageViews(vk::SurfaceFormatKHR const& desiredFormat, uint32_t const& desiredImageCount, vk::PresentModeKHR const& desiredPresentMode, vk::ImageUsageFlags const& imageUsage, vk::ImageAspectFlags const& imageViewAspect, vk::SharingMode const& sharingMode, uint32_t const& queueFamilyAccessorCount, uint32_t* queueFamilyAccessorIndiceList, vk::SurfaceTransformFlagBitsKHR const& preTransform) {
+	void GraphicsContext::initSwapchainAndImageViews(uint32_t const& desiredImageCount, vk::PresentModeKHR const& desiredPresentMode, vk::ImageUsageFlags const& imageUsage, vk::ImageAspectFlags const& imageViewAspect, vk::SharingMode const& sharingMode, uint32_t const& queueFamilyAccessorCount, uint32_t* queueFamilyAccessorIndiceList, vk::SurfaceTransformFlagBitsKHR const& preTransform, vk::SwapchainKHR const& oldSwapchain) {
 		vk::Extent2D extent = getSurfaceExtent();
-		vk::SurfaceFormatKHR format = getScFormat(desiredFormat);
+		vk::SurfaceFormatKHR format = scFormat;
 		uint32_t imageCount = getScImageCount(desiredImageCount);
 		vk::PresentModeKHR presentMode = getScPresentMode(desiredPresentMode);
 
-		if (format == vk::SurfaceFormatKHR{}) {
-			throw std::runtime_error("Desired swapchain format not supported");
-		}
 		if(imageCount == 0xFFFFFFFF) {
 			throw std::runtime_error("Desired swapchain image count not supported");
 		}
@@ -66,13 +154,15 @@ namespace Vulkan {
 			.preTransform = preTransform,
 			.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
 			.presentMode = presentMode,
-			.clipped = true
+			.clipped = true,
+			.oldSwapchain = oldSwapchain
 		};
 
 		swapchain = vk::raii::SwapchainKHR(context.device, swapchainInfo);
 		std::cout << "Created swapchain\n";
 
-		std::vector<vk::Image> scImages = swapchain.getImages();
+		scImages = swapchain.getImages();
+		scExtent = extent;
 
 		vk::ImageViewCreateInfo imageViewCreateInfo = {
 			.image = {},
@@ -116,21 +206,26 @@ namespace Vulkan {
 	}
 
 	// HARD CODED NANA
-	void GraphicsContext::createDescriptorPool() {
-		vk::DescriptorPoolSize poolSize = {
-			.type = vk::DescriptorType::eUniformBuffer,
-			.descriptorCount = 2
-		};
+	void GraphicsContext::createDescriptorPool(std::vector<vk::DescriptorSetLayoutBinding> const& bindings) {
+		std::vector<vk::DescriptorPoolSize> poolSizes;
+		for (vk::DescriptorSetLayoutBinding const& binding : bindings) {
+			std::vector<vk::DescriptorPoolSize>::iterator found = std::find_if(poolSizes.begin(), poolSizes.end(), [&binding](vk::DescriptorPoolSize const& size) { return size.type == binding.descriptorType; });
+			if (found == poolSizes.end()) {
+				poolSizes.push_back(vk::DescriptorPoolSize{ .type = binding.descriptorType, .descriptorCount = 0 });
+				found = poolSizes.end() - 1;
+			}
+			found->descriptorCount += binding.descriptorCount * 2;
+		}
 
 		vk::DescriptorPoolCreateInfo poolInfo = {
 			.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
 			.maxSets = 2,
-			.poolSizeCount = 1,
-			.pPoolSizes = &poolSize
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data()
 		};
 
 		descriptorSetPool = vk::raii::DescriptorPool(context.device, poolInfo);
-		std::cout << "Created descriptor pool to allocate " << poolSize.descriptorCount << " d-sets\n";
+		std::cout << "Created descriptor pool to allocate " << poolInfo.maxSets << " d-sets with " << poolSizes.size() << " descriptor types\n";
 	}
 
 	// HARD CODED NANA
@@ -167,110 +262,203 @@ namespace Vulkan {
 		std::cout << "Created the descriptor within the sets\n";
 	}
 
-	void GraphicsContext::initGraphicsPipeline(std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*>> const& shaderStageInfos, std::tuple<vk::VertexInputBindingDescription, std::vector<vk::VertexInputAttributeDescription>> const& vInfo, std::tuple<vk::PrimitiveTopology, bool> const& inAssemInfo, std::tuple<std::array<float, 6>, std::array<uint32_t, 4>> const& viewInfo, std::tuple<bool, bool, vk::PolygonMode, vk::CullModeFlagBits, vk::FrontFace, bool, float, float, float, float> const& rasInfo, std::tuple<std::vector<std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags>>, std::tuple<bool, vk::LogicOp, std::array<float, 4>>> const& cBlendInfo, std::vector<vk::DynamicState> const& dyInfo) {
-		std::vector<std::tuple<vk::ShaderStageFlagBits, vk::raii::ShaderModule, const char*>> shaderStageInfosConverted{};
-		for(int i = 0; i < shaderStageInfos.size(); i++) {
-			shaderStageInfosConverted.push_back(std::make_tuple(std::get<0>(shaderStageInfos[i]), getShaderModule(std::get<1>(shaderStageInfos[i])), std::get<2>(shaderStageInfos[i])));
+	void GraphicsContext::initPipelineLayout() {
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo = { 
+			.setLayoutCount = 1,
+			.pSetLayouts = &*descriptorSetLayout,
+			.pushConstantRangeCount = 0 
+		};
+		pipelineLayout = vk::raii::PipelineLayout(context.device, pipelineLayoutInfo);
+
+		std::cout << "Created pipeline layout\n";
+	}
+
+	// the pipeline is compiled in the background, the engine skips drawing with it until it is ready
+	void GraphicsContext::initGraphicsPipeline(ShaderVariantKey const& variant, uint32_t const& compileWorkerCount, std::vector<std::shared_ptr<SprivBinary const>> const& preloadedShaders) {
+		shaderModuleCache = std::make_unique<ShaderModuleCache>(context.device);
+		for (std::shared_ptr<SprivBinary const> const& binary : preloadedShaders) {
+			shaderModuleCache->addPreloaded(binary);
 		}
-		std::vector<vk::PipelineShaderStageCreateInfo> shaderCreateInfo = getConfigurableShaderStageInfos(shaderStageInfosConverted);
+		pipelineRegistry = std::make_unique<PipelineRegistry>(context.device, *shaderModuleCache, compileWorkerCount);
+		graphicsPipeline = requestPipelineVariant(variant);
 
-		vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {
-			.vertexBindingDescriptionCount = 1,
-			.pVertexBindingDescriptions = &std::get<0>(vInfo),
-			.vertexAttributeDescriptionCount = static_cast<uint32_t>(std::get<1>(vInfo).size()),
-			.pVertexAttributeDescriptions = std::get<1>(vInfo).data()
-		};
+		std::cout << "Requested graphics pipeline " << graphicsPipeline << '\n';
+	}
 
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {
-			.topology = std::get<0>(inAssemInfo),
-			.primitiveRestartEnable = static_cast<uint32_t>(std::get<1>(inAssemInfo))
-		};
+	PipelineDescription GraphicsContext::getPipelineDescription(std::vector<std::tuple<vk::ShaderStageFlagBits, const char*, const char*, SpecializationConstants>> const& shaderStageInfos, std::tuple<vk::VertexInputBindingDescription, std::vector<vk::VertexInputAttributeDescription>> const& vInfo, std::tuple<vk::PrimitiveTopology, bool> const& inAssemInfo, std::tuple<std::array<float, 6>, std::array<uint32_t, 4>> const& viewInfo, std::tuple<bool, bool, vk::PolygonMode, vk::CullModeFlagBits, vk::FrontFace, bool, float, float, float, float> const& rasInfo, std::tuple<std::vector<std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags>>, std::tuple<bool, vk::LogicOp, std::array<float, 4>>> const& cBlendInfo, std::vector<vk::DynamicState> const& dyInfo) {
+		std::vector<PipelineShaderStage> shaderStages{};
+		for (std::tuple<vk::ShaderStageFlagBits, const char*, const char*, SpecializationConstants> const& stageInfo : shaderStageInfos) {
+			shaderStages.push_back(PipelineShaderStage{ std::get<0>(stageInfo), std::get<1>(stageInfo), std::get<2>(stageInfo), std::get<3>(stageInfo) });
+		}
 
-		vk::Viewport viewport(std::get<0>(viewInfo)[0], std::get<0>(viewInfo)[1], std::get<0>(viewInfo)[2], std::get<0>(viewInfo)[3], std::get<0>(viewInfo)[4], std::get<0>(viewInfo)[5]);
-		vk::Rect2D scissor(vk::Offset2D(std::get<1>(viewInfo)[0], std::get<1>(viewInfo)[1]), vk::Extent2D(std::get<1>(viewInfo)[2], std::get<1>(viewInfo)[3]));
-		vk::PipelineViewportStateCreateInfo viewportScissorInfo = {
-			.viewportCount = 1,
-			.pViewports = &viewport,
-			.scissorCount = 1,
-			.pScissors = &scissor
-		};
+		std::vector<vk::PipelineColorBlendAttachmentState> attachmentInfos{};
+		for (std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags> const& attInfo : std::get<0>(cBlendInfo)) {
+			attachmentInfos.emplace_back(std::get<0>(attInfo), std::get<1>(attInfo), std::get<2>(attInfo), std::get<3>(attInfo), std::get<4>(attInfo), std::get<5>(attInfo), std::get<6>(attInfo), std::get<7>(attInfo));
+		}
 
-		vk::PipelineRasterizationStateCreateInfo rasterizationInfo = {
-			.depthClampEnable = std::get<0>(rasInfo),
-			.rasterizerDiscardEnable = std::get<1>(rasInfo),
+		return PipelineDescription{
+			.shaderStages = shaderStages,
+			.vertexBinding = std::get<0>(vInfo),
+			.vertexAttributes = std::get<1>(vInfo),
+			.topology = std::get<0>(inAssemInfo),
+			.primitiveRestart = std::get<1>(inAssemInfo),
+			.viewport = vk::Viewport(std::get<0>(viewInfo)[0], std::get<0>(viewInfo)[1], std::get<0>(viewInfo)[2], std::get<0>(viewInfo)[3], std::get<0>(viewInfo)[4], std::get<0>(viewInfo)[5]),
+			.scissor = vk::Rect2D(vk::Offset2D(std::get<1>(viewInfo)[0], std::get<1>(viewInfo)[1]), vk::Extent2D(std::get<1>(viewInfo)[2], std::get<1>(viewInfo)[3])),
+			.depthClamp = std::get<0>(rasInfo),
+			.rasterizerDiscard = std::get<1>(rasInfo),
 			.polygonMode = std::get<2>(rasInfo),
 			.cullMode = std::get<3>(rasInfo),
 			.frontFace = std::get<4>(rasInfo),
-			.depthBiasEnable = std::get<5>(rasInfo),
+			.depthBias = std::get<5>(rasInfo),
 			.depthBiasConstantFactor = std::get<6>(rasInfo),
 			.depthBiasClamp = std::get<7>(rasInfo),
 			.depthBiasSlopeFactor = std::get<8>(rasInfo),
-			.lineWidth = std::get<9>(rasInfo)
+			.lineWidth = std::get<9>(rasInfo),
+			.depthTest = true,
+			.depthWrite = true,
+			.depthCompareOp = vk::CompareOp::eLessOrEqual,
+			.depthBoundsTest = false,
+			.stencilTest = false,
+			.blendAttachments = attachmentInfos,
+			.logicOpEnable = std::get<0>(std::get<1>(cBlendInfo)),
+			.logicOp = std::get<1>(std::get<1>(cBlendInfo)),
+			.blendConstants = std::get<2>(std::get<1>(cBlendInfo)),
+			.dynamicStates = dyInfo,
+			.colourFormat = scFormat.format,
+			.depthFormat = depthFormat,
+			.samples = sampleCount,
+			.layout = *pipelineLayout
 		};
+	}
 
-		// HARD CODED NANA
-		vk::PipelineMultisampleStateCreateInfo multisampling{ .rasterizationSamples = vk::SampleCountFlagBits::e1, .sampleShadingEnable = vk::False };
+	// depth only formats, the first one that can be both rendered to and sampled, D16 is required to do both
+	vk::Format GraphicsContext::getDepthFormat() {
+		std::array<vk::Format, 3> candidates = { vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD16Unorm };
+		vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage;
 
-		std::vector<vk::PipelineColorBlendAttachmentState> attachmentInfos{};
-		for(std::tuple<bool, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::BlendFactor, vk::BlendFactor, vk::BlendOp, vk::ColorComponentFlags> const& attInfo : std::get<0>(cBlendInfo)) {
-			attachmentInfos.emplace_back(std::get<0>(attInfo), std::get<1>(attInfo), std::get<2>(attInfo), std::get<3>(attInfo), std::get<4>(attInfo), std::get<5>(attInfo), std::get<6>(attInfo), std::get<7>(attInfo));
+		for (vk::Format const& candidate : candidates) {
+			if ((context.physicalDevice.getFormatProperties(candidate).optimalTilingFeatures & required) == required) {
+				std::cout << "Depth format " << vk::to_string(candidate) << '\n';
+				return candidate;
+			}
 		}
-		vk::PipelineColorBlendStateCreateInfo colorBlendInfo = {
-			.logicOpEnable = std::get<0>(std::get<1>(cBlendInfo)),
-			.logicOp = std::get<1>(std::get<1>(cBlendInfo)),
-			.attachmentCount = static_cast<uint32_t>(attachmentInfos.size()),
-			.pAttachments = attachmentInfos.data(),
-			.blendConstants = std::get<2>(std::get<1>(cBlendInfo))
-		};
 
-		vk::PipelineDynamicStateCreateInfo dynamicStateInfo = {
-			.dynamicStateCount = static_cast<uint32_t>(dyInfo.size()),
-			.pDynamicStates = dyInfo.data()
-		};
+		throw std::runtime_error("No depth format can be both rendered to and sampled");
+	}
 
-		vk::PipelineLayoutCreateInfo pipelineLayoutInfo = { 
-			.setLayoutCount = 1,
-			.pSetLayouts = &*descriptorSetLayout,
-			.pushConstantRangeCount = 0 
-		};
-		pipelineLayout = vk::raii::PipelineLayout(context.device, pipelineLayoutInfo);
+	// sample counts are single bits, so halving walks down through every lower count
+	vk::SampleCountFlagBits GraphicsContext::getSampleCount(vk::SampleCountFlagBits const& requested) {
+		vk::PhysicalDeviceLimits limits = context.physicalDevice.getProperties().limits;
+		vk::SampleCountFlags supported = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
 
-		// HARD CODED NANA
-		vk::Format tempformat = vk::Format::eR8G8B8A8Srgb;
-		vk::PipelineRenderingCreateInfo renderingAttachmentInfo = {
-			.colorAttachmentCount = 1,
-			.pColorAttachmentFormats = &tempformat
-		};
+		uint32_t count = std::bit_floor(static_cast<uint32_t>(requested));
+		while (count > 1 && !(supported & static_cast<vk::SampleCountFlagBits>(count))) {
+			count >>= 1;
+		}
+		vk::SampleCountFlagBits chosen = count == 0 ? vk::SampleCountFlagBits::e1 : static_cast<vk::SampleCountFlagBits>(count);
 
-		vk::GraphicsPipelineCreateInfo graphicsPipelineInfo = {
-			.pNext = &renderingAttachmentInfo,
-			.stageCount = 2,
-			.pStages = shaderCreateInfo.data(),
-			.pVertexInputState = &vertexInputInfo,
-			.pInputAssemblyState = &inputAssemblyInfo,
-			.pViewportState = &viewportScissorInfo,
-			.pRasterizationState = &rasterizationInfo,
-			.pMultisampleState = &multisampling,
-			.pColorBlendState = &colorBlendInfo,
-			.pDynamicState = &dynamicStateInfo,
-			.layout = pipelineLayout,
-			.renderPass = nullptr
-		};
+		std::cout << "MSAA " << vk::to_string(chosen) << (chosen != requested ? " (" + vk::to_string(requested) + " requested)" : "") << '\n';
+		return chosen;
+	}
+
+	// sample zero is required of every device, max keeps the furthest depth of each pixel so the hi-z never occludes more than was drawn
+	vk::ResolveModeFlagBits GraphicsContext::getDepthResolveMode() {
+		vk::PhysicalDeviceDepthStencilResolveProperties resolveProperties = context.physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDepthStencilResolveProperties>().get<vk::PhysicalDeviceDepthStencilResolveProperties>();
 
-		graphicsPipeline = vk::raii::Pipeline(context.device, nullptr, graphicsPipelineInfo);
-		std::cout << "Created graphics pipeline\n";
+		return (resolveProperties.supportedDepthResolveModes & vk::ResolveModeFlagBits::eMax) ? vk::ResolveModeFlagBits::eMax : vk::ResolveModeFlagBits::eSampleZero;
 	}
 
-	// already decided by how large the window is
+	// extended dynamic state 1 and 2 are core in 1.3, the 3 states need the extension and their own feature bit
+	std::vector<vk::DynamicState> GraphicsContext::getSupportedDynamicStates(std::vector<vk::DynamicState> const& requested) {
+		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT const& eds3 = context.extendedDynamicState3Features;
+		std::vector<vk::DynamicState> supported{};
+
+		for (vk::DynamicState const& state : requested) {
+			bool isSupported = true;
+
+			switch (state) {
+			case vk::DynamicState::ePolygonModeEXT:
+				isSupported = eds3.extendedDynamicState3PolygonMode;
+				break;
+			case vk::DynamicState::eDepthClampEnableEXT:
+				isSupported = eds3.extendedDynamicState3DepthClampEnable;
+				break;
+			case vk::DynamicState::eLogicOpEnableEXT:
+				isSupported = eds3.extendedDynamicState3LogicOpEnable;
+				break;
+			case vk::DynamicState::eColorBlendEnableEXT:
+				isSupported = eds3.extendedDynamicState3ColorBlendEnable;
+				break;
+			case vk::DynamicState::eColorBlendEquationEXT:
+				isSupported = eds3.extendedDynamicState3ColorBlendEquation;
+				break;
+			case vk::DynamicState::eColorWriteMaskEXT:
+				isSupported = eds3.extendedDynamicState3ColorWriteMask;
+				break;
+			default:
+				break;
+			}
+
+			if (isSupported) {
+				supported.push_back(state);
+			} else {
+				std::cout << "Dynamic state " << vk::to_string(state) << " not supported, it stays baked into the pipeline\n";
+			}
+		}
+
+		std::cout << supported.size() << " of " << requested.size() << " requested dynamic states supported\n";
+
+		return supported;
+	}
+
+	DynamicRasterState GraphicsContext::getRasterState(PipelineDescription const& description) {
+		vk::PipelineColorBlendAttachmentState const& blend = description.blendAttachments.front();
+
+		return DynamicRasterState{
+			.topology = description.topology,
+			.primitiveRestart = description.primitiveRestart,
+			.rasterizerDiscard = description.rasterizerDiscard,
+			.depthClamp = description.depthClamp,
+			.polygonMode = description.polygonMode,
+			.cullMode = description.cullMode,
+			.frontFace = description.frontFace,
+			.depthBias = description.depthBias,
+			.depthBiasConstantFactor = description.depthBiasConstantFactor,
+			.depthBiasClamp = description.depthBiasClamp,
+			.depthBiasSlopeFactor = description.depthBiasSlopeFactor,
+			.lineWidth = description.lineWidth,
+			.depthTest = description.depthTest,
+			.depthWrite = description.depthWrite,
+			.depthCompareOp = description.depthCompareOp,
+			.depthBoundsTest = description.depthBoundsTest,
+			.stencilTest = description.stencilTest,
+			.logicOpEnable = description.logicOpEnable,
+			.blendEnable = static_cast<bool>(blend.blendEnable),
+			.blendEquation = vk::ColorBlendEquationEXT{
+				.srcColorBlendFactor = blend.srcColorBlendFactor,
+				.dstColorBlendFactor = blend.dstColorBlendFactor,
+				.colorBlendOp = blend.colorBlendOp,
+				.srcAlphaBlendFactor = blend.srcAlphaBlendFactor,
+				.dstAlphaBlendFactor = blend.dstAlphaBlendFactor,
+				.alphaBlendOp = blend.alphaBlendOp
+			},
+			.colourWriteMask = blend.colorWriteMask
+		};
+	}
+
+	// already decided by how large the window is, or by the size asked for when headless
 	vk::Extent2D GraphicsContext::getSurfaceExtent() {
 		vk::SurfaceCapabilitiesKHR surfaceCapabilities = context.physicalDevice.getSurfaceCapabilitiesKHR(context.surface);
 		vk::Extent2D selectedExtent{};
 
-		if(surfaceCapabilities.currentExtent.width == 0xFFFFFFFF) {
-			int width = 0;
-			int height = 0;
+		// a headless surface has no window to match, some drivers still report a fixed current extent for it which would override the size asked for
+		if(surfaceCapabilities.currentExtent.width == 0xFFFFFFFF || context.headless) {
+			int width = static_cast<int>(context.headlessExtent.width);
+			int height = static_cast<int>(context.headlessExtent.height);
 
-			glfwGetFramebufferSize(context.window, &width, &height);
+			if (!context.headless) {
+				glfwGetFramebufferSize(context.window, &width, &height);
+			}
 
 			selectedExtent = vk::Extent2D(
 				std::clamp<uint32_t>(width, surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width),
@@ -283,7 +471,7 @@ namespace Vulkan {
 		return selectedExtent;
 	}
 
-	// returns vk::SurfaceFormatKHR{} if desiredFormat is not found in compatible formats
+	// falls back to the first compatible format if desiredFormat is not among them, returns vk::SurfaceFormatKHR{} only if there are none
 	vk::SurfaceFormatKHR GraphicsContext::getScFormat(vk::SurfaceFormatKHR const& desiredFormat) {
 		std::vector<vk::SurfaceFormatKHR> compatibleSurfaceFormats = context.physicalDevice.getSurfaceFormatsKHR(context.surface);
 		vk::SurfaceFormatKHR selectedFormat{};
@@ -293,6 +481,10 @@ namespace Vulkan {
 				selectedFormat = compFormat;
 			}
 		}
+		if (selectedFormat == vk::SurfaceFormatKHR{} && !compatibleSurfaceFormats.empty()) {
+			selectedFormat = compatibleSurfaceFormats[0];
+			std::cout << "Desired swapchain format not supported, using " << vk::to_string(selectedFormat.format) << " instead\n";
+		}
 
 		return selectedFormat;
 	}
@@ -304,7 +496,8 @@ namespace Vulkan {
 		uint32_t minImages = surfaceCapabilities.minImageCount;
 		uint32_t maxImages = surfaceCapabilities.maxImageCount;
 
-		if(desiredImageCount >= minImages && desiredImageCount <= maxImages) {
+		// a max of 0 means there is no upper limit
+		if(desiredImageCount >= minImages && (maxImages == 0 || desiredImageCount <= maxImages)) {
 			selectedImageCount = desiredImageCount;
 		}
 
@@ -325,22 +518,14 @@ namespace Vulkan {
 		return selectedPresentMode;
 	}
 
-	std::vector<vk::PipelineShaderStageCreateInfo> GraphicsContext::getConfigurableShaderStageInfos(std::vector<std::tuple<vk::ShaderStageFlagBits, vk::raii::ShaderModule, const char*>> const& infos) {
-		std::vector<vk::PipelineShaderStageCreateInfo> configurableShaderStageInfos{};
-
-		for (std::tuple<vk::ShaderStageFlagBits, vk::raii::ShaderModule, const char*> const& info : infos) {
-			configurableShaderStageInfos.push_back(vk::PipelineShaderStageCreateInfo {
-				.stage = std::get<0>(info),
-				.module = std::get<1>(info),
-				.pName = std::get<2>(info)
-			});
-		}
-
-		return configurableShaderStageInfos;
-	}
-
 	void GraphicsContext::initVertexBuffer(std::tuple<vk::SharingMode, std::vector<General::Vertex>> const& vbInfo) {
 		verticiesCount = std::get<1>(vbInfo).size();
+		verticiesBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+		verticiesBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		for (General::Vertex const& vertex : std::get<1>(vbInfo)) {
+			verticiesBoundsMin = glm::min(verticiesBoundsMin, glm::vec3(vertex.position, 0.0f));
+			verticiesBoundsMax = glm::max(verticiesBoundsMax, glm::vec3(vertex.position, 0.0f));
+		}
 		uint32_t bufferSize = verticiesCount * sizeof(std::get<1>(vbInfo)[0]);
 		
 		vk::raii::Buffer stagingBuffer = nullptr;
@@ -431,33 +616,4 @@ namespace Vulkan {
 
 		return selectedMemoryTypeIndex;
 	}
-
-	vk::raii::ShaderModule GraphicsContext::getShaderModule(std::string const& sprivPath) {
-		std::vector<char> sprivShader = fileBytes(sprivPath);
-
-		if (sprivShader.size() == 1 && sprivShader[0] == 'x') {
-			throw std::runtime_error("Failure reading spriv file at " + sprivPath);
-		}
-
-		vk::ShaderModuleCreateInfo shaderModuleInfo = {
-			.codeSize = sprivShader.size() * sizeof(char),
-			.pCode = reinterpret_cast<uint32_t*>(sprivShader.data())
-		};
-		vk::raii::ShaderModule shaderModule = context.device.createShaderModule(shaderModuleInfo);
-
-		return shaderModule;
-	}
-
-	std::vector<char> GraphicsContext::fileBytes(std::string const& path) {
-		std::ifstream fileInput(path, std::ios::ate | std::ios::binary);
-		if (!fileInput.good()) {
-			return { 'x' };
-		}
-
-		std::vector<char> bytes(fileInput.tellg());
-		fileInput.seekg(0);
-		fileInput.read(bytes.data(), bytes.size());
-
-		return bytes;
-	}
 }
\ No newline at end of file
@@ -1,11 +1,20 @@
 #include "vulkan/GraphicsEngine.h"
 #include <limits>
 #include <chrono>
+#include <iomanip>
+#include <fstream>
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include "general/VertexTransformations.h"
+#include "general/Profiler.h"
+#include "general/AllocationTracker.h"
 #include "glm/gtc/matrix_transform.hpp"
 
 namespace Vulkan {
-	GraphicsEngine::GraphicsEngine(GraphicsContext&& context, GraphicsEngineInitInfo const& initInfo) : graphicsContext(std::move(context)), frameInFlight(0), FRAMES_IN_FLIGHT_COUNT(initInfo.framesInFlightCount), windowResized(false) {
+	GraphicsEngine::GraphicsEngine(GraphicsContext&& context, GraphicsEngineInitInfo const& initInfo) : graphicsContext(std::move(context)), deletionQueue(std::make_unique<DeletionQueue>(initInfo.framesInFlightCount)), frameInFlight(0), FRAMES_IN_FLIGHT_COUNT(initInfo.framesInFlightCount), rasterState(graphicsContext.defaultRasterState), requestedPipeline(graphicsContext.graphicsPipeline), gpuProfiler(nullptr), cpuFrameTimes(GpuProfiler::WINDOW_SIZE), cpuWorkTimes(GpuProfiler::WINDOW_SIZE), cpuRecordTimes(GpuProfiler::WINDOW_SIZE), cpuSubmitTimes(GpuProfiler::WINDOW_SIZE), pipelineStatistics(nullptr), overdrawMeter(nullptr), overdrawPipeline(0), frameCapture(nullptr), occlusionCuller(nullptr), computeQueue(nullptr), textureStreamer(nullptr), depthOnlyPipeline(0), depthPrepass(false), resolutionController(DEFAULT_RESOLUTION_SETTINGS), dynamicResolution(false), renderExtent(graphicsContext.scExtent), renderGraph{}, swapchainResource(0), graphHasOverdraw(false), graphHasCapture(false), graphHasPrepass(false), graphHasOcclusion(false), hiZDepthResource(0), graphRenderExtent{}, renderGraphDump(false), commandBufferCache(nullptr), recorder{}, drawList{}, sceneMesh(0), frameViewProjection(1.0f), sceneTexture(TextureStreamer::FALLBACK_TEXTURE), slotTextureVersions(initInfo.framesInFlightCount, 0), simulationTime(0.0), camera{ .position = glm::vec3(0.0f, 2.0f, 2.0f), .target = glm::vec3(0.0f, 0.0f, 0.0f), .up = glm::vec3(0.0f, 1.0f, 0.0f), .fovY = glm::radians(45.0f) }, lastFrameTiming{}, submittedFrameCount(0), sessionRecorder(nullptr), pendingEvents{}, pendingSpawns{}, spawnHandler{}, windowResized(false) {
+		General::StartupStep step("command buffers and sync");
 		initCommandPool(initInfo.commandPoolsInfos);
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
 		initCommandBuffers(initInfo.commandBuffersInfos);
@@ -13,12 +22,23 @@ namespace Vulkan {
 		initSemaphores(initInfo.framesInFlightCount);
 		std::cout << "-------------------------------------------------------------------------------------------------------\n";
 		initFences(initInfo.framesInFlightCount);
+		std::cout << "-------------------------------------------------------------------------------------------------------\n";
+		initGpuProfiler();
+		initFrameStatistics();
+		initTextures();
+		sceneMesh = drawList.addMesh(MeshRange{ .indexCount = graphicsContext.indicesCount, .firstIndex = 0, .vertexOffset = 0, .boundsMin = graphicsContext.verticiesBoundsMin, .boundsMax = graphicsContext.verticiesBoundsMax });
 
-		glfwSetWindowUserPointer(graphicsContext.context.window, this);
-		glfwSetFramebufferSizeCallback(graphicsContext.context.window, framebufferResizeCallback);
+		if (!graphicsContext.context.isHeadless()) {
+			glfwSetWindowUserPointer(graphicsContext.context.window, this);
+			glfwSetFramebufferSizeCallback(graphicsContext.context.window, framebufferResizeCallback);
+			glfwSetKeyCallback(graphicsContext.context.window, keyCallback);
+			glfwSetMouseButtonCallback(graphicsContext.context.window, mouseButtonCallback);
+			glfwSetCursorPosCallback(graphicsContext.context.window, cursorPositionCallback);
+			glfwSetScrollCallback(graphicsContext.context.window, scrollCallback);
+		}
 	}
 
-	GraphicsEngine::GraphicsEngine(GraphicsEngine&& moveFrom) : graphicsContext(std::move(moveFrom.graphicsContext)), commandPools(std::move(moveFrom.commandPools)), commandBuffers(std::move(moveFrom.commandBuffers)), readyToRender(std::move(moveFrom.readyToRender)), renderingFinished(std::move(moveFrom.renderingFinished)), commandBufferFinished(std::move(moveFrom.commandBufferFinished)), frameInFlight(moveFrom.frameInFlight), FRAMES_IN_FLIGHT_COUNT(moveFrom.FRAMES_IN_FLIGHT_COUNT), windowResized(moveFrom.windowResized) {
+	GraphicsEngine::GraphicsEngine(GraphicsEngine&& moveFrom) : graphicsContext(std::move(moveFrom.graphicsContext)), commandPools(std::move(moveFrom.commandPools)), commandBuffers(std::move(moveFrom.commandBuffers)), readyToRender(std::move(moveFrom.readyToRender)), renderingFinished(std::move(moveFrom.renderingFinished)), commandBufferFinished(std::move(moveFrom.commandBufferFinished)), deletionQueue(std::move(moveFrom.deletionQueue)), frameInFlight(moveFrom.frameInFlight), FRAMES_IN_FLIGHT_COUNT(moveFrom.FRAMES_IN_FLIGHT_COUNT), rasterState(moveFrom.rasterState), requestedPipeline(moveFrom.requestedPipeline), gpuProfiler(std::move(moveFrom.gpuProfiler)), cpuFrameTimes(std::move(moveFrom.cpuFrameTimes)), cpuWorkTimes(std::move(moveFrom.cpuWorkTimes)), cpuRecordTimes(std::move(moveFrom.cpuRecordTimes)), cpuSubmitTimes(std::move(moveFrom.cpuSubmitTimes)), pipelineStatistics(std::move(moveFrom.pipelineStatistics)), overdrawMeter(std::move(moveFrom.overdrawMeter)), overdrawPipeline(moveFrom.overdrawPipeline), frameCapture(std::move(moveFrom.frameCapture)), occlusionCuller(std::move(moveFrom.occlusionCuller)), computeQueue(std::move(moveFrom.computeQueue)), textureStreamer(std::move(moveFrom.textureStreamer)), depthOnlyPipeline(moveFrom.depthOnlyPipeline), depthPrepass(moveFrom.depthPrepass), resolutionController(moveFrom.resolutionController), dynamicResolution(moveFrom.dynamicResolution), renderExtent(moveFrom.renderExtent), renderGraph{}, swapchainResource(0), graphHasOverdraw(false), graphHasCapture(false), graphHasPrepass(false), graphHasOcclusion(false), hiZDepthResource(0), graphRenderExtent{}, renderGraphDump(moveFrom.renderGraphDump), commandBufferCache(std::move(moveFrom.commandBufferCache)), recorder{}, drawList(std::move(moveFrom.drawList)), sceneMesh(moveFrom.sceneMesh), frameViewProjection(moveFrom.frameViewProjection), sceneTexture(moveFrom.sceneTexture), slotTextureVersions(std::move(moveFrom.slotTextureVersions)), simulationTime(moveFrom.simulationTime), camera(moveFrom.camera), lastFrameTiming(moveFrom.lastFrameTiming), submittedFrameCount(moveFrom.submittedFrameCount), sessionRecorder(std::move(moveFrom.sessionRecorder)), pendingEvents(std::move(moveFrom.pendingEvents)), pendingSpawns(std::move(moveFrom.pendingSpawns)), spawnHandler(std::move(moveFrom.spawnHandler)), windowResized(moveFrom.windowResized) {
 
 	}
 
@@ -27,24 +47,81 @@ namespace Vulkan {
 		thisEngine->windowResized = true;
 	}
 
+	void GraphicsEngine::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		GraphicsEngine* thisEngine = reinterpret_cast<GraphicsEngine*>(glfwGetWindowUserPointer(window));
+		thisEngine->queueInputEvent(General::InputEvent{ .type = General::InputEventType::eKey, .action = static_cast<uint8_t>(action), .mods = static_cast<uint16_t>(mods), .code = key, .x = 0.0f, .y = 0.0f });
+	}
+
+	void GraphicsEngine::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+		GraphicsEngine* thisEngine = reinterpret_cast<GraphicsEngine*>(glfwGetWindowUserPointer(window));
+		thisEngine->queueInputEvent(General::InputEvent{ .type = General::InputEventType::eMouseButton, .action = static_cast<uint8_t>(action), .mods = static_cast<uint16_t>(mods), .code = button, .x = 0.0f, .y = 0.0f });
+	}
+
+	void GraphicsEngine::cursorPositionCallback(GLFWwindow* window, double x, double y) {
+		GraphicsEngine* thisEngine = reinterpret_cast<GraphicsEngine*>(glfwGetWindowUserPointer(window));
+		thisEngine->queueInputEvent(General::InputEvent{ .type = General::InputEventType::eCursor, .action = 0, .mods = 0, .code = 0, .x = static_cast<float>(x), .y = static_cast<float>(y) });
+	}
+
+	void GraphicsEngine::scrollCallback(GLFWwindow* window, double x, double y) {
+		GraphicsEngine* thisEngine = reinterpret_cast<GraphicsEngine*>(glfwGetWindowUserPointer(window));
+		thisEngine->queueInputEvent(General::InputEvent{ .type = General::InputEventType::eScroll, .action = 0, .mods = 0, .code = 0, .x = static_cast<float>(x), .y = static_cast<float>(y) });
+	}
+
+	// events are only kept while recording, nothing else reads them yet
+	void GraphicsEngine::queueInputEvent(General::InputEvent const& event) {
+		if (sessionRecorder) {
+			pendingEvents.push_back(event);
+		}
+	}
+
+	// the vectors are moved into the record and back so their capacity is kept from frame to frame
+	void GraphicsEngine::recordSessionFrame(double const& deltaTime) {
+		if (!sessionRecorder) {
+			return;
+		}
+
+		General::FrameRecord frame = {
+			.deltaTime = deltaTime,
+			.camera = camera,
+			.events = std::move(pendingEvents),
+			.spawns = std::move(pendingSpawns)
+		};
+		sessionRecorder->writeFrame(frame);
+
+		pendingEvents = std::move(frame.events);
+		pendingEvents.clear();
+		pendingSpawns = std::move(frame.spawns);
+		pendingSpawns.clear();
+	}
+
 	void GraphicsEngine::windowResizedAlert() {
-		int width = 0, height = 0;
-		glfwGetFramebufferSize(graphicsContext.context.window, &width, &height);
-		while(width == 0 || height == 0) {
-			glfwWaitEvents();
+		if (!graphicsContext.context.isHeadless()) {
+			int width = 0, height = 0;
 			glfwGetFramebufferSize(graphicsContext.context.window, &width, &height);
+			while(width == 0 || height == 0) {
+				glfwWaitEvents();
+				glfwGetFramebufferSize(graphicsContext.context.window, &width, &height);
+			}
 		}
 
-		graphicsContext.context.device.waitIdle();
-		graphicsContext.recreateSwapchain();
+		graphicsContext.recreateSwapchain(*deletionQueue);
 		recreateSemaphores();
+		renderGraph.reset(*deletionQueue);
+		commandBufferCache->resize(graphicsContext.context.device, static_cast<uint32_t>(graphicsContext.scImages.size()));
+		if (overdrawMeter->isEnabled()) {
+			overdrawMeter->resize(graphicsContext, graphicsContext.scExtent, *deletionQueue);
+		}
+		if (frameCapture->isSized()) {
+			frameCapture->resize(graphicsContext, graphicsContext.scExtent, graphicsContext.scFormat.format, *deletionQueue);
+		}
 
 		windowResized = false;
 	}
 
+	// an acquire that was never submitted leaves its semaphore signalled and a present may still be waiting on the others, so all of them are retired
 	void GraphicsEngine::recreateSemaphores() {
-		readyToRender.clear();
-		renderingFinished.clear();
+		deletionQueue->retireAll(readyToRender);
+		deletionQueue->retireAll(renderingFinished);
 		initSemaphores(FRAMES_IN_FLIGHT_COUNT);
 	}
 
@@ -93,34 +170,418 @@ namespace Vulkan {
 		std::cout << "Created " << commandBufferFinished.size() << " fences\n";
 	}
 
+	void GraphicsEngine::initGpuProfiler() {
+		gpuProfiler = std::make_unique<GpuProfiler>(graphicsContext.context.device, graphicsContext.context.physicalDevice, graphicsContext.context.acquiredQueueFamilyIndices[0], FRAMES_IN_FLIGHT_COUNT, 8);
+	}
+
+	void GraphicsEngine::initFrameStatistics() {
+		pipelineStatistics = std::make_unique<PipelineStatistics>(graphicsContext.context.device, graphicsContext.context.getEnabledOptionalFeatures().pipelineStatisticsQuery == VK_TRUE, FRAMES_IN_FLIGHT_COUNT, 4);
+		overdrawMeter = std::make_unique<OverdrawMeter>(FRAMES_IN_FLIGHT_COUNT);
+		// two spare buffers so a frame can be copied while the previous ones are still being encoded
+		frameCapture = std::make_unique<FrameCapture>(FRAMES_IN_FLIGHT_COUNT + 2, 2);
+		occlusionCuller = std::make_unique<OcclusionCuller>(graphicsContext, FRAMES_IN_FLIGHT_COUNT);
+		if (graphicsContext.context.hasAsyncCompute()) {
+			computeQueue = std::make_unique<ComputeQueue>(graphicsContext.context.device, graphicsContext.context.acquiredQueueFamilyIndices[0], graphicsContext.context.getComputeQueueFamilyIndex(), FRAMES_IN_FLIGHT_COUNT);
+		}
+		commandBufferCache = std::make_unique<CommandBufferCache>(graphicsContext.context.device, graphicsContext.context.acquiredQueueFamilyIndices[0], FRAMES_IN_FLIGHT_COUNT);
+		commandBufferCache->resize(graphicsContext.context.device, static_cast<uint32_t>(graphicsContext.scImages.size()));
+	}
+
+	void GraphicsEngine::initTextures() {
+		textureStreamer = std::make_unique<TextureStreamer>(graphicsContext, FRAMES_IN_FLIGHT_COUNT, DEFAULT_TEXTURE_STREAMING_SETTINGS);
+		for (uint32_t slot = 0; slot < FRAMES_IN_FLIGHT_COUNT; slot++) {
+			writeTextureDescriptor(slot);
+		}
+	}
+
+	void GraphicsEngine::writeTextureDescriptor(uint32_t const& slot) {
+		vk::DescriptorImageInfo imageInfo = textureStreamer->getDescriptorInfo(sceneTexture);
+		vk::WriteDescriptorSet writeDescSet = {
+			.dstSet = graphicsContext.descriptorSets[slot],
+			.dstBinding = TEXTURE_BINDING,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.pImageInfo = &imageInfo
+		};
+		graphicsContext.context.device.updateDescriptorSets(writeDescSet, {});
+		slotTextureVersions[slot] = textureStreamer->getViewVersion();
+	}
+
 	void GraphicsEngine::runLoop() {
 		uint32_t nextSecondMark = 1;
 		uint32_t framesInSecond = 0;
+		std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+		// a frame advances the scene by how long the one before it took, the first one does not move it
+		double deltaTime = 0.0;
+		GH_PROFILE_THREAD("main");
 
 		while (!glfwWindowShouldClose(graphicsContext.context.window)) {
 			glfwPollEvents();
 			if (glfwGetKey(graphicsContext.context.window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
 				glfwSetWindowShouldClose(graphicsContext.context.window, true);
 			}
+			simulationTime += deltaTime;
+			recordSessionFrame(deltaTime);
 			renderAndPresentImage();
+			std::chrono::steady_clock::time_point thisFrame = std::chrono::steady_clock::now();
+			cpuFrameTimes.add(std::chrono::duration<double, std::milli>(thisFrame - lastFrame).count());
+			deltaTime = std::chrono::duration<double>(thisFrame - lastFrame).count();
+			lastFrame = thisFrame;
+			if (!General::StartupTimeline::get().isFinished()) {
+				General::StartupTimeline::get().markFirstFrame();
+			}
 
 			if (glfwGetTime() <= nextSecondMark) {
 				++framesInSecond;
 			} else {
-				std::cout << "FPS:" << framesInSecond << '\n';
+				printFrameTimings(framesInSecond);
+				printFrameStatistics();
 				++nextSecondMark;
 				framesInSecond = 0;
 			}
 		}
 
 		graphicsContext.context.device.waitIdle();
+		deletionQueue->flush();
+		stopRecording();
+		GH_ALLOCATION_PRINT_REPORT(10);
+		GH_PROFILE_EXPORT("profile.json");
+	}
+
+	// GPU numbers lag the CPU ones by the frames in flight, which does not matter over a rolling window
+	void GraphicsEngine::printFrameTimings(uint32_t const& fps) {
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "FPS:" << fps << " | CPU frame p50/p95/p99: " << cpuFrameTimes.percentile(0.50) << '/' << cpuFrameTimes.percentile(0.95) << '/' << cpuFrameTimes.percentile(0.99) << " ms";
+		std::cout << " | CPU work: " << cpuWorkTimes.percentile(0.50) << '/' << cpuWorkTimes.percentile(0.95) << '/' << cpuWorkTimes.percentile(0.99) << " ms";
+
+		General::RollingPercentiles const* gpuFrameTimes = gpuProfiler->getZoneStats("frame");
+		if (gpuFrameTimes != nullptr) {
+			std::cout << " | GPU frame: " << gpuFrameTimes->percentile(0.50) << '/' << gpuFrameTimes->percentile(0.95) << '/' << gpuFrameTimes->percentile(0.99) << " ms";
+			std::cout << " | " << (gpuFrameTimes->percentile(0.50) > cpuWorkTimes.percentile(0.50) ? "GPU" : "CPU") << " bound";
+		}
+		std::cout << std::defaultfloat << '\n';
+	}
+
+	BenchmarkReport GraphicsEngine::runBenchmark(BenchmarkSettings const& settings) {
+		simulationTime = 0.0;
+		GH_PROFILE_THREAD("main");
+
+		std::cout << "Benchmark: " << settings.warmupFrameCount << " warmup frames then " << settings.frameCount << " measured frames with a " << settings.fixedTimestep * 1000.0 << " ms timestep\n";
+
+		std::chrono::steady_clock::time_point lastFrame = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point measureStart = lastFrame;
+		for (uint32_t frame = 0; frame < settings.warmupFrameCount + settings.frameCount; frame++) {
+			if (frame == settings.warmupFrameCount) {
+				resetFrameStatistics(settings.frameCount);
+				measureStart = std::chrono::steady_clock::now();
+				lastFrame = measureStart;
+			}
+
+			if (!graphicsContext.context.isHeadless()) {
+				glfwPollEvents();
+			}
+			renderAndPresentImage();
+			std::chrono::steady_clock::time_point thisFrame = std::chrono::steady_clock::now();
+			cpuFrameTimes.add(std::chrono::duration<double, std::milli>(thisFrame - lastFrame).count());
+			simulationTime += settings.fixedTimestep > 0.0 ? settings.fixedTimestep : std::chrono::duration<double>(thisFrame - lastFrame).count();
+			lastFrame = thisFrame;
+
+			if (!General::StartupTimeline::get().isFinished()) {
+				General::StartupTimeline::get().markFirstFrame();
+			}
+		}
+		graphicsContext.context.device.waitIdle();
+		deletionQueue->flush();
+		double wallTimeMs = std::chrono::duration<double, std::milli>(lastFrame - measureStart).count();
+
+		BenchmarkReport report = getBenchmarkReport(settings, wallTimeMs);
+		printFrameTimings(static_cast<uint32_t>(wallTimeMs > 0.0 ? settings.frameCount * 1000.0 / wallTimeMs : 0.0));
+		if (!settings.reportPath.empty()) {
+			report.writeJson(settings.reportPath);
+		}
+		GH_ALLOCATION_PRINT_REPORT(10);
+		GH_PROFILE_EXPORT("profile.json");
+
+		return report;
+	}
+
+	void GraphicsEngine::runReplay(General::SessionReplay const& replay, std::string const& timingsPath) {
+		struct ReplayRow {
+			double cpuFrame;
+			FrameTiming timing;
+			double gpuFrame;
+			bool rendered;
+		};
+
+		std::vector<General::FrameRecord> const& frames = replay.getFrames();
+		vk::Extent2D extent = graphicsContext.scExtent;
+		if (extent.width != replay.getWidth() || extent.height != replay.getHeight()) {
+			std::cout << "Replaying a " << replay.getWidth() << "x" << replay.getHeight() << " session at " << extent.width << "x" << extent.height << ", timings will not match the recording\n";
+		}
+		GH_PROFILE_THREAD("main");
+
+		// sized up front so the replay itself does not allocate, the GPU numbers come back frames late and are matched up at the end
+		std::vector<ReplayRow> rows(frames.size(), ReplayRow{ .cpuFrame = 0.0, .timing = {}, .gpuFrame = -1.0, .rendered = false });
+		std::vector<uint32_t> rowOfGpuFrame{};
+		rowOfGpuFrame.reserve(frames.size());
+		std::vector<GpuFrameSample> gpuHistory{};
+		gpuHistory.reserve(frames.size() * 4);
+		gpuProfiler->setFrameHistory(&gpuHistory);
+		uint64_t firstGpuFrame = gpuProfiler->getFrameNumber();
+		resetFrameStatistics(static_cast<uint32_t>(std::max<size_t>(frames.size(), 1)));
+		simulationTime = 0.0;
+
+		std::chrono::steady_clock::time_point replayStart = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point lastFrame = replayStart;
+		uint32_t replayed = 0;
+		for (; replayed < frames.size(); replayed++) {
+			General::FrameRecord const& frame = frames[replayed];
+
+			// live input is ignored, the window can still be closed to cut the replay short
+			if (!graphicsContext.context.isHeadless()) {
+				glfwPollEvents();
+				if (glfwWindowShouldClose(graphicsContext.context.window)) {
+					break;
+				}
+			}
+
+			bool quit = false;
+			for (General::InputEvent const& event : frame.events) {
+				if (event.type == General::InputEventType::eKey && event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS) {
+					quit = true;
+				}
+			}
+			camera = frame.camera;
+			if (spawnHandler) {
+				for (General::SpawnedObject const& spawn : frame.spawns) {
+					spawnHandler(spawn);
+				}
+			}
+			simulationTime += frame.deltaTime;
+
+			uint64_t submittedBefore = submittedFrameCount;
+			renderAndPresentImage();
+			std::chrono::steady_clock::time_point thisFrame = std::chrono::steady_clock::now();
+			double frameTime = std::chrono::duration<double, std::milli>(thisFrame - lastFrame).count();
+			cpuFrameTimes.add(frameTime);
+			lastFrame = thisFrame;
+
+			rows[replayed].cpuFrame = frameTime;
+			if (submittedFrameCount != submittedBefore) {
+				rows[replayed].timing = lastFrameTiming;
+				rows[replayed].rendered = true;
+				rowOfGpuFrame.push_back(replayed);
+			}
+
+			// the live loop still presents the frame escape was pressed on
+			if (quit) {
+				++replayed;
+				break;
+			}
+		}
+		graphicsContext.context.device.waitIdle();
+		deletionQueue->flush();
+		double wallTimeMs = std::chrono::duration<double, std::milli>(lastFrame - replayStart).count();
+
+		gpuProfiler->flush();
+		gpuProfiler->setFrameHistory(nullptr);
+		for (GpuFrameSample const& sample : gpuHistory) {
+			uint64_t gpuFrame = sample.frameNumber - firstGpuFrame;
+			if (strcmp(sample.zone, "frame") == 0 && gpuFrame < rowOfGpuFrame.size()) {
+				rows[rowOfGpuFrame[gpuFrame]].gpuFrame = sample.milliseconds;
+			}
+		}
+
+		printFrameTimings(static_cast<uint32_t>(wallTimeMs > 0.0 ? replayed * 1000.0 / wallTimeMs : 0.0));
+		std::cout << "Replayed " << replayed << " of " << frames.size() << " frames in " << wallTimeMs << " ms\n";
+
+		if (!timingsPath.empty()) {
+			std::ofstream file(timingsPath, std::ios::trunc);
+			if (!file) {
+				throw std::runtime_error("Could not open " + timingsPath + " for the replay timings");
+			}
+
+			// frames skipped for a swapchain recreation, or without a GPU reading, leave their columns empty
+			file << std::fixed << std::setprecision(4);
+			file << "frame,deltaMs,cpuFrameMs,cpuWorkMs,cpuRecordMs,cpuSubmitMs,gpuFrameMs\n";
+			for (uint32_t i = 0; i < replayed; i++) {
+				file << i << ',' << frames[i].deltaTime * 1000.0 << ',' << rows[i].cpuFrame << ',';
+				if (rows[i].rendered) {
+					file << rows[i].timing.cpuWork << ',' << rows[i].timing.cpuRecord << ',' << rows[i].timing.cpuSubmit << ',';
+				} else {
+					file << ",,,";
+				}
+				if (rows[i].gpuFrame >= 0.0) {
+					file << rows[i].gpuFrame;
+				}
+				file << '\n';
+			}
+
+			std::cout << "Wrote replay timings to " << timingsPath << '\n';
+		}
+		GH_ALLOCATION_PRINT_REPORT(10);
+		GH_PROFILE_EXPORT("profile.json");
+	}
+
+	void GraphicsEngine::startRecording(std::string const& path) {
+		vk::Extent2D extent = graphicsContext.scExtent;
+		pendingEvents.clear();
+		pendingSpawns.clear();
+		sessionRecorder = std::make_unique<General::SessionRecorder>(path, extent.width, extent.height);
+
+		std::cout << "Recording session to " << path << '\n';
+	}
+
+	void GraphicsEngine::stopRecording() {
+		sessionRecorder.reset();
+	}
+
+	void GraphicsEngine::setCamera(General::CameraState const& state) {
+		camera = state;
+	}
+
+	General::CameraState const& GraphicsEngine::getCamera() const {
+		return camera;
+	}
+
+	void GraphicsEngine::spawnObject(General::SpawnedObject const& object) {
+		if (sessionRecorder) {
+			pendingSpawns.push_back(object);
+		}
+		if (spawnHandler) {
+			spawnHandler(object);
+		}
+	}
+
+	void GraphicsEngine::setSpawnHandler(std::function<void(General::SpawnedObject const&)> handler) {
+		spawnHandler = std::move(handler);
+	}
+
+	void GraphicsEngine::resetFrameStatistics(uint32_t const& windowSize) {
+		cpuFrameTimes = General::RollingPercentiles(windowSize);
+		cpuWorkTimes = General::RollingPercentiles(windowSize);
+		cpuRecordTimes = General::RollingPercentiles(windowSize);
+		cpuSubmitTimes = General::RollingPercentiles(windowSize);
+		gpuProfiler->resetStatistics(windowSize);
+		GH_ALLOCATION_RESET();
+	}
+
+	BenchmarkReport GraphicsEngine::getBenchmarkReport(BenchmarkSettings const& settings, double const& wallTimeMs) {
+		vk::PhysicalDeviceProperties properties = graphicsContext.context.physicalDevice.getProperties();
+
+		BenchmarkReport report = {
+			.deviceName = properties.deviceName.data(),
+			.driverVersion = properties.driverVersion,
+			.apiVersion = properties.apiVersion,
+			.headless = graphicsContext.context.isHeadless(),
+			.settings = settings,
+			.extent = graphicsContext.scExtent,
+			.wallTimeMs = wallTimeMs,
+			.timings = {
+				{ "cpuFrame", cpuFrameTimes },
+				{ "cpuWork", cpuWorkTimes },
+				{ "cpuRecord", cpuRecordTimes },
+				{ "cpuSubmit", cpuSubmitTimes }
+			},
+			.hasMemoryBudget = graphicsContext.context.hasEnabledDeviceExtension(vk::EXTMemoryBudgetExtensionName),
+			.heaps = {}
+		};
+
+		for (std::pair<const char*, const char*> const& zone : { std::pair{ "frame", "gpuFrame" }, std::pair{ "rendering", "gpuRendering" } }) {
+			General::RollingPercentiles const* gpuTimes = gpuProfiler->getZoneStats(zone.first);
+			if (gpuTimes != nullptr) {
+				report.timings.emplace_back(zone.second, *gpuTimes);
+			}
+		}
+
+		vk::PhysicalDeviceMemoryProperties heaps{};
+		vk::PhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+		if (report.hasMemoryBudget) {
+			vk::StructureChain<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT> memoryProperties = graphicsContext.context.physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+			heaps = memoryProperties.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+			budget = memoryProperties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		} else {
+			heaps = graphicsContext.context.physicalDevice.getMemoryProperties();
+		}
+		for (uint32_t i = 0; i < heaps.memoryHeapCount; i++) {
+			report.heaps.push_back(MemoryHeapReport{
+				.size = heaps.memoryHeaps[i].size,
+				.deviceLocal = static_cast<bool>(heaps.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal),
+				.budget = report.hasMemoryBudget ? budget.heapBudget[i] : 0,
+				.usage = report.hasMemoryBudget ? budget.heapUsage[i] : 0
+			});
+		}
+
+		return report;
+	}
+
+	void GraphicsEngine::printFrameStatistics() {
+		for (std::pair<const char*, PassStatistics> const& pass : pipelineStatistics->getLastStatistics()) {
+			std::cout << "\tPass " << pass.first << ": IA vertices " << pass.second.inputVertices << ", IA primitives " << pass.second.inputPrimitives << ", VS invocations " << pass.second.vertexInvocations << ", clipping primitives " << pass.second.clippingPrimitives << ", FS invocations " << pass.second.fragmentInvocations << '\n';
+		}
+
+		if (overdrawMeter->isEnabled()) {
+			OverdrawResult const& overdraw = overdrawMeter->getLastResult();
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "\tOverdraw: average " << overdraw.average << ", average over covered " << overdraw.coveredAverage << ", max " << overdraw.max << ", coverage " << overdraw.coverage * 100.0 << "%\n";
+			std::cout << std::defaultfloat;
+		}
+
+		std::cout << "\tCommand buffers: " << commandBufferCache->getReusedCount() << " reused, " << commandBufferCache->getRecordedCount() << " recorded into the cache, version " << commandBufferCache->getVersion() << (commandBufferCache->isEnabled() ? "" : ", cache off") << '\n';
+		RecorderStatistics const& recorded = recorder.getStatistics();
+		DrawListStatistics const& draws = drawList.getStatistics();
+		std::cout << "\tDraw list: " << draws.packets << " packets merged into " << draws.batches << " batches, " << draws.sortPasses << " radix passes\n";
+		std::cout << "\tState calls in the last recording: " << recorded.issued << " issued, " << recorded.elided << " elided, " << recorded.draws << " draws\n";
+
+		if (dynamicResolution) {
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "\tDynamic resolution: scale " << resolutionController.getScale() << ", " << renderExtent.width << "x" << renderExtent.height << " of " << graphicsContext.scExtent.width << "x" << graphicsContext.scExtent.height << ", target " << resolutionController.getSettings().targetMilliseconds << " ms\n";
+			std::cout << std::defaultfloat;
+		}
+
+		if (graphHasOcclusion) {
+			OcclusionStatistics const& occlusion = occlusionCuller->getStatistics();
+			std::cout << "\tOcclusion culling: " << occlusion.culled << " of " << occlusion.tested << " objects culled in the last frame" << (computeQueue ? ", pyramid built on the async compute queue" : "") << '\n';
+		}
+
+		TextureStatistics const& textures = textureStreamer->getStatistics();
+		std::cout << "\tTextures: " << textures.textures << " loaded, " << textures.residentBytes / 1024 << " KiB resident, " << textures.pendingLevels << " levels pending, " << textures.lastFrameBytes / 1024 << " KiB streamed in the last frame, " << textures.streamedBytes / 1024 << " KiB in total\n";
+		MipGenerationStatistics const& mips = textureStreamer->getMipStatistics();
+		if (mips.blitImages > 0 || mips.computeImages > 0) {
+			std::cout << std::fixed << std::setprecision(3);
+			std::cout << "\tMip generation: " << mips.computeImages << " images by compute in " << mips.computeMilliseconds << " ms, " << mips.blitImages << " by blit in " << mips.blitMilliseconds << " ms\n";
+			std::cout << std::defaultfloat;
+		}
+
+		if (frameCapture->isActive()) {
+			std::cout << "\tCapture: " << frameCapture->getCapturedCount() << " frames written, " << frameCapture->getDroppedCount() << " dropped\n";
+		}
+		GH_ALLOCATION_PRINT_SUMMARY();
 	}
 
 	// KIND OF HARD CODED NANA
 	void GraphicsEngine::renderAndPresentImage() {
-		while (graphicsContext.context.device.waitForFences(*commandBufferFinished[frameInFlight], true, UINT64_MAX) == vk::Result::eTimeout);
+		GH_PROFILE_FUNCTION();
+		GH_ALLOCATION_FRAME();
+
+		{
+			GH_PROFILE_ZONE("fence wait");
+			while (graphicsContext.context.device.waitForFences(*commandBufferFinished[frameInFlight], true, UINT64_MAX) == vk::Result::eTimeout);
+			// the slot's compute batch can still be running after its graphics frame, and it uses what the deletion queue is about to free
+			if (computeQueue) {
+				computeQueue->frameCompleted(graphicsContext.context.device, frameInFlight);
+			}
+		}
+		textureStreamer->frameCompleted(graphicsContext, frameInFlight, *deletionQueue);
+		deletionQueue->frameCompleted(frameInFlight);
 
-		std::pair<vk::Result, uint32_t> imageIndexPair = graphicsContext.swapchain.acquireNextImage(UINT64_MAX, readyToRender[frameInFlight], nullptr);
+		std::pair<vk::Result, uint32_t> imageIndexPair{};
+		{
+			GH_PROFILE_ZONE("acquire");
+			imageIndexPair = graphicsContext.swapchain.acquireNextImage(UINT64_MAX, readyToRender[frameInFlight], nullptr);
+		}
+		std::chrono::steady_clock::time_point workStart = std::chrono::steady_clock::now();
 		if (windowResized || (imageIndexPair.first == vk::Result::eErrorOutOfDateKHR)) {
 			windowResizedAlert();
 			return;
@@ -128,21 +589,56 @@ namespace Vulkan {
 
 		graphicsContext.context.device.resetFences(*commandBufferFinished[frameInFlight]);
 		
-		commandBuffers[frameInFlight].reset();
-		recordCommandBuffer(commandBuffers[frameInFlight], graphicsContext.swapchain.getImages()[imageIndexPair.second], graphicsContext.scImageViews[imageIndexPair.second]);
+		vk::raii::CommandBuffer const& cmdBuffer = prepareCommandBuffer(imageIndexPair.second);
+		std::chrono::steady_clock::time_point recorded = std::chrono::steady_clock::now();
+		cpuRecordTimes.add(std::chrono::duration<double, std::milli>(recorded - workStart).count());
 
-		vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-		vk::SubmitInfo submitInfo = {
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &*readyToRender[frameInFlight],
-			.pWaitDstStageMask = &waitStage,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &*commandBuffers[frameInFlight],
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = &*renderingFinished[frameInFlight]
+		// with async compute the depth the last hi-z build read is reused by this frame, and the first barrier on it chains to the compute stage
+		std::array<vk::SemaphoreSubmitInfo, 2> waits = {
+			vk::SemaphoreSubmitInfo{ .semaphore = readyToRender[frameInFlight], .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput },
+			computeQueue ? computeQueue->getGraphicsWait(vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests) : vk::SemaphoreSubmitInfo{}
+		};
+		std::array<vk::SemaphoreSubmitInfo, 2> signals = {
+			vk::SemaphoreSubmitInfo{ .semaphore = renderingFinished[frameInFlight], .stageMask = vk::PipelineStageFlagBits2::eAllCommands },
+			computeQueue ? computeQueue->signalGraphics() : vk::SemaphoreSubmitInfo{}
+		};
+		uint32_t semaphoreCount = computeQueue ? 2 : 1;
+		// the texture uploads run first in the same batch, the frame's sampling waits on them through the barriers they end with
+		bool uploading = textureStreamer->recordUploads(frameInFlight);
+		std::array<vk::CommandBufferSubmitInfo, 2> commandBufferInfos = {
+			vk::CommandBufferSubmitInfo{ .commandBuffer = uploading ? *textureStreamer->getUploadBuffer(frameInFlight) : *cmdBuffer },
+			vk::CommandBufferSubmitInfo{ .commandBuffer = cmdBuffer }
+		};
+		vk::SubmitInfo2 submitInfo = {
+			.waitSemaphoreInfoCount = semaphoreCount,
+			.pWaitSemaphoreInfos = waits.data(),
+			.commandBufferInfoCount = uploading ? 2u : 1u,
+			.pCommandBufferInfos = commandBufferInfos.data(),
+			.signalSemaphoreInfoCount = semaphoreCount,
+			.pSignalSemaphoreInfos = signals.data()
 		};
 		updateUniformBuffer(frameInFlight);
-		graphicsContext.context.queues[0][0].submit(submitInfo, *commandBufferFinished[frameInFlight]);
+		{
+			GH_PROFILE_ZONE("submit");
+			graphicsContext.context.queues[0][0].submit2(submitInfo, *commandBufferFinished[frameInFlight]);
+			if (graphHasOcclusion && computeQueue) {
+				recordAsyncHiZ(computeQueue->begin(frameInFlight));
+				computeQueue->submit(graphicsContext.context.computeQueue, frameInFlight, vk::PipelineStageFlagBits2::eComputeShader);
+			}
+		}
+		deletionQueue->frameSubmitted(frameInFlight);
+		if (graphHasOcclusion) {
+			occlusionCuller->frameSubmitted(frameInFlight, frameViewProjection);
+		}
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		lastFrameTiming = FrameTiming{
+			.cpuWork = std::chrono::duration<double, std::milli>(submitted - workStart).count(),
+			.cpuRecord = std::chrono::duration<double, std::milli>(recorded - workStart).count(),
+			.cpuSubmit = std::chrono::duration<double, std::milli>(submitted - recorded).count()
+		};
+		cpuSubmitTimes.add(lastFrameTiming.cpuSubmit);
+		cpuWorkTimes.add(lastFrameTiming.cpuWork);
+		++submittedFrameCount;
 
 		vk::PresentInfoKHR presentInfo = {
 			.waitSemaphoreCount = 1,
@@ -151,8 +647,14 @@ namespace Vulkan {
 			.pSwapchains = &*graphicsContext.swapchain,
 			.pImageIndices = &imageIndexPair.second
 		};
-		
-		if (windowResized || (graphicsContext.context.queues[0][0].presentKHR(presentInfo) == vk::Result::eErrorOutOfDateKHR)) {
+
+		vk::Result presentResult{};
+		{
+			GH_PROFILE_ZONE("present");
+			presentResult = graphicsContext.context.queues[0][0].presentKHR(presentInfo);
+		}
+
+		if (windowResized || (presentResult == vk::Result::eErrorOutOfDateKHR)) {
 			windowResizedAlert();
 			return;
 		}
@@ -160,107 +662,709 @@ namespace Vulkan {
 		frameInFlight = (frameInFlight + 1) % FRAMES_IN_FLIGHT_COUNT;
 	}
 
-	void GraphicsEngine::updateUniformBuffer(uint32_t const& index) {
-		static auto loadTime = std::chrono::high_resolution_clock::now();
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float timeSinceLoad = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - loadTime).count();
-
-		General::VertexTransformations transformation = {
-			.model = glm::rotate(glm::mat4(1.0f), timeSinceLoad * glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
-			.view = glm::lookAt(glm::vec3(0.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
-			.projection = glm::perspective(glm::radians(45.0f), static_cast<float>(graphicsContext.getSurfaceExtent().width) / static_cast<float>(graphicsContext.getSurfaceExtent().height), 0.1f, 10.0f)
+	// the graph left the depth in shader read layout and released it, the pyramid is only ever touched on this queue so it starts from undefined
+	void GraphicsEngine::recordAsyncHiZ(vk::raii::CommandBuffer const& cmdBuffer) {
+		vk::ImageSubresourceRange pyramidRange = { .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = 0, .levelCount = vk::RemainingMipLevels, .baseArrayLayer = 0, .layerCount = 1 };
+		std::array<vk::ImageMemoryBarrier2, 2> toBuild = {
+			computeQueue->acquireFromGraphics(renderGraph.getImage(hiZDepthResource), vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eDepth, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead),
+			vk::ImageMemoryBarrier2{
+				.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+				.srcAccessMask = vk::AccessFlagBits2::eNone,
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eShaderSampledRead,
+				.oldLayout = vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eGeneral,
+				.srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+				.dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+				.image = occlusionCuller->getPyramidImage(),
+				.subresourceRange = pyramidRange
+			}
 		};
-		transformation.projection[1][1] *= -1.0f;
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = static_cast<uint32_t>(toBuild.size()), .pImageMemoryBarriers = toBuild.data() });
+
+		occlusionCuller->recordBuild(cmdBuffer);
+
+		vk::ImageMemoryBarrier2 toReadback = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+			.oldLayout = vk::ImageLayout::eGeneral,
+			.newLayout = vk::ImageLayout::eTransferSrcOptimal,
+			.srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+			.image = occlusionCuller->getPyramidImage(),
+			.subresourceRange = pyramidRange
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toReadback });
+
+		occlusionCuller->recordReadback(cmdBuffer, frameInFlight);
+	}
+
+	void GraphicsEngine::updateUniformBuffer(uint32_t const& index) {
+		GH_PROFILE_FUNCTION();
+
+		General::VertexTransformations transformation = General::VertexTransformations::compute(static_cast<float>(simulationTime), camera, static_cast<float>(graphicsContext.scExtent.width) / static_cast<float>(graphicsContext.scExtent.height));
 
 		memcpy(graphicsContext.uniformBuffersAddresses[index], &transformation, sizeof(General::VertexTransformations));
 	}
 
+	// static frames resubmit what was recorded for this image and slot, overdraw and capture keep per frame state on the CPU so they record every frame
+	vk::raii::CommandBuffer const& GraphicsEngine::prepareCommandBuffer(uint32_t const& imageIndex) {
+		GH_PROFILE_FUNCTION();
+
+		// the newest GPU frame time is already a few frames old, the controller waits for its own changes to show up before reacting again
+		General::RollingPercentiles const* gpuFrameTimes = gpuProfiler->getZoneStats("frame");
+		if (dynamicResolution && gpuFrameTimes != nullptr) {
+			resolutionController.update(gpuFrameTimes->getLatest());
+		}
+		// a new scale or a resized swapchain, the pyramid follows the depth it is built from
+		vk::Extent2D extent = getRenderExtent();
+		if (extent != renderExtent) {
+			renderExtent = extent;
+			if (occlusionCuller->isSized()) {
+				occlusionCuller->resize(graphicsContext, renderExtent, *deletionQueue);
+			}
+		}
+
+		// the prepass and overdraw passes only go in once their pipelines have compiled
+		bool prepass = depthPrepass && graphicsContext.pipelineRegistry->tryGet(depthOnlyPipeline);
+		bool occlusion = occlusionCuller->isEnabled();
+		bool overdraw = overdrawMeter->isEnabled() && graphicsContext.pipelineRegistry->tryGet(overdrawPipeline);
+		bool capture = frameCapture->isActive();
+		if (!renderGraph.isCompiled() || prepass != graphHasPrepass || occlusion != graphHasOcclusion || overdraw != graphHasOverdraw || capture != graphHasCapture || renderExtent != graphRenderExtent) {
+			buildRenderGraph(prepass, occlusion, overdraw, capture);
+		}
+
+		// this slot's fence has just been waited on, so the depth its last frame read back is there to cull against
+		occlusionCuller->beginFrame(frameInFlight);
+		textureStreamer->beginFrame();
+		// a different set of batches is a different recording, a variant that finished compiling changes the pipeline in the keys
+		if (collectDraws()) {
+			commandBufferCache->invalidate();
+		}
+		// a level that landed replaced the view the slot's set points at, recordings that bound the set are redone with the new one
+		if (slotTextureVersions[frameInFlight] != textureStreamer->getViewVersion()) {
+			writeTextureDescriptor(frameInFlight);
+			commandBufferCache->invalidate();
+		}
+
+		vk::Image image = graphicsContext.scImages[imageIndex];
+		vk::ImageView imageView = graphicsContext.scImageViews[imageIndex];
+		if (!commandBufferCache->isEnabled() || graphHasOverdraw || graphHasCapture) {
+			commandBuffers[frameInFlight].reset();
+			recordCommandBuffer(commandBuffers[frameInFlight], image, imageView);
+			return commandBuffers[frameInFlight];
+		}
+
+		vk::raii::CommandBuffer const& cached = commandBufferCache->get(imageIndex, frameInFlight);
+		if (commandBufferCache->reuse(imageIndex, frameInFlight)) {
+			gpuProfiler->replayFrame(frameInFlight);
+			pipelineStatistics->replayFrame(frameInFlight);
+			return cached;
+		}
+
+		cached.reset();
+		recordCommandBuffer(cached, image, imageView);
+		commandBufferCache->markRecorded(imageIndex, frameInFlight);
+		return cached;
+	}
+
 	// KIND OF HARD CODED NANA
 	void GraphicsEngine::recordCommandBuffer(vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::ImageView const& imageView) {
+		GH_PROFILE_FUNCTION();
+
+		renderGraph.setImportedImage(swapchainResource, image, imageView);
+
 		cmdBuffer.begin({});
+		recorder.begin(cmdBuffer);
+		gpuProfiler->beginFrame(cmdBuffer, frameInFlight);
+		pipelineStatistics->beginFrame(cmdBuffer, frameInFlight);
+		overdrawMeter->beginFrame(frameInFlight);
+		frameCapture->beginFrame(frameInFlight);
+
+		{
+			GpuZone frameZone(*gpuProfiler, cmdBuffer, "frame");
+			renderGraph.execute(cmdBuffer);
+		}
 
-		transitionImageLayout(cmdBuffer, image,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::eColorAttachmentOptimal,
-			vk::PipelineStageFlagBits2::eTopOfPipe,
-			{},
-			0,
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-			vk::AccessFlagBits2::eColorAttachmentWrite,
-			0,
-			vk::ImageSubresourceRange {
-				   .aspectMask = vk::ImageAspectFlagBits::eColor,
-				   .baseMipLevel = 0,
-				   .levelCount = 1,
-				   .baseArrayLayer = 0,
-				   .layerCount = 1 }
-		);
-
-		vk::RenderingAttachmentInfo attachmentInfo = {
-			.imageView = imageView,
-			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
-			.loadOp = vk::AttachmentLoadOp::eClear,
-			.storeOp = vk::AttachmentStoreOp::eStore,
-			.clearValue = vk::ClearColorValue(0.3f, 0.3f, 0.3f, 1.0f)
-		};
-		vk::RenderingInfo renderingInfo = {
-			.renderArea = vk::Rect2D{ .offset = {0, 0}, .extent = graphicsContext.getSurfaceExtent() },
-			.layerCount = 1,
-			.colorAttachmentCount = 1,
-			.pColorAttachments = &attachmentInfo 
-		};
-		cmdBuffer.beginRendering(renderingInfo);
-		cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsContext.graphicsPipeline);
-		cmdBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(graphicsContext.getSurfaceExtent().width), static_cast<float>(graphicsContext.getSurfaceExtent().height), 0.0f, 1.0f));
-		cmdBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), graphicsContext.getSurfaceExtent()));
-		
-		cmdBuffer.bindVertexBuffers(0, *graphicsContext.verticiesBuffer, { 0 });
-		cmdBuffer.bindIndexBuffer(graphicsContext.indicesBuffer, 0, vk::IndexType::eUint32);
-		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsContext.pipelineLayout, 0, *graphicsContext.descriptorSets[frameInFlight], nullptr);
-		cmdBuffer.drawIndexed(graphicsContext.indicesCount, 1, 0, 0, 0);
-		cmdBuffer.endRendering();
-
-		transitionImageLayout(cmdBuffer, image,
-			vk::ImageLayout::eColorAttachmentOptimal,
-			vk::ImageLayout::ePresentSrcKHR,
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-			vk::AccessFlagBits2::eColorAttachmentWrite,
-			0,
-			vk::PipelineStageFlagBits2::eBottomOfPipe,
-			{},
-			0,
-			vk::ImageSubresourceRange {
-				   .aspectMask = vk::ImageAspectFlagBits::eColor,
-				   .baseMipLevel = 0,
-				   .levelCount = 1,
-				   .baseArrayLayer = 0,
-				   .layerCount = 1 }
-		);
-		
 		cmdBuffer.end();
 	}
 
-	// KIND OF HARD CODED NANA
-	void GraphicsEngine::transitionImageLayout(vk::raii::CommandBuffer const& buffer, vk::Image const& image, vk::ImageLayout const& old, vk::ImageLayout const& newX, vk::PipelineStageFlags2 const& srcStage, vk::AccessFlags2 const& srcAccess, uint32_t const& srcQfIndex, vk::PipelineStageFlags2 const& dstStage, vk::AccessFlags2 const& dstAccess, uint32_t const& dstQfIndex, vk::ImageSubresourceRange const& range) {
-		vk::ImageMemoryBarrier2 imageTransitionBarrier = {
-			.srcStageMask = srcStage,
-			.srcAccessMask = srcAccess,
-			.dstStageMask = dstStage,
-			.dstAccessMask = dstAccess,
-			.oldLayout = old,
-			.newLayout = newX,
-			.srcQueueFamilyIndex = srcQfIndex,
-			.dstQueueFamilyIndex = dstQfIndex,
-			.image = image,
-			.subresourceRange = range
+	void GraphicsEngine::buildRenderGraph(bool const& prepass, bool const& occlusion, bool const& overdraw, bool const& capture) {
+		// transients may still be in use by the frames in flight, the queue holds on to them
+		renderGraph.reset(*deletionQueue);
+		commandBufferCache->invalidate();
+		graphHasPrepass = prepass;
+		graphHasOcclusion = occlusion;
+		graphHasOverdraw = overdraw;
+		graphHasCapture = capture;
+		graphRenderExtent = renderExtent;
+
+		// the acquire semaphore is waited on at colour attachment output, the first barrier chains onto it
+		swapchainResource = renderGraph.importImage("swapchain", ImportedImageInfo{
+			.format = graphicsContext.scFormat.format,
+			.extent = graphicsContext.scExtent,
+			.aspect = vk::ImageAspectFlagBits::eColor,
+			.initialAccess = ImageAccess::eColorAttachmentWrite,
+			.preserveContents = false,
+			.finalAccess = ImageAccess::ePresent
+		});
+
+		// below full resolution the scene ends up in an offscreen target that is upscaled into the swapchain
+		// with msaa it renders into multisampled targets and resolves them into that, and into a single sampled depth for the hi-z build
+		vk::SampleCountFlagBits samples = graphicsContext.sampleCount;
+		bool multisampled = samples != vk::SampleCountFlagBits::e1;
+		uint32_t depth = renderGraph.createImage(multisampled ? "depth msaa" : "depth", TransientImageInfo{
+			.format = graphicsContext.depthFormat,
+			.extent = renderExtent,
+			.aspect = vk::ImageAspectFlagBits::eDepth,
+			.samples = samples
+		});
+		uint32_t target = swapchainResource;
+		if (renderExtent != graphicsContext.scExtent) {
+			target = renderGraph.createImage("scene colour", TransientImageInfo{
+				.format = graphicsContext.scFormat.format,
+				.extent = renderExtent,
+				.aspect = vk::ImageAspectFlagBits::eColor,
+				.samples = vk::SampleCountFlagBits::e1
+			});
+		}
+		uint32_t colour = target;
+		uint32_t sampledDepth = depth;
+		if (multisampled) {
+			colour = renderGraph.createImage("colour msaa", TransientImageInfo{
+				.format = graphicsContext.scFormat.format,
+				.extent = renderExtent,
+				.aspect = vk::ImageAspectFlagBits::eColor,
+				.samples = samples
+			});
+		}
+		if (multisampled && occlusion) {
+			sampledDepth = renderGraph.createImage("depth", TransientImageInfo{
+				.format = graphicsContext.depthFormat,
+				.extent = renderExtent,
+				.aspect = vk::ImageAspectFlagBits::eDepth,
+				.samples = vk::SampleCountFlagBits::e1
+			});
+		}
+
+		if (prepass) {
+			renderGraph.addPass("depth prepass", [this, depth](vk::raii::CommandBuffer const& cmdBuffer) {
+				// the depth only pipeline leaves its one colour slot unused, a null view matches it
+				vk::RenderingAttachmentInfo colourInfo = {
+					.imageView = nullptr,
+					.imageLayout = vk::ImageLayout::eColorAttachmentOptimal
+				};
+				vk::RenderingAttachmentInfo depthInfo = {
+					.imageView = renderGraph.getImageView(depth),
+					.imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+					.loadOp = vk::AttachmentLoadOp::eClear,
+					.storeOp = vk::AttachmentStoreOp::eStore,
+					.clearValue = vk::ClearDepthStencilValue(1.0f, 0)
+				};
+				vk::RenderingInfo renderingInfo = {
+					.renderArea = vk::Rect2D{ .offset = {0, 0}, .extent = renderExtent },
+					.layerCount = 1,
+					.colorAttachmentCount = 1,
+					.pColorAttachments = &colourInfo,
+					.pDepthAttachment = &depthInfo
+				};
+
+				GpuZone prepassZone(*gpuProfiler, cmdBuffer, "depth prepass");
+				PipelineStatisticsScope prepassStatistics(*pipelineStatistics, cmdBuffer, "depth prepass");
+				cmdBuffer.beginRendering(renderingInfo);
+				recordDrawBatches(recorder, DrawPass::eDepthPrepass, getDepthPrepassRasterState(), renderExtent);
+				cmdBuffer.endRendering();
+			}).write(depth, ImageAccess::eDepthAttachmentWrite);
+		}
+
+		// after a prepass the scene only tests against the depth it finds, depth is only stored when the hi-z build reads it
+		// multisampled targets are only needed until the resolve at the end of the pass, so their samples are never written out
+		PassBuilder scenePass = renderGraph.addPass("scene", [this, target, colour, depth, sampledDepth, prepass, occlusion](vk::raii::CommandBuffer const& cmdBuffer) {
+			bool resolveColour = colour != target;
+			bool resolveDepth = depth != sampledDepth;
+			vk::RenderingAttachmentInfo attachmentInfo = {
+				.imageView = renderGraph.getImageView(colour),
+				.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+				.resolveMode = resolveColour ? vk::ResolveModeFlagBits::eAverage : vk::ResolveModeFlagBits::eNone,
+				.resolveImageView = resolveColour ? renderGraph.getImageView(target) : vk::ImageView{},
+				.resolveImageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+				.loadOp = vk::AttachmentLoadOp::eClear,
+				.storeOp = resolveColour ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore,
+				.clearValue = vk::ClearColorValue(0.3f, 0.3f, 0.3f, 1.0f)
+			};
+			vk::RenderingAttachmentInfo depthInfo = {
+				.imageView = renderGraph.getImageView(depth),
+				.imageLayout = prepass ? vk::ImageLayout::eDepthReadOnlyOptimal : vk::ImageLayout::eDepthAttachmentOptimal,
+				.resolveMode = resolveDepth ? graphicsContext.depthResolveMode : vk::ResolveModeFlagBits::eNone,
+				.resolveImageView = resolveDepth ? renderGraph.getImageView(sampledDepth) : vk::ImageView{},
+				.resolveImageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+				.loadOp = prepass ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+				.storeOp = occlusion && !resolveDepth ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+				.clearValue = vk::ClearDepthStencilValue(1.0f, 0)
+			};
+			vk::RenderingInfo renderingInfo = {
+				.renderArea = vk::Rect2D{ .offset = {0, 0}, .extent = renderExtent },
+				.layerCount = 1,
+				.colorAttachmentCount = 1,
+				.pColorAttachments = &attachmentInfo,
+				.pDepthAttachment = &depthInfo
+			};
+
+			GpuZone renderingZone(*gpuProfiler, cmdBuffer, "rendering");
+			PipelineStatisticsScope renderingStatistics(*pipelineStatistics, cmdBuffer, "rendering");
+			cmdBuffer.beginRendering(renderingInfo);
+
+			recordDrawBatches(recorder, DrawPass::eScene, getSceneRasterState(), renderExtent);
+			cmdBuffer.endRendering();
+		});
+		scenePass.write(colour, ImageAccess::eColorAttachmentWrite);
+		if (prepass) {
+			scenePass.read(depth, ImageAccess::eDepthAttachmentRead);
+		} else {
+			scenePass.write(depth, ImageAccess::eDepthAttachmentWrite);
+		}
+		// resolves write in the colour output stage
+		if (colour != target) {
+			scenePass.write(target, ImageAccess::eColorAttachmentWrite);
+		}
+		if (sampledDepth != depth) {
+			scenePass.write(sampledDepth, ImageAccess::eDepthResolveWrite);
+		}
+
+		// linear filtering on the blit is the bilinear upscale, the swapchain is not read before it so its contents are not kept
+		if (target != swapchainResource) {
+			renderGraph.addPass("upscale", [this, target](vk::raii::CommandBuffer const& cmdBuffer) {
+				vk::ImageSubresourceLayers subresource = { .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 };
+				vk::ImageBlit2 region = {
+					.srcSubresource = subresource,
+					.srcOffsets = std::array<vk::Offset3D, 2>{ vk::Offset3D(0, 0, 0), vk::Offset3D(static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1) },
+					.dstSubresource = subresource,
+					.dstOffsets = std::array<vk::Offset3D, 2>{ vk::Offset3D(0, 0, 0), vk::Offset3D(static_cast<int32_t>(graphicsContext.scExtent.width), static_cast<int32_t>(graphicsContext.scExtent.height), 1) }
+				};
+
+				GpuZone upscaleZone(*gpuProfiler, cmdBuffer, "upscale");
+				cmdBuffer.blitImage2(vk::BlitImageInfo2{
+					.srcImage = renderGraph.getImage(target),
+					.srcImageLayout = vk::ImageLayout::eTransferSrcOptimal,
+					.dstImage = renderGraph.getImage(swapchainResource),
+					.dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
+					.regionCount = 1,
+					.pRegions = &region,
+					.filter = vk::Filter::eLinear
+				});
+			}).read(target, ImageAccess::eTransferSrc).write(swapchainResource, ImageAccess::eTransferDst);
+		}
+
+		hiZDepthResource = sampledDepth;
+		if (occlusion && computeQueue) {
+			// the build and readback are recorded into the compute queue's buffer after this frame is submitted, the graph only hands the depth over
+			renderGraph.addPass("hi-z release", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				vk::ImageMemoryBarrier2 release = computeQueue->releaseToCompute(renderGraph.getImage(hiZDepthResource), vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eDepth, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone);
+				cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &release });
+			}).read(sampledDepth, ImageAccess::eComputeSampled).sideEffects();
+		} else if (occlusion) {
+			// rewritten every frame, only the previous frame's copy out of it has to be waited on
+			uint32_t pyramid = renderGraph.importImage("hi-z pyramid", ImportedImageInfo{
+				.format = OcclusionCuller::PYRAMID_FORMAT,
+				.extent = occlusionCuller->getPyramidExtent(),
+				.aspect = vk::ImageAspectFlagBits::eColor,
+				.initialAccess = ImageAccess::eTransferSrc,
+				.preserveContents = false,
+				.finalAccess = ImageAccess::eNone
+			});
+			renderGraph.setImportedImage(pyramid, occlusionCuller->getPyramidImage(), {});
+
+			renderGraph.addPass("hi-z", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				GpuZone hiZZone(*gpuProfiler, cmdBuffer, "hi-z");
+				occlusionCuller->recordBuild(cmdBuffer);
+			}).read(sampledDepth, ImageAccess::eComputeSampled).write(pyramid, ImageAccess::eComputeStorageWrite);
+
+			renderGraph.addPass("hi-z readback", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				occlusionCuller->recordReadback(cmdBuffer, frameInFlight);
+			}).read(pyramid, ImageAccess::eTransferSrc).sideEffects();
+		}
+
+		if (overdraw) {
+			// one counter target serves every slot: it is cleared every frame and all frames submit on the same queue, so the first
+			// barrier, whose source stage is the imported transfer read, orders this frame's writes after the previous frame's copy
+			// out of it; the copies land in per slot readback buffers that are only read once the slot's fence has signalled
+			uint32_t counter = renderGraph.importImage("overdraw counter", ImportedImageInfo{
+				.format = OverdrawMeter::COUNTER_FORMAT,
+				.extent = overdrawMeter->getExtent(),
+				.aspect = vk::ImageAspectFlagBits::eColor,
+				.initialAccess = ImageAccess::eTransferSrc,
+				.preserveContents = false,
+				.finalAccess = ImageAccess::eNone
+			});
+			renderGraph.setImportedImage(counter, overdrawMeter->getCounterImage(), {});
+
+			renderGraph.addPass("overdraw", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				GpuZone overdrawZone(*gpuProfiler, cmdBuffer, "overdraw");
+				PipelineStatisticsScope overdrawStatistics(*pipelineStatistics, cmdBuffer, "overdraw");
+				overdrawMeter->beginPass(cmdBuffer);
+				recordDrawBatches(recorder, DrawPass::eOverdraw, getOverdrawRasterState(), graphicsContext.scExtent);
+				overdrawMeter->endPass(cmdBuffer);
+			}).write(counter, ImageAccess::eColorAttachmentWrite);
+
+			renderGraph.addPass("overdraw readback", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				overdrawMeter->recordReadback(cmdBuffer, frameInFlight);
+			}).read(counter, ImageAccess::eTransferSrc).sideEffects();
+		}
+
+		// the image is moved to transfer source for every frame while capturing, recordCopy still decides whether this one is copied
+		if (capture) {
+			renderGraph.addPass("capture", [this](vk::raii::CommandBuffer const& cmdBuffer) {
+				frameCapture->recordCopy(cmdBuffer, renderGraph.getImage(swapchainResource), frameInFlight);
+			}).read(swapchainResource, ImageAccess::eTransferSrc).sideEffects();
+		}
+
+		renderGraph.compile(graphicsContext);
+		if (occlusion) {
+			occlusionCuller->bindDepth(graphicsContext, renderGraph.getImageView(sampledDepth), *deletionQueue);
+		}
+		if (renderGraphDump) {
+			renderGraph.dump(std::cout);
+		}
+	}
+
+	// every system that draws submits here, returns whether the sorted batches changed since the last frame
+	bool GraphicsEngine::collectDraws() {
+		GH_PROFILE_FUNCTION();
+
+		drawList.clear();
+		occlusionCuller->beginCulling();
+
+		// the same matrices updateUniformBuffer writes for this frame
+		General::VertexTransformations transformation = General::VertexTransformations::compute(static_cast<float>(simulationTime), camera, static_cast<float>(graphicsContext.scExtent.width) / static_cast<float>(graphicsContext.scExtent.height));
+		frameViewProjection = transformation.projection * transformation.view;
+
+		// the world space box around the object space one as the model matrix turns it
+		MeshRange const& mesh = drawList.getMesh(sceneMesh);
+		glm::vec3 worldMin(std::numeric_limits<float>::max());
+		glm::vec3 worldMax(std::numeric_limits<float>::lowest());
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			glm::vec3 position = { (corner & 1) ? mesh.boundsMax.x : mesh.boundsMin.x, (corner & 2) ? mesh.boundsMax.y : mesh.boundsMin.y, (corner & 4) ? mesh.boundsMax.z : mesh.boundsMin.z };
+			glm::vec3 world = glm::vec3(transformation.model * glm::vec4(position, 1.0f));
+			worldMin = glm::min(worldMin, world);
+			worldMax = glm::max(worldMax, world);
+		}
+		if (occlusionCuller->isOccluded(worldMin, worldMax)) {
+			return drawList.build();
+		}
+		textureStreamer->requestCoverage(sceneTexture, getScreenCoverage(worldMin, worldMax));
+
+		// the scene mesh sits at the origin, its depth is the camera's distance to it over the far plane
+		float sceneDepth = glm::length(camera.position) / General::VertexTransformations::FAR_PLANE;
+
+		// still compiling in the background, the frame only gets the clear colour until it is ready
+		if (getDrawPipeline()) {
+			drawList.submit(DrawPacket{ .key = SortKey::make(DrawPass::eScene, graphicsContext.graphicsPipeline, 0, sceneMesh, sceneDepth), .firstInstance = 0, .instanceCount = 1 });
+		}
+		if (graphHasPrepass) {
+			drawList.submit(DrawPacket{ .key = SortKey::make(DrawPass::eDepthPrepass, depthOnlyPipeline, 0, sceneMesh, sceneDepth), .firstInstance = 0, .instanceCount = 1 });
+		}
+		if (graphHasOverdraw) {
+			drawList.submit(DrawPacket{ .key = SortKey::make(DrawPass::eOverdraw, overdrawPipeline, 0, sceneMesh, sceneDepth), .firstInstance = 0, .instanceCount = 1 });
+		}
+
+		return drawList.build();
+	}
+
+	float GraphicsEngine::getScreenCoverage(glm::vec3 const& worldMin, glm::vec3 const& worldMax) const {
+		float screenPixels = static_cast<float>(renderExtent.width) * static_cast<float>(renderExtent.height);
+		glm::vec2 ndcMin(std::numeric_limits<float>::max());
+		glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			glm::vec3 position = { (corner & 1) ? worldMax.x : worldMin.x, (corner & 2) ? worldMax.y : worldMin.y, (corner & 4) ? worldMax.z : worldMin.z };
+			glm::vec4 clip = frameViewProjection * glm::vec4(position, 1.0f);
+			if (clip.w <= 0.0f) {
+				return screenPixels;
+			}
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+
+		glm::vec2 size = glm::max(glm::clamp(ndcMax, -1.0f, 1.0f) - glm::clamp(ndcMin, -1.0f, 1.0f), 0.0f) * 0.5f;
+		return size.x * size.y * screenPixels;
+	}
+
+	void GraphicsEngine::recordDrawBatches(CommandRecorder& recorder, DrawPass const& pass, DynamicRasterState const& state, vk::Extent2D const& extent) {
+		for (DrawBatch const& batch : drawList.getBatches(pass)) {
+			recordBatch(recorder, graphicsContext.pipelineRegistry->tryGet(SortKey::getPipeline(batch.key)), state, batch, extent);
+		}
+	}
+
+	// the recorder drops the binds a batch shares with the one before it, which the sort makes the common case
+	// material 0 is the only one so far, the transforms of the frame slot
+	void GraphicsEngine::recordBatch(CommandRecorder& recorder, vk::Pipeline const& pipeline, DynamicRasterState const& state, DrawBatch const& batch, vk::Extent2D const& extent) {
+		recorder.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+		recorder.setViewport(vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
+		recorder.setScissor(vk::Rect2D(vk::Offset2D(0, 0), extent));
+		applyDynamicState(recorder, state);
+
+		recorder.bindVertexBuffers(0, *graphicsContext.verticiesBuffer, { 0 });
+		recorder.bindIndexBuffer(graphicsContext.indicesBuffer, 0, vk::IndexType::eUint32);
+		recorder.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsContext.pipelineLayout, 0, *graphicsContext.descriptorSets[frameInFlight], nullptr);
+
+		MeshRange const& mesh = drawList.getMesh(SortKey::getMesh(batch.key));
+		recorder.drawIndexed(mesh.indexCount, batch.instanceCount, mesh.firstIndex, mesh.vertexOffset, batch.firstInstance);
+	}
+
+	// the scene's own state with blending forced to additive, dynamic blend state would otherwise override the overdraw pipeline
+	DynamicRasterState GraphicsEngine::getOverdrawRasterState() const {
+		DynamicRasterState state = rasterState;
+		state.logicOpEnable = false;
+		state.blendEnable = true;
+		state.blendEquation = vk::ColorBlendEquationEXT{
+			.srcColorBlendFactor = vk::BlendFactor::eOne,
+			.dstColorBlendFactor = vk::BlendFactor::eOne,
+			.colorBlendOp = vk::BlendOp::eAdd,
+			.srcAlphaBlendFactor = vk::BlendFactor::eOne,
+			.dstAlphaBlendFactor = vk::BlendFactor::eOne,
+			.alphaBlendOp = vk::BlendOp::eAdd
 		};
+		state.colourWriteMask = vk::ColorComponentFlagBits::eR;
+		// the counter target has no depth attachment, every fragment counts
+		state.depthTest = false;
+		state.depthWrite = false;
+
+		return state;
+	}
+
+	DynamicRasterState GraphicsEngine::getDepthPrepassRasterState() const {
+		DynamicRasterState state = rasterState;
+		state.depthTest = true;
+		state.depthWrite = true;
+		state.depthCompareOp = vk::CompareOp::eLess;
+
+		return state;
+	}
+
+	// the prepass already wrote the nearest depth, the scene's own fragments at that depth pass and everything behind is rejected before shading
+	DynamicRasterState GraphicsEngine::getSceneRasterState() const {
+		if (!graphHasPrepass) {
+			return rasterState;
+		}
+
+		DynamicRasterState state = rasterState;
+		state.depthTest = true;
+		state.depthWrite = false;
+		state.depthCompareOp = vk::CompareOp::eLessOrEqual;
+
+		return state;
+	}
+
+	// the recorder drops whatever the previous draw already set
+	void GraphicsEngine::applyDynamicState(CommandRecorder& recorder, DynamicRasterState const& state) {
+		for (vk::DynamicState const& dynamicState : graphicsContext.dynamicStates) {
+			switch (dynamicState) {
+			case vk::DynamicState::ePrimitiveTopology:
+				recorder.setPrimitiveTopology(state.topology);
+				break;
+			case vk::DynamicState::ePrimitiveRestartEnable:
+				recorder.setPrimitiveRestartEnable(state.primitiveRestart);
+				break;
+			case vk::DynamicState::eRasterizerDiscardEnable:
+				recorder.setRasterizerDiscardEnable(state.rasterizerDiscard);
+				break;
+			case vk::DynamicState::eCullMode:
+				recorder.setCullMode(state.cullMode);
+				break;
+			case vk::DynamicState::eFrontFace:
+				recorder.setFrontFace(state.frontFace);
+				break;
+			case vk::DynamicState::eDepthBiasEnable:
+				recorder.setDepthBiasEnable(state.depthBias);
+				break;
+			case vk::DynamicState::eDepthBias:
+				recorder.setDepthBias(state.depthBiasConstantFactor, state.depthBiasClamp, state.depthBiasSlopeFactor);
+				break;
+			case vk::DynamicState::eLineWidth:
+				recorder.setLineWidth(state.lineWidth);
+				break;
+			case vk::DynamicState::eDepthTestEnable:
+				recorder.setDepthTestEnable(state.depthTest);
+				break;
+			case vk::DynamicState::eDepthWriteEnable:
+				recorder.setDepthWriteEnable(state.depthWrite);
+				break;
+			case vk::DynamicState::eDepthCompareOp:
+				recorder.setDepthCompareOp(state.depthCompareOp);
+				break;
+			case vk::DynamicState::eDepthBoundsTestEnable:
+				recorder.setDepthBoundsTestEnable(state.depthBoundsTest);
+				break;
+			case vk::DynamicState::eStencilTestEnable:
+				recorder.setStencilTestEnable(state.stencilTest);
+				break;
+			case vk::DynamicState::ePolygonModeEXT:
+				recorder.setPolygonMode(state.polygonMode);
+				break;
+			case vk::DynamicState::eDepthClampEnableEXT:
+				recorder.setDepthClampEnable(state.depthClamp);
+				break;
+			case vk::DynamicState::eLogicOpEnableEXT:
+				recorder.setLogicOpEnable(state.logicOpEnable);
+				break;
+			case vk::DynamicState::eColorBlendEnableEXT:
+				recorder.setColourBlendEnable(state.blendEnable);
+				break;
+			case vk::DynamicState::eColorBlendEquationEXT:
+				recorder.setColourBlendEquation(state.blendEquation);
+				break;
+			case vk::DynamicState::eColorWriteMaskEXT:
+				recorder.setColourWriteMask(state.colourWriteMask);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void GraphicsEngine::setRasterState(DynamicRasterState const& state) {
+		rasterState = state;
+		commandBufferCache->invalidate();
+	}
+
+	DynamicRasterState const& GraphicsEngine::getRasterState() const {
+		return rasterState;
+	}
+
+	void GraphicsEngine::setShaderVariant(ShaderVariantKey const& variant) {
+		requestedPipeline = graphicsContext.requestPipelineVariant(variant);
+	}
+
+	void GraphicsEngine::setPipelineStatisticsEnabled(bool const& enable) {
+		pipelineStatistics->setEnabled(enable);
+		commandBufferCache->invalidate();
+	}
+
+	std::vector<std::pair<const char*, PassStatistics>> const& GraphicsEngine::getPipelineStatistics() const {
+		return pipelineStatistics->getLastStatistics();
+	}
+
+	void GraphicsEngine::setOverdrawEnabled(bool const& enable) {
+		if (enable && !overdrawMeter->isEnabled()) {
+			overdrawMeter->resize(graphicsContext, graphicsContext.scExtent, *deletionQueue);
+			// the graph may still hold the previous counter target if overdraw was switched off and on between two frames
+			renderGraph.reset(*deletionQueue);
+			overdrawPipeline = graphicsContext.requestOverdrawPipeline(OverdrawMeter::COUNTER_FORMAT);
+		}
+
+		overdrawMeter->setEnabled(enable);
+	}
+
+	OverdrawResult const& GraphicsEngine::getOverdraw() const {
+		return overdrawMeter->getLastResult();
+	}
+
+	void GraphicsEngine::setDepthPrepassEnabled(bool const& enable) {
+		if (enable && !depthPrepass) {
+			depthOnlyPipeline = graphicsContext.requestDepthOnlyPipeline();
+		}
+
+		depthPrepass = enable;
+	}
+
+	void GraphicsEngine::setOcclusionCullingEnabled(bool const& enable) {
+		if (enable && occlusionCuller->isAvailable() && !occlusionCuller->isSized()) {
+			occlusionCuller->resize(graphicsContext, renderExtent, *deletionQueue);
+		}
+
+		occlusionCuller->setEnabled(enable);
+	}
+
+	OcclusionStatistics const& GraphicsEngine::getOcclusionStatistics() const {
+		return occlusionCuller->getStatistics();
+	}
+
+	void GraphicsEngine::loadSceneTexture(std::string const& path) {
+		sceneTexture = textureStreamer->load(graphicsContext, path);
+		// every slot writes its set again once its fence has been waited on
+		std::fill(slotTextureVersions.begin(), slotTextureVersions.end(), std::numeric_limits<uint64_t>::max());
+	}
+
+	TextureStatistics const& GraphicsEngine::getTextureStatistics() const {
+		return textureStreamer->getStatistics();
+	}
+
+	void GraphicsEngine::setMipGenerationPath(MipPath const& path) {
+		textureStreamer->setMipPath(path);
+	}
+
+	void GraphicsEngine::setDynamicResolution(General::ResolutionControllerSettings const& settings) {
+		resolutionController.reset(settings);
+	}
+
+	void GraphicsEngine::setDynamicResolutionEnabled(bool const& enable) {
+		if (enable && !dynamicResolution) {
+			resolutionController.reset(resolutionController.getSettings());
+		}
 
-		vk::DependencyInfo dependencyInfo = {
-			.dependencyFlags = {},
-			.imageMemoryBarrierCount = 1,
-			.pImageMemoryBarriers = &imageTransitionBarrier 
+		dynamicResolution = enable;
+	}
+
+	float GraphicsEngine::getResolutionScale() const {
+		return dynamicResolution ? resolutionController.getScale() : 1.0f;
+	}
+
+	// never below a pixel, the graph is rebuilt whenever this changes
+	vk::Extent2D GraphicsEngine::getRenderExtent() const {
+		float scale = getResolutionScale();
+		return vk::Extent2D{
+			std::max(1u, static_cast<uint32_t>(std::lround(graphicsContext.scExtent.width * scale))),
+			std::max(1u, static_cast<uint32_t>(std::lround(graphicsContext.scExtent.height * scale)))
 		};
+	}
+
+	void GraphicsEngine::setCapture(CaptureSettings const& settings) {
+		if (settings.mode != CaptureMode::eOff && !frameCapture->isSized()) {
+			frameCapture->resize(graphicsContext, graphicsContext.scExtent, graphicsContext.scFormat.format, *deletionQueue);
+		}
+
+		frameCapture->setSettings(settings);
+	}
+
+	void GraphicsEngine::captureNextFrame() {
+		CaptureSettings settings = frameCapture->getSettings();
+		settings.mode = CaptureMode::eOneShot;
+		setCapture(settings);
+	}
+
+	FrameCapture const& GraphicsEngine::getFrameCapture() const {
+		return *frameCapture;
+	}
+
+	void GraphicsEngine::setRenderGraphDumpEnabled(bool const& enable) {
+		renderGraphDump = enable;
+	}
+
+	void GraphicsEngine::setCommandBufferCacheEnabled(bool const& enable) {
+		commandBufferCache->setEnabled(enable);
+	}
+
+	void GraphicsEngine::setRedundantStateFiltering(bool const& enable) {
+		recorder.setFiltering(enable);
+		commandBufferCache->invalidate();
+	}
+
+	vk::Pipeline GraphicsEngine::getDrawPipeline() {
+		PipelineRegistry& registry = *graphicsContext.pipelineRegistry;
+
+		if (requestedPipeline != graphicsContext.graphicsPipeline) {
+			vk::Pipeline requested = registry.tryGet(requestedPipeline);
+
+			if (requested) {
+				graphicsContext.graphicsPipeline = requestedPipeline;
+				return requested;
+			} else if (registry.getState(requestedPipeline) == PipelineState::eFailed) {
+				requestedPipeline = graphicsContext.graphicsPipeline;
+			}
+		}
 
-		buffer.pipelineBarrier2(dependencyInfo);
+		return registry.tryGet(graphicsContext.graphicsPipeline);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "vulkan/Ktx2File.h"
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+namespace Vulkan {
+	// the fixed part of the header up to the level index, all fields little endian
+	struct Ktx2Header {
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "the level index starts at byte 80");
+
+	struct Ktx2LevelIndex {
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	bool Ktx2File::getTexelBlock(vk::Format const& format, TexelBlock& block) {
+		switch (format) {
+		case vk::Format::eBc1RgbUnormBlock:
+		case vk::Format::eBc1RgbSrgbBlock:
+		case vk::Format::eBc1RgbaUnormBlock:
+		case vk::Format::eBc1RgbaSrgbBlock:
+		case vk::Format::eBc4UnormBlock:
+		case vk::Format::eBc4SnormBlock:
+			block = TexelBlock{ .width = 4, .height = 4, .bytes = 8 };
+			return true;
+		case vk::Format::eBc3UnormBlock:
+		case vk::Format::eBc3SrgbBlock:
+		case vk::Format::eBc5UnormBlock:
+		case vk::Format::eBc5SnormBlock:
+		case vk::Format::eBc7UnormBlock:
+		case vk::Format::eBc7SrgbBlock:
+			block = TexelBlock{ .width = 4, .height = 4, .bytes = 16 };
+			return true;
+		case vk::Format::eR8Unorm:
+			block = TexelBlock{ .width = 1, .height = 1, .bytes = 1 };
+			return true;
+		case vk::Format::eR8G8Unorm:
+			block = TexelBlock{ .width = 1, .height = 1, .bytes = 2 };
+			return true;
+		case vk::Format::eR8G8B8A8Unorm:
+		case vk::Format::eR8G8B8A8Srgb:
+			block = TexelBlock{ .width = 1, .height = 1, .bytes = 4 };
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool Ktx2File::isBlockCompressed(vk::Format const& format) {
+		TexelBlock block{};
+		return getTexelBlock(format, block) && block.width > 1;
+	}
+
+	// partial blocks at the right and bottom edges are stored whole
+	uint64_t Ktx2File::getLevelSize(vk::Format const& format, vk::Extent2D const& levelExtent) {
+		TexelBlock block{};
+		if (!getTexelBlock(format, block)) {
+			return 0;
+		}
+
+		uint64_t blocksWide = (levelExtent.width + block.width - 1) / block.width;
+		uint64_t blocksHigh = (levelExtent.height + block.height - 1) / block.height;
+		return blocksWide * blocksHigh * block.bytes;
+	}
+
+	Ktx2File::Ktx2File(std::string const& path, uint32_t const& maxDimension) : file(path), format{ vk::Format::eUndefined }, extent{}, levels{} {
+		uint8_t const* data = static_cast<uint8_t const*>(file.getData());
+		size_t size = file.getSize();
+
+		Ktx2Header header{};
+		if (size < sizeof(header)) {
+			throw std::runtime_error(path + " is too small to be a KTX2 file");
+		}
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0) {
+			throw std::runtime_error(path + " is not a KTX2 file");
+		}
+		if (header.supercompressionScheme != 0) {
+			throw std::runtime_error(path + " is supercompressed, only plain KTX2 data is supported");
+		}
+		if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+			throw std::runtime_error(path + " is not a single 2D image");
+		}
+
+		format = static_cast<vk::Format>(header.vkFormat);
+		TexelBlock block{};
+		if (!getTexelBlock(format, block)) {
+			throw std::runtime_error(path + " has unsupported format " + vk::to_string(format));
+		}
+		if (header.pixelWidth > maxDimension || header.pixelHeight > maxDimension) {
+			throw std::runtime_error(path + " is " + std::to_string(header.pixelWidth) + "x" + std::to_string(header.pixelHeight) + ", larger than the device's " + std::to_string(maxDimension));
+		}
+		extent = vk::Extent2D{ header.pixelWidth, header.pixelHeight };
+
+		// 0 asks the loader to generate the levels, the file then only holds the base image
+		uint32_t levelCount = std::max(header.levelCount, 1u);
+		if (levelCount > static_cast<uint32_t>(std::bit_width(std::max(header.pixelWidth, header.pixelHeight)))) {
+			throw std::runtime_error(path + " has " + std::to_string(levelCount) + " levels, more than a full chain for its size");
+		}
+		if (size < sizeof(header) + levelCount * sizeof(Ktx2LevelIndex)) {
+			throw std::runtime_error(path + " is truncated in its level index");
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++) {
+			Ktx2LevelIndex index{};
+			memcpy(&index, data + sizeof(header) + level * sizeof(Ktx2LevelIndex), sizeof(index));
+
+			vk::Extent2D levelExtent = getLevelExtent(level);
+			if (index.byteLength != getLevelSize(format, levelExtent) || index.byteOffset > size || index.byteLength > size - index.byteOffset) {
+				throw std::runtime_error(path + " has a level " + std::to_string(level) + " that does not fit its size or the file");
+			}
+			levels.push_back(Level{ .offset = index.byteOffset, .length = index.byteLength });
+		}
+	}
+
+	vk::Format Ktx2File::getFormat() const {
+		return format;
+	}
+
+	vk::Extent2D Ktx2File::getExtent() const {
+		return extent;
+	}
+
+	vk::Extent2D Ktx2File::getLevelExtent(uint32_t const& level) const {
+		return vk::Extent2D{ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+	}
+
+	uint32_t Ktx2File::getLevelCount() const {
+		return static_cast<uint32_t>(levels.size());
+	}
+
+	std::span<const uint8_t> Ktx2File::getLevelData(uint32_t const& level) const {
+		Level const& range = levels[level];
+		return std::span<const uint8_t>(static_cast<uint8_t const*>(file.getData()) + range.offset, range.length);
+	}
+}
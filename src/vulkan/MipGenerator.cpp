@@ -0,0 +1,322 @@
+#include "vulkan/MipGenerator.h"
+#include "vulkan/GraphicsContext.h"
+#include "vulkan/Ktx2File.h"
+#include <array>
+#include <bit>
+#include <limits>
+#include <algorithm>
+#include <string>
+
+namespace Vulkan {
+	static vk::ImageMemoryBarrier2 mipBarrier(vk::Image const& image, uint32_t const& baseLevel, uint32_t const& levelCount, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout, vk::PipelineStageFlags2 const& srcStages, vk::AccessFlags2 const& srcAccess, vk::PipelineStageFlags2 const& dstStages, vk::AccessFlags2 const& dstAccess) {
+		return vk::ImageMemoryBarrier2{
+			.srcStageMask = srcStages,
+			.srcAccessMask = srcAccess,
+			.dstStageMask = dstStages,
+			.dstAccessMask = dstAccess,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = baseLevel, .levelCount = levelCount, .baseArrayLayer = 0, .layerCount = 1 }
+		};
+	}
+
+	MipGenerator::MipGenerator(GraphicsContext& context) : sampler{ nullptr }, setLayout{ nullptr }, pipelineLayout{ nullptr }, pipeline{ nullptr }, counterBuffer{ nullptr }, counterMemory{ nullptr }, tileBuffer{ nullptr }, tileMemory{ nullptr }, queryPool{ nullptr }, pending{}, pendingViews{}, pendingPools{}, pendingSets{}, queryResults{}, statistics{}, preferredPath{ MipPath::eAuto }, timestampPeriod{ context.context.physicalDevice.getProperties().limits.timestampPeriod }, timestampMask{ 0 }, computeAvailable{ false } {
+		// level 0 is only ever read with a bilinear tap between four texels
+		sampler = vk::raii::Sampler(context.context.device, vk::SamplerCreateInfo{
+			.magFilter = vk::Filter::eLinear,
+			.minFilter = vk::Filter::eLinear,
+			.mipmapMode = vk::SamplerMipmapMode::eNearest,
+			.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+			.addressModeV = vk::SamplerAddressMode::eClampToEdge,
+			.addressModeW = vk::SamplerAddressMode::eClampToEdge
+		});
+
+		std::array<vk::DescriptorSetLayoutBinding, 4> bindings = {
+			vk::DescriptorSetLayoutBinding{ .binding = 0, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			vk::DescriptorSetLayoutBinding{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = MAX_COMPUTE_LEVELS, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			vk::DescriptorSetLayoutBinding{ .binding = 2, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			vk::DescriptorSetLayoutBinding{ .binding = 3, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute }
+		};
+		setLayout = vk::raii::DescriptorSetLayout(context.context.device, vk::DescriptorSetLayoutCreateInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() });
+
+		vk::PushConstantRange pushConstantRange = { .stageFlags = vk::ShaderStageFlagBits::eCompute, .offset = 0, .size = sizeof(DownsampleConstants) };
+		pipelineLayout = vk::raii::PipelineLayout(context.context.device, vk::PipelineLayoutCreateInfo{ .setLayoutCount = 1, .pSetLayouts = &*setLayout, .pushConstantRangeCount = 1, .pPushConstantRanges = &pushConstantRange });
+
+		uint32_t validBits = context.context.physicalDevice.getQueueFamilyProperties()[context.context.acquiredQueueFamilyIndices[0]].timestampValidBits;
+		if (validBits > 0) {
+			timestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : ((uint64_t{ 1 } << validBits) - 1);
+			queryPool = vk::raii::QueryPool(context.context.device, vk::QueryPoolCreateInfo{ .queryType = vk::QueryType::eTimestamp, .queryCount = MAX_PENDING * 2 });
+			queryResults.resize(MAX_PENDING * 2);
+		}
+
+		// the levels are written through views without a format in the shader, picked from the array by the level being written, and 2x2 texels are reduced across quads
+		vk::StructureChain<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties> properties = context.context.physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+		vk::PhysicalDeviceSubgroupProperties const& subgroup = properties.get<vk::PhysicalDeviceSubgroupProperties>();
+		bool quadsInCompute = (subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute) && (subgroup.supportedOperations & vk::SubgroupFeatureFlagBits::eQuad);
+		vk::PhysicalDeviceFeatures const& features = context.context.getEnabledOptionalFeatures();
+		bool storageFeatures = features.shaderStorageImageWriteWithoutFormat == VK_TRUE && features.shaderStorageImageArrayDynamicIndexing == VK_TRUE;
+		if (!quadsInCompute || !storageFeatures) {
+			std::cout << "Compute mip generation unavailable, " << (quadsInCompute ? "storage image writes without a format or indexing into storage image arrays are not enabled" : "subgroup quad operations are not supported in compute") << '\n';
+			return;
+		}
+
+		try {
+			pipeline = context.createComputePipeline("shaders/downsample.spv", "downsample", *pipelineLayout);
+		} catch (std::exception const& e) {
+			std::cout << "Compute mip generation unavailable, the downsample pipeline could not be created: " << e.what() << '\n';
+			return;
+		}
+
+		context.createBufferAndMemory(counterBuffer, counterMemory, vk::MemoryPropertyFlagBits::eDeviceLocal, sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive);
+		// a float4 for each of the 64x64 tiles a 4096 texel level 0 has, filled from the transfer side only by the benchmarks
+		context.createBufferAndMemory(tileBuffer, tileMemory, vk::MemoryPropertyFlagBits::eDeviceLocal, 64 * 64 * 4 * sizeof(float), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive);
+		computeAvailable = true;
+
+		std::cout << "Created single pass downsample pipeline {SUBGROUP SIZE: " << subgroup.subgroupSize << "}\n";
+	}
+
+	uint32_t MipGenerator::getFullLevelCount(vk::Extent2D const& extent) {
+		return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+	}
+
+	vk::Format MipGenerator::getStorageFormat(vk::Format const& format) {
+		switch (format) {
+		case vk::Format::eR8Srgb:
+			return vk::Format::eR8Unorm;
+		case vk::Format::eR8G8Srgb:
+			return vk::Format::eR8G8Unorm;
+		case vk::Format::eR8G8B8A8Srgb:
+			return vk::Format::eR8G8B8A8Unorm;
+		case vk::Format::eB8G8R8A8Srgb:
+			return vk::Format::eB8G8R8A8Unorm;
+		default:
+			return format;
+		}
+	}
+
+	// storage only where the format the levels are written through supports it, an sRGB image then has to allow that view
+	vk::ImageUsageFlags MipGenerator::getImageUsage(GraphicsContext& context, vk::Format const& format) const {
+		vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+		if (computeAvailable && (context.context.physicalDevice.getFormatProperties(getStorageFormat(format)).optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage)) {
+			usage |= vk::ImageUsageFlagBits::eStorage;
+		}
+		return usage;
+	}
+
+	vk::ImageCreateFlags MipGenerator::getImageFlags(GraphicsContext& context, vk::Format const& format) const {
+		if (getStorageFormat(format) == format || !(getImageUsage(context, format) & vk::ImageUsageFlagBits::eStorage)) {
+			return {};
+		}
+		return vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage;
+	}
+
+	bool MipGenerator::canCompute(GraphicsContext& context, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount) const {
+		if (!computeAvailable || levelCount - 1 > MAX_COMPUTE_LEVELS || extent.width > 4096 || extent.height > 4096) {
+			return false;
+		}
+
+		vk::FormatFeatureFlags sampled = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		return (context.context.physicalDevice.getFormatProperties(format).optimalTilingFeatures & sampled) == sampled && (getImageUsage(context, format) & vk::ImageUsageFlagBits::eStorage);
+	}
+
+	bool MipGenerator::canBlit(GraphicsContext& context, vk::Format const& format) const {
+		vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+		return !Ktx2File::isBlockCompressed(format) && (context.context.physicalDevice.getFormatProperties(format).optimalTilingFeatures & required) == required;
+	}
+
+	bool MipGenerator::canGenerate(GraphicsContext& context, vk::Format const& format) const {
+		return canBlit(context, format) || canCompute(context, format, vk::Extent2D{ 1, 1 }, 1);
+	}
+
+	MipPath MipGenerator::record(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount) {
+		if (pending.size() >= MAX_PENDING) {
+			throw std::runtime_error("Mip generation recorded more than " + std::to_string(MAX_PENDING) + " images without a collect");
+		}
+
+		bool compute = canCompute(context, format, extent, levelCount);
+		bool blit = canBlit(context, format);
+		MipPath path = (compute && (preferredPath != MipPath::eBlit || !blit)) ? MipPath::eCompute : MipPath::eBlit;
+
+		uint32_t firstQuery = static_cast<uint32_t>(pending.size()) * 2;
+		if (*queryPool) {
+			cmdBuffer.resetQueryPool(queryPool, firstQuery, 2);
+			cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, queryPool, firstQuery);
+		}
+		if (path == MipPath::eCompute) {
+			recordDownsample(context, cmdBuffer, image, format, extent, levelCount);
+		} else {
+			recordBlitChain(context, cmdBuffer, image, format, extent, levelCount);
+		}
+		if (*queryPool) {
+			cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, queryPool, firstQuery + 1);
+		}
+
+		pending.push_back(Pending{ .path = path, .firstQuery = firstQuery });
+		return path;
+	}
+
+	// each level is blitted from the whole of the one above, so odd sizes are scaled rather than cropped
+	void MipGenerator::recordBlitChain(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount) {
+		bool linear = static_cast<bool>(context.context.physicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+
+		vk::ImageMemoryBarrier2 baseToSource = mipBarrier(image, 0, 1, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryWrite, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &baseToSource });
+
+		for (uint32_t level = 1; level < levelCount; level++) {
+			vk::ImageMemoryBarrier2 toDestination = mipBarrier(image, level, 1, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite);
+			cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toDestination });
+
+			int32_t sourceWidth = static_cast<int32_t>(std::max(extent.width >> (level - 1), 1u));
+			int32_t sourceHeight = static_cast<int32_t>(std::max(extent.height >> (level - 1), 1u));
+			int32_t width = static_cast<int32_t>(std::max(extent.width >> level, 1u));
+			int32_t height = static_cast<int32_t>(std::max(extent.height >> level, 1u));
+			vk::ImageBlit2 region = {
+				.srcSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = level - 1, .baseArrayLayer = 0, .layerCount = 1 },
+				.srcOffsets = std::array<vk::Offset3D, 2>{ vk::Offset3D(0, 0, 0), vk::Offset3D(sourceWidth, sourceHeight, 1) },
+				.dstSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = level, .baseArrayLayer = 0, .layerCount = 1 },
+				.dstOffsets = std::array<vk::Offset3D, 2>{ vk::Offset3D(0, 0, 0), vk::Offset3D(width, height, 1) }
+			};
+			cmdBuffer.blitImage2(vk::BlitImageInfo2{
+				.srcImage = image,
+				.srcImageLayout = vk::ImageLayout::eTransferSrcOptimal,
+				.dstImage = image,
+				.dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
+				.regionCount = 1,
+				.pRegions = &region,
+				.filter = linear ? vk::Filter::eLinear : vk::Filter::eNearest
+			});
+
+			vk::ImageMemoryBarrier2 toSource = mipBarrier(image, level, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead);
+			cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toSource });
+		}
+
+		vk::ImageMemoryBarrier2 toShader = mipBarrier(image, 0, levelCount, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShader });
+	}
+
+	void MipGenerator::recordDownsample(GraphicsContext& context, vk::raii::CommandBuffer const& cmdBuffer, vk::Image const& image, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount) {
+		vk::Format storageFormat = getStorageFormat(format);
+		uint32_t writtenLevels = levelCount - 1;
+
+		// the sampled view of an sRGB image leaves out the storage usage its format does not have
+		vk::ImageViewUsageCreateInfo sampledUsage = { .usage = vk::ImageUsageFlagBits::eSampled };
+		pendingViews.push_back(vk::raii::ImageView(context.context.device, vk::ImageViewCreateInfo{
+			.pNext = &sampledUsage,
+			.image = image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = format,
+			.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+		}));
+		vk::DescriptorImageInfo sourceInfo = { .sampler = sampler, .imageView = pendingViews.back(), .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal };
+
+		// the array is always full, slots past the last level repeat it and the shader never writes them
+		std::array<vk::DescriptorImageInfo, MAX_COMPUTE_LEVELS> levelInfos{};
+		for (uint32_t level = 1; level <= writtenLevels; level++) {
+			pendingViews.push_back(vk::raii::ImageView(context.context.device, vk::ImageViewCreateInfo{
+				.image = image,
+				.viewType = vk::ImageViewType::e2D,
+				.format = storageFormat,
+				.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = level, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+			}));
+			levelInfos[level - 1] = vk::DescriptorImageInfo{ .imageView = pendingViews.back(), .imageLayout = vk::ImageLayout::eGeneral };
+		}
+		for (uint32_t slot = writtenLevels; slot < MAX_COMPUTE_LEVELS; slot++) {
+			levelInfos[slot] = levelInfos[writtenLevels - 1];
+		}
+		vk::DescriptorBufferInfo counterInfo = { .buffer = counterBuffer, .offset = 0, .range = vk::WholeSize };
+		vk::DescriptorBufferInfo tileInfo = { .buffer = tileBuffer, .offset = 0, .range = vk::WholeSize };
+
+		std::array<vk::DescriptorPoolSize, 3> poolSizes = {
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1 },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageImage, .descriptorCount = MAX_COMPUTE_LEVELS },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 2 }
+		};
+		pendingPools.push_back(vk::raii::DescriptorPool(context.context.device, vk::DescriptorPoolCreateInfo{ .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, .maxSets = 1, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() }));
+		pendingSets.push_back(std::move(context.context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{ .descriptorPool = pendingPools.back(), .descriptorSetCount = 1, .pSetLayouts = &*setLayout })[0]));
+		vk::DescriptorSet set = pendingSets.back();
+
+		std::array<vk::WriteDescriptorSet, 4> writes = {
+			vk::WriteDescriptorSet{ .dstSet = set, .dstBinding = 0, .dstArrayElement = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .pImageInfo = &sourceInfo },
+			vk::WriteDescriptorSet{ .dstSet = set, .dstBinding = 1, .dstArrayElement = 0, .descriptorCount = MAX_COMPUTE_LEVELS, .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = levelInfos.data() },
+			vk::WriteDescriptorSet{ .dstSet = set, .dstBinding = 2, .dstArrayElement = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .pBufferInfo = &counterInfo },
+			vk::WriteDescriptorSet{ .dstSet = set, .dstBinding = 3, .dstArrayElement = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .pBufferInfo = &tileInfo }
+		};
+		context.context.device.updateDescriptorSets(writes, {});
+
+		// the counter starts from 0 every dispatch, after whatever an earlier one did with it and the tiles
+		vk::MemoryBarrier2 beforeClear = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &beforeClear });
+		cmdBuffer.fillBuffer(counterBuffer, 0, sizeof(uint32_t), 0);
+
+		vk::MemoryBarrier2 cleared = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+		};
+		std::array<vk::ImageMemoryBarrier2, 2> toCompute = {
+			mipBarrier(image, 0, 1, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryWrite, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead),
+			mipBarrier(image, 1, writtenLevels, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite)
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &cleared, .imageMemoryBarrierCount = static_cast<uint32_t>(toCompute.size()), .pImageMemoryBarriers = toCompute.data() });
+
+		// a workgroup per 32x32 texels of level 1, which is 64x64 of level 0
+		uint32_t groupsX = (std::max(extent.width >> 1, 1u) + 31) / 32;
+		uint32_t groupsY = (std::max(extent.height >> 1, 1u) + 31) / 32;
+		DownsampleConstants constants = {
+			.sourceWidth = extent.width,
+			.sourceHeight = extent.height,
+			.tilesX = groupsX,
+			.tilesY = groupsY,
+			.levelCount = writtenLevels,
+			.srgb = storageFormat != format ? 1u : 0u
+		};
+		cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+		cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, set, nullptr);
+		cmdBuffer.pushConstants<DownsampleConstants>(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+		cmdBuffer.dispatch(groupsX, groupsY, 1);
+
+		vk::ImageMemoryBarrier2 toShader = mipBarrier(image, 1, writtenLevels, vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead);
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShader });
+	}
+
+	void MipGenerator::collect() {
+		uint32_t queryCount = static_cast<uint32_t>(pending.size()) * 2;
+		bool timed = false;
+		if (*queryPool && queryCount > 0) {
+			timed = queryPool.getDevice().getQueryPoolResults(*queryPool, 0, queryCount, queryCount * sizeof(uint64_t), queryResults.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait, *queryPool.getDispatcher()) == vk::Result::eSuccess;
+		}
+
+		for (Pending const& recorded : pending) {
+			double milliseconds = timed ? static_cast<double>((queryResults[recorded.firstQuery + 1] - queryResults[recorded.firstQuery]) & timestampMask) * timestampPeriod / 1000000.0 : 0.0;
+			if (recorded.path == MipPath::eCompute) {
+				++statistics.computeImages;
+				statistics.computeMilliseconds += milliseconds;
+			} else {
+				++statistics.blitImages;
+				statistics.blitMilliseconds += milliseconds;
+			}
+		}
+
+		pending.clear();
+		pendingSets.clear();
+		pendingPools.clear();
+		pendingViews.clear();
+	}
+
+	void MipGenerator::setPreferredPath(MipPath const& path) {
+		preferredPath = path;
+	}
+
+	MipGenerationStatistics const& MipGenerator::getStatistics() const {
+		return statistics;
+	}
+}
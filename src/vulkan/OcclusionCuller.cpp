@@ -0,0 +1,292 @@
+#include "vulkan/OcclusionCuller.h"
+#include "vulkan/GraphicsContext.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace Vulkan {
+	OcclusionCuller::OcclusionCuller(GraphicsContext& context, uint32_t const& framesInFlightCount) : sampler{ nullptr }, setLayout{ nullptr }, pipelineLayout{ nullptr }, pipeline{ nullptr }, pyramidImage{ nullptr }, pyramidMemory{ nullptr }, levelViews{}, descriptorPool{ nullptr }, levelSets{}, levelExtents{}, depthExtent{}, readbackLevel{ 0 }, readbackBuffers{}, readbackMemory{}, readbackAddresses{}, awaitingResults(framesInFlightCount, false), slotViewProjections(framesInFlightCount, glm::mat4(1.0f)), readbackDepths{}, readbackViewProjection{ 1.0f }, hasReadback{ false }, statistics{}, framesInFlightCount{ framesInFlightCount }, available{ false }, enabled{ false } {
+		// texels are only ever loaded, never filtered
+		sampler = vk::raii::Sampler(context.context.device, vk::SamplerCreateInfo{
+			.magFilter = vk::Filter::eNearest,
+			.minFilter = vk::Filter::eNearest,
+			.mipmapMode = vk::SamplerMipmapMode::eNearest,
+			.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+			.addressModeV = vk::SamplerAddressMode::eClampToEdge,
+			.addressModeW = vk::SamplerAddressMode::eClampToEdge
+		});
+
+		std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+			vk::DescriptorSetLayoutBinding{ .binding = 0, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute },
+			vk::DescriptorSetLayoutBinding{ .binding = 1, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eCompute }
+		};
+		setLayout = vk::raii::DescriptorSetLayout(context.context.device, vk::DescriptorSetLayoutCreateInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() });
+
+		vk::PushConstantRange pushConstantRange = { .stageFlags = vk::ShaderStageFlagBits::eCompute, .offset = 0, .size = sizeof(ReduceConstants) };
+		pipelineLayout = vk::raii::PipelineLayout(context.context.device, vk::PipelineLayoutCreateInfo{ .setLayoutCount = 1, .pSetLayouts = &*setLayout, .pushConstantRangeCount = 1, .pPushConstantRanges = &pushConstantRange });
+
+		try {
+			pipeline = context.createComputePipeline("shaders/hiz.spv", "reduceDepth", *pipelineLayout);
+			available = true;
+
+			std::cout << "Created hi-z compute pipeline\n";
+		} catch (std::exception const& e) {
+			std::cout << "Occlusion culling unavailable, the hi-z pipeline could not be created: " << e.what() << '\n';
+		}
+	}
+
+	void OcclusionCuller::resize(GraphicsContext& context, vk::Extent2D const& newDepthExtent, DeletionQueue& deletionQueue) {
+		deletionQueue.retireAll(levelSets);
+		deletionQueue.retire(std::move(descriptorPool));
+		deletionQueue.retireAll(levelViews);
+		deletionQueue.retire(std::move(pyramidImage));
+		deletionQueue.retire(std::move(pyramidMemory));
+		readbackAddresses.clear();
+		deletionQueue.retireAll(readbackBuffers);
+		deletionQueue.retireAll(readbackMemory);
+		std::fill(awaitingResults.begin(), awaitingResults.end(), false);
+		hasReadback = false;
+		depthExtent = newDepthExtent;
+
+		// halved and rounded down every level down to a single texel, the shader folds in the texels rounding leaves over
+		levelExtents.clear();
+		vk::Extent2D levelExtent = { std::max(depthExtent.width / 2, 1u), std::max(depthExtent.height / 2, 1u) };
+		levelExtents.push_back(levelExtent);
+		while (levelExtent.width > 1 || levelExtent.height > 1) {
+			levelExtent = { std::max(levelExtent.width / 2, 1u), std::max(levelExtent.height / 2, 1u) };
+			levelExtents.push_back(levelExtent);
+		}
+		readbackLevel = 0;
+		while (readbackLevel + 1 < levelExtents.size() && (levelExtents[readbackLevel].width > READBACK_SIZE || levelExtents[readbackLevel].height > READBACK_SIZE)) {
+			++readbackLevel;
+		}
+
+		vk::ImageCreateInfo imageInfo = {
+			.imageType = vk::ImageType::e2D,
+			.format = PYRAMID_FORMAT,
+			.extent = vk::Extent3D{ levelExtents[0].width, levelExtents[0].height, 1 },
+			.mipLevels = static_cast<uint32_t>(levelExtents.size()),
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		pyramidImage = vk::raii::Image(context.context.device, imageInfo);
+
+		vk::MemoryRequirements imageRequirements = pyramidImage.getMemoryRequirements();
+		uint32_t memoryTypeIndex = context.getSuitableMemoryTypeIndex(imageRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		if (memoryTypeIndex == 0xFFFFFFFF) {
+			throw std::runtime_error("No suitable memory type found for the hi-z pyramid");
+		}
+		pyramidMemory = vk::raii::DeviceMemory(context.context.device, vk::MemoryAllocateInfo{ .allocationSize = imageRequirements.size, .memoryTypeIndex = memoryTypeIndex });
+		pyramidImage.bindMemory(pyramidMemory, 0);
+
+		for (uint32_t level = 0; level < levelExtents.size(); level++) {
+			vk::ImageViewCreateInfo viewInfo = {
+				.image = pyramidImage,
+				.viewType = vk::ImageViewType::e2D,
+				.format = PYRAMID_FORMAT,
+				.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = level, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+			};
+			levelViews.push_back(vk::raii::ImageView(context.context.device, viewInfo));
+		}
+
+		vk::Extent2D readbackExtent = levelExtents[readbackLevel];
+		uint32_t readbackSize = readbackExtent.width * readbackExtent.height * sizeof(float);
+		for (uint32_t i = 0; i < framesInFlightCount; i++) {
+			readbackBuffers.push_back(nullptr);
+			readbackMemory.push_back(nullptr);
+			context.createBufferAndMemory(readbackBuffers[i], readbackMemory[i], vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, readbackSize, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive);
+			readbackAddresses.push_back(readbackMemory[i].mapMemory(0, readbackSize));
+		}
+		readbackDepths.assign(readbackExtent.width * readbackExtent.height, 1.0f);
+
+		std::cout << "Created hi-z pyramid " << levelExtents[0].width << "x" << levelExtents[0].height << " with " << levelExtents.size() << " levels, level " << readbackLevel << " is read back\n";
+	}
+
+	void OcclusionCuller::bindDepth(GraphicsContext& context, vk::ImageView const& depthView, DeletionQueue& deletionQueue) {
+		deletionQueue.retireAll(levelSets);
+		deletionQueue.retire(std::move(descriptorPool));
+
+		uint32_t levelCount = static_cast<uint32_t>(levelExtents.size());
+		std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = levelCount },
+			vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageImage, .descriptorCount = levelCount }
+		};
+		descriptorPool = vk::raii::DescriptorPool(context.context.device, vk::DescriptorPoolCreateInfo{ .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, .maxSets = levelCount, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() });
+
+		std::vector<vk::DescriptorSetLayout> layouts(levelCount, *setLayout);
+		vk::DescriptorSetAllocateInfo setsInfo = {
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = levelCount,
+			.pSetLayouts = layouts.data()
+		};
+		levelSets = context.context.device.allocateDescriptorSets(setsInfo);
+
+		for (uint32_t level = 0; level < levelCount; level++) {
+			// the levels below are read in general layout since the pass never moves them out of it
+			vk::DescriptorImageInfo sourceInfo = level == 0
+				? vk::DescriptorImageInfo{ .sampler = sampler, .imageView = depthView, .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal }
+				: vk::DescriptorImageInfo{ .sampler = sampler, .imageView = levelViews[level - 1], .imageLayout = vk::ImageLayout::eGeneral };
+			vk::DescriptorImageInfo destinationInfo = { .imageView = levelViews[level], .imageLayout = vk::ImageLayout::eGeneral };
+
+			std::array<vk::WriteDescriptorSet, 2> writes = {
+				vk::WriteDescriptorSet{ .dstSet = levelSets[level], .dstBinding = 0, .dstArrayElement = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .pImageInfo = &sourceInfo },
+				vk::WriteDescriptorSet{ .dstSet = levelSets[level], .dstBinding = 1, .dstArrayElement = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = &destinationInfo }
+			};
+			context.context.device.updateDescriptorSets(writes, {});
+		}
+	}
+
+	void OcclusionCuller::beginFrame(uint32_t const& frameIndex) {
+		if (!awaitingResults[frameIndex]) {
+			return;
+		}
+
+		memcpy(readbackDepths.data(), readbackAddresses[frameIndex], readbackDepths.size() * sizeof(float));
+		readbackViewProjection = slotViewProjections[frameIndex];
+		hasReadback = true;
+		awaitingResults[frameIndex] = false;
+	}
+
+	void OcclusionCuller::recordBuild(vk::raii::CommandBuffer const& cmdBuffer) {
+		cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+
+		vk::Extent2D sourceExtent = depthExtent;
+		for (uint32_t level = 0; level < levelExtents.size(); level++) {
+			if (level > 0) {
+				vk::MemoryBarrier2 levelWritten = {
+					.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+					.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+					.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+					.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead
+				};
+				cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &levelWritten });
+			}
+
+			vk::Extent2D const& extent = levelExtents[level];
+			ReduceConstants constants = { .sourceWidth = sourceExtent.width, .sourceHeight = sourceExtent.height, .destinationWidth = extent.width, .destinationHeight = extent.height };
+			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, *levelSets[level], nullptr);
+			cmdBuffer.pushConstants<ReduceConstants>(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+			cmdBuffer.dispatch((extent.width + 7) / 8, (extent.height + 7) / 8, 1);
+
+			sourceExtent = extent;
+		}
+	}
+
+	void OcclusionCuller::recordReadback(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex) {
+		vk::Extent2D const& extent = levelExtents[readbackLevel];
+		vk::BufferImageCopy region = {
+			.bufferOffset = 0,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = readbackLevel, .baseArrayLayer = 0, .layerCount = 1 },
+			.imageOffset = vk::Offset3D{ 0, 0, 0 },
+			.imageExtent = vk::Extent3D{ extent.width, extent.height, 1 }
+		};
+		cmdBuffer.copyImageToBuffer(pyramidImage, vk::ImageLayout::eTransferSrcOptimal, readbackBuffers[frameIndex], region);
+
+		vk::BufferMemoryBarrier2 toHost = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eHost,
+			.dstAccessMask = vk::AccessFlagBits2::eHostRead,
+			.buffer = readbackBuffers[frameIndex],
+			.offset = 0,
+			.size = vk::WholeSize
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .bufferMemoryBarrierCount = 1, .pBufferMemoryBarriers = &toHost });
+	}
+
+	void OcclusionCuller::frameSubmitted(uint32_t const& frameIndex, glm::mat4 const& viewProjection) {
+		slotViewProjections[frameIndex] = viewProjection;
+		awaitingResults[frameIndex] = true;
+	}
+
+	void OcclusionCuller::beginCulling() {
+		statistics = OcclusionStatistics{};
+	}
+
+	// the nearest corner against the farthest depth anywhere under the projected rectangle, widened by a texel for the rounded down levels
+	bool OcclusionCuller::isOccluded(glm::vec3 const& boundsMin, glm::vec3 const& boundsMax) {
+		++statistics.tested;
+		if (!enabled || !hasReadback) {
+			return false;
+		}
+
+		float nearest = 1.0f;
+		glm::vec2 rectMin(1.0f);
+		glm::vec2 rectMax(-1.0f);
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			glm::vec3 position = { (corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z };
+			glm::vec4 clip = readbackViewProjection * glm::vec4(position, 1.0f);
+			if (clip.w <= 0.0f) {
+				return false;
+			}
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			nearest = std::min(nearest, ndc.z);
+			rectMin = glm::min(rectMin, glm::vec2(ndc));
+			rectMax = glm::max(rectMax, glm::vec2(ndc));
+		}
+		// off screen is for frustum culling to decide
+		if (rectMax.x < -1.0f || rectMax.y < -1.0f || rectMin.x > 1.0f || rectMin.y > 1.0f || nearest < 0.0f) {
+			return false;
+		}
+
+		vk::Extent2D const& extent = levelExtents[readbackLevel];
+		int32_t width = static_cast<int32_t>(extent.width);
+		int32_t height = static_cast<int32_t>(extent.height);
+		int32_t x0 = std::clamp(static_cast<int32_t>(std::floor((rectMin.x * 0.5f + 0.5f) * width)) - 1, 0, width - 1);
+		int32_t y0 = std::clamp(static_cast<int32_t>(std::floor((rectMin.y * 0.5f + 0.5f) * height)) - 1, 0, height - 1);
+		int32_t x1 = std::clamp(static_cast<int32_t>(std::floor((rectMax.x * 0.5f + 0.5f) * width)) + 1, 0, width - 1);
+		int32_t y1 = std::clamp(static_cast<int32_t>(std::floor((rectMax.y * 0.5f + 0.5f) * height)) + 1, 0, height - 1);
+
+		float farthest = 0.0f;
+		for (int32_t y = y0; y <= y1; y++) {
+			for (int32_t x = x0; x <= x1; x++) {
+				farthest = std::max(farthest, readbackDepths[y * width + x]);
+			}
+		}
+
+		if (nearest > farthest) {
+			++statistics.culled;
+			return true;
+		}
+		return false;
+	}
+
+	void OcclusionCuller::setEnabled(bool const& enable) {
+		enabled = enable && available;
+		if (!enabled) {
+			std::fill(awaitingResults.begin(), awaitingResults.end(), false);
+			hasReadback = false;
+		}
+	}
+
+	bool OcclusionCuller::isEnabled() const {
+		return enabled;
+	}
+
+	bool OcclusionCuller::isAvailable() const {
+		return available;
+	}
+
+	bool OcclusionCuller::isSized() const {
+		return !levelExtents.empty();
+	}
+
+	vk::Image OcclusionCuller::getPyramidImage() const {
+		return pyramidImage;
+	}
+
+	vk::Extent2D OcclusionCuller::getPyramidExtent() const {
+		return levelExtents.empty() ? vk::Extent2D{} : levelExtents[0];
+	}
+
+	OcclusionStatistics const& OcclusionCuller::getStatistics() const {
+		return statistics;
+	}
+}
@@ -0,0 +1,176 @@
+#include "vulkan/OverdrawMeter.h"
+#include "vulkan/GraphicsContext.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace Vulkan {
+	OverdrawMeter::OverdrawMeter(uint32_t const& framesInFlightCount) : counterImage{ nullptr }, counterMemory{ nullptr }, counterView{ nullptr }, readbackBuffers{}, readbackMemory{}, readbackAddresses{}, awaitingResults(framesInFlightCount, false), extent{}, lastResult{}, framesInFlightCount{ framesInFlightCount }, enabled{ false } {
+
+	}
+
+	void OverdrawMeter::resize(GraphicsContext& context, vk::Extent2D const& newExtent, DeletionQueue& deletionQueue) {
+		deletionQueue.retire(std::move(counterView));
+		deletionQueue.retire(std::move(counterImage));
+		deletionQueue.retire(std::move(counterMemory));
+		readbackAddresses.clear();
+		deletionQueue.retireAll(readbackBuffers);
+		deletionQueue.retireAll(readbackMemory);
+		std::fill(awaitingResults.begin(), awaitingResults.end(), false);
+		extent = newExtent;
+
+		vk::ImageCreateInfo imageInfo = {
+			.imageType = vk::ImageType::e2D,
+			.format = COUNTER_FORMAT,
+			.extent = vk::Extent3D{ extent.width, extent.height, 1 },
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		counterImage = vk::raii::Image(context.context.device, imageInfo);
+
+		vk::MemoryRequirements imageRequirements = counterImage.getMemoryRequirements();
+		uint32_t memoryTypeIndex = context.getSuitableMemoryTypeIndex(imageRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		if (memoryTypeIndex == 0xFFFFFFFF) {
+			throw std::runtime_error("No suitable memory type found for the overdraw counter image");
+		}
+		counterMemory = vk::raii::DeviceMemory(context.context.device, vk::MemoryAllocateInfo{ .allocationSize = imageRequirements.size, .memoryTypeIndex = memoryTypeIndex });
+		counterImage.bindMemory(counterMemory, 0);
+
+		vk::ImageViewCreateInfo viewInfo = {
+			.image = counterImage,
+			.viewType = vk::ImageViewType::e2D,
+			.format = COUNTER_FORMAT,
+			.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+		};
+		counterView = vk::raii::ImageView(context.context.device, viewInfo);
+
+		uint32_t readbackSize = extent.width * extent.height * sizeof(uint16_t);
+		for (uint32_t i = 0; i < framesInFlightCount; i++) {
+			readbackBuffers.push_back(nullptr);
+			readbackMemory.push_back(nullptr);
+			context.createBufferAndMemory(readbackBuffers[i], readbackMemory[i], vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, readbackSize, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive);
+			readbackAddresses.push_back(readbackMemory[i].mapMemory(0, readbackSize));
+		}
+
+		std::cout << "Created overdraw counter target " << extent.width << "x" << extent.height << " with " << readbackBuffers.size() << " readback buffers\n";
+	}
+
+	void OverdrawMeter::beginFrame(uint32_t const& frameIndex) {
+		if (awaitingResults[frameIndex]) {
+			reduce(frameIndex);
+			awaitingResults[frameIndex] = false;
+		}
+	}
+
+	void OverdrawMeter::beginPass(vk::raii::CommandBuffer const& cmdBuffer) {
+		vk::RenderingAttachmentInfo attachmentInfo = {
+			.imageView = counterView,
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 0.0f)
+		};
+		cmdBuffer.beginRendering(vk::RenderingInfo{
+			.renderArea = vk::Rect2D{ .offset = {0, 0}, .extent = extent },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &attachmentInfo
+		});
+	}
+
+	void OverdrawMeter::endPass(vk::raii::CommandBuffer const& cmdBuffer) {
+		cmdBuffer.endRendering();
+	}
+
+	void OverdrawMeter::recordReadback(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex) {
+		vk::BufferImageCopy region = {
+			.bufferOffset = 0,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 },
+			.imageOffset = vk::Offset3D{ 0, 0, 0 },
+			.imageExtent = vk::Extent3D{ extent.width, extent.height, 1 }
+		};
+		cmdBuffer.copyImageToBuffer(counterImage, vk::ImageLayout::eTransferSrcOptimal, readbackBuffers[frameIndex], region);
+
+		vk::BufferMemoryBarrier2 toHost = {
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eHost,
+			.dstAccessMask = vk::AccessFlagBits2::eHostRead,
+			.buffer = readbackBuffers[frameIndex],
+			.offset = 0,
+			.size = vk::WholeSize
+		};
+		cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .bufferMemoryBarrierCount = 1, .pBufferMemoryBarriers = &toHost });
+
+		awaitingResults[frameIndex] = true;
+	}
+
+	void OverdrawMeter::reduce(uint32_t const& frameIndex) {
+		uint16_t const* counts = reinterpret_cast<uint16_t const*>(readbackAddresses[frameIndex]);
+		uint64_t pixelCount = static_cast<uint64_t>(extent.width) * extent.height;
+		if (pixelCount == 0) {
+			return;
+		}
+
+		uint64_t total = 0;
+		uint64_t covered = 0;
+		uint32_t max = 0;
+		for (uint64_t i = 0; i < pixelCount; i++) {
+			uint32_t count = static_cast<uint32_t>(halfToFloat(counts[i]));
+			total += count;
+			max = std::max(max, count);
+			if (count > 0) {
+				++covered;
+			}
+		}
+
+		lastResult = OverdrawResult{
+			.average = static_cast<double>(total) / static_cast<double>(pixelCount),
+			.coveredAverage = covered == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(covered),
+			.max = max,
+			.coverage = static_cast<double>(covered) / static_cast<double>(pixelCount)
+		};
+	}
+
+	// the counts are small non negative whole numbers, so subnormals, infinities and NaNs never show up
+	float OverdrawMeter::halfToFloat(uint16_t const& half) {
+		uint32_t exponent = (half >> 10) & 0x1F;
+		uint32_t mantissa = half & 0x3FF;
+		if (exponent == 0) {
+			return 0.0f;
+		}
+
+		return std::ldexp(1.0f + static_cast<float>(mantissa) / 1024.0f, static_cast<int>(exponent) - 15);
+	}
+
+	void OverdrawMeter::setEnabled(bool const& enable) {
+		enabled = enable;
+		if (!enabled) {
+			std::fill(awaitingResults.begin(), awaitingResults.end(), false);
+			lastResult = OverdrawResult{};
+		}
+	}
+
+	bool OverdrawMeter::isEnabled() const {
+		return enabled;
+	}
+
+	vk::Image OverdrawMeter::getCounterImage() const {
+		return counterImage;
+	}
+
+	vk::Extent2D OverdrawMeter::getExtent() const {
+		return extent;
+	}
+
+	OverdrawResult const& OverdrawMeter::getLastResult() const {
+		return lastResult;
+	}
+}
@@ -0,0 +1,376 @@
+#include "vulkan/PipelineRegistry.h"
+#include "general/Hash.h"
+#include "general/Profiler.h"
+#include <algorithm>
+
+namespace Vulkan {
+	// dynamic topology may only switch within the topology class the pipeline was created with
+	static vk::PrimitiveTopology topologyClass(vk::PrimitiveTopology const& topology) {
+		switch (topology) {
+		case vk::PrimitiveTopology::ePointList:
+			return vk::PrimitiveTopology::ePointList;
+		case vk::PrimitiveTopology::eLineList:
+		case vk::PrimitiveTopology::eLineStrip:
+		case vk::PrimitiveTopology::eLineListWithAdjacency:
+		case vk::PrimitiveTopology::eLineStripWithAdjacency:
+			return vk::PrimitiveTopology::eLineList;
+		case vk::PrimitiveTopology::ePatchList:
+			return vk::PrimitiveTopology::ePatchList;
+		default:
+			return vk::PrimitiveTopology::eTriangleList;
+		}
+	}
+
+	void PipelineDescription::canonicalize() {
+		std::sort(dynamicStates.begin(), dynamicStates.end());
+		dynamicStates.erase(std::unique(dynamicStates.begin(), dynamicStates.end()), dynamicStates.end());
+
+		if (isDynamic(vk::DynamicState::eViewport) || isDynamic(vk::DynamicState::eViewportWithCount)) {
+			viewport = vk::Viewport{};
+		}
+		if (isDynamic(vk::DynamicState::eScissor) || isDynamic(vk::DynamicState::eScissorWithCount)) {
+			scissor = vk::Rect2D{};
+		}
+		if (isDynamic(vk::DynamicState::eVertexInputBindingStride)) {
+			vertexBinding.stride = 0;
+		}
+		if (isDynamic(vk::DynamicState::ePrimitiveTopology)) {
+			topology = topologyClass(topology);
+		}
+		if (isDynamic(vk::DynamicState::ePrimitiveRestartEnable)) {
+			primitiveRestart = false;
+		}
+		if (isDynamic(vk::DynamicState::eDepthClampEnableEXT)) {
+			depthClamp = false;
+		}
+		if (isDynamic(vk::DynamicState::eRasterizerDiscardEnable)) {
+			rasterizerDiscard = false;
+		}
+		if (isDynamic(vk::DynamicState::ePolygonModeEXT)) {
+			polygonMode = vk::PolygonMode::eFill;
+		}
+		if (isDynamic(vk::DynamicState::eCullMode)) {
+			cullMode = vk::CullModeFlagBits::eNone;
+		}
+		if (isDynamic(vk::DynamicState::eFrontFace)) {
+			frontFace = vk::FrontFace::eCounterClockwise;
+		}
+		if (isDynamic(vk::DynamicState::eDepthBias) || (!depthBias && !isDynamic(vk::DynamicState::eDepthBiasEnable))) {
+			depthBiasConstantFactor = 0.0f;
+			depthBiasClamp = 0.0f;
+			depthBiasSlopeFactor = 0.0f;
+		}
+		if (isDynamic(vk::DynamicState::eDepthBiasEnable)) {
+			depthBias = false;
+		}
+		if (isDynamic(vk::DynamicState::eLineWidth)) {
+			lineWidth = 1.0f;
+		}
+		if (isDynamic(vk::DynamicState::eDepthTestEnable)) {
+			depthTest = false;
+		}
+		if (isDynamic(vk::DynamicState::eDepthWriteEnable)) {
+			depthWrite = false;
+		}
+		if (isDynamic(vk::DynamicState::eDepthCompareOp)) {
+			depthCompareOp = vk::CompareOp::eNever;
+		}
+		if (isDynamic(vk::DynamicState::eDepthBoundsTestEnable)) {
+			depthBoundsTest = false;
+		}
+		if (isDynamic(vk::DynamicState::eStencilTestEnable)) {
+			stencilTest = false;
+		}
+		if (isDynamic(vk::DynamicState::eLogicOpEnableEXT)) {
+			logicOpEnable = false;
+		}
+		if (!logicOpEnable && !isDynamic(vk::DynamicState::eLogicOpEnableEXT)) {
+			logicOp = vk::LogicOp::eClear;
+		}
+
+		for (vk::PipelineColorBlendAttachmentState& attachment : blendAttachments) {
+			if (isDynamic(vk::DynamicState::eColorBlendEnableEXT)) {
+				attachment.blendEnable = false;
+			}
+			if (isDynamic(vk::DynamicState::eColorBlendEquationEXT) || (!attachment.blendEnable && !isDynamic(vk::DynamicState::eColorBlendEnableEXT))) {
+				attachment = vk::PipelineColorBlendAttachmentState{ .blendEnable = attachment.blendEnable, .colorWriteMask = attachment.colorWriteMask };
+			}
+			if (isDynamic(vk::DynamicState::eColorWriteMaskEXT)) {
+				attachment.colorWriteMask = {};
+			}
+		}
+	}
+
+	bool PipelineDescription::isDynamic(vk::DynamicState const& state) const {
+		return std::find(dynamicStates.begin(), dynamicStates.end(), state) != dynamicStates.end();
+	}
+
+	void PipelineDescription::applyVariant(ShaderVariantKey const& variant) {
+		SpecializationConstants variantConstants = variant.getConstants();
+
+		for (PipelineShaderStage& stage : shaderStages) {
+			stage.specialization.merge(variantConstants);
+		}
+	}
+
+	size_t PipelineDescriptionHash::operator()(PipelineDescription const& description) const {
+		uint64_t hash = General::FNV_OFFSET_BASIS;
+
+		for (PipelineShaderStage const& stage : description.shaderStages) {
+			hash = General::hashValue(stage.stage, hash);
+			hash = General::hashValue(stage.sprivPath, hash);
+			hash = General::hashValue(stage.entryPoint, hash);
+			for (std::pair<const uint32_t, SpecializationValue> const& constant : stage.specialization.getConstants()) {
+				hash = General::hashValue(constant.first, hash);
+				hash = General::hashValue(constant.second.index(), hash);
+				hash = std::visit([hash](auto const& value) { return General::hashValue(value, hash); }, constant.second);
+			}
+		}
+		hash = General::hashValue(description.vertexBinding, hash);
+		hash = General::hashValue(description.vertexAttributes, hash);
+		hash = General::hashValue(description.topology, hash);
+		hash = General::hashValue(description.primitiveRestart, hash);
+		hash = General::hashValue(description.viewport, hash);
+		hash = General::hashValue(description.scissor, hash);
+		hash = General::hashValue(description.depthClamp, hash);
+		hash = General::hashValue(description.rasterizerDiscard, hash);
+		hash = General::hashValue(description.polygonMode, hash);
+		hash = General::hashValue(description.cullMode, hash);
+		hash = General::hashValue(description.frontFace, hash);
+		hash = General::hashValue(description.depthBias, hash);
+		hash = General::hashValue(description.depthBiasConstantFactor, hash);
+		hash = General::hashValue(description.depthBiasClamp, hash);
+		hash = General::hashValue(description.depthBiasSlopeFactor, hash);
+		hash = General::hashValue(description.lineWidth, hash);
+		hash = General::hashValue(description.depthTest, hash);
+		hash = General::hashValue(description.depthWrite, hash);
+		hash = General::hashValue(description.depthCompareOp, hash);
+		hash = General::hashValue(description.depthBoundsTest, hash);
+		hash = General::hashValue(description.stencilTest, hash);
+		hash = General::hashValue(description.blendAttachments, hash);
+		hash = General::hashValue(description.logicOpEnable, hash);
+		hash = General::hashValue(description.logicOp, hash);
+		hash = General::hashValue(description.blendConstants, hash);
+		hash = General::hashValue(description.dynamicStates, hash);
+		hash = General::hashValue(description.colourFormat, hash);
+		hash = General::hashValue(description.depthFormat, hash);
+		hash = General::hashValue(description.samples, hash);
+		hash = General::hashValue(description.layout, hash);
+
+		return static_cast<size_t>(hash);
+	}
+
+	PipelineRegistry::PipelineRegistry(vk::raii::Device const& device, ShaderModuleCache& shaderModules, uint32_t const& workerCount) : device{ *device }, dispatcher{ device.getDispatcher() }, pipelineCache{ nullptr }, shaderModules{ shaderModules }, lookup{}, entries{}, deduplicatedRequests{ 0 }, compileWorkers{ nullptr } {
+		pipelineCache = this->device.createPipelineCache(vk::PipelineCacheCreateInfo{}, nullptr, *dispatcher);
+		compileWorkers = std::make_unique<General::ThreadPool>(workerCount);
+
+		std::cout << "Created pipeline registry with " << compileWorkers->getThreadCount() << " compile workers\n";
+	}
+
+	PipelineRegistry::~PipelineRegistry() {
+		compileWorkers.reset();
+
+		for (std::unique_ptr<Entry> const& entry : entries) {
+			if (entry->pipeline) {
+				device.destroyPipeline(entry->pipeline, nullptr, *dispatcher);
+			}
+		}
+		device.destroyPipelineCache(pipelineCache, nullptr, *dispatcher);
+	}
+
+	PipelineRegistry::PipelineId PipelineRegistry::request(PipelineDescription description) {
+		description.canonicalize();
+
+		Entry* newEntry = nullptr;
+		PipelineId id = 0;
+		{
+			std::lock_guard<std::mutex> lock(entriesMutex);
+
+			auto found = lookup.find(description);
+			if (found != lookup.end()) {
+				++deduplicatedRequests;
+				return found->second;
+			}
+
+			id = static_cast<PipelineId>(entries.size());
+			entries.push_back(std::make_unique<Entry>());
+			newEntry = entries.back().get();
+			newEntry->description = description;
+			lookup.emplace(std::move(description), id);
+		}
+
+		compileWorkers->submit([this, newEntry]() { compile(*newEntry); });
+
+		return id;
+	}
+
+	vk::Pipeline PipelineRegistry::tryGet(PipelineId const& id) const {
+		Entry const* entry = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(entriesMutex);
+			entry = entries[id].get();
+		}
+
+		if (entry->state.load(std::memory_order_acquire) == PipelineState::eReady) {
+			return entry->pipeline;
+		}
+
+		return nullptr;
+	}
+
+	vk::Pipeline PipelineRegistry::get(PipelineId const& id) {
+		std::unique_lock<std::mutex> lock(entriesMutex);
+		Entry const* entry = entries[id].get();
+
+		entryFinished.wait(lock, [entry]() { return entry->state.load(std::memory_order_acquire) != PipelineState::ePending; });
+
+		if (entry->state.load(std::memory_order_acquire) == PipelineState::eFailed) {
+			throw std::runtime_error("Graphics pipeline " + std::to_string(id) + " failed to compile");
+		}
+
+		return entry->pipeline;
+	}
+
+	PipelineState PipelineRegistry::getState(PipelineId const& id) const {
+		std::lock_guard<std::mutex> lock(entriesMutex);
+		return entries[id]->state.load(std::memory_order_acquire);
+	}
+
+	uint32_t PipelineRegistry::getPipelineCount() const {
+		std::lock_guard<std::mutex> lock(entriesMutex);
+		return static_cast<uint32_t>(entries.size());
+	}
+
+	uint32_t PipelineRegistry::getDeduplicatedRequestCount() const {
+		std::lock_guard<std::mutex> lock(entriesMutex);
+		return deduplicatedRequests;
+	}
+
+	// runs on a compile worker, only reads the entry's description which nothing else writes after request()
+	void PipelineRegistry::compile(Entry& entry) {
+		General::StartupStep step("pipeline compile");
+		GH_PROFILE_ZONE("pipeline compile");
+		PipelineDescription const& description = entry.description;
+		PipelineState result = PipelineState::eFailed;
+
+		try {
+			// reserved up front, the create infos point into these
+			std::vector<PackedSpecialization> packedSpecializations{};
+			std::vector<vk::SpecializationInfo> specializationInfos{};
+			packedSpecializations.reserve(description.shaderStages.size());
+			specializationInfos.reserve(description.shaderStages.size());
+
+			std::vector<vk::PipelineShaderStageCreateInfo> shaderCreateInfo{};
+			for (PipelineShaderStage const& stage : description.shaderStages) {
+				packedSpecializations.push_back(stage.specialization.pack());
+				specializationInfos.push_back(packedSpecializations.back().getInfo());
+
+				// Vulkan ignores map entries for ids the module does not declare, a stale binary would silently drop a variant
+				vk::ShaderModule module = shaderModules.getShaderModule(stage.sprivPath);
+				if (!stage.specialization.setsExactly(shaderModules.getSpecializationIds(stage.sprivPath))) {
+					throw std::runtime_error("Spriv file at " + stage.sprivPath + " does not declare the specialization constants the pipeline sets, it is out of date with its source");
+				}
+
+				shaderCreateInfo.push_back(vk::PipelineShaderStageCreateInfo{
+					.stage = stage.stage,
+					.module = module,
+					.pName = stage.entryPoint.c_str(),
+					.pSpecializationInfo = stage.specialization.empty() ? nullptr : &specializationInfos.back()
+				});
+			}
+
+			vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {
+				.vertexBindingDescriptionCount = 1,
+				.pVertexBindingDescriptions = &description.vertexBinding,
+				.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size()),
+				.pVertexAttributeDescriptions = description.vertexAttributes.data()
+			};
+
+			vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {
+				.topology = description.topology,
+				.primitiveRestartEnable = description.primitiveRestart
+			};
+
+			// with the count dynamic as well the counts have to be zero here
+			bool viewportCountDynamic = description.isDynamic(vk::DynamicState::eViewportWithCount);
+			bool scissorCountDynamic = description.isDynamic(vk::DynamicState::eScissorWithCount);
+			vk::PipelineViewportStateCreateInfo viewportScissorInfo = {
+				.viewportCount = viewportCountDynamic ? 0u : 1u,
+				.pViewports = &description.viewport,
+				.scissorCount = scissorCountDynamic ? 0u : 1u,
+				.pScissors = &description.scissor
+			};
+
+			vk::PipelineRasterizationStateCreateInfo rasterizationInfo = {
+				.depthClampEnable = description.depthClamp,
+				.rasterizerDiscardEnable = description.rasterizerDiscard,
+				.polygonMode = description.polygonMode,
+				.cullMode = description.cullMode,
+				.frontFace = description.frontFace,
+				.depthBiasEnable = description.depthBias,
+				.depthBiasConstantFactor = description.depthBiasConstantFactor,
+				.depthBiasClamp = description.depthBiasClamp,
+				.depthBiasSlopeFactor = description.depthBiasSlopeFactor,
+				.lineWidth = description.lineWidth
+			};
+
+			vk::PipelineDepthStencilStateCreateInfo depthStencilInfo = {
+				.depthTestEnable = description.depthTest,
+				.depthWriteEnable = description.depthWrite,
+				.depthCompareOp = description.depthCompareOp,
+				.depthBoundsTestEnable = description.depthBoundsTest,
+				.stencilTestEnable = description.stencilTest,
+				.minDepthBounds = 0.0f,
+				.maxDepthBounds = 1.0f
+			};
+
+			vk::PipelineMultisampleStateCreateInfo multisampling{ .rasterizationSamples = description.samples, .sampleShadingEnable = vk::False };
+
+			vk::PipelineColorBlendStateCreateInfo colorBlendInfo = {
+				.logicOpEnable = description.logicOpEnable,
+				.logicOp = description.logicOp,
+				.attachmentCount = static_cast<uint32_t>(description.blendAttachments.size()),
+				.pAttachments = description.blendAttachments.data(),
+				.blendConstants = description.blendConstants
+			};
+
+			vk::PipelineDynamicStateCreateInfo dynamicStateInfo = {
+				.dynamicStateCount = static_cast<uint32_t>(description.dynamicStates.size()),
+				.pDynamicStates = description.dynamicStates.data()
+			};
+
+			vk::PipelineRenderingCreateInfo renderingAttachmentInfo = {
+				.colorAttachmentCount = 1,
+				.pColorAttachmentFormats = &description.colourFormat,
+				.depthAttachmentFormat = description.depthFormat
+			};
+
+			vk::GraphicsPipelineCreateInfo graphicsPipelineInfo = {
+				.pNext = &renderingAttachmentInfo,
+				.stageCount = static_cast<uint32_t>(shaderCreateInfo.size()),
+				.pStages = shaderCreateInfo.data(),
+				.pVertexInputState = &vertexInputInfo,
+				.pInputAssemblyState = &inputAssemblyInfo,
+				.pViewportState = &viewportScissorInfo,
+				.pRasterizationState = &rasterizationInfo,
+				.pMultisampleState = &multisampling,
+				.pDepthStencilState = &depthStencilInfo,
+				.pColorBlendState = &colorBlendInfo,
+				.pDynamicState = &dynamicStateInfo,
+				.layout = description.layout,
+				.renderPass = nullptr
+			};
+
+			entry.pipeline = device.createGraphicsPipeline(pipelineCache, graphicsPipelineInfo, nullptr, *dispatcher).value;
+			result = PipelineState::eReady;
+		} catch (std::exception const& e) {
+			std::cout << "Graphics pipeline compile failed: " << e.what() << '\n';
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(entriesMutex);
+			entry.state.store(result, std::memory_order_release);
+		}
+		entryFinished.notify_all();
+	}
+}
@@ -0,0 +1,143 @@
+#include "vulkan/PipelineStatistics.h"
+#include <limits>
+
+namespace Vulkan {
+	PipelineStatistics::PipelineStatistics(vk::raii::Device const& device, bool const& supported, uint32_t const& framesInFlightCount, uint32_t const& maxPassesPerFrame) : pools{}, framePasses(framesInFlightCount), awaitingResults(framesInFlightCount, false), lastStatistics{}, results{}, maxPassesPerFrame{ maxPassesPerFrame }, currentFrame{ 0 }, supported{ supported }, enabled{ false } {
+		if (!supported) {
+			std::cout << "Pipeline statistics queries not supported, pipeline statistics disabled\n";
+			return;
+		}
+
+		vk::QueryPoolCreateInfo poolInfo = {
+			.queryType = vk::QueryType::ePipelineStatistics,
+			.queryCount = maxPassesPerFrame,
+			.pipelineStatistics = FLAGS
+		};
+		for (uint32_t i = 0; i < framesInFlightCount; i++) {
+			pools.push_back(vk::raii::QueryPool(device, poolInfo));
+			framePasses[i].reserve(maxPassesPerFrame);
+		}
+		lastStatistics.reserve(maxPassesPerFrame);
+		results.resize(maxPassesPerFrame * (VALUE_COUNT + 1));
+
+		std::cout << "Created " << pools.size() << " pipeline statistics query pools with " << maxPassesPerFrame << " queries each\n";
+	}
+
+	void PipelineStatistics::beginFrame(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& frameIndex) {
+		currentFrame = frameIndex;
+		if (!supported) {
+			return;
+		}
+
+		collect(frameIndex);
+		framePasses[frameIndex].clear();
+
+		if (enabled) {
+			cmdBuffer.resetQueryPool(pools[frameIndex], 0, maxPassesPerFrame);
+			awaitingResults[frameIndex] = true;
+		}
+	}
+
+	void PipelineStatistics::replayFrame(uint32_t const& frameIndex) {
+		currentFrame = frameIndex;
+		if (!supported) {
+			return;
+		}
+
+		collect(frameIndex);
+
+		if (enabled) {
+			awaitingResults[frameIndex] = true;
+		}
+	}
+
+	uint32_t PipelineStatistics::beginPass(vk::raii::CommandBuffer const& cmdBuffer, const char* name) {
+		if (!supported || !enabled || !awaitingResults[currentFrame] || framePasses[currentFrame].size() >= maxPassesPerFrame) {
+			return std::numeric_limits<uint32_t>::max();
+		}
+
+		uint32_t query = static_cast<uint32_t>(framePasses[currentFrame].size());
+		framePasses[currentFrame].push_back(Pass{ .name = name, .query = query });
+		cmdBuffer.beginQuery(pools[currentFrame], query, {});
+
+		return query;
+	}
+
+	void PipelineStatistics::endPass(vk::raii::CommandBuffer const& cmdBuffer, uint32_t const& pass) {
+		if (pass == std::numeric_limits<uint32_t>::max()) {
+			return;
+		}
+
+		cmdBuffer.endQuery(pools[currentFrame], pass);
+	}
+
+	void PipelineStatistics::collect(uint32_t const& frameIndex) {
+		if (!awaitingResults[frameIndex]) {
+			return;
+		}
+		awaitingResults[frameIndex] = false;
+		if (!enabled) {
+			return;
+		}
+
+		uint32_t queryCount = static_cast<uint32_t>(framePasses[frameIndex].size());
+		if (queryCount == 0) {
+			return;
+		}
+
+		// the counters then an availability word for each query
+		size_t stride = (VALUE_COUNT + 1) * sizeof(uint64_t);
+		vk::raii::QueryPool const& pool = pools[frameIndex];
+		vk::Result queried = pool.getDevice().getQueryPoolResults(*pool, 0, queryCount, queryCount * stride, results.data(), stride, vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability, *pool.getDispatcher());
+		if (queried != vk::Result::eSuccess && queried != vk::Result::eNotReady) {
+			return;
+		}
+
+		lastStatistics.clear();
+		for (Pass const& pass : framePasses[frameIndex]) {
+			uint64_t const* values = results.data() + pass.query * (VALUE_COUNT + 1);
+			if (values[VALUE_COUNT] == 0) {
+				continue;
+			}
+
+			lastStatistics.emplace_back(pass.name, PassStatistics{
+				.inputVertices = values[0],
+				.inputPrimitives = values[1],
+				.vertexInvocations = values[2],
+				.clippingPrimitives = values[3],
+				.fragmentInvocations = values[4]
+			});
+		}
+	}
+
+	void PipelineStatistics::setEnabled(bool const& enable) {
+		if (enable && !supported) {
+			std::cout << "Pipeline statistics requested but the device does not support them\n";
+		}
+
+		enabled = enable && supported;
+		if (!enabled) {
+			lastStatistics.clear();
+		}
+	}
+
+	bool PipelineStatistics::isEnabled() const {
+		return enabled;
+	}
+
+	bool PipelineStatistics::isSupported() const {
+		return supported;
+	}
+
+	std::vector<std::pair<const char*, PassStatistics>> const& PipelineStatistics::getLastStatistics() const {
+		return lastStatistics;
+	}
+
+	PipelineStatisticsScope::PipelineStatisticsScope(PipelineStatistics& statistics, vk::raii::CommandBuffer const& cmdBuffer, const char* name) : statistics{ statistics }, cmdBuffer{ cmdBuffer }, pass{ statistics.beginPass(cmdBuffer, name) } {
+
+	}
+
+	PipelineStatisticsScope::~PipelineStatisticsScope() {
+		statistics.endPass(cmdBuffer, pass);
+	}
+}
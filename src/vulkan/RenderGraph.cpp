@@ -0,0 +1,549 @@
+#include "vulkan/RenderGraph.h"
+#include "vulkan/GraphicsContext.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace Vulkan {
+	struct AccessInfo {
+		vk::PipelineStageFlags2 stage;
+		vk::AccessFlags2 access;
+		vk::ImageLayout layout;
+		bool write;
+		vk::ImageUsageFlags usage;
+	};
+
+	static AccessInfo getAccessInfo(ImageAccess const& access) {
+		switch (access) {
+		case ImageAccess::eColorAttachmentWrite:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eColorAttachmentRead, vk::ImageLayout::eColorAttachmentOptimal, true, vk::ImageUsageFlagBits::eColorAttachment };
+		case ImageAccess::eDepthAttachmentWrite:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentWrite | vk::AccessFlagBits2::eDepthStencilAttachmentRead, vk::ImageLayout::eDepthAttachmentOptimal, true, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+		case ImageAccess::eDepthAttachmentRead:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead, vk::ImageLayout::eDepthReadOnlyOptimal, false, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+		case ImageAccess::eDepthResolveWrite:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eDepthAttachmentOptimal, true, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+		case ImageAccess::eFragmentSampled:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal, false, vk::ImageUsageFlagBits::eSampled };
+		case ImageAccess::eComputeSampled:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal, false, vk::ImageUsageFlagBits::eSampled };
+		case ImageAccess::eComputeStorageRead:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead, vk::ImageLayout::eGeneral, false, vk::ImageUsageFlagBits::eStorage };
+		case ImageAccess::eComputeStorageWrite:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eShaderStorageRead, vk::ImageLayout::eGeneral, true, vk::ImageUsageFlagBits::eStorage };
+		case ImageAccess::eTransferSrc:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eAllTransfer, vk::AccessFlagBits2::eTransferRead, vk::ImageLayout::eTransferSrcOptimal, false, vk::ImageUsageFlagBits::eTransferSrc };
+		case ImageAccess::eTransferDst:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eAllTransfer, vk::AccessFlagBits2::eTransferWrite, vk::ImageLayout::eTransferDstOptimal, true, vk::ImageUsageFlagBits::eTransferDst };
+		case ImageAccess::ePresent:
+			return AccessInfo{ vk::PipelineStageFlagBits2::eBottomOfPipe, {}, vk::ImageLayout::ePresentSrcKHR, false, {} };
+		default:
+			return AccessInfo{ {}, {}, vk::ImageLayout::eUndefined, false, {} };
+		}
+	}
+
+	PassBuilder::PassBuilder(RenderGraph& graph, uint32_t const& pass) : graph{ graph }, pass{ pass } {
+
+	}
+
+	PassBuilder& PassBuilder::read(uint32_t const& resource, ImageAccess const& access) {
+		graph.addAccess(pass, resource, access, false);
+		return *this;
+	}
+
+	PassBuilder& PassBuilder::write(uint32_t const& resource, ImageAccess const& access) {
+		graph.addAccess(pass, resource, access, true);
+		return *this;
+	}
+
+	PassBuilder& PassBuilder::sideEffects() {
+		graph.passes[pass].sideEffects = true;
+		return *this;
+	}
+
+	RenderGraph::RenderGraph() : passes{}, resources{}, order{}, batches{}, memoryBlocks{}, transientImages{}, transientViews{}, transientBytes{ 0 }, allocatedBytes{ 0 }, lazilyAllocatedBytes{ 0 }, barrierCount{ 0 }, compiled{ false } {
+
+	}
+
+	void RenderGraph::reset(DeletionQueue& deletionQueue) {
+		deletionQueue.retireAll(transientViews);
+		deletionQueue.retireAll(transientImages);
+		deletionQueue.retireAll(memoryBlocks);
+		passes.clear();
+		resources.clear();
+		order.clear();
+		batches.clear();
+		transientBytes = 0;
+		allocatedBytes = 0;
+		lazilyAllocatedBytes = 0;
+		barrierCount = 0;
+		compiled = false;
+	}
+
+	uint32_t RenderGraph::importImage(const char* name, ImportedImageInfo const& info) {
+		resources.push_back(Resource{
+			.name = name,
+			.imported = true,
+			.format = info.format,
+			.extent = info.extent,
+			.aspect = info.aspect,
+			.samples = vk::SampleCountFlagBits::e1,
+			.initialAccess = info.initialAccess,
+			.preserveContents = info.preserveContents,
+			.finalAccess = info.finalAccess,
+			.image = {},
+			.view = {},
+			.firstPosition = NONE,
+			.lastPosition = NONE,
+			.usedStages = {},
+			.writtenAccess = {},
+			.usage = {},
+			.memoryBlock = NONE,
+			.memorySize = 0,
+			.previousOccupant = NONE
+		});
+
+		return static_cast<uint32_t>(resources.size() - 1);
+	}
+
+	uint32_t RenderGraph::createImage(const char* name, TransientImageInfo const& info) {
+		resources.push_back(Resource{
+			.name = name,
+			.imported = false,
+			.format = info.format,
+			.extent = info.extent,
+			.aspect = info.aspect,
+			.samples = info.samples,
+			.initialAccess = ImageAccess::eNone,
+			.preserveContents = false,
+			.finalAccess = ImageAccess::eNone,
+			.image = {},
+			.view = {},
+			.firstPosition = NONE,
+			.lastPosition = NONE,
+			.usedStages = {},
+			.writtenAccess = {},
+			.usage = {},
+			.memoryBlock = NONE,
+			.memorySize = 0,
+			.previousOccupant = NONE
+		});
+
+		return static_cast<uint32_t>(resources.size() - 1);
+	}
+
+	PassBuilder RenderGraph::addPass(const char* name, std::function<void(vk::raii::CommandBuffer const&)> execute) {
+		passes.push_back(Pass{ .name = name, .execute = std::move(execute), .accesses = {}, .sideEffects = false, .live = false });
+		compiled = false;
+
+		return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+	}
+
+	// one access per resource per pass, two transitions of the same image in one batch would not be ordered
+	void RenderGraph::addAccess(uint32_t const& pass, uint32_t const& resource, ImageAccess const& access, bool const& write) {
+		if (resource >= resources.size()) {
+			throw std::runtime_error(std::string("Render graph pass ") + passes[pass].name + " uses a resource that does not exist");
+		}
+		if (getAccessInfo(access).write != write || access == ImageAccess::eNone || access == ImageAccess::ePresent) {
+			throw std::runtime_error(std::string("Render graph pass ") + passes[pass].name + (write ? " writes " : " reads ") + resources[resource].name + " with an access that does not " + (write ? "write" : "read"));
+		}
+		for (Access const& existing : passes[pass].accesses) {
+			if (existing.resource == resource) {
+				throw std::runtime_error(std::string("Render graph pass ") + passes[pass].name + " uses " + resources[resource].name + " twice");
+			}
+		}
+
+		passes[pass].accesses.push_back(Access{ .resource = resource, .access = access });
+	}
+
+	void RenderGraph::compile(GraphicsContext& context) {
+		transientViews.clear();
+		transientImages.clear();
+		memoryBlocks.clear();
+
+		cull();
+		computeLifetimes();
+		allocateTransients(context);
+		buildBarriers();
+		compiled = true;
+	}
+
+	// walks back from the outputs, a pass lives if it has side effects or writes something a live pass or the final layout needs
+	// a write does not end the need for earlier writers, passes that only partly overwrite an image keep what came before
+	void RenderGraph::cull() {
+		std::vector<bool> needed(resources.size(), false);
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			needed[i] = resources[i].imported && resources[i].finalAccess != ImageAccess::eNone;
+		}
+
+		for (uint32_t i = static_cast<uint32_t>(passes.size()); i-- > 0;) {
+			Pass& pass = passes[i];
+			pass.live = pass.sideEffects;
+			for (Access const& access : pass.accesses) {
+				if (getAccessInfo(access.access).write && needed[access.resource]) {
+					pass.live = true;
+				}
+			}
+
+			if (pass.live) {
+				for (Access const& access : pass.accesses) {
+					if (!getAccessInfo(access.access).write) {
+						needed[access.resource] = true;
+					}
+				}
+			}
+		}
+
+		order.clear();
+		for (uint32_t i = 0; i < passes.size(); i++) {
+			if (passes[i].live) {
+				order.push_back(i);
+			}
+		}
+	}
+
+	void RenderGraph::computeLifetimes() {
+		for (Resource& resource : resources) {
+			resource.firstPosition = NONE;
+			resource.lastPosition = NONE;
+			resource.usedStages = {};
+			resource.writtenAccess = {};
+			resource.usage = {};
+			resource.memoryBlock = NONE;
+			resource.memorySize = 0;
+			resource.previousOccupant = NONE;
+		}
+
+		for (uint32_t position = 0; position < order.size(); position++) {
+			for (Access const& access : passes[order[position]].accesses) {
+				Resource& resource = resources[access.resource];
+				AccessInfo info = getAccessInfo(access.access);
+
+				if (resource.firstPosition == NONE) {
+					resource.firstPosition = position;
+				}
+				resource.lastPosition = position;
+				resource.usedStages |= info.stage;
+				if (info.write) {
+					resource.writtenAccess |= info.access;
+				}
+				resource.usage |= info.usage;
+			}
+		}
+	}
+
+	// greedy interval packing, each transient goes into the first block of a compatible memory type whose last user is done before it starts
+	void RenderGraph::allocateTransients(GraphicsContext& context) {
+		struct MemoryBlock {
+			vk::DeviceSize size;
+			vk::DeviceSize alignment;
+			uint32_t typeBits;
+			uint32_t lastPosition;
+			uint32_t firstOccupant;
+			uint32_t lastOccupant;
+			// transient attachments only share with each other, lazily allocated memory can back nothing else
+			bool transientAttachments;
+		};
+		vk::ImageUsageFlags attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+
+		std::vector<uint32_t> transients{};
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			if (!resources[i].imported && resources[i].firstPosition != NONE) {
+				transients.push_back(i);
+			}
+		}
+		std::sort(transients.begin(), transients.end(), [this](uint32_t const& a, uint32_t const& b) { return resources[a].firstPosition < resources[b].firstPosition; });
+
+		std::vector<uint32_t> imageOfResource(resources.size(), NONE);
+		std::vector<vk::MemoryRequirements> requirements{};
+		for (uint32_t resourceIndex : transients) {
+			Resource& resource = resources[resourceIndex];
+			// never loaded from or stored to memory outside the passes that render into it
+			if (!(resource.usage & ~attachmentUsage)) {
+				resource.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+			}
+			vk::ImageCreateInfo imageInfo = {
+				.imageType = vk::ImageType::e2D,
+				.format = resource.format,
+				.extent = vk::Extent3D{ resource.extent.width, resource.extent.height, 1 },
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = resource.samples,
+				.tiling = vk::ImageTiling::eOptimal,
+				.usage = resource.usage,
+				.sharingMode = vk::SharingMode::eExclusive,
+				.initialLayout = vk::ImageLayout::eUndefined
+			};
+			transientImages.push_back(vk::raii::Image(context.context.device, imageInfo));
+			imageOfResource[resourceIndex] = static_cast<uint32_t>(transientImages.size() - 1);
+			requirements.push_back(transientImages.back().getMemoryRequirements());
+		}
+
+		std::vector<MemoryBlock> blocks{};
+		std::vector<vk::DeviceSize> offsets(resources.size(), 0);
+		transientBytes = 0;
+		for (uint32_t i = 0; i < transients.size(); i++) {
+			Resource& resource = resources[transients[i]];
+			vk::MemoryRequirements const& required = requirements[i];
+			bool transientAttachment = static_cast<bool>(resource.usage & vk::ImageUsageFlagBits::eTransientAttachment);
+			transientBytes += required.size;
+
+			uint32_t chosen = NONE;
+			for (uint32_t b = 0; b < blocks.size(); b++) {
+				if (blocks[b].lastPosition < resource.firstPosition && blocks[b].transientAttachments == transientAttachment && (blocks[b].typeBits & required.memoryTypeBits) != 0) {
+					chosen = b;
+					break;
+				}
+			}
+
+			if (chosen == NONE) {
+				blocks.push_back(MemoryBlock{ .size = required.size, .alignment = required.alignment, .typeBits = required.memoryTypeBits, .lastPosition = resource.lastPosition, .firstOccupant = transients[i], .lastOccupant = transients[i], .transientAttachments = transientAttachment });
+				chosen = static_cast<uint32_t>(blocks.size() - 1);
+			} else {
+				MemoryBlock& block = blocks[chosen];
+				resource.previousOccupant = block.lastOccupant;
+				block.size = std::max(block.size, required.size);
+				block.alignment = std::max(block.alignment, required.alignment);
+				block.typeBits &= required.memoryTypeBits;
+				block.lastPosition = resource.lastPosition;
+				block.lastOccupant = transients[i];
+			}
+			resource.memoryBlock = chosen;
+			resource.memorySize = required.size;
+		}
+
+		allocatedBytes = 0;
+		lazilyAllocatedBytes = 0;
+		for (MemoryBlock const& block : blocks) {
+			// the first user of a block comes after its last one from the frame before
+			resources[block.firstOccupant].previousOccupant = block.lastOccupant;
+
+			uint32_t memoryTypeIndex = 0xFFFFFFFF;
+			if (block.transientAttachments) {
+				memoryTypeIndex = context.getSuitableMemoryTypeIndex(block.typeBits, vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated);
+				lazilyAllocatedBytes += memoryTypeIndex == 0xFFFFFFFF ? 0 : block.size;
+			}
+			if (memoryTypeIndex == 0xFFFFFFFF) {
+				memoryTypeIndex = context.getSuitableMemoryTypeIndex(block.typeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			}
+			if (memoryTypeIndex == 0xFFFFFFFF) {
+				throw std::runtime_error("No suitable memory type found for a render graph transient image");
+			}
+			memoryBlocks.push_back(vk::raii::DeviceMemory(context.context.device, vk::MemoryAllocateInfo{ .allocationSize = block.size, .memoryTypeIndex = memoryTypeIndex }));
+			allocatedBytes += block.size;
+		}
+
+		for (uint32_t resourceIndex : transients) {
+			Resource& resource = resources[resourceIndex];
+			vk::raii::Image& image = transientImages[imageOfResource[resourceIndex]];
+			image.bindMemory(memoryBlocks[resource.memoryBlock], 0);
+
+			vk::ImageViewCreateInfo viewInfo = {
+				.image = image,
+				.viewType = vk::ImageViewType::e2D,
+				.format = resource.format,
+				.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = resource.aspect, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1 }
+			};
+			transientViews.push_back(vk::raii::ImageView(context.context.device, viewInfo));
+			resource.image = *image;
+			resource.view = *transientViews.back();
+		}
+	}
+
+	// every barrier is hoisted to just after the image's previous use, so barriers for different images share one call
+	// sync2 keeps per barrier stage masks, so batching never adds a dependency that was not asked for
+	void RenderGraph::buildBarriers() {
+		struct ImageState {
+			vk::ImageLayout layout;
+			vk::PipelineStageFlags2 writeStages;
+			vk::AccessFlags2 writeAccess;
+			// reads since the last write, and which of them the write has been made visible to
+			vk::PipelineStageFlags2 readStages;
+			vk::PipelineStageFlags2 visibleStages;
+			vk::AccessFlags2 visibleAccess;
+			// the batch after this position gets the next barrier, NONE places it before the first pass
+			uint32_t lastPosition;
+		};
+
+		batches.clear();
+		batches.resize(order.size() + 1);
+		barrierCount = 0;
+
+		std::vector<ImageState> states(resources.size());
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			Resource const& resource = resources[i];
+			ImageState& state = states[i];
+			state = ImageState{ .layout = vk::ImageLayout::eUndefined, .writeStages = {}, .writeAccess = {}, .readStages = {}, .visibleStages = {}, .visibleAccess = {}, .lastPosition = NONE };
+
+			if (resource.imported) {
+				AccessInfo initial = getAccessInfo(resource.initialAccess);
+				state.layout = resource.preserveContents ? initial.layout : vk::ImageLayout::eUndefined;
+				if (initial.write) {
+					state.writeStages = initial.stage;
+					state.writeAccess = initial.access;
+				} else {
+					state.readStages = initial.stage;
+				}
+			} else if (resource.previousOccupant != NONE) {
+				// the memory is reused, whatever used it last, this frame or the one before, has to be done with it
+				Resource const& previous = resources[resource.previousOccupant];
+				state.writeStages = previous.usedStages;
+				state.writeAccess = previous.writtenAccess;
+				if (previous.lastPosition < resource.firstPosition) {
+					state.lastPosition = previous.lastPosition;
+				}
+			}
+		}
+
+		auto transition = [this, &states](uint32_t const& resourceIndex, AccessInfo const& info, uint32_t const& position) {
+			ImageState& state = states[resourceIndex];
+			bool layoutChange = state.layout != info.layout;
+			bool visible = (info.stage & ~state.visibleStages) == vk::PipelineStageFlags2{} && (info.access & ~state.visibleAccess) == vk::AccessFlags2{};
+			bool needed = info.write || layoutChange || (state.writeStages != vk::PipelineStageFlags2{} && !visible);
+
+			if (needed) {
+				// a write or a layout transition has to wait for the reads since the last write as well
+				bool waitsOnReads = info.write || layoutChange;
+				uint32_t batch = state.lastPosition == NONE ? 0 : state.lastPosition + 1;
+				batches[batch].barriers.push_back(vk::ImageMemoryBarrier2{
+					.srcStageMask = state.writeStages | (waitsOnReads ? state.readStages : vk::PipelineStageFlags2{}),
+					.srcAccessMask = state.writeAccess,
+					.dstStageMask = info.stage,
+					.dstAccessMask = info.access,
+					.oldLayout = state.layout,
+					.newLayout = info.layout,
+					.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.image = resources[resourceIndex].image,
+					.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = resources[resourceIndex].aspect, .baseMipLevel = 0, .levelCount = vk::RemainingMipLevels, .baseArrayLayer = 0, .layerCount = 1 }
+				});
+				batches[batch].resources.push_back(resourceIndex);
+				++barrierCount;
+			}
+
+			if (info.write) {
+				state.writeStages = info.stage;
+				state.writeAccess = info.access;
+				state.readStages = {};
+				state.visibleStages = info.stage;
+				state.visibleAccess = info.access;
+			} else if (layoutChange) {
+				// the transition is the last write now, and only this reader has seen it
+				state.writeStages = info.stage;
+				state.writeAccess = {};
+				state.readStages = info.stage;
+				state.visibleStages = info.stage;
+				state.visibleAccess = info.access;
+			} else {
+				state.readStages |= info.stage;
+				if (needed) {
+					state.visibleStages |= info.stage;
+					state.visibleAccess |= info.access;
+				}
+			}
+			state.layout = info.layout;
+			state.lastPosition = position;
+		};
+
+		for (uint32_t position = 0; position < order.size(); position++) {
+			for (Access const& access : passes[order[position]].accesses) {
+				transition(access.resource, getAccessInfo(access.access), position);
+			}
+		}
+
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			if (resources[i].imported && resources[i].finalAccess != ImageAccess::eNone) {
+				transition(i, getAccessInfo(resources[i].finalAccess), order.empty() ? NONE : static_cast<uint32_t>(order.size() - 1));
+			}
+		}
+	}
+
+	void RenderGraph::setImportedImage(uint32_t const& resource, vk::Image const& image, vk::ImageView const& view) {
+		resources[resource].image = image;
+		resources[resource].view = view;
+	}
+
+	void RenderGraph::execute(vk::raii::CommandBuffer const& cmdBuffer) {
+		for (uint32_t position = 0; position <= order.size(); position++) {
+			BarrierBatch& batch = batches[position];
+			if (!batch.barriers.empty()) {
+				for (uint32_t i = 0; i < batch.barriers.size(); i++) {
+					batch.barriers[i].image = resources[batch.resources[i]].image;
+				}
+				cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = static_cast<uint32_t>(batch.barriers.size()), .pImageMemoryBarriers = batch.barriers.data() });
+			}
+
+			if (position < order.size()) {
+				passes[order[position]].execute(cmdBuffer);
+			}
+		}
+	}
+
+	vk::Image RenderGraph::getImage(uint32_t const& resource) const {
+		return resources[resource].image;
+	}
+
+	vk::ImageView RenderGraph::getImageView(uint32_t const& resource) const {
+		return resources[resource].view;
+	}
+
+	bool RenderGraph::isCompiled() const {
+		return compiled;
+	}
+
+	bool RenderGraph::isLive(uint32_t const& pass) const {
+		return passes[pass].live;
+	}
+
+	void RenderGraph::dump(std::ostream& out) const {
+		uint32_t batchCount = static_cast<uint32_t>(std::count_if(batches.begin(), batches.end(), [](BarrierBatch const& batch) { return !batch.barriers.empty(); }));
+		out << "Render graph: " << order.size() << " of " << passes.size() << " passes live, " << barrierCount << " barriers in " << batchCount << " batches\n";
+
+		auto printBatch = [this, &out](BarrierBatch const& batch) {
+			for (uint32_t i = 0; i < batch.barriers.size(); i++) {
+				vk::ImageMemoryBarrier2 const& barrier = batch.barriers[i];
+				out << "\t\tbarrier " << resources[batch.resources[i]].name << ": " << vk::to_string(barrier.oldLayout) << " -> " << vk::to_string(barrier.newLayout) << ", " << vk::to_string(barrier.srcStageMask) << " " << vk::to_string(barrier.srcAccessMask) << " -> " << vk::to_string(barrier.dstStageMask) << " " << vk::to_string(barrier.dstAccessMask) << '\n';
+			}
+		};
+
+		uint32_t position = 0;
+		for (uint32_t i = 0; i < passes.size(); i++) {
+			Pass const& pass = passes[i];
+			if (!pass.live) {
+				out << "\tpass " << pass.name << " (culled)\n";
+				continue;
+			}
+
+			out << "\tpass " << pass.name << (pass.sideEffects ? " (side effects)" : "") << '\n';
+			printBatch(batches[position]);
+			for (Access const& access : pass.accesses) {
+				out << "\t\t" << (getAccessInfo(access.access).write ? "writes " : "reads ") << resources[access.resource].name << " as " << vk::to_string(getAccessInfo(access.access).layout) << '\n';
+			}
+			++position;
+		}
+		if (!batches.empty() && !batches.back().barriers.empty()) {
+			out << "\tafter the last pass\n";
+			printBatch(batches.back());
+		}
+
+		for (Resource const& resource : resources) {
+			out << "\t" << (resource.imported ? "imported " : "transient ") << resource.name << " " << resource.extent.width << "x" << resource.extent.height << " " << vk::to_string(resource.format);
+			if (resource.samples != vk::SampleCountFlagBits::e1) {
+				out << " " << vk::to_string(resource.samples);
+			}
+			if (resource.firstPosition == NONE) {
+				out << ", unused\n";
+				continue;
+			}
+			out << ", passes " << resource.firstPosition << " to " << resource.lastPosition;
+			if (!resource.imported) {
+				out << ", memory block " << resource.memoryBlock << " (" << resource.memorySize << " bytes)";
+			}
+			out << '\n';
+		}
+
+		double savedPercent = transientBytes == 0 ? 0.0 : 100.0 * static_cast<double>(transientBytes - allocatedBytes) / static_cast<double>(transientBytes);
+		out << std::fixed << std::setprecision(1);
+		out << "\ttransient memory: " << transientBytes << " bytes in " << transientImages.size() << " images aliased into " << allocatedBytes << " bytes in " << memoryBlocks.size() << " blocks, " << transientBytes - allocatedBytes << " bytes (" << savedPercent << "%) saved, " << lazilyAllocatedBytes << " bytes lazily allocated\n";
+		out << std::defaultfloat;
+	}
+}
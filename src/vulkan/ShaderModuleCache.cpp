@@ -0,0 +1,165 @@
+#include "vulkan/ShaderModuleCache.h"
+#include "general/Hash.h"
+#include <cstring>
+#include <algorithm>
+
+namespace Vulkan {
+	ShaderModuleCache::ShaderModuleCache(vk::raii::Device const& device) : device{ *device }, dispatcher{ device.getDispatcher() }, pathModules{}, preloadedBinaries{}, modules{}, fileLoads{ 0 }, cacheHits{ 0 }, moduleCount{ 0 } {
+		std::cout << "Created shader module cache\n";
+	}
+
+	ShaderModuleCache::~ShaderModuleCache() {
+		for (std::pair<const uint64_t, std::vector<CachedModule>> const& bucket : modules) {
+			for (CachedModule const& cached : bucket.second) {
+				device.destroyShaderModule(cached.module, nullptr, *dispatcher);
+			}
+		}
+
+		std::cout << "Shader module cache loaded " << fileLoads << " files into " << moduleCount << " modules, " << cacheHits << " lookups were hits\n";
+	}
+
+	vk::ShaderModule ShaderModuleCache::getShaderModule(std::string const& sprivPath) {
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+
+			auto knownPath = pathModules.find(sprivPath);
+			if (knownPath != pathModules.end()) {
+				++cacheHits;
+				return knownPath->second.module;
+			}
+		}
+
+		return loadShaderModule(sprivPath);
+	}
+
+	std::vector<uint32_t> const& ShaderModuleCache::getSpecializationIds(std::string const& sprivPath) {
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		auto knownPath = pathModules.find(sprivPath);
+		if (knownPath == pathModules.end()) {
+			throw std::runtime_error("Spriv file at " + sprivPath + " has not been loaded into a shader module");
+		}
+		return knownPath->second.binary->specializationIds;
+	}
+
+	uint32_t ShaderModuleCache::getModuleCount() {
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		return moduleCount;
+	}
+
+	void ShaderModuleCache::addPreloaded(std::shared_ptr<SprivBinary const> const& binary) {
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		preloadedBinaries[binary->path] = binary;
+	}
+
+	uint32_t const* SprivBinary::getWords() const {
+		return static_cast<uint32_t const*>(file.getData());
+	}
+
+	std::shared_ptr<SprivBinary const> ShaderModuleCache::loadSprivBinary(std::string const& sprivPath) {
+		General::MappedFile sprivFile(sprivPath);
+
+		if (sprivFile.getSize() < sizeof(uint32_t) || sprivFile.getSize() % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("Spriv file at " + sprivPath + " is not a whole number of 32 bit words");
+		}
+		if (reinterpret_cast<uintptr_t>(sprivFile.getData()) % alignof(uint32_t) != 0) {
+			throw std::runtime_error("Spriv file at " + sprivPath + " is not mapped at a 4 byte aligned address");
+		}
+		if (static_cast<uint32_t const*>(sprivFile.getData())[0] != SPIRV_MAGIC) {
+			throw std::runtime_error("Spriv file at " + sprivPath + " does not start with the SPIR-V magic number");
+		}
+
+		uint64_t contentHash = General::fnv1a(sprivFile.getData(), sprivFile.getSize());
+
+		// decorations all come before the first function, the walk stops there
+		uint32_t const* words = static_cast<uint32_t const*>(sprivFile.getData());
+		size_t wordCount = sprivFile.getSize() / sizeof(uint32_t);
+		if (wordCount < SPIRV_HEADER_WORDS) {
+			throw std::runtime_error("Spriv file at " + sprivPath + " is shorter than the SPIR-V header");
+		}
+		std::vector<uint32_t> specializationIds{};
+		for (size_t word = SPIRV_HEADER_WORDS; word < wordCount;) {
+			uint32_t instructionWords = words[word] >> 16;
+			uint32_t opcode = words[word] & 0xFFFF;
+			if (instructionWords == 0 || word + instructionWords > wordCount) {
+				throw std::runtime_error("Spriv file at " + sprivPath + " has a malformed instruction at word " + std::to_string(word));
+			}
+			if (opcode == SPIRV_OP_FUNCTION) {
+				break;
+			}
+			if (opcode == SPIRV_OP_DECORATE && instructionWords >= 4 && words[word + 2] == SPIRV_DECORATION_SPEC_ID) {
+				specializationIds.push_back(words[word + 3]);
+			}
+			word += instructionWords;
+		}
+		std::sort(specializationIds.begin(), specializationIds.end());
+		specializationIds.erase(std::unique(specializationIds.begin(), specializationIds.end()), specializationIds.end());
+
+		return std::make_shared<SprivBinary const>(SprivBinary{ sprivPath, std::move(sprivFile), contentHash, std::move(specializationIds) });
+	}
+
+	vk::ShaderModule ShaderModuleCache::findModule(SprivBinary const& binary) const {
+		auto bucket = modules.find(binary.contentHash);
+		if (bucket == modules.end()) {
+			return nullptr;
+		}
+
+		for (CachedModule const& cached : bucket->second) {
+			size_t size = cached.binary->file.getSize();
+			if (size == binary.file.getSize() && std::memcmp(cached.binary->file.getData(), binary.file.getData(), size) == 0) {
+				return cached.module;
+			}
+		}
+		return nullptr;
+	}
+
+	// the module is created straight from the mapped pages, two workers after the same file may both create one and the later drops its own
+	vk::ShaderModule ShaderModuleCache::loadShaderModule(std::string const& sprivPath) {
+		std::shared_ptr<SprivBinary const> binary{};
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+
+			auto preloaded = preloadedBinaries.find(sprivPath);
+			if (preloaded != preloadedBinaries.end()) {
+				binary = preloaded->second;
+				preloadedBinaries.erase(preloaded);
+			}
+		}
+		if (!binary) {
+			binary = loadSprivBinary(sprivPath);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			++fileLoads;
+
+			vk::ShaderModule known = findModule(*binary);
+			if (known) {
+				++cacheHits;
+				pathModules.emplace(sprivPath, CachedModule{ binary, known });
+				return known;
+			}
+		}
+
+		vk::ShaderModuleCreateInfo shaderModuleInfo = {
+			.codeSize = binary->file.getSize(),
+			.pCode = binary->getWords()
+		};
+		vk::ShaderModule shaderModule = device.createShaderModule(shaderModuleInfo, nullptr, *dispatcher);
+
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		vk::ShaderModule known = findModule(*binary);
+		if (known) {
+			device.destroyShaderModule(shaderModule, nullptr, *dispatcher);
+			pathModules.emplace(sprivPath, CachedModule{ binary, known });
+			return known;
+		}
+		modules[binary->contentHash].push_back(CachedModule{ binary, shaderModule });
+		pathModules.emplace(sprivPath, CachedModule{ binary, shaderModule });
+		++moduleCount;
+
+		std::cout << "Created shader module for " << sprivPath << " (" << binary->file.getSize() << " bytes)\n";
+
+		return shaderModule;
+	}
+}
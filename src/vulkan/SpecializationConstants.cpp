@@ -0,0 +1,80 @@
+#include "vulkan/SpecializationConstants.h"
+#include <bit>
+#include <algorithm>
+
+namespace Vulkan {
+	vk::SpecializationInfo PackedSpecialization::getInfo() const {
+		return vk::SpecializationInfo{
+			.mapEntryCount = static_cast<uint32_t>(entries.size()),
+			.pMapEntries = entries.data(),
+			.dataSize = data.size() * sizeof(uint32_t),
+			.pData = data.data()
+		};
+	}
+
+	void SpecializationConstants::set(uint32_t const& constantId, SpecializationValue const& value) {
+		constants[constantId] = value;
+	}
+
+	// constants already set here win over the ones being merged in
+	void SpecializationConstants::merge(SpecializationConstants const& other) {
+		constants.insert(other.constants.begin(), other.constants.end());
+	}
+
+	bool SpecializationConstants::empty() const {
+		return constants.empty();
+	}
+
+	std::map<uint32_t, SpecializationValue> const& SpecializationConstants::getConstants() const {
+		return constants;
+	}
+
+	bool SpecializationConstants::setsExactly(std::vector<uint32_t> const& constantIds) const {
+		return constants.size() == constantIds.size() && std::equal(constantIds.begin(), constantIds.end(), constants.begin(), [](uint32_t const& id, std::pair<const uint32_t, SpecializationValue> const& constant) {
+			return id == constant.first;
+		});
+	}
+
+	PackedSpecialization SpecializationConstants::pack() const {
+		PackedSpecialization packed{};
+
+		for (std::pair<const uint32_t, SpecializationValue> const& constant : constants) {
+			uint32_t bits = std::visit([](auto const& value) -> uint32_t {
+				using T = std::decay_t<decltype(value)>;
+				if constexpr (std::is_same_v<T, bool>) {
+					return value ? vk::True : vk::False;
+				} else {
+					return std::bit_cast<uint32_t>(value);
+				}
+			}, constant.second);
+
+			packed.entries.push_back(vk::SpecializationMapEntry{
+				.constantID = constant.first,
+				.offset = static_cast<uint32_t>(packed.data.size() * sizeof(uint32_t)),
+				.size = sizeof(uint32_t)
+			});
+			packed.data.push_back(bits);
+		}
+
+		return packed;
+	}
+
+	ShaderVariantKey ShaderVariantKey::with(ShaderFeature const& feature, bool const& enabled) const {
+		uint32_t bit = 1u << static_cast<uint32_t>(feature);
+		return ShaderVariantKey{ .features = enabled ? (features | bit) : (features & ~bit) };
+	}
+
+	bool ShaderVariantKey::has(ShaderFeature const& feature) const {
+		return (features & (1u << static_cast<uint32_t>(feature))) != 0;
+	}
+
+	SpecializationConstants ShaderVariantKey::getConstants() const {
+		SpecializationConstants constants{};
+
+		for (uint32_t bit = 0; bit < FEATURE_COUNT; bit++) {
+			constants.set(bit, has(static_cast<ShaderFeature>(bit)));
+		}
+
+		return constants;
+	}
+}
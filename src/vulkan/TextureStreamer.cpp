@@ -0,0 +1,440 @@
+#include "vulkan/TextureStreamer.h"
+#include "vulkan/GraphicsContext.h"
+#include <cstring>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <chrono>
+
+namespace Vulkan {
+	static vk::ImageMemoryBarrier2 levelBarrier(vk::Image const& image, uint32_t const& baseLevel, uint32_t const& levelCount, vk::ImageLayout const& oldLayout, vk::ImageLayout const& newLayout, vk::PipelineStageFlags2 const& srcStages, vk::AccessFlags2 const& srcAccess, vk::PipelineStageFlags2 const& dstStages, vk::AccessFlags2 const& dstAccess) {
+		return vk::ImageMemoryBarrier2{
+			.srcStageMask = srcStages,
+			.srcAccessMask = srcAccess,
+			.dstStageMask = dstStages,
+			.dstAccessMask = dstAccess,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = baseLevel, .levelCount = levelCount, .baseArrayLayer = 0, .layerCount = 1 }
+		};
+	}
+
+	TextureStreamer::TextureStreamer(GraphicsContext& context, uint32_t const& framesInFlightCount, TextureStreamingSettings const& settings) : settings{ settings }, sampler{ nullptr }, textures{}, blockCompressionEnabled{ context.context.getEnabledOptionalFeatures().textureCompressionBC == VK_TRUE }, pool{ nullptr }, uploadBuffers{}, stagingBuffers{}, stagingMemory{}, stagingAddresses{}, slotLandings(framesInFlightCount), viewVersion{ 0 }, statistics{}, mipGenerator{ context }, reader{ 1 } {
+		// a budget that can not hold one row of the widest level would never finish it
+		uint64_t widestRow = static_cast<uint64_t>(context.context.physicalDevice.getProperties().limits.maxImageDimension2D) * 4;
+		this->settings.frameBudgetBytes = std::max(this->settings.frameBudgetBytes, widestRow);
+
+		sampler = vk::raii::Sampler(context.context.device, vk::SamplerCreateInfo{
+			.magFilter = vk::Filter::eLinear,
+			.minFilter = vk::Filter::eLinear,
+			.mipmapMode = vk::SamplerMipmapMode::eLinear,
+			.addressModeU = vk::SamplerAddressMode::eRepeat,
+			.addressModeV = vk::SamplerAddressMode::eRepeat,
+			.addressModeW = vk::SamplerAddressMode::eRepeat,
+			.minLod = 0.0f,
+			.maxLod = vk::LodClampNone
+		});
+
+		pool = vk::raii::CommandPool(context.context.device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer, .queueFamilyIndex = context.context.acquiredQueueFamilyIndices[0] });
+		uploadBuffers = vk::raii::CommandBuffers(context.context.device, vk::CommandBufferAllocateInfo{ .commandPool = pool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = framesInFlightCount });
+
+		uint32_t stagingSize = static_cast<uint32_t>(this->settings.frameBudgetBytes);
+		for (uint32_t i = 0; i < framesInFlightCount; i++) {
+			stagingBuffers.push_back(nullptr);
+			stagingMemory.push_back(nullptr);
+			context.createBufferAndMemory(stagingBuffers[i], stagingMemory[i], vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingSize, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive);
+			stagingAddresses.push_back(stagingMemory[i].mapMemory(0, stagingSize));
+		}
+
+		std::array<uint8_t, 4> white = { 0xFF, 0xFF, 0xFF, 0xFF };
+		TextureId fallback = createTexture(context, "fallback", vk::Format::eR8G8B8A8Unorm, vk::Extent2D{ 1, 1 }, 1, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst, {});
+		uploadNow(context, fallback, 0, { std::span<const uint8_t>(white) }, false);
+
+		std::cout << "Created texture streamer with " << framesInFlightCount << " staging buffers of " << stagingSize / 1024 << " KiB" << (blockCompressionEnabled ? "" : ", BC formats unavailable") << '\n';
+	}
+
+	vk::DescriptorSetLayoutBinding TextureStreamer::getDescriptorSetLayoutBinding(uint32_t const& bindingNum) {
+		return vk::DescriptorSetLayoutBinding{
+			.binding = bindingNum,
+			.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+			.descriptorCount = 1,
+			.stageFlags = vk::ShaderStageFlagBits::eFragment
+		};
+	}
+
+	TextureStreamer::TextureId TextureStreamer::createTexture(GraphicsContext& context, std::string const& name, vk::Format const& format, vk::Extent2D const& extent, uint32_t const& levelCount, vk::ImageUsageFlags const& usage, vk::ImageCreateFlags const& flags) {
+		vk::ImageCreateInfo imageInfo = {
+			.flags = flags,
+			.imageType = vk::ImageType::e2D,
+			.format = format,
+			.extent = vk::Extent3D{ extent.width, extent.height, 1 },
+			.mipLevels = levelCount,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = usage,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		vk::raii::Image image(context.context.device, imageInfo);
+
+		vk::MemoryRequirements imageRequirements = image.getMemoryRequirements();
+		uint32_t memoryTypeIndex = context.getSuitableMemoryTypeIndex(imageRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		if (memoryTypeIndex == 0xFFFFFFFF) {
+			throw std::runtime_error("No suitable memory type found for texture " + name);
+		}
+		vk::raii::DeviceMemory memory(context.context.device, vk::MemoryAllocateInfo{ .allocationSize = imageRequirements.size, .memoryTypeIndex = memoryTypeIndex });
+		image.bindMemory(memory, 0);
+
+		textures.push_back(Texture{
+			.name = name,
+			.source = nullptr,
+			.image = std::move(image),
+			.memory = std::move(memory),
+			.view = nullptr,
+			.format = format,
+			.extent = extent,
+			.levelCount = levelCount,
+			.residentLevel = levelCount,
+			.recordedLevel = levelCount,
+			.uploadedRows = 0,
+			.pendingRead = {},
+			.levelData = {},
+			.wantedLevel = levelCount,
+			.coverage = 0.0f
+		});
+
+		return static_cast<TextureId>(textures.size() - 1);
+	}
+
+	void TextureStreamer::uploadNow(GraphicsContext& context, TextureId const& id, uint32_t const& firstLevel, std::vector<std::span<const uint8_t>> const& levels, bool const& generateLevels) {
+		Texture& texture = textures[id];
+
+		uint64_t totalSize = 0;
+		for (std::span<const uint8_t> const& level : levels) {
+			totalSize = (totalSize + 15) & ~uint64_t(15);
+			totalSize += level.size();
+		}
+
+		vk::raii::Buffer stagingBuffer = nullptr;
+		vk::raii::DeviceMemory stagingBufferMemory = nullptr;
+		context.createBufferAndMemory(stagingBuffer, stagingBufferMemory, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, static_cast<uint32_t>(totalSize), vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive);
+		uint8_t* stagingAddress = static_cast<uint8_t*>(stagingBufferMemory.mapMemory(0, totalSize));
+
+		std::vector<vk::BufferImageCopy> regions;
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < levels.size(); i++) {
+			// copies start on a multiple of the block size and of 4
+			offset = (offset + 15) & ~uint64_t(15);
+			memcpy(stagingAddress + offset, levels[i].data(), levels[i].size());
+
+			vk::Extent2D levelExtent = { std::max(texture.extent.width >> (firstLevel + i), 1u), std::max(texture.extent.height >> (firstLevel + i), 1u) };
+			regions.push_back(vk::BufferImageCopy{
+				.bufferOffset = offset,
+				.bufferRowLength = 0,
+				.bufferImageHeight = 0,
+				.imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = firstLevel + i, .baseArrayLayer = 0, .layerCount = 1 },
+				.imageOffset = vk::Offset3D{ 0, 0, 0 },
+				.imageExtent = vk::Extent3D{ levelExtent.width, levelExtent.height, 1 }
+			});
+			offset += levels[i].size();
+			statistics.residentBytes += levels[i].size();
+		}
+		stagingBufferMemory.unmapMemory();
+
+		vk::raii::CommandPool tempPool(context.context.device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eTransient, .queueFamilyIndex = context.context.acquiredQueueFamilyIndices[0] });
+		vk::raii::CommandBuffer tempCmdBuf = std::move(vk::raii::CommandBuffers(context.context.device, vk::CommandBufferAllocateInfo{ .commandPool = tempPool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = 1 })[0]);
+
+		uint32_t levelCount = static_cast<uint32_t>(levels.size());
+		tempCmdBuf.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		vk::ImageMemoryBarrier2 toTransfer = levelBarrier(texture.image, firstLevel, levelCount, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite);
+		tempCmdBuf.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+		tempCmdBuf.copyBufferToImage(stagingBuffer, texture.image, vk::ImageLayout::eTransferDstOptimal, regions);
+		vk::ImageMemoryBarrier2 toShader = levelBarrier(texture.image, firstLevel, levelCount, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead);
+		tempCmdBuf.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShader });
+		MipPath generatedWith = MipPath::eAuto;
+		if (generateLevels) {
+			generatedWith = mipGenerator.record(context, tempCmdBuf, texture.image, texture.format, texture.extent, texture.levelCount);
+			for (uint32_t level = 1; level < texture.levelCount; level++) {
+				statistics.residentBytes += Ktx2File::getLevelSize(texture.format, vk::Extent2D{ std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u) });
+			}
+		}
+		tempCmdBuf.end();
+
+		context.context.queues[0][0].submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*tempCmdBuf }, nullptr);
+		context.context.device.waitIdle();
+		if (generateLevels) {
+			mipGenerator.collect();
+			MipGenerationStatistics const& mips = mipGenerator.getStatistics();
+			std::cout << "Generated " << texture.levelCount - 1 << " levels of " << texture.name << " with the " << (generatedWith == MipPath::eCompute ? "compute path" : "blit chain") << ", " << mips.computeImages << " images by compute in " << mips.computeMilliseconds << " ms and " << mips.blitImages << " by blit in " << mips.blitMilliseconds << " ms so far\n";
+		}
+
+		texture.residentLevel = firstLevel;
+		texture.recordedLevel = firstLevel;
+		createView(context, texture);
+		++viewVersion;
+	}
+
+	// only sampled, an sRGB image that is also written as unorm has usage its own format does not support
+	void TextureStreamer::createView(GraphicsContext& context, Texture& texture) {
+		vk::ImageViewUsageCreateInfo sampledUsage = { .usage = vk::ImageUsageFlagBits::eSampled };
+		vk::ImageViewCreateInfo viewInfo = {
+			.pNext = &sampledUsage,
+			.image = texture.image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = texture.format,
+			.subresourceRange = vk::ImageSubresourceRange{ .aspectMask = vk::ImageAspectFlagBits::eColor, .baseMipLevel = texture.residentLevel, .levelCount = texture.levelCount - texture.residentLevel, .baseArrayLayer = 0, .layerCount = 1 }
+		};
+		texture.view = vk::raii::ImageView(context.context.device, viewInfo);
+	}
+
+	bool TextureStreamer::isFormatUsable(GraphicsContext& context, vk::Format const& format) const {
+		if (Ktx2File::isBlockCompressed(format) && !blockCompressionEnabled) {
+			return false;
+		}
+
+		vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear | vk::FormatFeatureFlagBits::eTransferDst;
+		return (context.context.physicalDevice.getFormatProperties(format).optimalTilingFeatures & required) == required;
+	}
+
+	TextureStreamer::TextureId TextureStreamer::load(GraphicsContext& context, std::string const& path) {
+		std::unique_ptr<Ktx2File> file;
+		try {
+			file = std::make_unique<Ktx2File>(path, context.context.physicalDevice.getProperties().limits.maxImageDimension2D);
+		} catch (std::exception const& e) {
+			std::cout << "Drawing the fallback texture, " << e.what() << '\n';
+			return FALLBACK_TEXTURE;
+		}
+		if (!isFormatUsable(context, file->getFormat())) {
+			std::cout << "Drawing the fallback texture, " << path << " has format " << vk::to_string(file->getFormat()) << " which can not be sampled on this device\n";
+			return FALLBACK_TEXTURE;
+		}
+
+		// a lone level 0 is all a file without a chain has, the GPU fills in the rest right away
+		vk::Extent2D extent = file->getExtent();
+		uint32_t fullLevelCount = MipGenerator::getFullLevelCount(extent);
+		if (file->getLevelCount() == 1 && fullLevelCount > 1 && mipGenerator.canGenerate(context, file->getFormat())) {
+			TextureId id = createTexture(context, path, file->getFormat(), extent, fullLevelCount, mipGenerator.getImageUsage(context, file->getFormat()), mipGenerator.getImageFlags(context, file->getFormat()));
+			uploadNow(context, id, 0, { file->getLevelData(0) }, true);
+			textures[id].wantedLevel = 0;
+
+			std::cout << "Loaded texture " << path << " " << extent.width << "x" << extent.height << " " << vk::to_string(textures[id].format) << " with " << fullLevelCount << " levels, all but level 0 generated\n";
+			return id;
+		}
+
+		uint32_t levelCount = file->getLevelCount();
+		uint32_t tailLevel = levelCount - 1;
+		while (tailLevel > 0) {
+			vk::Extent2D levelExtent = file->getLevelExtent(tailLevel - 1);
+			if (std::max(levelExtent.width, levelExtent.height) > settings.residentTailSize) {
+				break;
+			}
+			--tailLevel;
+		}
+
+		std::vector<std::span<const uint8_t>> tail;
+		for (uint32_t level = tailLevel; level < levelCount; level++) {
+			tail.push_back(file->getLevelData(level));
+		}
+
+		TextureId id = createTexture(context, path, file->getFormat(), extent, levelCount, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst, {});
+		uploadNow(context, id, tailLevel, tail, false);
+		textures[id].source = std::move(file);
+		textures[id].wantedLevel = tailLevel;
+
+		std::cout << "Loaded texture " << path << " " << textures[id].extent.width << "x" << textures[id].extent.height << " " << vk::to_string(textures[id].format) << " with " << levelCount << " levels, " << levelCount - tailLevel << " resident\n";
+		return id;
+	}
+
+	void TextureStreamer::frameCompleted(GraphicsContext& context, uint32_t const& slot, DeletionQueue& deletionQueue) {
+		for (Landing const& landing : slotLandings[slot]) {
+			Texture& texture = textures[landing.texture];
+			if (landing.level >= texture.residentLevel) {
+				continue;
+			}
+
+			texture.residentLevel = landing.level;
+			deletionQueue.retire(std::move(texture.view));
+			createView(context, texture);
+			++viewVersion;
+		}
+		slotLandings[slot].clear();
+	}
+
+	void TextureStreamer::beginFrame() {
+		for (Texture& texture : textures) {
+			texture.coverage = 0.0f;
+		}
+	}
+
+	void TextureStreamer::requestCoverage(TextureId const& id, float const& pixels) {
+		Texture& texture = textures[id];
+		texture.coverage = std::max(texture.coverage, pixels);
+	}
+
+	// every level down has a quarter of the texels, the wanted one is the finest with no more texels than the pixels it covers
+	// a frame nothing drew it in leaves the wanted level alone, and since nothing is streamed out it only ever gets finer
+	void TextureStreamer::updateWantedLevel(Texture& texture) {
+		if (texture.coverage <= 0.0f) {
+			return;
+		}
+
+		double texels = static_cast<double>(texture.extent.width) * texture.extent.height;
+		double level = std::floor(0.5 * std::log2(texels / texture.coverage));
+		uint32_t wanted = static_cast<uint32_t>(std::clamp(level, 0.0, static_cast<double>(texture.levelCount - 1)));
+		texture.wantedLevel = std::min(texture.wantedLevel, wanted);
+	}
+
+	bool TextureStreamer::recordLevelRows(vk::raii::CommandBuffer const& cmdBuffer, TextureId const& id, uint32_t const& slot, uint64_t& stagingOffset, bool& begun) {
+		Texture& texture = textures[id];
+		if (texture.pendingRead.valid()) {
+			if (texture.pendingRead.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				return false;
+			}
+			texture.levelData = texture.pendingRead.get();
+		}
+
+		uint32_t level = texture.recordedLevel - 1;
+		vk::Extent2D levelExtent = texture.source->getLevelExtent(level);
+		TexelBlock block{};
+		Ktx2File::getTexelBlock(texture.format, block);
+		uint32_t blocksWide = (levelExtent.width + block.width - 1) / block.width;
+		uint32_t blocksHigh = (levelExtent.height + block.height - 1) / block.height;
+		uint64_t rowBytes = static_cast<uint64_t>(blocksWide) * block.bytes;
+
+		// copies start on a multiple of the block size and of 4
+		stagingOffset = (stagingOffset + 15) & ~uint64_t(15);
+		if (stagingOffset >= settings.frameBudgetBytes) {
+			return false;
+		}
+		uint32_t rows = static_cast<uint32_t>(std::min<uint64_t>(blocksHigh - texture.uploadedRows, (settings.frameBudgetBytes - stagingOffset) / rowBytes));
+		if (rows == 0) {
+			return false;
+		}
+
+		if (!begun) {
+			cmdBuffer.reset();
+			cmdBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+			begun = true;
+		}
+
+		// the level is outside the view until it lands, so it can sit in transfer layout across frames
+		if (texture.uploadedRows == 0) {
+			vk::ImageMemoryBarrier2 toTransfer = levelBarrier(texture.image, level, 1, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite);
+			cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toTransfer });
+		}
+
+		uint64_t copySize = rows * rowBytes;
+		memcpy(static_cast<uint8_t*>(stagingAddresses[slot]) + stagingOffset, texture.levelData.data() + texture.uploadedRows * rowBytes, copySize);
+
+		// the last rows may hold partial blocks, the copy then ends at the level's edge
+		uint32_t firstTexelRow = texture.uploadedRows * block.height;
+		vk::BufferImageCopy region = {
+			.bufferOffset = stagingOffset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = vk::ImageSubresourceLayers{ .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = level, .baseArrayLayer = 0, .layerCount = 1 },
+			.imageOffset = vk::Offset3D{ 0, static_cast<int32_t>(firstTexelRow), 0 },
+			.imageExtent = vk::Extent3D{ levelExtent.width, std::min(rows * block.height, levelExtent.height - firstTexelRow), 1 }
+		};
+		cmdBuffer.copyBufferToImage(stagingBuffers[slot], texture.image, vk::ImageLayout::eTransferDstOptimal, region);
+
+		stagingOffset += copySize;
+		texture.uploadedRows += rows;
+		statistics.lastFrameBytes += copySize;
+		statistics.streamedBytes += copySize;
+
+		if (texture.uploadedRows == blocksHigh) {
+			vk::ImageMemoryBarrier2 toShader = levelBarrier(texture.image, level, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead);
+			cmdBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShader });
+
+			texture.recordedLevel = level;
+			texture.uploadedRows = 0;
+			std::vector<uint8_t>().swap(texture.levelData);
+			slotLandings[slot].push_back(Landing{ .texture = id, .level = level });
+			statistics.residentBytes += texture.source->getLevelData(level).size();
+		}
+
+		return true;
+	}
+
+	bool TextureStreamer::recordUploads(uint32_t const& slot) {
+		statistics.lastFrameBytes = 0;
+		statistics.pendingLevels = 0;
+
+		std::vector<TextureId> candidates;
+		for (TextureId id = 0; id < textures.size(); id++) {
+			Texture& texture = textures[id];
+			if (!texture.source) {
+				continue;
+			}
+
+			updateWantedLevel(texture);
+			if (texture.residentLevel > texture.wantedLevel) {
+				statistics.pendingLevels += texture.residentLevel - texture.wantedLevel;
+			}
+			if (texture.recordedLevel <= texture.wantedLevel) {
+				continue;
+			}
+
+			// the level is read off the frame's thread, it is copied from in the frames after the read finishes
+			if (!texture.pendingRead.valid() && texture.levelData.empty()) {
+				Ktx2File const* file = texture.source.get();
+				uint32_t level = texture.recordedLevel - 1;
+				texture.pendingRead = reader.enqueue([file, level]() {
+					std::span<const uint8_t> data = file->getLevelData(level);
+					return std::vector<uint8_t>(data.begin(), data.end());
+				});
+			}
+			candidates.push_back(id);
+		}
+
+		// the texture with the most pixels per texel of the level it gets next is the most blurred, it goes first
+		std::sort(candidates.begin(), candidates.end(), [this](TextureId const& a, TextureId const& b) {
+			auto priority = [this](TextureId const& id) {
+				vk::Extent2D next = textures[id].source->getLevelExtent(textures[id].recordedLevel - 1);
+				return textures[id].coverage / (static_cast<float>(next.width) * next.height);
+			};
+			return priority(a) > priority(b);
+		});
+
+		uint64_t stagingOffset = 0;
+		bool begun = false;
+		for (TextureId const& id : candidates) {
+			recordLevelRows(uploadBuffers[slot], id, slot, stagingOffset, begun);
+		}
+		statistics.textures = static_cast<uint32_t>(textures.size());
+
+		if (begun) {
+			uploadBuffers[slot].end();
+		}
+		return begun;
+	}
+
+	vk::raii::CommandBuffer const& TextureStreamer::getUploadBuffer(uint32_t const& slot) const {
+		return uploadBuffers[slot];
+	}
+
+	vk::DescriptorImageInfo TextureStreamer::getDescriptorInfo(TextureId const& id) const {
+		return vk::DescriptorImageInfo{ .sampler = sampler, .imageView = textures[id].view, .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal };
+	}
+
+	uint64_t TextureStreamer::getViewVersion() const {
+		return viewVersion;
+	}
+
+	TextureStatistics const& TextureStreamer::getStatistics() const {
+		return statistics;
+	}
+
+	void TextureStreamer::setMipPath(MipPath const& path) {
+		mipGenerator.setPreferredPath(path);
+	}
+
+	MipGenerationStatistics const& TextureStreamer::getMipStatistics() const {
+		return mipGenerator.getStatistics();
+	}
+}
@@ -1,20 +1,31 @@
 #include "vulkan/VulkanContext.h"
 #include <cstddef>
 #include <limits>
+#include <algorithm>
+#include <bit>
 
 namespace Vulkan {
-	VulkanContext::VulkanContext(VulkanContext&& moveFrom) : context(std::move(moveFrom.context)), instance(std::move(moveFrom.instance)), surface(std::move(moveFrom.surface)), physicalDevice(std::move(moveFrom.physicalDevice)), device(std::move(moveFrom.device)), queues(std::move(moveFrom.queues)), acquiredQueueFamilyIndices(std::move(moveFrom.acquiredQueueFamilyIndices)) {
+	VulkanContext::VulkanContext(VulkanContext&& moveFrom) : context(std::move(moveFrom.context)), instance(std::move(moveFrom.instance)), surface(std::move(moveFrom.surface)), physicalDevice(std::move(moveFrom.physicalDevice)), device(std::move(moveFrom.device)), queues(std::move(moveFrom.queues)), computeQueue(std::move(moveFrom.computeQueue)), computeQueueFamily(moveFrom.computeQueueFamily), acquiredQueueFamilyIndices(std::move(moveFrom.acquiredQueueFamilyIndices)), enabledDeviceExtensions(std::move(moveFrom.enabledDeviceExtensions)), extendedDynamicState3Features(moveFrom.extendedDynamicState3Features), enabledOptionalFeatures(moveFrom.enabledOptionalFeatures), deviceProfile(std::move(moveFrom.deviceProfile)), deviceProfileCached(moveFrom.deviceProfileCached), headless(moveFrom.headless), headlessExtent(moveFrom.headlessExtent) {
 		window = moveFrom.window;
 		moveFrom.window = nullptr;
 	}
 
 	VulkanContext::~VulkanContext() {
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		if (!headless) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
+	}
+
+	void VulkanContext::initGlfw() {
+		General::StartupStep step("glfw");
+
+		if (glfwInit() == GLFW_FALSE) {
+			throw std::runtime_error("Glfw initialization failure");
+		}
 	}
 
 	void VulkanContext::initWindow(int const& WIDTH, int const& HEIGHT, const char* name) {
-		glfwInit();
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		window = glfwCreateWindow(WIDTH, HEIGHT, name, nullptr, nullptr);
 
@@ -25,12 +36,18 @@ namespace Vulkan {
 		}
 	}
 
+	void VulkanContext::initHeadlessWindow(int const& WIDTH, int const& HEIGHT) {
+		headlessExtent = vk::Extent2D(static_cast<uint32_t>(WIDTH), static_cast<uint32_t>(HEIGHT));
+
+		std::cout << "Headless mode, no window created, rendering at {WIDTH: " << WIDTH << "} {HEIGHT: " << HEIGHT << "}\n";
+	}
+
 	void VulkanContext::initInstance(uint32_t const& apiVersion, std::vector<const char*> const& validLays) {
 		vk::ApplicationInfo appInfo = {
 			.apiVersion = apiVersion
 		};
 
-		std::pair<uint32_t, const char**> glfwExtensionInfo = enumerateGlfwExtensions();
+		std::pair<uint32_t, const char**> glfwExtensionInfo = headless ? enumerateHeadlessExtensions() : enumerateGlfwExtensions();
 
 		vk::InstanceCreateInfo instanceInfo = {
 			.pApplicationInfo = &appInfo,
@@ -57,6 +74,13 @@ namespace Vulkan {
 	}
 
 	void VulkanContext::initSurface() {
+		if (headless) {
+			surface = vk::raii::SurfaceKHR(instance, vk::HeadlessSurfaceCreateInfoEXT{});
+
+			std::cout << "Headless surface creation successful\n";
+			return;
+		}
+
 		VkSurfaceKHR paperSurface;
 		glfwCreateWindowSurface(*instance, window, nullptr, &paperSurface);
 		
@@ -76,6 +100,18 @@ namespace Vulkan {
 		return { requiredExtensionsCount, requiredExtensions };
 	}
 
+	// what glfw would ask for on a real window system, minus the platform surface which VK_EXT_headless_surface replaces
+	std::pair<uint32_t, const char**> VulkanContext::enumerateHeadlessExtensions() {
+		static const char* headlessExtensions[] = { vk::KHRSurfaceExtensionName, vk::EXTHeadlessSurfaceExtensionName };
+		const char** requiredExtensions = headlessExtensions;
+
+		if (!verifyHaveGlfwExtensions(2, requiredExtensions)) {
+			throw std::runtime_error("VK_EXT_headless_surface not supported by the instance");
+		}
+
+		return { 2, requiredExtensions };
+	}
+
 	bool VulkanContext::verifyHaveGlfwExtensions(uint32_t const& needCount, const char**& needs) {
 		bool haveGlfwExtensions = true;
 
@@ -128,6 +164,104 @@ namespace Vulkan {
 		return haveValidationLayers;
 	}
 
+	// the profile is only trusted for the same device on the same driver asked for the same things, anything else rates the devices again
+	bool VulkanContext::loadCachedPhysicalDevice(std::vector<vk::raii::PhysicalDevice> const& physicalDevices, std::string const& profilePath, uint64_t const& requirementsHash) {
+		DeviceProfile profile{};
+		if (!DeviceProfile::load(profilePath, profile) || profile.requirementsHash != requirementsHash) {
+			return false;
+		}
+
+		for (vk::raii::PhysicalDevice const& phyDev : physicalDevices) {
+			vk::PhysicalDeviceProperties properties = phyDev.getProperties();
+			if (properties.vendorID == profile.vendorId && properties.deviceID == profile.deviceId && properties.driverVersion == profile.driverVersion) {
+				physicalDevice = phyDev;
+				deviceProfile = std::move(profile);
+				deviceProfileCached = true;
+
+				std::cout << "Physical device selection from the saved profile: " << properties.deviceName << " with performance score " << deviceProfile.score << '\n';
+				return true;
+			}
+		}
+
+		std::cout << "The saved device profile does not match any device on this driver, rating them again\n";
+		return false;
+	}
+
+	DeviceProfile VulkanContext::profilePhysicalDevice(vk::raii::PhysicalDevice const& phyDev, std::vector<const char*> const& optionalDevExts, uint64_t const& requirementsHash) {
+		vk::PhysicalDeviceProperties properties = phyDev.getProperties();
+		DeviceProfile profile = {
+			.vendorId = properties.vendorID,
+			.deviceId = properties.deviceID,
+			.driverVersion = properties.driverVersion,
+			.requirementsHash = requirementsHash,
+			.deviceType = static_cast<uint32_t>(properties.deviceType),
+			.deviceLocalBytes = 0,
+			.score = 0,
+			.optionalExtensions = {}
+		};
+
+		// the largest heap, an integrated GPU can report several that all map the same system memory
+		vk::PhysicalDeviceMemoryProperties memoryProperties = phyDev.getMemoryProperties();
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+			if (memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+				profile.deviceLocalBytes = std::max<uint64_t>(profile.deviceLocalBytes, memoryProperties.memoryHeaps[i].size);
+			}
+		}
+
+		std::vector<vk::ExtensionProperties> extensionProperties = phyDev.enumerateDeviceExtensionProperties();
+		for (const char* optionalExtension : optionalDevExts) {
+			for (vk::ExtensionProperties const& property : extensionProperties) {
+				if (strcmp(property.extensionName, optionalExtension) == 0) {
+					profile.optionalExtensions.push_back(optionalExtension);
+					break;
+				}
+			}
+		}
+
+		profile.score = scorePhysicalDevice(phyDev, profile);
+		return profile;
+	}
+
+	// the type dominates so a discrete GPU beats an integrated one with more shared memory, memory, limits and extensions separate devices of a type
+	uint32_t VulkanContext::scorePhysicalDevice(vk::raii::PhysicalDevice const& phyDev, DeviceProfile const& profile) {
+		uint32_t score = 0;
+
+		switch (static_cast<vk::PhysicalDeviceType>(profile.deviceType)) {
+		case vk::PhysicalDeviceType::eDiscreteGpu:
+			score += 10000;
+			break;
+		case vk::PhysicalDeviceType::eIntegratedGpu:
+			score += 4000;
+			break;
+		case vk::PhysicalDeviceType::eVirtualGpu:
+			score += 2000;
+			break;
+		case vk::PhysicalDeviceType::eCpu:
+			score += 100;
+			break;
+		default:
+			break;
+		}
+
+		// a point per 16 MiB up to 32 GiB
+		score += static_cast<uint32_t>(std::min<uint64_t>(profile.deviceLocalBytes / (16ull * 1024 * 1024), 2048));
+
+		vk::PhysicalDeviceLimits limits = phyDev.getProperties().limits;
+		score += limits.maxImageDimension2D / 1024;
+		score += limits.maxComputeSharedMemorySize / 4096;
+		score += static_cast<uint32_t>(std::popcount(static_cast<uint32_t>(limits.framebufferColorSampleCounts))) * 8;
+		if (limits.timestampComputeAndGraphics) {
+			score += 50;
+		}
+
+		score += static_cast<uint32_t>(profile.optionalExtensions.size()) * 100;
+		if (dedicatedComputeFamilyIndex(phyDev, {}) != std::numeric_limits<uint32_t>::max()) {
+			score += 100;
+		}
+
+		return score;
+	}
+
 	uint32_t VulkanContext::judgePhysicalDevice(std::array<std::pair<std::string, uint32_t>, 4> rating) {
 		uint32_t judgement = 0;
 
@@ -201,6 +335,19 @@ namespace Vulkan {
 		return familyIndex;
 	}
 
+	uint32_t VulkanContext::dedicatedComputeFamilyIndex(vk::raii::PhysicalDevice const& phyDev, std::vector<uint32_t> const& acquired) {
+		std::vector<vk::QueueFamilyProperties> queueFamilyProperties = phyDev.getQueueFamilyProperties();
+
+		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++) {
+			vk::QueueFlags flags = queueFamilyProperties[i].queueFlags;
+			if ((flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics) && std::find(acquired.begin(), acquired.end(), i) == acquired.end()) {
+				return i;
+			}
+		}
+
+		return std::numeric_limits<uint32_t>::max();
+	}
+
 	std::vector<vk::DeviceQueueCreateInfo> VulkanContext::createDeviceQueueCreateInfos(std::vector<std::tuple<vk::QueueFlagBits, uint32_t, std::vector<float>>> const& queuesInfo, std::vector<uint32_t> const& familyIndices) {
 		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos{};
 
@@ -215,7 +362,84 @@ namespace Vulkan {
 		return queueCreateInfos;	
 	}
 
+	// the device's profile already lists which of them it has, the pointers handed on are the caller's so they outlive device creation
+	std::vector<const char*> VulkanContext::getSupportedOptionalExtensions(std::vector<const char*> const& optionalDevExts) {
+		std::vector<const char*> supportedExtensions{};
+
+		for (const char* optionalExtension : optionalDevExts) {
+			if (std::find(deviceProfile.optionalExtensions.begin(), deviceProfile.optionalExtensions.end(), optionalExtension) != deviceProfile.optionalExtensions.end()) {
+				std::cout << "Optional physical device extension supported:" << optionalExtension << '\n';
+				supportedExtensions.push_back(optionalExtension);
+			} else {
+				std::cout << "Optional physical device extension not supported:" << optionalExtension << '\n';
+			}
+		}
+
+		return supportedExtensions;
+	}
+
+	vk::PhysicalDeviceFeatures VulkanContext::getSupportedOptionalFeatures(vk::PhysicalDeviceFeatures const& optionalDevFeats) {
+		vk::PhysicalDeviceFeatures available = physicalDevice.getFeatures();
+		vk::PhysicalDeviceFeatures supported{};
+
+		// every member is a VkBool32, so the structs are walked as arrays
+		VkBool32 const* requestedBools = reinterpret_cast<VkBool32 const*>(&optionalDevFeats);
+		VkBool32 const* availableBools = reinterpret_cast<VkBool32 const*>(&available);
+		VkBool32* supportedBools = reinterpret_cast<VkBool32*>(&supported);
+
+		uint32_t requestedCount = 0;
+		uint32_t supportedCount = 0;
+		for (size_t i = 0; i < sizeof(vk::PhysicalDeviceFeatures) / sizeof(VkBool32); i++) {
+			if (requestedBools[i] == VK_TRUE) {
+				++requestedCount;
+				if (availableBools[i] == VK_TRUE) {
+					supportedBools[i] = VK_TRUE;
+					++supportedCount;
+				} else {
+					std::cout << "Optional device feature not supported at location " << i * sizeof(VkBool32) << '\n';
+				}
+			}
+		}
+
+		std::cout << "Optional device features supported: " << supportedCount << " of " << requestedCount << '\n';
+		return supported;
+	}
+
 	std::vector<uint32_t> VulkanContext::getQueueFamilyIndices() const {
 		return acquiredQueueFamilyIndices;
 	}
+
+	bool VulkanContext::hasEnabledDeviceExtension(const char* extension) const {
+		for (std::string const& enabled : enabledDeviceExtensions) {
+			if (enabled == extension) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	vk::PhysicalDeviceFeatures const& VulkanContext::getEnabledOptionalFeatures() const {
+		return enabledOptionalFeatures;
+	}
+
+	DeviceProfile const& VulkanContext::getDeviceProfile() const {
+		return deviceProfile;
+	}
+
+	bool VulkanContext::isDeviceProfileCached() const {
+		return deviceProfileCached;
+	}
+
+	bool VulkanContext::isHeadless() const {
+		return headless;
+	}
+
+	bool VulkanContext::hasAsyncCompute() const {
+		return computeQueueFamily != std::numeric_limits<uint32_t>::max();
+	}
+
+	uint32_t VulkanContext::getComputeQueueFamilyIndex() const {
+		return computeQueueFamily;
+	}
 }
\ No newline at end of file